@@ -6,6 +6,13 @@
  * e classificar moedas, exibe estatísticas em tempo real e apresenta um resumo final no terminal.
  *
  * A execução continua em loop, permitindo ao utilizador escolher novamente outro vídeo após a execução anterior.
+ * As opções da linha de comandos (ver `lerOpcoes`) permitem gravar as máscaras de cada frame num ficheiro .vcr
+ * e reproduzir essa gravação mais tarde, sem voltar a descodificar o vídeo, e ativar o detetor de movimento,
+ * que salta a segmentação e a etiquetagem dos frames sem alterações, ou a decimação adaptativa,
+ * que só processa um frame em cada k.
+ *
+ * @param argc Número de argumentos da linha de comandos.
+ * @param argv Argumentos da linha de comandos.
  *
  * @return 0 ao finalizar o programa.
  */
@@ -14,11 +21,29 @@
 #include "vc.hpp"
 
 
-int main(void)
+int main(int argc, char** argv)
 {
     // Definir locale para permitir acentuação correta no terminal
     setlocale(LC_ALL, "Portuguese");
 
+    // Lê as opções da linha de comandos (sem opções, usa o menu)
+    if (!lerOpcoes(argc, argv, &opcoes))
+    {
+        return 1;
+    }
+
+    // Tabela de moedas (se o ficheiro não existir, usa a tabela das moedas de euro)
+    if (!carregarMoedas(&tabelaMoedas, (opcoes.moedas[0] != '\0') ? opcoes.moedas : "moedas.txt") && (opcoes.moedas[0] != '\0'))
+    {
+        fprintf(stderr, "Erro ao ler a tabela de moedas %s! A usar as moedas de euro.\n", opcoes.moedas);
+    }
+
+    // Nível SIMD das operações ponto a ponto (por omissão, o mais alto suportado pelo processador)
+    if (opcoes.simd >= 0 && vc_simd_definir(opcoes.simd) != opcoes.simd)
+    {
+        fprintf(stderr, "O processador não suporta %s! A usar %s.\n", vc_simd_nome(opcoes.simd), vc_simd_nome(vc_simd_nivel()));
+    }
+
     // Estrutura para armazenar dados do vídeo
     struct
     {
@@ -26,6 +51,7 @@ int main(void)
         int ntotalframes;          ///< Total de frames
         int fps;                   ///< Frames por segundo
         int nframe;                ///< Número do frame atual
+        double tempo;              ///< Instante do frame atual (ms)
     } video;
 
     // Variáveis de controlo
@@ -37,13 +63,66 @@ int main(void)
     // Nome do vídeo a abrir (alocado dinamicamente)
     char* videofile = (char*)malloc(256 * sizeof(char));
 
+    // Vídeo sintético em bruto no stdout (para --entrada-stdin), com a verdade num ficheiro
+    if (opcoes.gerar[0] != '\0')
+    {
+        return gerarSintetico(opcoes.gerar, (opcoes.verdade[0] != '\0') ? opcoes.verdade : "verdade.csv") ? 0 : 1;
+    }
+
+    // Microbenchmark das funções vc_*, com comparação com o OpenCV
+    if (opcoes.microbenchmark[0] != '\0')
+    {
+        return microbenchmark(opcoes.microbenchmark) ? 0 : 1;
+    }
+
+    // Moedas contadas escritas no terminal (e no ficheiro de eventos) por uma thread própria
+    if (!abrirEventos(opcoes.eventos))
+    {
+        fprintf(stderr, "Erro ao criar o ficheiro de eventos %s!\n", opcoes.eventos);
+    }
+
+    // Reprodução de uma gravação .vcr: processa as máscaras gravadas em vez de um vídeo
+    if (opcoes.reproduzir[0] != '\0')
+    {
+        vc_timer();
+        iniciarRastreador(&rastreador);
+        if (!reproduzirGravacao(opcoes.reproduzir, &soma, total))
+        {
+            fecharEventos();
+            return 1;
+        }
+        fecharEventos();
+        resumoTerminal(total, soma);
+        vc_timer();
+        return 0;
+    }
+
+    // Métricas do processamento (contadores e tempos por etapa), exportadas por uma thread própria
+    if (opcoes.metricas[0] != '\0' && !abrirMetricas(opcoes.metricas, opcoes.metricasPeriodo))
+    {
+        fprintf(stderr, "Erro ao abrir o destino das métricas %s!\n", opcoes.metricas);
+    }
+
+    // Benchmark: exatidão da contagem e velocidade em cenários sintéticos (código 1 se alguma contagem difere)
+    if (opcoes.benchmark[0] != '\0')
+    {
+        int certos = benchmarkSintetico(opcoes.benchmark);
+        fecharEventos();
+        resumoCascata(&cascata);
+        fecharMetricas();
+        return certos ? 0 : 1;
+    }
+
+    // Entrada em bruto (stdin ou memória partilhada): uma única passagem, sem menu
+    bool aoVivo = (opcoes.entrada.tipo != FONTE_VIDEO);
+
     // Loop principal do programa (permite reprocessar vídeos)
     do
     {
         system("cls");
 
         // Apresenta o menu e permite escolher o vídeo; se 0, termina o programa
-        if (escolherVideo(videofile) == 0)
+        if (!aoVivo && escolherVideo(videofile) == 0)
         {
             break;
         }
@@ -51,51 +130,208 @@ int main(void)
         // Inicia temporização
         vc_timer();
 
-        // Abre o vídeo selecionado
         cv::VideoCapture capture;
-        capture.open(videofile);
+        DESCODIFICADOR* descodificador;
+        int profundidade = (opcoes.antecipar > 0) ? opcoes.antecipar : ANTECIPAR_FRAMES;
 
-        if (!capture.isOpened())
+        if (aoVivo)
         {
-            fprintf(stderr, "Erro ao abrir o ficheiro de vídeo!\n");
-            return 1;
+            // Frames em bruto lidos diretamente para o anel do descodificador
+            descodificador = abrirEntrada(&opcoes.entrada, profundidade);
+            if (descodificador == NULL)
+            {
+                fprintf(stderr, "Erro ao abrir a entrada de frames!\n");
+                fecharEventos();
+                fecharMetricas();
+                return 1;
+            }
+
+            video.ntotalframes = 0;
+            video.fps = (opcoes.entrada.fps > 0.0f) ? (int)opcoes.entrada.fps : 30;
+            video.width = opcoes.entrada.width;
+            video.height = opcoes.entrada.height;
         }
+        else
+        {
+            // Abre o vídeo selecionado (descodificação com várias threads, se o backend o permitir)
+            abrirVideo(capture, videofile);
+
+            if (!capture.isOpened())
+            {
+                fprintf(stderr, "Erro ao abrir o ficheiro de vídeo!\n");
+                fecharEventos();
+                fecharMetricas();
+                return 1;
+            }
 
-        // Obtém as propriedades do vídeo
-        video.ntotalframes = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_COUNT));
-        video.fps = static_cast<int>(capture.get(cv::CAP_PROP_FPS));
-        video.width = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH));
-        video.height = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+            // Obtém as propriedades do vídeo
+            video.ntotalframes = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_COUNT));
+            video.fps = static_cast<int>(capture.get(cv::CAP_PROP_FPS));
+            video.width = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH));
+            video.height = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+            // Descodificação antecipada do vídeo numa thread própria
+            descodificador = abrirDescodificador(&capture, profundidade, video.width, video.height);
+        }
 
         system("cls");
 
+        // Máscara do frame atual (reutilizada em todos os frames)
+        IVC* mascara = vc_image_new(video.width, video.height, 1, 255);
+
+        // Gravação opcional das máscaras (e etiquetas/frames) num ficheiro .vcr
+        VC_GRAVADOR* gravador = NULL;
+        if (opcoes.gravar[0] != '\0')
+        {
+            gravador = vc_gravador_abrir(opcoes.gravar, VC_REC_RLE);
+            if (gravador == NULL)
+            {
+                fprintf(stderr, "Erro ao criar o ficheiro de gravação!\n");
+            }
+        }
+
+        // Gravação opcional do vídeo anotado (ou só dos frames em torno de cada moeda contada)
+        ESCRITOR* escritor = NULL;
+        if (opcoes.saida[0] != '\0')
+        {
+            escritor = abrirEscritor(opcoes.saida, video.fps, video.width, video.height, opcoes.saidaEventos, opcoes.saidaEsperar);
+            if (escritor == NULL)
+            {
+                fprintf(stderr, "Erro ao criar o vídeo %s!\n", opcoes.saida);
+            }
+        }
+
+        // Detetor de movimento e blobs do último frame processado
+        MOVIMENTO movimento = { opcoes.movimento, 4, 32, NULL, 0, 0, 0 };
+        OVC* blobs = NULL;
+        int nblobs = 0;
+        int nframeBlobs = 0;                     ///< Frame em que os blobs foram medidos
+
+        // Cada vídeo começa sem moedas seguidas
+        iniciarRastreador(&rastreador);
+        memset(&cascata, 0, sizeof(CASCATA));
+
+        // Janela de visualização (thread própria; o processamento não espera pela janela)
+        ECRA* ecra = abrirEcra("Trabalho de Visao por Computador", opcoes.previsualizar);
+
+        // Decimação adaptativa (k = 1 enquanto não houver velocidade observada)
+        DECIMACAO decimacao;
+        iniciarDecimacao(&decimacao, opcoes.decimarAlvo);
+        int k = 1;
+
+        int nframeAnterior = 0;
+
         // Processamento frame a frame
         while (true)
         {
-            // Lê o próximo frame
-            if (!capture.read(frameMat))
+            // Próximo frame já descodificado (os frames saltados pela decimação só são avançados, sem descodificação)
+            cv::Mat* frame = obterFrame(descodificador, &video.nframe, &video.tempo);
+            if (frame == NULL)
                 break;
+            frameMat = *frame;
+            double inicioFrame = metricaRelogio();
+
+            decimacao.nlidos += video.nframe - nframeAnterior;
+            nframeAnterior = video.nframe;
 
-            // Atualiza o número do frame atual
-            video.nframe = static_cast<int>(capture.get(cv::CAP_PROP_POS_FRAMES));
+            // Grava o frame original antes de ser anotado
+            if (gravador != NULL && opcoes.gravarFrames)
+            {
+                IVC vista = { frameMat.data, frameMat.cols, frameMat.rows, 3, 256, (int)frameMat.step, 0, VC_BORDER_REPLICATE, 0 };
+                vc_gravador_escrever(gravador, &vista, video.nframe, VC_REC_FRAME);
+            }
 
-            // Processa o frame para identificar e contar moedas
-            filtrarMoedas(frameMat, &soma, total);
+            // Sem movimento, os blobs do último frame processado são reutilizados
+            if (opcoes.movimento <= 0.0f || verificarMovimento(&movimento, frameMat, blobs, nblobs, video.height / 4, video.nframe, &rastreador))
+            {
+                free(blobs);
+
+                double inicio = metricaRelogio();
+                if (opcoes.piramide > 1)
+                {
+                    // Segmenta a resolução reduzida e mede as moedas à resolução original
+                    blobs = detetarMoedasPiramide(frameMat, opcoes.piramide, mascara, &nblobs);
+                    metricaTempo(TEMPO_PIRAMIDE, inicio);
+                    vc_gravador_escrever(gravador, mascara, video.nframe, VC_REC_MASCARA);
+                }
+                else
+                {
+                    // Processa o frame para identificar as moedas
+                    segmentarMoedas(frameMat, mascara, 9);
+                    metricaTempo(TEMPO_SEGMENTACAO, inicio);
+                    vc_gravador_escrever(gravador, mascara, video.nframe, VC_REC_MASCARA);
+
+                    inicio = metricaRelogio();
+                    blobs = etiquetarMoedas(mascara, video.height / 4, &nblobs);
+                    metricaTempo(TEMPO_ETIQUETAGEM, inicio);
+
+                    // Após a etiquetagem, a máscara contém a imagem de etiquetas
+                    if (opcoes.gravarEtiquetas)
+                    {
+                        vc_gravador_escrever(gravador, mascara, video.nframe, VC_REC_ETIQUETAS);
+                    }
+                }
+                nframeBlobs = video.nframe;
+            }
+            else
+            {
+                metricaContar(METRICA_FRAMES_SEM_MOVIMENTO, 1);
+            }
+
+            // Desenha e conta as moedas (blobs reutilizados mantêm o frame em que foram medidos)
+            int contadas = total[8];
+            double inicio = metricaRelogio();
+            processarBlobs(frameMat, blobs, nblobs, nframeBlobs, &soma, total);
+            metricaTempo(TEMPO_ANALISE, inicio);
+
+            // Escolhe quantos frames avançar até ao próximo frame processado
+            if (opcoes.decimar)
+            {
+                k = calcularDecimacao(&decimacao, &rastreador, nframeBlobs);
+                saltarFrames(descodificador, k);
+            }
 
             // Exibe o resumo atualizado no próprio frame
+            inicio = metricaRelogio();
             resumoFrame(frameMat, total, soma, video.width, video.height, video.ntotalframes, video.fps, video.nframe);
+            mostrarEcra(ecra, frameMat);
+            escreverEscritor(escritor, frameMat, total[8] != contadas);
+            metricaTempo(TEMPO_APRESENTACAO, inicio);
+            metricaTempo(TEMPO_FRAME, inicioFrame);
+
+            // Devolve o frame ao anel do descodificador
+            libertarFrame(descodificador);
 
-            // Espera tecla, sai do loop se for ESC
-            key = cv::waitKey(10);
+            // Sai do loop se for premido ESC
+            key = teclaEcra(ecra);
             if (key == 27) break;
         }
 
         // Liberta o vídeo e fecha a janela
+        fecharDescodificador(descodificador);
         capture.release();
-        cv::destroyWindow("Trabalho de Visao por Computador");
+        vc_image_free(mascara);
+        vc_image_free(movimento.referencia);
+        free(blobs);
+        if (gravador != NULL && !vc_gravador_fechar(gravador))
+        {
+            fprintf(stderr, "Erro ao escrever o ficheiro de gravação!\n");
+        }
+        fecharEcra(ecra);
+        fecharEscritor(escritor);
 
-        // Exibe o resumo final no terminal
+        // Exibe o resumo final no terminal (depois das moedas ainda no registo de eventos)
+        esvaziarEventos();
         resumoTerminal(total, soma);
+        resumoCascata(&cascata);
+        if (opcoes.movimento > 0.0f)
+        {
+            resumoMovimento(&movimento);
+        }
+        if (opcoes.decimar)
+        {
+            resumoDecimacao(&decimacao);
+        }
 
          // Finaliza temporização
         vc_timer();
@@ -105,9 +341,15 @@ int main(void)
         soma = 0.0f;
 
         // Pausa aguardando interação do utilizador antes de recomeçar o loop
-        system("pause");
+        if (!aoVivo)
+        {
+            system("pause");
+        }
+
+    } while (!aoVivo);
 
-    } while (true);
+    fecharEventos();
+    fecharMetricas();
 
     return 0;
 }
@@ -13,13 +13,68 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <stdint.h>
+#include <limits.h>
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <opencv2/highgui.hpp>
 
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <intrin.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
 #include "vc.hpp"
 
 #define MAX(a, b) (a > b ? a : b)
 #define MIN(a, b) (a < b ? a : b)
 
+// SSE2 existe em todos os processadores x86-64 (e é o mínimo do MSVC em x86)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VC_SSE2
+#endif
+
+// Contador de tempo do processador (__rdtsc) para o microbenchmark: intrin.h no MSVC, x86intrin.h no GCC e Clang
+#if defined(_M_X64) || defined(_M_IX86)
+#define VC_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define VC_RDTSC
+#endif
+
+// Variantes SIMD escolhidas em tempo de execução (ver vc_simd_suportado): o GCC e o Clang só compilam as
+// instruções de cada nível nas funções com o atributo target; o MSVC aceita as intrínsecas em qualquer função
+#ifdef VC_SSE2
+#include <immintrin.h>
+#define VC_SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VC_ALVO(isa)
+#define VC_NAO_EXPANDIR __declspec(noinline)
+#else
+#include <cpuid.h>
+#define VC_ALVO(isa) __attribute__((target(isa)))
+#define VC_NAO_EXPANDIR __attribute__((noinline))
+#endif
+#else
+#define VC_NAO_EXPANDIR
+#endif
+
 #pragma region Funções : Alocar e Libertar uma Imagem
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //            FUNÇÕES: ALOCAR E LIBERTAR UMA IMAGEM
@@ -39,6 +94,9 @@ IVC* vc_image_new(int width, int height, int channels, int levels)
 	image->channels = channels;
 	image->levels = levels;
 	image->bytesperline = image->width * image->channels;
+	image->border = 0;
+	image->bordertype = VC_BORDER_REPLICATE;
+	image->bordervalue = 0;
 	image->data = (unsigned char*)malloc(image->width * image->height * image->channels * sizeof(char));
 
 	if (image->data == NULL)
@@ -50,6 +108,38 @@ IVC* vc_image_new(int width, int height, int channels, int levels)
 }
 
 
+// Alocar memória para uma imagem com uma borda de guarda de `border` píxeis a toda a volta.
+// data aponta para o primeiro píxel da imagem; as linhas têm bytesperline = (width + 2 * border) * channels.
+IVC* vc_image_new_border(int width, int height, int channels, int levels, int border, int bordertype, int bordervalue)
+{
+	if ((border < 0) || (bordertype < VC_BORDER_REPLICATE) || (bordertype > VC_BORDER_REFLECT)) return NULL;
+	if ((levels <= 0) || (levels > 256)) return NULL;
+
+	IVC* image = (IVC*)malloc(sizeof(IVC));
+
+	if (image == NULL) return NULL;
+
+	image->width = width;
+	image->height = height;
+	image->channels = channels;
+	image->levels = levels;
+	image->bytesperline = (width + 2 * border) * channels;
+	image->border = border;
+	image->bordertype = bordertype;
+	image->bordervalue = bordervalue;
+
+	unsigned char* base = (unsigned char*)malloc((size_t)image->bytesperline * (height + 2 * border));
+	if (base == NULL)
+	{
+		image->data = NULL;
+		return vc_image_free(image);
+	}
+	image->data = base + border * image->bytesperline + border * channels;
+
+	return image;
+}
+
+
 // Libertar memória de uma imagem
 IVC* vc_image_free(IVC* image)
 {
@@ -57,7 +147,7 @@ IVC* vc_image_free(IVC* image)
 	{
 		if (image->data != NULL)
 		{
-			free(image->data);
+			free(image->data - image->border * image->bytesperline - image->border * image->channels);
 			image->data = NULL;
 		}
 
@@ -70,6 +160,87 @@ IVC* vc_image_free(IVC* image)
 
 #pragma endregion
 
+#pragma region Função: vc_image_fill_border
+
+// Índice (0..n-1) que preenche a posição i fora da imagem (replicar ou refletir; n >= 1)
+static int vc_border_index(int i, int n, int bordertype)
+{
+	if (bordertype == VC_BORDER_REPLICATE || n == 1) return MIN(MAX(i, 0), n - 1);
+
+	// Reflexão sem repetir o píxel do limite (repetida se a borda for maior do que a imagem)
+	while ((i < 0) || (i >= n))
+	{
+		if (i < 0) i = -i;
+		if (i >= n) i = 2 * (n - 1) - i;
+	}
+	return i;
+}
+
+/**
+ * Função: vc_image_fill_border
+ * ----------------------------
+ * Preenche a borda de guarda de uma imagem criada por vc_image_new_border, segundo o tipo de borda
+ * da imagem (replicar o píxel do limite, valor constante ou reflexão). Deve ser chamada depois de a imagem
+ * ser escrita; os operadores de vizinhança voltam a preenchê-la nas imagens de saída com borda.
+ *
+ * Parâmetros:
+ *   image - imagem com borda (sem borda não há nada a fazer)
+ *
+ * Retorna:
+ *   1 se a borda foi preenchida (ou a imagem não tem borda), 0 em caso de erro.
+ */
+int vc_image_fill_border(IVC* image)
+{
+	if ((image == NULL) || (image->data == NULL) || (image->width <= 0) || (image->height <= 0)) return 0;
+	if (image->border == 0) return 1;
+
+	int border = image->border;
+	int channels = image->channels;
+	int width = image->width;
+	int height = image->height;
+	int bytesperline = image->bytesperline;
+	int bytes = (width + 2 * border) * channels;	// Linha completa, com as bordas laterais
+	int x, y;
+
+	// Colunas à esquerda e à direita de cada linha da imagem
+	for (y = 0; y < height; y++)
+	{
+		unsigned char* linha = image->data + y * bytesperline;
+
+		if (image->bordertype == VC_BORDER_CONSTANT)
+		{
+			memset(linha - border * channels, image->bordervalue, border * channels);
+			memset(linha + width * channels, image->bordervalue, border * channels);
+			continue;
+		}
+		for (x = 1; x <= border; x++)
+		{
+			memcpy(linha - x * channels, linha + vc_border_index(-x, width, image->bordertype) * channels, channels);
+			memcpy(linha + (width - 1 + x) * channels, linha + vc_border_index(width - 1 + x, width, image->bordertype) * channels, channels);
+		}
+	}
+
+	// Linhas acima e abaixo (já com as bordas laterais)
+	for (y = 1; y <= border; y++)
+	{
+		unsigned char* acima = image->data - y * bytesperline - border * channels;
+		unsigned char* abaixo = image->data + (height - 1 + y) * bytesperline - border * channels;
+
+		if (image->bordertype == VC_BORDER_CONSTANT)
+		{
+			memset(acima, image->bordervalue, bytes);
+			memset(abaixo, image->bordervalue, bytes);
+			continue;
+		}
+		memcpy(acima, image->data + vc_border_index(-y, height, image->bordertype) * bytesperline - border * channels, bytes);
+		memcpy(abaixo, image->data + vc_border_index(height - 1 + y, height, image->bordertype) * bytesperline - border * channels, bytes);
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
 #pragma region Funcões : Leitura e Escrita de imagens
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //    FUNÇÕES: LEITURA E ESCRITA DE IMAGENS (PBM, PGM E PPM)
@@ -371,2981 +542,10349 @@ int vc_write_image(char* filename, IVC* image)
 
 #pragma endregion
 
-#pragma region Função: vc_gray_negative
-/**
- * Função: vc_gray_negative
- * -------------------------
- * Aplica o negativo a uma imagem em tons de cinzento (grayscale),
- * ou seja, inverte a intensidade de cada pixel: pixel = 255 - pixel.
- *
- * Parâmetros:
- *   srddst - ponteiro para a estrutura IVC contendo a imagem a ser processada
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
+#pragma region Funções : Gravação de sequências de imagens (VCR)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//      FUNÇÕES: GRAVAÇÃO DE SEQUÊNCIAS DE IMAGENS (VCR)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-int vc_gray_negative(IVC* srddst)
+// Formato de um ficheiro .vcr (inteiros em little-endian):
+//   Cabeçalho : "VCR1" + versão + 8 bytes reservados                (16 bytes)
+//   Registos  : VCR_REGISTO + dados (em bruto ou RLE), por ordem de escrita
+//   Índice    : um VCR_INDICE por registo                            (16 bytes cada)
+//   Rodapé    : posição do índice + número de registos + "VCRI"      (16 bytes)
+//
+// O ficheiro só é acrescentado. O índice e o rodapé são escritos no fecho; se faltarem
+// (programa terminado abruptamente), o leitor reconstrói o índice percorrendo os registos.
+//
+// RLE: sequência de pares (valor, comprimento), com o comprimento codificado em grupos de
+// 7 bits (o bit mais significativo indica que há mais um byte). Uma máscara 0/255 com poucos
+// discos reduz-se a algumas centenas de bytes por frame.
+
+#ifdef _WIN32
+#define vcr_fseek _fseeki64
+#define vcr_ftell _ftelli64
+#else
+#define vcr_fseek fseeko
+#define vcr_ftell ftello
+#endif
+
+#define VCR_FILA_MAX 64		// Número máximo de imagens à espera de escrita
+
+typedef struct {
+	uint32_t nframe;
+	int32_t width, height;
+	uint16_t channels, levels;
+	uint16_t tipo, compressao;
+	uint32_t tamanho;			// Número de bytes de dados que se seguem
+} VCR_REGISTO;
+
+typedef struct {
+	uint64_t offset;			// Posição do VCR_REGISTO no ficheiro
+	uint32_t nframe;
+	uint16_t tipo;
+	uint16_t reservado;
+} VCR_INDICE;
+
+typedef struct {
+	uint64_t offsetindice;
+	uint32_t nregistos;
+	char magic[4];
+} VCR_RODAPE;
+
+// Cabeçalho de registo plausível (os ficheiros lidos não são de confiança: dimensões e tipos são
+// verificados antes de alocar a imagem ou de aceitar o registo na reconstrução do índice)
+static int vcr_registo_valido(const VCR_REGISTO* registo)
 {
-	unsigned char* data = (unsigned char*)srddst->data;
-	int width = srddst->width;
-	int height = srddst->height;
-	int channels = srddst->channels;
-	int bytesperline = srddst->bytesperline;
-	int x, y;
-	long int pos;
+	if ((registo->width <= 0) || (registo->width > 65535) || (registo->height <= 0) || (registo->height > 65535)) return 0;
+	if ((registo->channels < 1) || (registo->channels > 4) || (registo->levels < 1) || (registo->levels > 256)) return 0;
+	if ((registo->tipo > VC_REC_FRAME) || (registo->compressao > VC_REC_RLE)) return 0;
 
-	// Verifica se os parâmetros são válidos
-	if (width <= 0 || height <= 0 || data == NULL)
-		return 0;
+	return 1;
+}
 
-	// Verifica se a imagem é em tons de cinzento
-	if (channels != 1)
-		return 0;
+typedef struct {
+	VCR_REGISTO registo;
+	unsigned char* dados;		// Cópia da imagem (bytesperline = width * channels)
+} VCR_PEDIDO;
+
+struct VC_GRAVADOR {
+	FILE* file;
+	int compressao;
+	uint64_t posicao;			// Posição atual de escrita (ftell é limitado a 2 GB no Windows)
+	std::vector<VCR_INDICE> indice;
+	std::deque<VCR_PEDIDO> fila;
+	std::mutex mutex;
+	std::condition_variable filacheia;	// Acorda a thread de escrita
+	std::condition_variable filalivre;	// Acorda quem espera por espaço na fila
+	bool terminar;
+	int erro;
+	std::thread thread;
+};
+
+struct VC_LEITOR {
+	FILE* file;
+	std::vector<VCR_INDICE> indice;
+};
+
+
+// Codifica em RLE; retorna o número de bytes escritos, ou -1 se não couber em maxsize
+long int vcr_rle_encode(const unsigned char* src, long int size, unsigned char* dst, long int maxsize)
+{
+	long int i = 0, n = 0;
+	unsigned long int run;
 
-	// Percorre todos os pixels da imagem
-	for (y = 0; y < height; y++)
+	while (i < size)
 	{
-		for (x = 0; x < width; x++)
-		{
-			// Calcula a posição do pixel atual
-			pos = x * channels + y * bytesperline;
+		unsigned char valor = src[i];
 
-			// Inverte a intensidade do pixel (negativo)
-			data[pos] = 255 - data[pos];
+		for (run = 1; (i + (long int)run < size) && (src[i + run] == valor); run++);
+		i += run;
+
+		if (n + 6 > maxsize) return -1;
+
+		dst[n++] = valor;
+		while (run >= 0x80)
+		{
+			dst[n++] = (unsigned char)(run | 0x80);
+			run >>= 7;
 		}
+		dst[n++] = (unsigned char)run;
 	}
 
-	return 1;
+	return n;
 }
-#pragma endregion
-
-#pragma region Função: vc_rgb_negative
 
-/**
- * Função: vc_rgb_negative
- * -----------------------
- * Aplica o negativo a uma imagem RGB (3 canais), invertendo os valores
- * de cada componente de cor (R, G e B) de cada pixel: componente = 255 - componente.
- *
- * Parâmetros:
- *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
 
-int vc_rgb_negative(IVC* srcdst)
+// Descodifica RLE; retorna 1 se foram gerados exatamente size bytes
+int vcr_rle_decode(const unsigned char* src, long int srcsize, unsigned char* dst, long int size)
 {
-	int x, y;
-	long int pos;
-	unsigned char* data = (unsigned char*)srcdst->data;
-
-	// Verifica se o ponteiro para a imagem é válido
-	if (srcdst == NULL) return 0;
+	long int i = 0, n = 0;
 
-	// Percorre todos os píxeis da imagem
-	for (y = 0; y < srcdst->height; y++)
+	while (i < srcsize)
 	{
-		for (x = 0; x < srcdst->width; x++)
-		{
-			// Calcula a posição do pixel no array de dados
-			pos = srcdst->bytesperline * y + 3 * x;
+		unsigned char valor = src[i++];
+		unsigned long int run = 0;
+		int shift = 0;
 
-			// Inverte os valores dos três canais (R, G, B)
-			data[pos] = 255 - data[pos];     // Vermelho
-			data[pos + 1] = 255 - data[pos + 1]; // Verde
-			data[pos + 2] = 255 - data[pos + 2]; // Azul
+		while ((i < srcsize) && (src[i] & 0x80))
+		{
+			run |= (unsigned long int)(src[i++] & 0x7F) << shift;
+			shift += 7;
 		}
+		if (i >= srcsize) return 0;
+		run |= (unsigned long int)src[i++] << shift;
+
+		if (n + (long int)run > size) return 0;
+		memset(dst + n, valor, run);
+		n += run;
 	}
 
-	return 1;
+	return n == size;
 }
 
-#pragma endregion
-
-#pragma region Função: vc_rgb_get_red_gray
-/**
- * Função: vc_rgb_get_red_gray
- * ---------------------------
- * Converte uma imagem RGB para tons de cinzento utilizando apenas o canal vermelho (R).
- * O valor do vermelho de cada pixel é copiado para os canais verde (G) e azul (B),
- * criando uma imagem cinzenta baseada apenas na intensidade do vermelho.
- *
- * Parâmetros:
- *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
 
-int vc_rgb_get_red_gray(IVC* srcdst)
+// Thread de escrita: retira pedidos da fila, comprime-os e escreve-os no ficheiro
+void vcr_gravador_thread(VC_GRAVADOR* gravador)
 {
-	int x, y;
-	long int pos;
+	std::vector<unsigned char> rle;
 
-	// Acede aos dados da imagem como vetor de bytes
-	unsigned char* data = (unsigned char*)srcdst->data;
+	for (;;)
+	{
+		VCR_PEDIDO pedido;
 
-	// Verifica se o ponteiro para a estrutura é válido
-	if (srcdst == NULL) return 0;
+		{
+			std::unique_lock<std::mutex> lock(gravador->mutex);
+			gravador->filacheia.wait(lock, [gravador] { return gravador->terminar || !gravador->fila.empty(); });
+			if (gravador->fila.empty()) break;
+			pedido = gravador->fila.front();
+			gravador->fila.pop_front();
+		}
+		gravador->filalivre.notify_one();
 
-	// Percorre todos os pixels da imagem
-	for (y = 0; y < srcdst->height; y++)
-	{
-		for (x = 0; x < srcdst->width; x++)
+		const unsigned char* dados = pedido.dados;
+		long int size = (long int)pedido.registo.width * pedido.registo.height * pedido.registo.channels;
+
+		// Só as imagens de 1 canal (máscaras, etiquetas) são comprimidas
+		if ((gravador->compressao == VC_REC_RLE) && (pedido.registo.channels == 1))
 		{
-			// Calcula a posição do pixel no array de dados
-			pos = srcdst->bytesperline * y + 3 * x;
+			rle.resize(size);
+			long int n = vcr_rle_encode(pedido.dados, size, rle.data(), size);
+			if (n > 0)
+			{
+				pedido.registo.compressao = VC_REC_RLE;
+				dados = rle.data();
+				size = n;
+			}
+		}
+		pedido.registo.tamanho = (uint32_t)size;
 
-			// Copia o valor do canal vermelho para os canais verde e azul
-			// (sem alterar o vermelho, mantendo o valor original)
-			data[pos] = data[pos];           // Vermelho (mantém)
-			data[pos + 1] = data[pos];       // Verde = Vermelho
-			data[pos + 2] = data[pos];       // Azul  = Vermelho
+		VCR_INDICE entrada = { gravador->posicao, pedido.registo.nframe, pedido.registo.tipo, 0 };
+
+		if ((fwrite(&pedido.registo, sizeof(VCR_REGISTO), 1, gravador->file) != 1) ||
+			(fwrite(dados, 1, size, gravador->file) != (size_t)size))
+		{
+			gravador->erro = 1;
+		}
+		else
+		{
+			gravador->indice.push_back(entrada);
+			gravador->posicao += sizeof(VCR_REGISTO) + size;
 		}
-	}
 
-	return 1;
+		free(pedido.dados);
+	}
 }
-#pragma endregion
 
-#pragma region Função: vc_rgb_get_green_gray
 
 /**
- * Função: vc_rgb_get_green_gray
- * -----------------------------
- * Converte uma imagem RGB para tons de cinzento utilizando apenas o canal verde (G).
- * O valor do verde de cada pixel é copiado para os canais vermelho (R) e azul (B),
- * criando uma imagem cinzenta baseada apenas na intensidade do verde.
+ * Função: vc_gravador_abrir
+ * -------------------------
+ * Cria um ficheiro .vcr e arranca a thread que escreve as imagens em segundo plano.
  *
  * Parâmetros:
- *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
+ *   filename   - nome do ficheiro a criar
+ *   compressao - VC_REC_RAW ou VC_REC_RLE (só aplicada a imagens de 1 canal)
  *
  * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
+ *   Apontador para o gravador, ou NULL em caso de erro.
  */
-
-int vc_rgb_get_green_gray(IVC* srcdst)
+VC_GRAVADOR* vc_gravador_abrir(const char* filename, int compressao)
 {
-	int x, y;
-	long int pos;
+	unsigned char cabecalho[16] = { 'V', 'C', 'R', '1', 1, 0, 0, 0 };
+	FILE* file = fopen(filename, "wb");
 
-	// Acede aos dados da imagem como vetor de bytes
-	unsigned char* data = (unsigned char*)srcdst->data;
-
-	// Verifica se o ponteiro para a imagem é válido
-	if (srcdst == NULL) return 0;
+	if (file == NULL) return NULL;
 
-	// Percorre todos os pixels da imagem
-	for (y = 0; y < srcdst->height; y++)
+	if (fwrite(cabecalho, sizeof(cabecalho), 1, file) != 1)
 	{
-		for (x = 0; x < srcdst->width; x++)
-		{
-			// Calcula a posição do pixel no array de dados
-			pos = srcdst->bytesperline * y + 3 * x;
-
-			// Copia o valor do canal verde para os outros canais
-			data[pos] = data[pos + 1]; // Vermelho = Verde
-			data[pos + 1] = data[pos + 1]; // Verde (mantém)
-			data[pos + 2] = data[pos + 1]; // Azul = Verde
-		}
+		fclose(file);
+		return NULL;
 	}
 
-	return 1;
-}
+	VC_GRAVADOR* gravador = new VC_GRAVADOR();
+	gravador->file = file;
+	gravador->compressao = compressao;
+	gravador->posicao = sizeof(cabecalho);
+	gravador->terminar = false;
+	gravador->erro = 0;
+	gravador->thread = std::thread(vcr_gravador_thread, gravador);
 
-#pragma endregion
+	return gravador;
+}
 
-#pragma region Função: vc_rgb_get_blue_gray
 
 /**
- * Função: vc_rgb_get_blue_gray
+ * Função: vc_gravador_escrever
  * ----------------------------
- * Converte uma imagem RGB para tons de cinzento utilizando apenas o canal azul (B).
- * O valor do azul de cada pixel é copiado para os canais vermelho (R) e verde (G),
- * criando uma imagem cinzenta baseada apenas na intensidade do azul.
+ * Copia a imagem e coloca-a na fila de escrita. A compressão e a escrita em disco são feitas
+ * pela thread do gravador; esta função só bloqueia se a fila estiver cheia (VCR_FILA_MAX).
  *
  * Parâmetros:
- *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
+ *   gravador - gravador devolvido por vc_gravador_abrir
+ *   image    - imagem a gravar (pode ser uma vista sobre um cv::Mat, com bytesperline = step)
+ *   nframe   - número do frame a que a imagem pertence
+ *   tipo     - VC_REC_MASCARA, VC_REC_ETIQUETAS ou VC_REC_FRAME
  *
  * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
+ *   1 se a imagem foi colocada na fila, 0 caso contrário.
  */
-
-int vc_rgb_get_blue_gray(IVC* srcdst)
+int vc_gravador_escrever(VC_GRAVADOR* gravador, IVC* image, int nframe, int tipo)
 {
-	int x, y;
-	long int pos;
-
-	// Acede aos dados da imagem como vetor de bytes
-	unsigned char* data = (unsigned char*)srcdst->data;
-
-	// Verifica se o ponteiro para a imagem é válido
-	if (srcdst == NULL) return 0;
-
-	// Percorre todos os pixels da imagem
-	for (y = 0; y < srcdst->height; y++)
+	int y;
+	long int linha;
+	VCR_PEDIDO pedido;
+
+	if ((gravador == NULL) || (image == NULL) || (image->data == NULL)) return 0;
+	if ((image->width <= 0) || (image->height <= 0)) return 0;
+
+	linha = image->width * image->channels;
+
+	pedido.registo.nframe = nframe;
+	pedido.registo.width = image->width;
+	pedido.registo.height = image->height;
+	pedido.registo.channels = image->channels;
+	pedido.registo.levels = image->levels;
+	pedido.registo.tipo = tipo;
+	pedido.registo.compressao = VC_REC_RAW;
+	pedido.registo.tamanho = 0;
+	pedido.dados = (unsigned char*)malloc(linha * image->height);
+	if (pedido.dados == NULL) return 0;
+
+	// Copia linha a linha (a imagem de origem pode ter bytesperline > width * channels)
+	for (y = 0; y < image->height; y++)
 	{
-		for (x = 0; x < srcdst->width; x++)
-		{
-			// Calcula a posição do pixel no array de dados
-			pos = srcdst->bytesperline * y + 3 * x;
+		memcpy(pedido.dados + y * linha, image->data + y * image->bytesperline, linha);
+	}
 
-			// Copia o valor do canal azul para os outros canais
-			data[pos] = data[pos + 2]; // Vermelho = Azul
-			data[pos + 1] = data[pos + 2]; // Verde = Azul
-			data[pos + 2] = data[pos + 2]; // Azul (mantém)
-		}
+	{
+		std::unique_lock<std::mutex> lock(gravador->mutex);
+		gravador->filalivre.wait(lock, [gravador] { return gravador->fila.size() < VCR_FILA_MAX; });
+		gravador->fila.push_back(pedido);
 	}
+	gravador->filacheia.notify_one();
 
 	return 1;
 }
 
-#pragma endregion
-
-#pragma region Função: vc_rgb_to_gray
 
 /**
- * Função: vc_rgb_to_gray
- * ----------------------
- * Converte uma imagem RGB (3 canais) para uma imagem em tons de cinzento (1 canal),
- * utilizando a fórmula de luminância ponderada:
- * Gray = 0.299 * R + 0.587 * G + 0.114 * B
+ * Função: vc_gravador_fechar
+ * --------------------------
+ * Espera que a fila de escrita fique vazia, escreve o índice e o rodapé e fecha o ficheiro.
  *
  * Parâmetros:
- *   src - ponteiro para a imagem de entrada (RGB)
- *   dst - ponteiro para a imagem de saída (grayscale)
+ *   gravador - gravador a fechar (é libertado)
  *
  * Retorna:
- *   1 se a conversão for bem-sucedida, 0 caso contrário
+ *   1 se todas as imagens foram gravadas, 0 caso contrário.
  */
-
-int vc_rgb_to_gray(IVC* src, IVC* dst)
+int vc_gravador_fechar(VC_GRAVADOR* gravador)
 {
-	int x, y;
-	long int pos;
+	int ret;
 
-	// Ponteiros para os dados das imagens de origem e destino
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
+	if (gravador == NULL) return 0;
 
-	// Verifica se os ponteiros são válidos
-	if (src == NULL || dst == NULL) return 0;
+	{
+		std::lock_guard<std::mutex> lock(gravador->mutex);
+		gravador->terminar = true;
+	}
+	gravador->filacheia.notify_one();
+	gravador->thread.join();
 
-	// Verifica se a imagem de origem tem 3 canais e a de destino tem 1
-	if (src->channels != 3 || dst->channels != 1) return 0;
+	VCR_RODAPE rodape = { gravador->posicao, (uint32_t)gravador->indice.size(), { 'V', 'C', 'R', 'I' } };
 
-	// Percorre todos os píxeis da imagem
-	for (y = 0; y < src->height; y++)
+	if (!gravador->indice.empty() &&
+		(fwrite(gravador->indice.data(), sizeof(VCR_INDICE), gravador->indice.size(), gravador->file) != gravador->indice.size()))
 	{
-		for (x = 0; x < src->width; x++)
-		{
-			// Calcula a posição do pixel no array da imagem RGB
-			pos = y * src->bytesperline + x * src->channels;
-
-			// Aplica a fórmula da luminância e guarda o valor na imagem grayscale
-			datadst[y * dst->bytesperline + x] = (unsigned char)(0.299 * datasrc[pos] + 0.587 * datasrc[pos + 1] + 0.114 * datasrc[pos + 2]);
-		}
+		gravador->erro = 1;
+	}
+	if (fwrite(&rodape, sizeof(VCR_RODAPE), 1, gravador->file) != 1)
+	{
+		gravador->erro = 1;
 	}
 
-	return 1;
+	fclose(gravador->file);
+
+	ret = !gravador->erro;
+	delete gravador;
+
+	return ret;
 }
 
-#pragma endregion
 
-#pragma region Função: vc_rgb_to_hsv
 /**
- * Função: vc_rgb_to_hsv
- * ---------------------
- * Converte uma imagem RGB (3 canais) para o espaço de cor HSV (Hue, Saturation, Value).
- * Os valores HSV resultantes são armazenados também como imagem com 3 canais (cada componente em [0,255]).
+ * Função: vc_leitor_abrir
+ * -----------------------
+ * Abre um ficheiro .vcr e carrega o seu índice (ou reconstrói-o, se o ficheiro não foi fechado ou o
+ * rodapé não for coerente com o tamanho do ficheiro).
  *
  * Parâmetros:
- *   src - ponteiro para a imagem RGB de entrada
- *   dst - ponteiro para a imagem HSV de saída
+ *   filename - nome do ficheiro
  *
  * Retorna:
- *   1 se a conversão for bem-sucedida, 0 caso contrário
+ *   Apontador para o leitor, ou NULL em caso de erro.
  */
-
-int vc_rgb_to_hsv(IVC* src, IVC* dst)
+VC_LEITOR* vc_leitor_abrir(const char* filename)
 {
-	int x, y;
-	long int pos;
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	float r, g, b, hue, saturation, value, min, max, delta;
+	unsigned char cabecalho[16];
+	VCR_RODAPE rodape;
+	FILE* file = fopen(filename, "rb");
 
-	// Verificações básicas de ponteiros e canais
-	if (src == NULL || dst == NULL) return 0;
-	if (src->channels != 3 || dst->channels != 3) return 0;
+	if (file == NULL) return NULL;
 
-	// Percorre todos os pixels da imagem
-	for (y = 0; y < src->height; y++)
+	if ((fread(cabecalho, sizeof(cabecalho), 1, file) != 1) || (memcmp(cabecalho, "VCR1", 4) != 0))
 	{
-		for (x = 0; x < src->width; x++)
-		{
-			pos = y * src->bytesperline + x * src->channels;
+#ifdef VC_DEBUG
+		printf("ERROR -> vc_leitor_abrir():\n\tFile is not a valid VCR file.\n");
+#endif
+		fclose(file);
+		return NULL;
+	}
 
-			// Obtém os valores RGB e normaliza para [0,1]
-			r = (float)datasrc[pos];
-			g = (float)datasrc[pos + 1];
-			b = (float)datasrc[pos + 2];
-			r /= 255.0f;
-			g /= 255.0f;
-			b /= 255.0f;
+	VC_LEITOR* leitor = new VC_LEITOR();
+	leitor->file = file;
 
-			// Calcula os valores máximo e mínimo entre R, G, B
-			max = (r > g) ? ((r > b) ? r : b) : ((g > b) ? g : b);
-			min = (r < g) ? ((r < b) ? r : b) : ((g < b) ? g : b);
-			delta = max - min;
+	// Tamanho do ficheiro (o fseek aceita posições depois do fim, por isso as posições lidas são comparadas com ele)
+	uint64_t tamanho = 0;
+	int indiceValido = 0;
 
-			// Valor (V) corresponde ao máximo dos canais RGB
-			value = max;
+	if (vcr_fseek(file, 0, SEEK_END) == 0) tamanho = (uint64_t)vcr_ftell(file);
 
-			// Saturação (S)
-			if (max > 0.0f)
-				saturation = delta / max;
-			else
-				saturation = 0.0f;
+	if ((tamanho >= sizeof(cabecalho) + sizeof(VCR_RODAPE)) &&
+		(vcr_fseek(file, -(long int)sizeof(VCR_RODAPE), SEEK_END) == 0) &&
+		(fread(&rodape, sizeof(VCR_RODAPE), 1, file) == 1) && (memcmp(rodape.magic, "VCRI", 4) == 0))
+	{
+		// O rodapé pode estar corrompido: o índice tem de caber entre o cabeçalho e o rodapé antes de ser alocado
+		uint64_t fim = tamanho - sizeof(VCR_RODAPE);
 
-			// Matiz (H)
-			if (delta == 0)
-				hue = 0.0f; // Sem matiz (cor neutra)
-			else
-			{
-				if (r == max) hue = (g - b) / delta;
-				else if (g == max) hue = 2.0f + (b - r) / delta;
-				else hue = 4.0f + (r - g) / delta;
+		if ((rodape.offsetindice >= sizeof(cabecalho)) && (rodape.offsetindice <= fim) &&
+			((uint64_t)rodape.nregistos <= (fim - rodape.offsetindice) / sizeof(VCR_INDICE)))
+		{
+			leitor->indice.resize(rodape.nregistos);
+			indiceValido = (rodape.nregistos == 0) ||
+				((vcr_fseek(file, rodape.offsetindice, SEEK_SET) == 0) &&
+				(fread(leitor->indice.data(), sizeof(VCR_INDICE), rodape.nregistos, file) == rodape.nregistos));
+			if (!indiceValido) leitor->indice.clear();
+		}
+	}
 
-				hue *= 60.0f;
-				if (hue < 0.0f) hue += 360.0f;
-			}
+	if (!indiceValido)
+	{
+		// Sem rodapé válido: percorre os registos até ao primeiro que esteja incompleto
+		VCR_REGISTO registo;
+		uint64_t posicao = sizeof(cabecalho);
 
-			// Converte H, S e V para a escala de 0 a 255
-			datadst[pos] = (unsigned char)(hue / 360.0f * 255.0f);  // H
-			datadst[pos + 1] = (unsigned char)(saturation * 255.0f);    // S
-			datadst[pos + 2] = (unsigned char)(value * 255.0f);         // V
+		vcr_fseek(file, posicao, SEEK_SET);
+		while (fread(&registo, sizeof(VCR_REGISTO), 1, file) == 1)
+		{
+			if (!vcr_registo_valido(&registo)) break;
+			if (posicao + sizeof(VCR_REGISTO) + registo.tamanho > tamanho) break;
+			if (vcr_fseek(file, registo.tamanho, SEEK_CUR) != 0) break;
+
+			VCR_INDICE entrada = { posicao, registo.nframe, registo.tipo, 0 };
+			leitor->indice.push_back(entrada);
+			posicao += sizeof(VCR_REGISTO) + registo.tamanho;
 		}
 	}
 
-	return 1;  // Sucesso
+	return leitor;
 }
 
 
-#pragma endregion
+int vc_leitor_nregistos(VC_LEITOR* leitor)
+{
+	if (leitor == NULL) return 0;
 
-#pragma region Função: vc_hsv_segmentation
-/**
- * Função: vc_hsv_segmentation
- * ---------------------------
- * Realiza a segmentação de uma imagem HSV com base em intervalos de H (matiz), S (saturação) e V (valor).
- * Pixels dentro do intervalo definido são marcados como "1" (ou valor máximo em `dst->levels - 1`), os restantes são definidos como 0.
- * A imagem de destino deve ser binária (1 canal).
- *
- * Parâmetros:
- *   src   - imagem HSV de entrada (3 canais)
- *   dst   - imagem binária de saída (1 canal)
- *   hmin  - valor mínimo de matiz (H), em graus (0–360)
- *   hmax  - valor máximo de matiz (H), em graus (0–360)
- *   smin  - saturação mínima (0–100)
- *   smax  - saturação máxima (0–100)
- *   vmin  - valor mínimo de brilho (0–100)
- *   vmax  - valor máximo de brilho (0–100)
- *
- * Retorna:
- *   1 se a segmentação for bem-sucedida, 0 caso contrário
- */
+	return (int)leitor->indice.size();
+}
 
-int vc_hsv_segmentation(IVC* src, IVC* dst, int hmin, int hmax, int smin, int smax, int vmin, int vmax)
+
+// Obtém o número do frame e o tipo de um registo sem ler os dados
+int vc_leitor_info(VC_LEITOR* leitor, int indice, int* nframe, int* tipo)
 {
-	if (!src || !dst || src->channels != 3 || dst->channels != 1)
-		return 0;
+	if ((leitor == NULL) || (indice < 0) || (indice >= (int)leitor->indice.size())) return 0;
 
-	int x, y, i = 0;
-	for (y = 0; y < src->height; y++)
-	{
-		for (x = 0; x < src->width; x++, i += 3)
-		{
-			int h = src->data[i];
-			int s = src->data[i + 1];
-			int v = src->data[i + 2];
-			int pos = y * dst->bytesperline + x;
+	if (nframe != NULL) *nframe = leitor->indice[indice].nframe;
+	if (tipo != NULL) *tipo = leitor->indice[indice].tipo;
 
-			if (h >= hmin && h <= hmax &&
-				s >= smin && s <= smax &&
-				v >= vmin && v <= vmax)
-			{
-				dst->data[pos] = 255;
-			}
-			else
-			{
-				dst->data[pos] = 0;
-			}
-		}
-	}
 	return 1;
 }
 
 
-#pragma endregion
-
-#pragma region Função: vc_scale_gray_to_color_palette
 /**
- * Função: vc_scale_gray_to_color_palette
- * --------------------------------------
- * Converte uma imagem em tons de cinzento (grayscale, 1 canal) para uma imagem RGB (3 canais),
- * aplicando uma paleta de cores tipo "Jet", que vai do azul ao vermelho, passando por ciano, verde e amarelo.
+ * Função: vc_leitor_ler
+ * ---------------------
+ * Lê (e descomprime, se necessário) a imagem com o índice dado.
  *
  * Parâmetros:
- *   src - imagem de entrada em grayscale (1 canal)
- *   dst - imagem de saída em RGB (3 canais), com as mesmas dimensões da original
+ *   leitor - leitor devolvido por vc_leitor_abrir
+ *   indice - posição do registo no ficheiro [0, vc_leitor_nregistos[
+ *   nframe - (saída, opcional) número do frame gravado
+ *   tipo   - (saída, opcional) VC_REC_MASCARA, VC_REC_ETIQUETAS ou VC_REC_FRAME
  *
  * Retorna:
- *   1 se a conversão for bem-sucedida, 0 caso contrário
+ *   Nova imagem (libertar com vc_image_free), ou NULL em caso de erro.
  */
+IVC* vc_leitor_ler(VC_LEITOR* leitor, int indice, int* nframe, int* tipo)
+{
+	VCR_REGISTO registo;
+	IVC* image;
+	long int size;
 
-int vc_scale_gray_to_color_palette(IVC* src, IVC* dst) {
-	// Verificações básicas
-	if (src == NULL || dst == NULL) return 0;
-	if (src->channels != 1 || dst->channels != 3) return 0; // Entrada deve ser grayscale e saída RGB
-	if (src->width != dst->width || src->height != dst->height) return 0; // As dimensões devem ser iguais
-
-	unsigned char* src_data = src->data;
-	unsigned char* dst_data = dst->data;
-	int width = src->width;
-	int height = src->height;
+	if ((leitor == NULL) || (indice < 0) || (indice >= (int)leitor->indice.size())) return NULL;
 
-	// Percorre todos os píxeis da imagem
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			int index_gray = y * width + x;   // Índice do píxel na imagem grayscale
-			int index_rgb = index_gray * 3;   // Índice correspondente na imagem RGB
+	if ((vcr_fseek(leitor->file, leitor->indice[indice].offset, SEEK_SET) != 0) ||
+		(fread(&registo, sizeof(VCR_REGISTO), 1, leitor->file) != 1) || !vcr_registo_valido(&registo))
+	{
+		return NULL;
+	}
 
-			unsigned char gray = src_data[index_gray]; // Valor do píxel em grayscale
+	image = vc_image_new(registo.width, registo.height, registo.channels, registo.levels);
+	if (image == NULL) return NULL;
 
-			// Mapeamento de cinzento para cor com paleta "Jet"
-			unsigned char r, g, b;
+	size = image->bytesperline * image->height;
 
-			if (gray < 64) {        // Azul → Ciano
-				r = 0;
-				g = 4 * gray;
-				b = 255;
-			}
-			else if (gray < 128) {  // Ciano → Verde
-				r = 0;
-				g = 255;
-				b = 255 - (4 * (gray - 64));
-			}
-			else if (gray < 192) {  // Verde → Amarelo
-				r = 4 * (gray - 128);
-				g = 255;
-				b = 0;
-			}
-			else {                  // Amarelo → Vermelho
-				r = 255;
-				g = 255 - (4 * (gray - 192));
-				b = 0;
-			}
+	if (registo.compressao == VC_REC_RLE)
+	{
+		unsigned char* tmp = (unsigned char*)malloc(registo.tamanho);
 
-			// Escreve os valores RGB no destino
-			dst_data[index_rgb] = r; // Red
-			dst_data[index_rgb + 1] = g; // Green
-			dst_data[index_rgb + 2] = b; // Blue
+		if ((tmp == NULL) || (fread(tmp, 1, registo.tamanho, leitor->file) != registo.tamanho) ||
+			!vcr_rle_decode(tmp, registo.tamanho, image->data, size))
+		{
+			free(tmp);
+			return vc_image_free(image);
 		}
+		free(tmp);
+	}
+	else if ((registo.tamanho != (uint32_t)size) || (fread(image->data, 1, size, leitor->file) != (size_t)size))
+	{
+		return vc_image_free(image);
 	}
 
-	return 1;
+	if (nframe != NULL) *nframe = registo.nframe;
+	if (tipo != NULL) *tipo = registo.tipo;
+
+	return image;
+}
+
+
+void vc_leitor_fechar(VC_LEITOR* leitor)
+{
+	if (leitor == NULL) return;
+
+	fclose(leitor->file);
+	delete leitor;
 }
 
 #pragma endregion
 
-#pragma region Função: vc_gray_to_binary
+#pragma region Funções : Despacho SIMD (operações ponto a ponto)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//      FUNÇÕES: DESPACHO SIMD (OPERAÇÕES PONTO A PONTO)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-/**
- * Função: vc_gray_to_binary
- * -------------------------
- * Converte uma imagem em tons de cinzento (grayscale, 1 canal) para uma imagem binária (1 canal),
- * com base num valor de limiar (threshold).
- * Todos os píxeis com valor >= threshold são definidos como 1 (branco), os restantes como 0 (preto).
- *
- * Parâmetros:
- *   src       - imagem de entrada (grayscale)
- *   dst       - imagem de saída (binária)
- *   threshold - valor de limiar para binarização (0–255)
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
+// As operações ponto a ponto (negativo, cópia de um canal, RGB para cinzento, limiarização e soma de
+// máscaras) percorrem a imagem linha a linha com kernels que têm uma variante por nível SIMD.
+// O nível é lido do CPUID uma só vez (ver vc_simd_suportado), pelo que o mesmo executável usa AVX-512
+// onde existe e SSE4.1 nos processadores mais antigos. Todas as variantes dão exatamente o resultado
+// da escalar, que é o ciclo original de cada função (ver vc_simd_verificar).
+
+// Kernels de uma linha de um nível SIMD
+typedef struct {
+	void (*negativo)(unsigned char* dados, long int n);										// n bytes: 255 - valor
+	void (*canal)(unsigned char* dados, long int npixeis, int canal);						// RGB: os três canais = canal
+	void (*cinzento)(const unsigned char* rgb, unsigned char* gray, long int npixeis);		// 0.299 R + 0.587 G + 0.114 B
+	void (*limiar)(const unsigned char* src, unsigned char* dst, long int n, int limiar);	// >= limiar (0 a 255): 255, senão 0
+	void (*ou)(const unsigned char* a, const unsigned char* b, unsigned char* dst, long int n);	// 255 se a ou b é 255, senão 0
+} VC_SIMD_KERNELS;
+
+#define VC_SIMD_NKERNELS	5
+
+// Variantes escalares (referência)
+static void vc_negativo_escalar(unsigned char* dados, long int n)
+{
+	for (long int i = 0; i < n; i++) dados[i] = 255 - dados[i];
+}
 
-int vc_gray_to_binary(IVC* src, IVC* dst, int threshold)
+static void vc_canal_escalar(unsigned char* dados, long int npixeis, int canal)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int width = src->width;
-	int height = src->height;
-	int x, y;
-	long int pos;
+	for (long int i = 0; i < npixeis; i++, dados += 3)
+	{
+		unsigned char v = dados[canal];
 
-	// Verificações de validade da imagem de entrada e saída
-	if ((width <= 0) || (height <= 0) || (datasrc == NULL))
-		return 0;
-	if ((dst->width <= 0) || (dst->height < height) || (dst->channels != channels))
-		return 0;
-	if (channels != 1)
-		return 0;
+		dados[0] = v;
+		dados[1] = v;
+		dados[2] = v;
+	}
+}
 
-	// Percorre todos os píxeis da imagem
-	for (y = 0; y < height; y++)
+// Fora de linha: as variantes SIMD chamam-na nos píxeis que recalculam, e dentro de uma função AVX-512
+// o compilador juntaria as multiplicações e as somas em FMA, que arredondam de outra forma
+static VC_NAO_EXPANDIR void vc_cinzento_escalar(const unsigned char* rgb, unsigned char* gray, long int npixeis)
+{
+	for (long int i = 0; i < npixeis; i++, rgb += 3)
 	{
-		for (x = 0; x < width; x++)
-		{
-			pos = y * bytesperline + x * channels;
+		gray[i] = (unsigned char)(0.299 * rgb[0] + 0.587 * rgb[1] + 0.114 * rgb[2]);
+	}
+}
 
-			// Aplica limiarização: >= threshold → 255, senão → 0
-			if (datasrc[pos] >= threshold)
-			{
-				datadst[pos] = 255;
-			}
-			else
-			{
-				datadst[pos] = 0;
-			}
-		}
-	}
+static void vc_limiar_escalar(const unsigned char* src, unsigned char* dst, long int n, int limiar)
+{
+	for (long int i = 0; i < n; i++) dst[i] = (src[i] >= limiar) ? 255 : 0;
+}
 
-	return 1;
+static void vc_ou_escalar(const unsigned char* a, const unsigned char* b, unsigned char* dst, long int n)
+{
+	for (long int i = 0; i < n; i++) dst[i] = (a[i] == 255 || b[i] == 255) ? 255 : 0;
 }
 
-#pragma endregion
+#ifdef VC_SIMD_X86
+// Cópia de um canal: os 48 bytes de 16 píxeis RGB são lidos em três blocos de 16 bytes, a partir dos
+// bytes canal, 15 + canal e 30 + canal, e o byte j do bloco de saída k é o byte mascaras[k][j] do bloco lido
+static const unsigned char vc_canal_mascaras[3][16] = {
+	{ 0, 0, 0, 3, 3, 3, 6, 6, 6, 9, 9, 9, 12, 12, 12, 15 },
+	{ 0, 0, 3, 3, 3, 6, 6, 6, 9, 9, 9, 12, 12, 12, 15, 15 },
+	{ 0, 3, 3, 3, 6, 6, 6, 9, 9, 9, 12, 12, 12, 15, 15, 15 },
+};
+
+// Nas variantes de 32 e 64 bytes, o bloco de saída de 16 bytes número b (3 por cada 16 píxeis) é lido a partir
+// do byte 48 (b / 3) + 15 (b % 3) + canal, com a máscara b % 3
+
+// RGB para cinzento: 4 píxeis (12 bytes) de um bloco de 16 bytes, a partir do byte 0 ou do byte 4 (o último
+// bloco de cada iteração, para não ler além da linha), separados em palavras de 16 bits (R, G) e (B, 0)
+static const unsigned char vc_cinzento_mascaras[2][2][16] = {
+	{
+		{ 0, 0x80, 1, 0x80, 3, 0x80, 4, 0x80, 6, 0x80, 7, 0x80, 9, 0x80, 10, 0x80 },
+		{ 2, 0x80, 0x80, 0x80, 5, 0x80, 0x80, 0x80, 8, 0x80, 0x80, 0x80, 11, 0x80, 0x80, 0x80 },
+	},
+	{
+		{ 4, 0x80, 5, 0x80, 7, 0x80, 8, 0x80, 10, 0x80, 11, 0x80, 13, 0x80, 14, 0x80 },
+		{ 6, 0x80, 0x80, 0x80, 9, 0x80, 0x80, 0x80, 12, 0x80, 0x80, 0x80, 15, 0x80, 0x80, 0x80 },
+	},
+};
+
+// O cinzento é k / 1000 com k = 299 R + 587 G + 114 B (inteiro), calculado em float (exato a menos de 1e-4).
+// Quando k é múltiplo de 1000 (resto 0, ou 1000 se o float ficou abaixo), a fórmula em double pode dar
+// k / 1000 - 1, e esses píxeis são recalculados com vc_cinzento_escalar.
+static void vc_cinzento_corrigir(const unsigned char* rgb, unsigned char* gray, unsigned long long corrigir)
+{
+	for (int i = 0; corrigir != 0; i++, corrigir >>= 1)
+	{
+		if (corrigir & 1) vc_cinzento_escalar(rgb + 3 * i, gray + i, 1);
+	}
+}
 
-#pragma region Função: vc_gray_to_binary_global_mean
-/**
- * Função: vc_gray_to_binary_global_mean
- * -------------------------------------
- * Converte uma imagem em tons de cinzento (grayscale, 1 canal) para uma imagem binária (1 canal),
- * utilizando como limiar o valor da média global dos píxeis da imagem.
- *
- * Parâmetros:
- *   src - imagem de entrada em grayscale
- *   dst - imagem de saída binária (1 canal)
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
 
-int vc_gray_to_binary_global_mean(IVC* src, IVC* dst)
+// SSE4.1 (16 bytes por instrução)
+VC_ALVO("sse4.1") static void vc_negativo_sse41(unsigned char* dados, long int n)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int width = src->width;
-	int height = src->height;
-	int x, y;
-	long int pos;
-	long int sum = 0;
-	int threshold;
+	const __m128i uns = _mm_set1_epi8(-1);
+	long int i = 0;
 
-	// Verificações básicas
-	if ((width <= 0) || (height <= 0) || (datasrc == NULL))
-		return 0;
-	if ((dst->width <= 0) || (dst->height < height) || (dst->channels != channels))
-		return 0;
-	if (channels != 1)
-		return 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm_storeu_si128((__m128i*)(dados + i), _mm_xor_si128(_mm_loadu_si128((const __m128i*)(dados + i)), uns));
+	}
 
-	// Calcula a soma de todos os valores de píxeis
-	for (y = 0; y < height; y++)
+	vc_negativo_escalar(dados + i, n - i);
+}
+
+VC_ALVO("sse4.1") static void vc_canal_sse41(unsigned char* dados, long int npixeis, int canal)
+{
+	const __m128i m0 = _mm_loadu_si128((const __m128i*)vc_canal_mascaras[0]);
+	const __m128i m1 = _mm_loadu_si128((const __m128i*)vc_canal_mascaras[1]);
+	const __m128i m2 = _mm_loadu_si128((const __m128i*)vc_canal_mascaras[2]);
+	long int i = 0;
+
+	for (; i + 16 <= npixeis; i += 16)
 	{
-		for (x = 0; x < width; x++)
-		{
-			pos = y * bytesperline + x * channels;
-			sum += datasrc[pos];
-		}
+		unsigned char* p = dados + 3 * i;
+		__m128i o0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + canal)), m0);
+		__m128i o1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 15 + canal)), m1);
+		__m128i o2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 30 + canal)), m2);
+
+		_mm_storeu_si128((__m128i*)(p), o0);
+		_mm_storeu_si128((__m128i*)(p + 16), o1);
+		_mm_storeu_si128((__m128i*)(p + 32), o2);
 	}
 
-	// Calcula a média (limiar global)
-	threshold = sum / (width * height);
+	vc_canal_escalar(dados + 3 * i, npixeis - i, canal);
+}
 
-	// Aplica a binarização com o limiar calculado
-	vc_gray_to_binary(src, dst, threshold);
+// Cinzento de 4 píxeis; bit i de *corrigir a 1 se o píxel i tem de ser recalculado
+VC_ALVO("sse4.1") static inline __m128i vc_cinzento4_sse41(__m128i x, __m128i mrg, __m128i mb, int* corrigir)
+{
+	__m128i k = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi8(x, mrg), _mm_set1_epi32((587 << 16) | 299)),
+		_mm_madd_epi16(_mm_shuffle_epi8(x, mb), _mm_set1_epi32(114)));
+	__m128i q = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(k), _mm_set1_ps(0.001f)));
+	__m128i r = _mm_sub_epi32(k, _mm_mullo_epi32(q, _mm_set1_epi32(1000)));
 
-	return 1;
+	*corrigir = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(r, _mm_setzero_si128()), _mm_cmpeq_epi32(r, _mm_set1_epi32(1000)))));
+
+	return q;
 }
 
-#pragma endregion
+VC_ALVO("sse4.1") static void vc_cinzento_sse41(const unsigned char* rgb, unsigned char* gray, long int npixeis)
+{
+	const __m128i mrg = _mm_loadu_si128((const __m128i*)vc_cinzento_mascaras[0][0]);
+	const __m128i mb = _mm_loadu_si128((const __m128i*)vc_cinzento_mascaras[0][1]);
+	const __m128i mrgfim = _mm_loadu_si128((const __m128i*)vc_cinzento_mascaras[1][0]);
+	const __m128i mbfim = _mm_loadu_si128((const __m128i*)vc_cinzento_mascaras[1][1]);
+	long int i = 0;
 
-#pragma region Função: vc_gray_to_binary_midpoint
+	for (; i + 16 <= npixeis; i += 16)
+	{
+		const unsigned char* p = rgb + 3 * i;
+		int c0, c1, c2, c3;
+		__m128i q0 = vc_cinzento4_sse41(_mm_loadu_si128((const __m128i*)(p)), mrg, mb, &c0);
+		__m128i q1 = vc_cinzento4_sse41(_mm_loadu_si128((const __m128i*)(p + 12)), mrg, mb, &c1);
+		__m128i q2 = vc_cinzento4_sse41(_mm_loadu_si128((const __m128i*)(p + 24)), mrg, mb, &c2);
+		__m128i q3 = vc_cinzento4_sse41(_mm_loadu_si128((const __m128i*)(p + 32)), mrgfim, mbfim, &c3);
 
-/**
- * Função: vc_gray_to_binary_midpoint
- * ----------------------------------
- * Aplica binarização adaptativa a uma imagem grayscale usando o método do ponto médio (midpoint).
- * Para cada píxel, calcula-se o valor médio entre o mínimo e o máximo numa vizinhança (janela)
- * e esse valor é usado como limiar local.
- *
- * Parâmetros:
- *   src        - imagem de entrada (grayscale, 1 canal)
- *   dst        - imagem binária de saída (1 canal, mesma dimensão da entrada)
- *   kernelSize - tamanho da janela (deve ser ímpar, ex: 3, 5, 7...)
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
+		_mm_storeu_si128((__m128i*)(gray + i), _mm_packus_epi16(_mm_packus_epi32(q0, q1), _mm_packus_epi32(q2, q3)));
 
-int vc_gray_to_binary_midpoint(IVC* src, IVC* dst, int kernelSize)
+		if (c0 | c1 | c2 | c3) vc_cinzento_corrigir(p, gray + i, (unsigned long long)(c0 | (c1 << 4) | (c2 << 8) | (c3 << 12)));
+	}
+
+	vc_cinzento_escalar(rgb + 3 * i, gray + i, npixeis - i);
+}
+
+// v >= limiar se max(v, limiar) == v (comparação sem sinal)
+VC_ALVO("sse4.1") static void vc_limiar_sse41(const unsigned char* src, unsigned char* dst, long int n, int limiar)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int pos, max, min;
-	int offset = (kernelSize - 1) / 2;
-	int treshold;
+	const __m128i t = _mm_set1_epi8((char)limiar);
+	long int i = 0;
 
-	// Verificações básicas
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
-		return 0;
-	if (src->channels != 1)
-		return 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(src + i));
 
-	// Binarização usando ponto médio local
-	for (y = 0; y < height; y++)
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_cmpeq_epi8(_mm_max_epu8(x, t), x));
+	}
+
+	vc_limiar_escalar(src + i, dst + i, n - i, limiar);
+}
+
+VC_ALVO("sse4.1") static void vc_ou_sse41(const unsigned char* a, const unsigned char* b, unsigned char* dst, long int n)
+{
+	const __m128i uns = _mm_set1_epi8(-1);
+	long int i = 0;
+
+	for (; i + 16 <= n; i += 16)
 	{
-		for (x = 0; x < width; x++)
-		{
-			max = 0;
-			min = src->levels - 1;
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
 
-			// Percorre a janela local
-			for (ky = -offset; ky < offset; ky++)
-			{
-				for (kx = -offset; kx < offset; kx++)
-				{
-					if ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width))
-					{
-						int localPos = (y + ky) * bytesperline + (x + kx) * channels;
-						unsigned char value = datasrc[localPos];
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_cmpeq_epi8(va, uns), _mm_cmpeq_epi8(vb, uns)));
+	}
 
-						if (value > max) max = value;
-						if (value < min) min = value;
-					}
-				}
-			}
+	vc_ou_escalar(a + i, b + i, dst + i, n - i);
+}
 
-			// Calcula o limiar como a média entre o máximo e o mínimo
-			treshold = (unsigned char)((float)(max + min) / 2);
 
-			// Aplica binarização ao píxel atual
-			pos = y * bytesperline + x * channels;
-			if (datasrc[pos] > treshold)
-				datadst[pos] = 255;
-			else
-				datadst[pos] = 0;
-		}
+// AVX2 (32 bytes; os kernels que reorganizam bytes trabalham em duas metades de 16, como o SSE4.1)
+VC_ALVO("avx2") static inline __m256i vc_carregar2_avx2(const unsigned char* baixo, const unsigned char* alto)
+{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)baixo)), _mm_loadu_si128((const __m128i*)alto), 1);
+}
+
+VC_ALVO("avx2") static void vc_negativo_avx2(unsigned char* dados, long int n)
+{
+	const __m256i uns = _mm256_set1_epi8(-1);
+	long int i = 0;
+
+	for (; i + 32 <= n; i += 32)
+	{
+		_mm256_storeu_si256((__m256i*)(dados + i), _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(dados + i)), uns));
 	}
 
-	return 1;
+	vc_negativo_escalar(dados + i, n - i);
 }
 
-#pragma endregion
+// Metade l do vetor de saída k: bloco de 16 bytes 2k + l (ver vc_canal_mascaras)
+VC_ALVO("avx2") static void vc_canal_avx2(unsigned char* dados, long int npixeis, int canal)
+{
+	const __m256i m0 = vc_carregar2_avx2(vc_canal_mascaras[0], vc_canal_mascaras[1]);
+	const __m256i m1 = vc_carregar2_avx2(vc_canal_mascaras[2], vc_canal_mascaras[0]);
+	const __m256i m2 = vc_carregar2_avx2(vc_canal_mascaras[1], vc_canal_mascaras[2]);
+	long int i = 0;
 
-#pragma region Função: vc_gray_to_binary_bernsen
+	for (; i + 32 <= npixeis; i += 32)
+	{
+		unsigned char* p = dados + 3 * i;
+		__m256i o0 = _mm256_shuffle_epi8(vc_carregar2_avx2(p + canal, p + 15 + canal), m0);
+		__m256i o1 = _mm256_shuffle_epi8(vc_carregar2_avx2(p + 30 + canal, p + 48 + canal), m1);
+		__m256i o2 = _mm256_shuffle_epi8(vc_carregar2_avx2(p + 63 + canal, p + 78 + canal), m2);
+
+		_mm256_storeu_si256((__m256i*)(p), o0);
+		_mm256_storeu_si256((__m256i*)(p + 32), o1);
+		_mm256_storeu_si256((__m256i*)(p + 64), o2);
+	}
 
-/**
- * Função: vc_gray_to_binary_bernsen
- * ---------------------------------
- * Aplica binarização adaptativa a uma imagem em tons de cinzento utilizando o método de Bernsen.
- * Para cada píxel, calcula o mínimo e máximo na sua vizinhança. Se o contraste local (max - min)
- * for menor que um valor limite (`cmin`), o píxel é definido como fundo. Caso contrário, o limiar
- * é definido como a média entre max e min.
- *
- * Parâmetros:
- *   src        - imagem de entrada em grayscale (1 canal)
- *   dst        - imagem de saída binária (1 canal)
- *   kernelSize - tamanho da janela (deve ser ímpar)
- *   cmin       - valor mínimo de contraste local
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
+	vc_canal_escalar(dados + 3 * i, npixeis - i, canal);
+}
 
-int vc_gray_to_binary_bernsen(IVC* src, IVC* dst, int kernelSize, int cmin)
+// Cinzento de 8 píxeis (4 em cada metade); bit i de *corrigir a 1 se o píxel i tem de ser recalculado
+VC_ALVO("avx2") static inline __m256i vc_cinzento8_avx2(__m256i x, __m256i mrg, __m256i mb, int* corrigir)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int max, min;
-	int offset = (kernelSize - 1) / 2;
-	int pos;
-	unsigned char treshold;
+	__m256i k = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi8(x, mrg), _mm256_set1_epi32((587 << 16) | 299)),
+		_mm256_madd_epi16(_mm256_shuffle_epi8(x, mb), _mm256_set1_epi32(114)));
+	__m256i q = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(k), _mm256_set1_ps(0.001f)));
+	__m256i r = _mm256_sub_epi32(k, _mm256_mullo_epi32(q, _mm256_set1_epi32(1000)));
 
-	// Verificações básicas
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
-		return 0;
-	if (src->channels != 1)
-		return 0;
+	*corrigir = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_cmpeq_epi32(r, _mm256_setzero_si256()), _mm256_cmpeq_epi32(r, _mm256_set1_epi32(1000)))));
 
-	// Binarização usando método de Bernsen
-	for (y = 0; y < height; y++)
+	return q;
+}
+
+VC_ALVO("avx2") static void vc_cinzento_avx2(const unsigned char* rgb, unsigned char* gray, long int npixeis)
+{
+	const __m256i mrg = vc_carregar2_avx2(vc_cinzento_mascaras[0][0], vc_cinzento_mascaras[0][0]);
+	const __m256i mb = vc_carregar2_avx2(vc_cinzento_mascaras[0][1], vc_cinzento_mascaras[0][1]);
+	const __m256i mrgfim = vc_carregar2_avx2(vc_cinzento_mascaras[0][0], vc_cinzento_mascaras[1][0]);
+	const __m256i mbfim = vc_carregar2_avx2(vc_cinzento_mascaras[0][1], vc_cinzento_mascaras[1][1]);
+	const __m256i ordem = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	long int i = 0;
+
+	for (; i + 32 <= npixeis; i += 32)
 	{
-		for (x = 0; x < width; x++)
-		{
-			max = 0;
-			min = src->levels - 1;
+		const unsigned char* p = rgb + 3 * i;
+		int c0, c1, c2, c3;
+		__m256i q0 = vc_cinzento8_avx2(vc_carregar2_avx2(p, p + 12), mrg, mb, &c0);
+		__m256i q1 = vc_cinzento8_avx2(vc_carregar2_avx2(p + 24, p + 36), mrg, mb, &c1);
+		__m256i q2 = vc_cinzento8_avx2(vc_carregar2_avx2(p + 48, p + 60), mrg, mb, &c2);
+		__m256i q3 = vc_cinzento8_avx2(vc_carregar2_avx2(p + 72, p + 80), mrgfim, mbfim, &c3);
+
+		// packus junta as metades de 128 bits em separado: a permutação repõe os grupos de 4 píxeis por ordem
+		__m256i q = _mm256_packus_epi16(_mm256_packus_epi32(q0, q1), _mm256_packus_epi32(q2, q3));
+		_mm256_storeu_si256((__m256i*)(gray + i), _mm256_permutevar8x32_epi32(q, ordem));
+
+		if (c0 | c1 | c2 | c3) vc_cinzento_corrigir(p, gray + i, (unsigned long long)(c0 | (c1 << 8) | (c2 << 16)) | ((unsigned long long)c3 << 24));
+	}
 
-			// Percorre a janela local
-			for (ky = -offset; ky < offset; ky++)
-			{
-				for (kx = -offset; kx < offset; kx++)
-				{
-					if ((y + ky >= 0) && (y + ky < height) &&
-						(x + kx >= 0) && (x + kx < width))
-					{
-						pos = (y + ky) * bytesperline + (x + kx) * channels;
+	vc_cinzento_escalar(rgb + 3 * i, gray + i, npixeis - i);
+}
 
-						if (datasrc[pos] > max)
-							max = datasrc[pos];
-						if (datasrc[pos] < min)
-							min = datasrc[pos];
-					}
-				}
-			}
+VC_ALVO("avx2") static void vc_limiar_avx2(const unsigned char* src, unsigned char* dst, long int n, int limiar)
+{
+	const __m256i t = _mm256_set1_epi8((char)limiar);
+	long int i = 0;
 
-			// Define o limiar de acordo com o contraste local
-			if ((max - min) < cmin)
-				treshold = (unsigned char)((float)(src->levels) / 2.0); // Contraste baixo: assume fundo
-			else
-				treshold = (unsigned char)((float)(max + min) / 2.0);   // Contraste suficiente: usa média local
+	for (; i + 32 <= n; i += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
 
-			pos = y * bytesperline + x * channels;
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_cmpeq_epi8(_mm256_max_epu8(x, t), x));
+	}
 
-			if (datasrc[pos] > treshold)
-				datadst[pos] = 255;
-			else
-				datadst[pos] = 0;
+	vc_limiar_escalar(src + i, dst + i, n - i, limiar);
+}
 
-		}
+VC_ALVO("avx2") static void vc_ou_avx2(const unsigned char* a, const unsigned char* b, unsigned char* dst, long int n)
+{
+	const __m256i uns = _mm256_set1_epi8(-1);
+	long int i = 0;
+
+	for (; i + 32 <= n; i += 32)
+	{
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_cmpeq_epi8(va, uns), _mm256_cmpeq_epi8(vb, uns)));
 	}
 
-	return 1;
+	vc_ou_escalar(a + i, b + i, dst + i, n - i);
 }
 
-#pragma endregion
 
-#pragma region Função: vc_gray_to_binary_niblack
+// AVX-512 F e BW (64 bytes; o fim de cada linha é feito com leituras e escritas mascaradas)
+#define VC_SIMD_AVX512_ISA "avx512f,avx512bw"
 
-/**
- * Função: vc_gray_to_binary_niblack
- * ---------------------------------
- * Aplica binarização adaptativa a uma imagem em tons de cinzento usando o método de Niblack.
- * O limiar é calculado dinamicamente para cada píxel com base na média (mean) e desvio padrão (stdev)
- * da sua vizinhança (janela). O limiar local é definido como: threshold = mean + k * stdev.
- *
- * Parâmetros:
- *   src        - imagem de entrada em grayscale (1 canal)
- *   dst        - imagem de saída binária (1 canal)
- *   kernelSize - tamanho da janela (deve ser ímpar)
- *   k          - fator multiplicador do desvio padrão (ajusta a sensibilidade)
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário
- */
+// Máscara dos n primeiros bytes (n < 64)
+static inline __mmask64 vc_mascara_avx512(long int n)
+{
+	return (__mmask64)((1ULL << n) - 1);
+}
 
-int vc_gray_to_binary_niblack(IVC* src, IVC* dst, int kernelSize, float k)
+VC_ALVO(VC_SIMD_AVX512_ISA) static inline __m512i vc_carregar4_avx512(const unsigned char* p0, const unsigned char* p1, const unsigned char* p2, const unsigned char* p3)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int offset = (kernelSize - 1) / 2; // Offset da janela (metade do kernel)
-	int pos;
-	float sum, sumsq;
-	float mean, stdev;
-	unsigned char threshold;
+	__m512i x = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)p0));
 
+	x = _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)p1), 1);
+	x = _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)p2), 2);
+	return _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)p3), 3);
+}
 
-	// Verificações básicas
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
-		return 0;
-	if (src->channels != 1)
-		return 0;
+VC_ALVO(VC_SIMD_AVX512_ISA) static void vc_negativo_avx512(unsigned char* dados, long int n)
+{
+	const __m512i uns = _mm512_set1_epi8(-1);
+	long int i = 0;
 
-	// Binarização usando método de Niblack
-	for (y = 0; y < height; y++)
+	for (; i + 64 <= n; i += 64)
 	{
-		for (x = 0; x < width; x++)
-		{
-			sum = 0.0;
-			sumsq = 0.0;
-			int counter_mean = 0;
+		_mm512_storeu_si512(dados + i, _mm512_xor_si512(_mm512_loadu_si512(dados + i), uns));
+	}
 
-			// Calcula a soma dos valores dos píxeis na vizinhança
-			for (ky = -offset; ky <= offset; ky++)
-			{
-				for (kx = -offset; kx <= offset; kx++)
-				{
-					if ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width))
-					{
-						pos = (y + ky) * bytesperline + (x + kx) * channels;
-						sum += datasrc[pos];
-						counter_mean++; // Número de elementos somados
-					}
-				}
-			}
+	if (i < n)
+	{
+		__mmask64 m = vc_mascara_avx512(n - i);
 
-			mean = sum / counter_mean; // Média da janela
-			int counter_stdev = 0;
+		_mm512_mask_storeu_epi8(dados + i, m, _mm512_xor_si512(_mm512_maskz_loadu_epi8(m, dados + i), uns));
+	}
+}
 
-			// Calcula o desvio padrão dos valores da janela
-			for (ky = -offset; ky <= offset; ky++)
-			{
-				for (kx = -offset; kx <= offset; kx++)
-				{
-					if ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width))
-					{
-						pos = (y + ky) * bytesperline + (x + kx) * channels;
-						sumsq += powf(((float)datasrc[pos] - mean), 2); // Soma dos quadrados da diferença
-						counter_stdev++;
-					}
-				}
-			}
+// Quarto l do vetor de saída k: bloco de 16 bytes 4k + l (ver vc_canal_mascaras)
+VC_ALVO(VC_SIMD_AVX512_ISA) static void vc_canal_avx512(unsigned char* dados, long int npixeis, int canal)
+{
+	const __m512i m0 = vc_carregar4_avx512(vc_canal_mascaras[0], vc_canal_mascaras[1], vc_canal_mascaras[2], vc_canal_mascaras[0]);
+	const __m512i m1 = vc_carregar4_avx512(vc_canal_mascaras[1], vc_canal_mascaras[2], vc_canal_mascaras[0], vc_canal_mascaras[1]);
+	const __m512i m2 = vc_carregar4_avx512(vc_canal_mascaras[2], vc_canal_mascaras[0], vc_canal_mascaras[1], vc_canal_mascaras[2]);
+	long int i = 0;
 
-			stdev = sqrtf(sumsq / counter_stdev); // Desvio padrão da janela
+	for (; i + 64 <= npixeis; i += 64)
+	{
+		unsigned char* p = dados + 3 * i;
+		unsigned char* q = p + canal;
+		__m512i o0 = _mm512_shuffle_epi8(vc_carregar4_avx512(q, q + 15, q + 30, q + 48), m0);
+		__m512i o1 = _mm512_shuffle_epi8(vc_carregar4_avx512(q + 63, q + 78, q + 96, q + 111), m1);
+		__m512i o2 = _mm512_shuffle_epi8(vc_carregar4_avx512(q + 126, q + 144, q + 159, q + 174), m2);
+
+		_mm512_storeu_si512(p, o0);
+		_mm512_storeu_si512(p + 64, o1);
+		_mm512_storeu_si512(p + 128, o2);
+	}
 
-			// Calcula limiar adaptativo
-			threshold = (unsigned char)(mean + k * stdev);
+	vc_canal_escalar(dados + 3 * i, npixeis - i, canal);
+}
 
-			pos = y * bytesperline + x * channels;
+// Cinzento de 16 píxeis (4 em cada quarto); bit i de *corrigir a 1 se o píxel i tem de ser recalculado
+VC_ALVO(VC_SIMD_AVX512_ISA) static inline __m512i vc_cinzento16_avx512(__m512i x, __m512i mrg, __m512i mb, __mmask16* corrigir)
+{
+	__m512i k = _mm512_add_epi32(_mm512_madd_epi16(_mm512_shuffle_epi8(x, mrg), _mm512_set1_epi32((587 << 16) | 299)),
+		_mm512_madd_epi16(_mm512_shuffle_epi8(x, mb), _mm512_set1_epi32(114)));
+	__m512i q = _mm512_cvttps_epi32(_mm512_mul_ps(_mm512_cvtepi32_ps(k), _mm512_set1_ps(0.001f)));
+	__m512i r = _mm512_sub_epi32(k, _mm512_mullo_epi32(q, _mm512_set1_epi32(1000)));
 
-			// Aplica binarização
-			if (datasrc[pos] > threshold)
-				datadst[pos] = 255;
-			else
-				datadst[pos] = 0;
+	*corrigir = _mm512_cmpeq_epi32_mask(r, _mm512_setzero_si512()) | _mm512_cmpeq_epi32_mask(r, _mm512_set1_epi32(1000));
+
+	return q;
+}
+
+VC_ALVO(VC_SIMD_AVX512_ISA) static void vc_cinzento_avx512(const unsigned char* rgb, unsigned char* gray, long int npixeis)
+{
+	const unsigned char* mrg0 = vc_cinzento_mascaras[0][0];
+	const unsigned char* mb0 = vc_cinzento_mascaras[0][1];
+	const __m512i mrg = vc_carregar4_avx512(mrg0, mrg0, mrg0, mrg0);
+	const __m512i mb = vc_carregar4_avx512(mb0, mb0, mb0, mb0);
+	const __m512i mrgfim = vc_carregar4_avx512(mrg0, mrg0, mrg0, vc_cinzento_mascaras[1][0]);
+	const __m512i mbfim = vc_carregar4_avx512(mb0, mb0, mb0, vc_cinzento_mascaras[1][1]);
+	const __m512i ordem = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	long int i = 0;
+
+	for (; i + 64 <= npixeis; i += 64)
+	{
+		const unsigned char* p = rgb + 3 * i;
+		__mmask16 c0, c1, c2, c3;
+		__m512i q0 = vc_cinzento16_avx512(vc_carregar4_avx512(p, p + 12, p + 24, p + 36), mrg, mb, &c0);
+		__m512i q1 = vc_cinzento16_avx512(vc_carregar4_avx512(p + 48, p + 60, p + 72, p + 84), mrg, mb, &c1);
+		__m512i q2 = vc_cinzento16_avx512(vc_carregar4_avx512(p + 96, p + 108, p + 120, p + 132), mrg, mb, &c2);
+		__m512i q3 = vc_cinzento16_avx512(vc_carregar4_avx512(p + 144, p + 156, p + 168, p + 176), mrgfim, mbfim, &c3);
+
+		// Como no AVX2, packus trabalha em cada quarto de 128 bits: a permutação repõe a ordem dos píxeis
+		__m512i q = _mm512_packus_epi16(_mm512_packus_epi32(q0, q1), _mm512_packus_epi32(q2, q3));
+		_mm512_storeu_si512(gray + i, _mm512_permutexvar_epi32(ordem, q));
+
+		if (c0 | c1 | c2 | c3)
+		{
+			vc_cinzento_corrigir(p, gray + i, (unsigned long long)c0 | ((unsigned long long)c1 << 16) | ((unsigned long long)c2 << 32) | ((unsigned long long)c3 << 48));
 		}
 	}
-	return 1;
+
+	vc_cinzento_escalar(rgb + 3 * i, gray + i, npixeis - i);
 }
 
-#pragma endregion
+VC_ALVO(VC_SIMD_AVX512_ISA) static void vc_limiar_avx512(const unsigned char* src, unsigned char* dst, long int n, int limiar)
+{
+	const __m512i t = _mm512_set1_epi8((char)limiar);
+	long int i = 0;
+
+	for (; i + 64 <= n; i += 64)
+	{
+		_mm512_storeu_si512(dst + i, _mm512_movm_epi8(_mm512_cmpge_epu8_mask(_mm512_loadu_si512(src + i), t)));
+	}
+
+	if (i < n)
+	{
+		__mmask64 m = vc_mascara_avx512(n - i);
+
+		_mm512_mask_storeu_epi8(dst + i, m, _mm512_movm_epi8(_mm512_cmpge_epu8_mask(_mm512_maskz_loadu_epi8(m, src + i), t)));
+	}
+}
+
+VC_ALVO(VC_SIMD_AVX512_ISA) static void vc_ou_avx512(const unsigned char* a, const unsigned char* b, unsigned char* dst, long int n)
+{
+	const __m512i uns = _mm512_set1_epi8(-1);
+	long int i = 0;
+
+	for (; i + 64 <= n; i += 64)
+	{
+		__mmask64 m = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(a + i), uns) | _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(b + i), uns);
+
+		_mm512_storeu_si512(dst + i, _mm512_movm_epi8(m));
+	}
+
+	if (i < n)
+	{
+		__mmask64 fim = vc_mascara_avx512(n - i);
+		__mmask64 m = _mm512_cmpeq_epi8_mask(_mm512_maskz_loadu_epi8(fim, a + i), uns) | _mm512_cmpeq_epi8_mask(_mm512_maskz_loadu_epi8(fim, b + i), uns);
+
+		_mm512_mask_storeu_epi8(dst + i, fim, _mm512_movm_epi8(m));
+	}
+}
+#endif
+
+// Tabela de kernels por nível (índice VC_SIMD_*); sem x86, todos os níveis usam os kernels escalares
+static const VC_SIMD_KERNELS vc_simd_kernels[4] = {
+	{ vc_negativo_escalar, vc_canal_escalar, vc_cinzento_escalar, vc_limiar_escalar, vc_ou_escalar },
+#ifdef VC_SIMD_X86
+	{ vc_negativo_sse41, vc_canal_sse41, vc_cinzento_sse41, vc_limiar_sse41, vc_ou_sse41 },
+	{ vc_negativo_avx2, vc_canal_avx2, vc_cinzento_avx2, vc_limiar_avx2, vc_ou_avx2 },
+	{ vc_negativo_avx512, vc_canal_avx512, vc_cinzento_avx512, vc_limiar_avx512, vc_ou_avx512 },
+#else
+	{ vc_negativo_escalar, vc_canal_escalar, vc_cinzento_escalar, vc_limiar_escalar, vc_ou_escalar },
+	{ vc_negativo_escalar, vc_canal_escalar, vc_cinzento_escalar, vc_limiar_escalar, vc_ou_escalar },
+	{ vc_negativo_escalar, vc_canal_escalar, vc_cinzento_escalar, vc_limiar_escalar, vc_ou_escalar },
+#endif
+};
+
+static const char* vc_simd_nomes[4] = { "escalar", "sse4.1", "avx2", "avx512" };
+
+// Nível pedido com vc_simd_definir (-1 = o suportado)
+static std::atomic<int> vc_simd_pedido(-1);
+
+#ifdef VC_SIMD_X86
+// Registos EAX, EBX, ECX e EDX de uma folha (e subfolha) do CPUID
+static void vc_cpuid(unsigned int folha, unsigned int subfolha, unsigned int registos[4])
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int r[4];
+
+	__cpuidex(r, (int)folha, (int)subfolha);
+	for (int i = 0; i < 4; i++) registos[i] = (unsigned int)r[i];
+#else
+	__cpuid_count(folha, subfolha, registos[0], registos[1], registos[2], registos[3]);
+#endif
+}
+
+// Estados de registos que o sistema operativo guarda na troca de contexto (XCR0)
+static unsigned long long vc_xgetbv(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return _xgetbv(0);
+#else
+	unsigned int baixo, alto;
+
+	__asm__ volatile ("xgetbv" : "=a"(baixo), "=d"(alto) : "c"(0));
+	return ((unsigned long long)alto << 32) | baixo;
+#endif
+}
+#endif
+
+// Nível mais alto suportado: o processador tem de ter as instruções e o sistema operativo tem de guardar
+// os registos que usam (YMM para o AVX2; YMM, ZMM e máscaras para o AVX-512)
+static int vc_simd_detetar(void)
+{
+	int nivel = VC_SIMD_ESCALAR;
+
+#ifdef VC_SIMD_X86
+	unsigned int r[4], maximo, ecx1;
+	unsigned long long xcr0;
+
+	vc_cpuid(0, 0, r);
+	maximo = r[0];
+	if (maximo < 1) return nivel;
+
+	// Folha 1, ECX: SSSE3 (bit 9), SSE4.1 (bit 19), OSXSAVE (bit 27) e AVX (bit 28)
+	vc_cpuid(1, 0, r);
+	ecx1 = r[2];
+	if (!(ecx1 & (1u << 9)) || !(ecx1 & (1u << 19))) return nivel;
+	nivel = VC_SIMD_SSE41;
+
+	if ((maximo < 7) || !(ecx1 & (1u << 27)) || !(ecx1 & (1u << 28))) return nivel;
+
+	// XCR0: estados SSE e AVX (bits 1 e 2); máscaras, metade alta dos ZMM0 a 15 e ZMM16 a 31 (bits 5 a 7)
+	xcr0 = vc_xgetbv();
+	if ((xcr0 & 0x6) != 0x6) return nivel;
+
+	// Folha 7, EBX: AVX2 (bit 5), AVX-512 F (bit 16) e BW (bit 30)
+	vc_cpuid(7, 0, r);
+	if (!(r[1] & (1u << 5))) return nivel;
+	nivel = VC_SIMD_AVX2;
+
+	if ((r[1] & (1u << 16)) && (r[1] & (1u << 30)) && ((xcr0 & 0xE6) == 0xE6)) nivel = VC_SIMD_AVX512;
+#endif
+
+	return nivel;
+}
 
-#pragma region Função: vc_binary_dilate
 /**
- * Função: vc_binary_dilate
+ * Função: vc_simd_suportado
  * -------------------------
- * Aplica a operação de **dilatação morfológica** a uma imagem binária.
- * Para cada píxel, verifica se há algum píxel ativo (≠ 0) na vizinhança (definida por um kernel quadrado).
- * Se houver, o píxel atual será definido como 1 (ativo). Caso contrário, permanece 0.
+ * Nível SIMD mais alto suportado pelo processador e pelo sistema operativo. O CPUID é lido
+ * só na primeira chamada (a inicialização da variável estática é segura entre threads).
  *
- * Parâmetros:
- *   src     - imagem binária de entrada (1 canal, valores 0 ou 1)
- *   dst     - imagem binária de saída (1 canal, mesma dimensão)
- *   kernel  - tamanho do kernel (deve ser ímpar, ex: 3, 5, 7...)
+ * Retorna:
+ *   VC_SIMD_ESCALAR, VC_SIMD_SSE41, VC_SIMD_AVX2 ou VC_SIMD_AVX512
+ */
+int vc_simd_suportado(void)
+{
+	static const int nivel = vc_simd_detetar();
+
+	return nivel;
+}
+
+/**
+ * Função: vc_simd_nivel
+ * ---------------------
+ * Nível SIMD em uso pelas operações ponto a ponto: o suportado, ou o definido com vc_simd_definir
+ * se for mais baixo.
  *
  * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ *   VC_SIMD_ESCALAR, VC_SIMD_SSE41, VC_SIMD_AVX2 ou VC_SIMD_AVX512
  */
+int vc_simd_nivel(void)
+{
+	int pedido = vc_simd_pedido.load(std::memory_order_relaxed);
+	int suportado = vc_simd_suportado();
 
-int vc_binary_dilate(IVC* src, IVC* dst, int kernel)
+	return ((pedido >= 0) && (pedido < suportado)) ? pedido : suportado;
+}
+
+/**
+ * Função: vc_simd_definir
+ * -----------------------
+ * Limita o nível SIMD das operações ponto a ponto (ex.: para as comparar ou para excluir um
+ * conjunto de instruções). Um nível acima do suportado fica no suportado.
+ *
+ * Parâmetros:
+ *   nivel - VC_SIMD_* máximo a usar (negativo = o suportado)
+ *
+ * Retorna:
+ *   O nível em uso
+ */
+int vc_simd_definir(int nivel)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int offset = (kernel - 1) / 2; // Metade do tamanho do kernel
-	int pos;
-	int i, j;
-	int pixel;
-	int posk;
+	vc_simd_pedido.store(nivel, std::memory_order_relaxed);
 
-	// Verificações básicas
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
-		return 0;
-	if (src->channels != 1)
-		return 0;
+	return vc_simd_nivel();
+}
 
-	// Dilatação
-	for (y = 0; y < height; y++)
+// Nome de um nível ("escalar", "sse4.1", "avx2" ou "avx512"; "?" se não existe)
+const char* vc_simd_nome(int nivel)
+{
+	return ((nivel >= VC_SIMD_ESCALAR) && (nivel <= VC_SIMD_AVX512)) ? vc_simd_nomes[nivel] : "?";
+}
+
+// Nível com o nome dado (ver vc_simd_nome); -1 se não existe
+int vc_simd_procurar(const char* nome)
+{
+	for (int nivel = VC_SIMD_ESCALAR; nivel <= VC_SIMD_AVX512; nivel++)
 	{
-		for (x = 0; x < width; x++)
-		{
-			pos = y * bytesperline + x * channels;
-			pixel = datasrc[pos]; // Valor atual do píxel
+		if (strcmp(nome, vc_simd_nomes[nivel]) == 0) return nivel;
+	}
 
-			// Só processa se o pixel atual for 0 (para tentar ativá-lo)
-			if (pixel == 0)
-			{
-				for (ky = -offset; ky <= offset; ky++)
-				{
-					for (kx = -offset; kx <= offset; kx++)
-					{
-						posk = (y + ky) * bytesperline + (x + kx) * channels;
+	return -1;
+}
 
-						// Verifica se vizinho está dentro dos limites da imagem
-						if ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width))
-						{
-							// Se algum vizinho estiver ativo, ativa este pixel
-							pixel |= datasrc[posk];
+// Kernels do nível em uso
+static const VC_SIMD_KERNELS* vc_simd(void)
+{
+	return &vc_simd_kernels[vc_simd_nivel()];
+}
 
-							// Se encontrou algum vizinho ativo, sai da busca
-							if (pixel != 0)
-							{
-								kx = offset;
-								ky = offset;
-							}
-						}
-					}
-				}
-			}
+/**
+ * Função: vc_simd_verificar
+ * -------------------------
+ * Compara cada kernel de um nível SIMD com o escalar: linhas de 0 a 300 píxeis (todos os restos
+ * dos ciclos de 16, 32 e 64) e uma de 4099, com inícios desalinhados e dados aleatórios; todos os
+ * limiares; e todas as cores RGB no cinzento. São comparados também os bytes depois do fim da linha,
+ * que nenhuma variante pode escrever.
+ *
+ * Parâmetros:
+ *   nivel - VC_SIMD_* a verificar (até vc_simd_suportado)
+ *
+ * Retorna:
+ *   O número de kernels com resultados diferentes do escalar (0 = todos iguais),
+ *   ou -1 se o nível não é suportado
+ */
+int vc_simd_verificar(int nivel)
+{
+	const VC_SIMD_KERNELS* ref = &vc_simd_kernels[VC_SIMD_ESCALAR];
+	const VC_SIMD_KERNELS* var;
+	const long int maximo = 4099, folga = 64;
+	std::vector<unsigned char> a(3 * maximo + folga), b(3 * maximo + folga);
+	std::vector<unsigned char> esperado(3 * maximo + folga), obtido(3 * maximo + folga);
+	int diferente[VC_SIMD_NKERNELS] = { 0 };
+	unsigned int semente = 12345;
+	long int comprimentos[302];
+	int ncomprimentos = 0, c, t, inicio, total = 0;
 
-			// Define o novo valor do píxel na imagem de saída
-			if (pixel != 0)
+	if ((nivel < VC_SIMD_ESCALAR) || (nivel > vc_simd_suportado())) return -1;
+
+	var = &vc_simd_kernels[nivel];
+
+	for (long int n = 0; n <= 300; n++) comprimentos[ncomprimentos++] = n;
+	comprimentos[ncomprimentos++] = maximo;
+
+	// Bytes aleatórios, com um terço a 255 (para a soma de máscaras)
+	auto sortear = [&](std::vector<unsigned char>& v)
+	{
+		for (size_t i = 0; i < v.size(); i++)
+		{
+			semente = semente * 1103515245u + 12345u;
+			v[i] = ((semente >> 16) % 3 == 0) ? 255 : (unsigned char)(semente >> 24);
+		}
+	};
+
+	for (int j = 0; j < ncomprimentos; j++)
+	{
+		long int n = comprimentos[j];
+
+		for (inicio = 0; inicio < 4; inicio++)
+		{
+			sortear(a);
+			sortear(b);
+
+			// Negativo (n píxeis RGB = 3n bytes)
+			memcpy(esperado.data(), a.data(), a.size());
+			memcpy(obtido.data(), a.data(), a.size());
+			ref->negativo(esperado.data() + inicio, 3 * n);
+			var->negativo(obtido.data() + inicio, 3 * n);
+			diferente[0] |= (memcmp(esperado.data(), obtido.data(), a.size()) != 0);
+
+			// Cópia de cada canal
+			for (c = 0; c < 3; c++)
 			{
-				datadst[pos] = 1;
+				memcpy(esperado.data(), a.data(), a.size());
+				memcpy(obtido.data(), a.data(), a.size());
+				ref->canal(esperado.data() + inicio, n, c);
+				var->canal(obtido.data() + inicio, n, c);
+				diferente[1] |= (memcmp(esperado.data(), obtido.data(), a.size()) != 0);
 			}
-			else
+
+			// RGB para cinzento
+			memset(esperado.data(), 0, esperado.size());
+			memset(obtido.data(), 0, obtido.size());
+			ref->cinzento(a.data() + inicio, esperado.data(), n);
+			var->cinzento(a.data() + inicio, obtido.data(), n);
+			diferente[2] |= (memcmp(esperado.data(), obtido.data(), a.size()) != 0);
+
+			// Limiarização, com limiares nos extremos e no meio
+			for (t = 0; t < 256; t += (n == maximo) ? 1 : 51)
 			{
-				datadst[pos] = 0;
+				memset(esperado.data(), 7, esperado.size());
+				memset(obtido.data(), 7, obtido.size());
+				ref->limiar(a.data() + inicio, esperado.data() + inicio, 3 * n, t);
+				var->limiar(a.data() + inicio, obtido.data() + inicio, 3 * n, t);
+				diferente[3] |= (memcmp(esperado.data(), obtido.data(), a.size()) != 0);
 			}
+
+			// Soma de máscaras
+			memset(esperado.data(), 7, esperado.size());
+			memset(obtido.data(), 7, obtido.size());
+			ref->ou(a.data() + inicio, b.data(), esperado.data() + inicio, 3 * n);
+			var->ou(a.data() + inicio, b.data(), obtido.data() + inicio, 3 * n);
+			diferente[4] |= (memcmp(esperado.data(), obtido.data(), a.size()) != 0);
 		}
 	}
-	return 1;
+
+	// Todas as cores (4096 píxeis RGB de cada vez)
+	for (long int cor = 0; (cor < (1L << 24)) && !diferente[2]; cor += 4096)
+	{
+		for (long int i = 0; i < 4096; i++)
+		{
+			a[3 * i] = (unsigned char)((cor + i) >> 16);
+			a[3 * i + 1] = (unsigned char)((cor + i) >> 8);
+			a[3 * i + 2] = (unsigned char)(cor + i);
+		}
+
+		ref->cinzento(a.data(), esperado.data(), 4096);
+		var->cinzento(a.data(), obtido.data(), 4096);
+		diferente[2] |= (memcmp(esperado.data(), obtido.data(), 4096) != 0);
+	}
+
+	for (int k = 0; k < VC_SIMD_NKERNELS; k++) total += diferente[k];
+
+	return total;
 }
 
 #pragma endregion
 
-#pragma	region Função: vc_binary_erode
+#pragma region Função: vc_gray_negative
 /**
- * Função: vc_binary_erode
- * ------------------------
- * Aplica a operação de **erosão morfológica** a uma imagem binária.
- * Para cada píxel ativo (valor 1), verifica se **todos os vizinhos** na janela definida pelo kernel
- * também estão ativos. Se algum vizinho for 0, o píxel será erodido (definido como 0).
- *
- * Parâmetros:
- *   src     - imagem binária de entrada (1 canal, valores 0 ou 1)
- *   dst     - imagem binária de saída (1 canal, mesma dimensão)
- *   kernel  - tamanho do kernel (deve ser ímpar, ex: 3, 5, 7...)
+ * Função: vc_gray_negative
+ * -------------------------
+ * Aplica o negativo a uma imagem em tons de cinzento (grayscale),
+ * ou seja, inverte a intensidade de cada pixel: pixel = 255 - pixel.
+ * Cada linha é processada pelo kernel do nível SIMD em uso (ver vc_simd_nivel).
+ *
+ * Parâmetros:
+ *   srddst - ponteiro para a estrutura IVC contendo a imagem a ser processada
  *
  * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ *   1 se a operação for bem-sucedida, 0 caso contrário
  */
 
-int vc_binary_erode(IVC* src, IVC* dst, int kernel)
+int vc_gray_negative(IVC* srddst)
+{
+	unsigned char* data = (unsigned char*)srddst->data;
+	int width = srddst->width;
+	int height = srddst->height;
+	int channels = srddst->channels;
+	int bytesperline = srddst->bytesperline;
+	const VC_SIMD_KERNELS* simd = vc_simd();
+	int y;
+
+	// Verifica se os parâmetros são válidos
+	if (width <= 0 || height <= 0 || data == NULL)
+		return 0;
+
+	// Verifica se a imagem é em tons de cinzento
+	if (channels != 1)
+		return 0;
+
+	// Inverte a intensidade dos píxeis de cada linha (negativo)
+	for (y = 0; y < height; y++)
+	{
+		simd->negativo(data + (long int)y * bytesperline, width);
+	}
+
+	return 1;
+}
+#pragma endregion
+
+#pragma region Função: vc_rgb_negative
+
+/**
+ * Função: vc_rgb_negative
+ * -----------------------
+ * Aplica o negativo a uma imagem RGB (3 canais), invertendo os valores
+ * de cada componente de cor (R, G e B) de cada pixel: componente = 255 - componente.
+ * Cada linha é processada pelo kernel do nível SIMD em uso (ver vc_simd_nivel).
+ *
+ * Parâmetros:
+ *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_rgb_negative(IVC* srcdst)
+{
+	int y;
+	unsigned char* data = (unsigned char*)srcdst->data;
+	const VC_SIMD_KERNELS* simd = vc_simd();
+
+	// Verifica se o ponteiro para a imagem é válido
+	if (srcdst == NULL) return 0;
+
+	// Inverte os valores dos três canais (R, G, B) de cada linha
+	for (y = 0; y < srcdst->height; y++)
+	{
+		simd->negativo(data + (long int)srcdst->bytesperline * y, 3L * srcdst->width);
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_rgb_get_red_gray
+/**
+ * Função: vc_rgb_get_red_gray
+ * ---------------------------
+ * Converte uma imagem RGB para tons de cinzento utilizando apenas o canal vermelho (R).
+ * O valor do vermelho de cada pixel é copiado para os canais verde (G) e azul (B),
+ * criando uma imagem cinzenta baseada apenas na intensidade do vermelho.
+ *
+ * Parâmetros:
+ *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_rgb_get_red_gray(IVC* srcdst)
+{
+	int y;
+
+	// Acede aos dados da imagem como vetor de bytes
+	unsigned char* data = (unsigned char*)srcdst->data;
+	const VC_SIMD_KERNELS* simd = vc_simd();
+
+	// Verifica se o ponteiro para a estrutura é válido
+	if (srcdst == NULL) return 0;
+
+	// Copia o valor do canal vermelho para os outros canais, linha a linha
+	for (y = 0; y < srcdst->height; y++)
+	{
+		simd->canal(data + (long int)srcdst->bytesperline * y, srcdst->width, 0);
+	}
+
+	return 1;
+}
+#pragma endregion
+
+#pragma region Função: vc_rgb_get_green_gray
+
+/**
+ * Função: vc_rgb_get_green_gray
+ * -----------------------------
+ * Converte uma imagem RGB para tons de cinzento utilizando apenas o canal verde (G).
+ * O valor do verde de cada pixel é copiado para os canais vermelho (R) e azul (B),
+ * criando uma imagem cinzenta baseada apenas na intensidade do verde.
+ *
+ * Parâmetros:
+ *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_rgb_get_green_gray(IVC* srcdst)
+{
+	int y;
+
+	// Acede aos dados da imagem como vetor de bytes
+	unsigned char* data = (unsigned char*)srcdst->data;
+	const VC_SIMD_KERNELS* simd = vc_simd();
+
+	// Verifica se o ponteiro para a imagem é válido
+	if (srcdst == NULL) return 0;
+
+	// Copia o valor do canal verde para os outros canais, linha a linha
+	for (y = 0; y < srcdst->height; y++)
+	{
+		simd->canal(data + (long int)srcdst->bytesperline * y, srcdst->width, 1);
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_rgb_get_blue_gray
+
+/**
+ * Função: vc_rgb_get_blue_gray
+ * ----------------------------
+ * Converte uma imagem RGB para tons de cinzento utilizando apenas o canal azul (B).
+ * O valor do azul de cada pixel é copiado para os canais vermelho (R) e verde (G),
+ * criando uma imagem cinzenta baseada apenas na intensidade do azul.
+ *
+ * Parâmetros:
+ *   srcdst - ponteiro para a estrutura IVC contendo a imagem RGB a ser processada
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_rgb_get_blue_gray(IVC* srcdst)
+{
+	int y;
+
+	// Acede aos dados da imagem como vetor de bytes
+	unsigned char* data = (unsigned char*)srcdst->data;
+	const VC_SIMD_KERNELS* simd = vc_simd();
+
+	// Verifica se o ponteiro para a imagem é válido
+	if (srcdst == NULL) return 0;
+
+	// Copia o valor do canal azul para os outros canais, linha a linha
+	for (y = 0; y < srcdst->height; y++)
+	{
+		simd->canal(data + (long int)srcdst->bytesperline * y, srcdst->width, 2);
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_rgb_to_gray
+
+/**
+ * Função: vc_rgb_to_gray
+ * ----------------------
+ * Converte uma imagem RGB (3 canais) para uma imagem em tons de cinzento (1 canal),
+ * utilizando a fórmula de luminância ponderada:
+ * Gray = 0.299 * R + 0.587 * G + 0.114 * B
+ * Cada linha é convertida pelo kernel do nível SIMD em uso (ver vc_simd_nivel),
+ * com o mesmo resultado que a fórmula em double.
+ *
+ * Parâmetros:
+ *   src - ponteiro para a imagem de entrada (RGB)
+ *   dst - ponteiro para a imagem de saída (grayscale)
+ *
+ * Retorna:
+ *   1 se a conversão for bem-sucedida, 0 caso contrário
+ */
+
+int vc_rgb_to_gray(IVC* src, IVC* dst)
 {
+	int y;
+	const VC_SIMD_KERNELS* simd = vc_simd();
+
+	// Ponteiros para os dados das imagens de origem e destino
 	unsigned char* datasrc = (unsigned char*)src->data;
 	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int offset = (kernel - 1) / 2; // Metade do tamanho do kernel
-	int pos;
-	int i, j;
-	int pixel;
-	int posk;
 
-	// Verificações básicas
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
-		return 0;
-	if (src->channels != 1)
-		return 0;
+	// Verifica se os ponteiros são válidos
+	if (src == NULL || dst == NULL) return 0;
+
+	// Verifica se a imagem de origem tem 3 canais e a de destino tem 1
+	if (src->channels != 3 || dst->channels != 1) return 0;
+
+	// Aplica a fórmula da luminância a cada linha e guarda o valor na imagem grayscale
+	for (y = 0; y < src->height; y++)
+	{
+		simd->cinzento(datasrc + (long int)y * src->bytesperline, datadst + (long int)y * dst->bytesperline, src->width);
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_rgb_to_hsv
+/**
+ * Função: vc_rgb_to_hsv
+ * ---------------------
+ * Converte uma imagem RGB (3 canais) para o espaço de cor HSV (Hue, Saturation, Value).
+ * Os valores HSV resultantes são armazenados também como imagem com 3 canais (cada componente em [0,255]).
+ *
+ * Parâmetros:
+ *   src - ponteiro para a imagem RGB de entrada
+ *   dst - ponteiro para a imagem HSV de saída
+ *
+ * Retorna:
+ *   1 se a conversão for bem-sucedida, 0 caso contrário
+ */
+
+int vc_rgb_to_hsv(IVC* src, IVC* dst)
+{
+	int x, y;
+	long int pos;
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	float r, g, b, hue, saturation, value, min, max, delta;
+
+	// Verificações básicas de ponteiros e canais
+	if (src == NULL || dst == NULL) return 0;
+	if (src->channels != 3 || dst->channels != 3) return 0;
+
+	// Percorre todos os pixels da imagem
+	for (y = 0; y < src->height; y++)
+	{
+		for (x = 0; x < src->width; x++)
+		{
+			pos = y * src->bytesperline + x * src->channels;
+
+			// Obtém os valores RGB e normaliza para [0,1]
+			r = (float)datasrc[pos];
+			g = (float)datasrc[pos + 1];
+			b = (float)datasrc[pos + 2];
+			r /= 255.0f;
+			g /= 255.0f;
+			b /= 255.0f;
+
+			// Calcula os valores máximo e mínimo entre R, G, B
+			max = (r > g) ? ((r > b) ? r : b) : ((g > b) ? g : b);
+			min = (r < g) ? ((r < b) ? r : b) : ((g < b) ? g : b);
+			delta = max - min;
+
+			// Valor (V) corresponde ao máximo dos canais RGB
+			value = max;
+
+			// Saturação (S)
+			if (max > 0.0f)
+				saturation = delta / max;
+			else
+				saturation = 0.0f;
+
+			// Matiz (H)
+			if (delta == 0)
+				hue = 0.0f; // Sem matiz (cor neutra)
+			else
+			{
+				if (r == max) hue = (g - b) / delta;
+				else if (g == max) hue = 2.0f + (b - r) / delta;
+				else hue = 4.0f + (r - g) / delta;
+
+				hue *= 60.0f;
+				if (hue < 0.0f) hue += 360.0f;
+			}
+
+			// Converte H, S e V para a escala de 0 a 255
+			datadst[pos] = (unsigned char)(hue / 360.0f * 255.0f);  // H
+			datadst[pos + 1] = (unsigned char)(saturation * 255.0f);    // S
+			datadst[pos + 2] = (unsigned char)(value * 255.0f);         // V
+		}
+	}
+
+	return 1;  // Sucesso
+}
+
+
+#pragma endregion
+
+#pragma region Função: vc_hsv_segmentation
+/**
+ * Função: vc_hsv_segmentation
+ * ---------------------------
+ * Realiza a segmentação de uma imagem HSV com base em intervalos de H (matiz), S (saturação) e V (valor).
+ * Pixels dentro do intervalo definido são marcados como "1" (ou valor máximo em `dst->levels - 1`), os restantes são definidos como 0.
+ * A imagem de destino deve ser binária (1 canal).
+ *
+ * Parâmetros:
+ *   src   - imagem HSV de entrada (3 canais)
+ *   dst   - imagem binária de saída (1 canal)
+ *   hmin  - valor mínimo de matiz (H), em graus (0–360)
+ *   hmax  - valor máximo de matiz (H), em graus (0–360)
+ *   smin  - saturação mínima (0–100)
+ *   smax  - saturação máxima (0–100)
+ *   vmin  - valor mínimo de brilho (0–100)
+ *   vmax  - valor máximo de brilho (0–100)
+ *
+ * Retorna:
+ *   1 se a segmentação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_hsv_segmentation(IVC* src, IVC* dst, int hmin, int hmax, int smin, int smax, int vmin, int vmax)
+{
+	if (!src || !dst || src->channels != 3 || dst->channels != 1)
+		return 0;
+
+	int x, y, i = 0;
+	for (y = 0; y < src->height; y++)
+	{
+		for (x = 0; x < src->width; x++, i += 3)
+		{
+			int h = src->data[i];
+			int s = src->data[i + 1];
+			int v = src->data[i + 2];
+			int pos = y * dst->bytesperline + x;
+
+			if (h >= hmin && h <= hmax &&
+				s >= smin && s <= smax &&
+				v >= vmin && v <= vmax)
+			{
+				dst->data[pos] = 255;
+			}
+			else
+			{
+				dst->data[pos] = 0;
+			}
+		}
+	}
+	return 1;
+}
+
+
+#pragma endregion
+
+#pragma region Função: vc_scale_gray_to_color_palette
+/**
+ * Função: vc_scale_gray_to_color_palette
+ * --------------------------------------
+ * Converte uma imagem em tons de cinzento (grayscale, 1 canal) para uma imagem RGB (3 canais),
+ * aplicando uma paleta de cores tipo "Jet", que vai do azul ao vermelho, passando por ciano, verde e amarelo.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada em grayscale (1 canal)
+ *   dst - imagem de saída em RGB (3 canais), com as mesmas dimensões da original
+ *
+ * Retorna:
+ *   1 se a conversão for bem-sucedida, 0 caso contrário
+ */
+
+int vc_scale_gray_to_color_palette(IVC* src, IVC* dst) {
+	// Verificações básicas
+	if (src == NULL || dst == NULL) return 0;
+	if (src->channels != 1 || dst->channels != 3) return 0; // Entrada deve ser grayscale e saída RGB
+	if (src->width != dst->width || src->height != dst->height) return 0; // As dimensões devem ser iguais
+
+	unsigned char* src_data = src->data;
+	unsigned char* dst_data = dst->data;
+	int width = src->width;
+	int height = src->height;
+
+	// Percorre todos os píxeis da imagem
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int index_gray = y * width + x;   // Índice do píxel na imagem grayscale
+			int index_rgb = index_gray * 3;   // Índice correspondente na imagem RGB
+
+			unsigned char gray = src_data[index_gray]; // Valor do píxel em grayscale
+
+			// Mapeamento de cinzento para cor com paleta "Jet"
+			unsigned char r, g, b;
+
+			if (gray < 64) {        // Azul → Ciano
+				r = 0;
+				g = 4 * gray;
+				b = 255;
+			}
+			else if (gray < 128) {  // Ciano → Verde
+				r = 0;
+				g = 255;
+				b = 255 - (4 * (gray - 64));
+			}
+			else if (gray < 192) {  // Verde → Amarelo
+				r = 4 * (gray - 128);
+				g = 255;
+				b = 0;
+			}
+			else {                  // Amarelo → Vermelho
+				r = 255;
+				g = 255 - (4 * (gray - 192));
+				b = 0;
+			}
+
+			// Escreve os valores RGB no destino
+			dst_data[index_rgb] = r; // Red
+			dst_data[index_rgb + 1] = g; // Green
+			dst_data[index_rgb + 2] = b; // Blue
+		}
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_gray_to_binary
+
+/**
+ * Função: vc_gray_to_binary
+ * -------------------------
+ * Converte uma imagem em tons de cinzento (grayscale, 1 canal) para uma imagem binária (1 canal),
+ * com base num valor de limiar (threshold).
+ * Todos os píxeis com valor >= threshold são definidos como 1 (branco), os restantes como 0 (preto).
+ * Cada linha é processada pelo kernel do nível SIMD em uso (ver vc_simd_nivel).
+ *
+ * Parâmetros:
+ *   src       - imagem de entrada (grayscale)
+ *   dst       - imagem de saída (binária)
+ *   threshold - valor de limiar para binarização (0–255)
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_gray_to_binary(IVC* src, IVC* dst, int threshold)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int bytesperline = src->bytesperline;
+	int channels = src->channels;
+	int width = src->width;
+	int height = src->height;
+	int y;
+
+	// Os kernels SIMD comparam bytes: fora de 0 a 255 (todos ou nenhum píxel) fica o escalar
+	void (*limiar)(const unsigned char*, unsigned char*, long int, int) =
+		((threshold >= 0) && (threshold <= 255)) ? vc_simd()->limiar : vc_limiar_escalar;
+
+	// Verificações de validade da imagem de entrada e saída
+	if ((width <= 0) || (height <= 0) || (datasrc == NULL))
+		return 0;
+	if ((dst->width <= 0) || (dst->height < height) || (dst->channels != channels))
+		return 0;
+	if (channels != 1)
+		return 0;
+
+	// Aplica limiarização a cada linha: >= threshold → 255, senão → 0
+	for (y = 0; y < height; y++)
+	{
+		limiar(datasrc + (long int)y * bytesperline, datadst + (long int)y * bytesperline, width, threshold);
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_gray_to_binary_global_mean
+/**
+ * Função: vc_gray_to_binary_global_mean
+ * -------------------------------------
+ * Converte uma imagem em tons de cinzento (grayscale, 1 canal) para uma imagem binária (1 canal),
+ * utilizando como limiar o valor da média global dos píxeis da imagem.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada em grayscale
+ *   dst - imagem de saída binária (1 canal)
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_gray_to_binary_global_mean(IVC* src, IVC* dst)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	int channels = src->channels;
+	int width = src->width;
+	int height = src->height;
+	unsigned int hist[256];
+	long long sum = 0;
+	int i;
+	int threshold;
+
+	// Verificações básicas
+	if ((width <= 0) || (height <= 0) || (datasrc == NULL))
+		return 0;
+	if ((dst->width <= 0) || (dst->height < height) || (dst->channels != channels))
+		return 0;
+	if (channels != 1)
+		return 0;
+
+	// Calcula a soma de todos os valores de píxeis (a partir do histograma partilhado)
+	vc_gray_histogram(src, hist);
+	for (i = 0; i < 256; i++)
+	{
+		sum += (long long)i * hist[i];
+	}
+
+	// Calcula a média (limiar global)
+	threshold = (int)(sum / ((long long)width * height));
+
+	// Aplica a binarização com o limiar calculado
+	vc_gray_to_binary(src, dst, threshold);
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_gray_to_binary_midpoint
+
+/**
+ * Função: vc_gray_to_binary_midpoint
+ * ----------------------------------
+ * Aplica binarização adaptativa a uma imagem grayscale usando o método do ponto médio (midpoint).
+ * Para cada píxel, calcula-se o valor médio entre o mínimo e o máximo numa vizinhança (janela)
+ * e esse valor é usado como limiar local.
+ *
+ * Parâmetros:
+ *   src        - imagem de entrada (grayscale, 1 canal)
+ *   dst        - imagem binária de saída (1 canal, mesma dimensão da entrada)
+ *   kernelSize - tamanho da janela (deve ser ímpar, ex: 3, 5, 7...)
+ *
+ * Se src tiver uma borda de guarda de pelo menos kernelSize/2 píxeis (vc_image_new_border), a janela
+ * inclui a borda em vez de ser cortada nos limites.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_gray_to_binary_midpoint(IVC* src, IVC* dst, int kernelSize)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int pos, max, min;
+	int offset = (kernelSize - 1) / 2;
+	int treshold;
+	int guarda = (src->border >= offset); // Borda de guarda: janela completa sem verificar limites
+
+	// Verificações básicas
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
+		return 0;
+	if (src->channels != 1)
+		return 0;
+
+	// Binarização usando ponto médio local
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			max = 0;
+			min = src->levels - 1;
+
+			// Percorre a janela local
+			for (ky = -offset; ky < offset; ky++)
+			{
+				for (kx = -offset; kx < offset; kx++)
+				{
+					if (guarda || ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width)))
+					{
+						int localPos = (y + ky) * bytesperline + (x + kx) * channels;
+						unsigned char value = datasrc[localPos];
+
+						if (value > max) max = value;
+						if (value < min) min = value;
+					}
+				}
+			}
+
+			// Calcula o limiar como a média entre o máximo e o mínimo
+			treshold = (unsigned char)((float)(max + min) / 2);
+
+			// Aplica binarização ao píxel atual
+			pos = y * bytesperline + x * channels;
+			if (datasrc[pos] > treshold)
+				datadst[y * bytesperlinedst + x * channels] = 255;
+			else
+				datadst[y * bytesperlinedst + x * channels] = 0;
+		}
+	}
+
+	return vc_image_fill_border(dst);
+}
+
+#pragma endregion
+
+#pragma region Função: vc_gray_to_binary_bernsen
+
+/**
+ * Função: vc_gray_to_binary_bernsen
+ * ---------------------------------
+ * Aplica binarização adaptativa a uma imagem em tons de cinzento utilizando o método de Bernsen.
+ * Para cada píxel, calcula o mínimo e máximo na sua vizinhança. Se o contraste local (max - min)
+ * for menor que um valor limite (`cmin`), o píxel é definido como fundo. Caso contrário, o limiar
+ * é definido como a média entre max e min.
+ *
+ * Parâmetros:
+ *   src        - imagem de entrada em grayscale (1 canal)
+ *   dst        - imagem de saída binária (1 canal)
+ *   kernelSize - tamanho da janela (deve ser ímpar)
+ *   cmin       - valor mínimo de contraste local
+ *
+ * Se src tiver uma borda de guarda de pelo menos kernelSize/2 píxeis (vc_image_new_border), a janela
+ * inclui a borda em vez de ser cortada nos limites.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_gray_to_binary_bernsen(IVC* src, IVC* dst, int kernelSize, int cmin)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int max, min;
+	int offset = (kernelSize - 1) / 2;
+	int pos;
+	unsigned char treshold;
+	int guarda = (src->border >= offset); // Borda de guarda: janela completa sem verificar limites
+
+	// Verificações básicas
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
+		return 0;
+	if (src->channels != 1)
+		return 0;
+
+	// Binarização usando método de Bernsen
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			max = 0;
+			min = src->levels - 1;
+
+			// Percorre a janela local
+			for (ky = -offset; ky < offset; ky++)
+			{
+				for (kx = -offset; kx < offset; kx++)
+				{
+					if (guarda || ((y + ky >= 0) && (y + ky < height) &&
+						(x + kx >= 0) && (x + kx < width)))
+					{
+						pos = (y + ky) * bytesperline + (x + kx) * channels;
+
+						if (datasrc[pos] > max)
+							max = datasrc[pos];
+						if (datasrc[pos] < min)
+							min = datasrc[pos];
+					}
+				}
+			}
+
+			// Define o limiar de acordo com o contraste local
+			if ((max - min) < cmin)
+				treshold = (unsigned char)((float)(src->levels) / 2.0); // Contraste baixo: assume fundo
+			else
+				treshold = (unsigned char)((float)(max + min) / 2.0);   // Contraste suficiente: usa média local
+
+			pos = y * bytesperline + x * channels;
+
+			if (datasrc[pos] > treshold)
+				datadst[y * bytesperlinedst + x * channels] = 255;
+			else
+				datadst[y * bytesperlinedst + x * channels] = 0;
+
+		}
+	}
+
+	return vc_image_fill_border(dst);
+}
+
+#pragma endregion
+
+#pragma region Função: vc_gray_to_binary_niblack
+
+// Limiar de Niblack de um píxel com a janela cortada pelos limites da imagem (mesmas contas da versão genérica)
+static inline unsigned char vc_niblack_pixel(const unsigned char* datasrc, int width, int height, int bytesperline, int x, int y, int offset, float k)
+{
+	int ky0 = MAX(-offset, -y), ky1 = MIN(offset, height - 1 - y);
+	int kx0 = MAX(-offset, -x), kx1 = MIN(offset, width - 1 - x);
+	float sum = 0.0f, sumsq = 0.0f;
+	int n = (ky1 - ky0 + 1) * (kx1 - kx0 + 1);
+	int ky, kx;
+
+	for (ky = ky0; ky <= ky1; ky++)
+		for (kx = kx0; kx <= kx1; kx++)
+			sum += datasrc[(y + ky) * bytesperline + x + kx];
+
+	float mean = sum / n;
+
+	for (ky = ky0; ky <= ky1; ky++)
+		for (kx = kx0; kx <= kx1; kx++)
+		{
+			float d = (float)datasrc[(y + ky) * bytesperline + x + kx] - mean;
+			sumsq += d * d;
+		}
+
+	unsigned char threshold = (unsigned char)(mean + k * sqrtf(sumsq / n));
+
+	return (datasrc[y * bytesperline + x] > threshold) ? 255 : 0;
+}
+
+// Niblack com o tamanho da janela conhecido na compilação: no interior, a janela K x K é lida sem
+// verificação de limites e os ciclos da janela são desenrolados; junto aos limites usa vc_niblack_pixel.
+// Com borda de guarda (margem = 0), toda a imagem é tratada como interior.
+template <int K>
+static void vc_gray_to_binary_niblack_k(const unsigned char* datasrc, unsigned char* datadst, int width, int height, int bytesperline, int bytesperlinedst, int margem, float k)
+{
+	const int offset = K / 2;
+	float janela[K * K];
+
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char* linhadst = datadst + y * bytesperlinedst;
+
+		if (y < margem || y >= height - margem)
+		{
+			for (int x = 0; x < width; x++) linhadst[x] = vc_niblack_pixel(datasrc, width, height, bytesperline, x, y, offset, k);
+			continue;
+		}
+
+		const unsigned char* linha0 = datasrc + (y - offset) * bytesperline;
+
+		for (int x = 0; x < margem; x++) linhadst[x] = vc_niblack_pixel(datasrc, width, height, bytesperline, x, y, offset, k);
+
+		for (int x = margem; x < width - margem; x++)
+		{
+			float sum = 0.0f, sumsq = 0.0f;
+
+			for (int ky = 0; ky < K; ky++)
+				for (int kx = 0; kx < K; kx++)
+				{
+					janela[ky * K + kx] = (float)linha0[ky * bytesperline + x - offset + kx];
+					sum += janela[ky * K + kx];
+				}
+
+			float mean = sum / (K * K);
+
+			for (int i = 0; i < K * K; i++)
+			{
+				float d = janela[i] - mean;
+				sumsq += d * d;
+			}
+
+			unsigned char threshold = (unsigned char)(mean + k * sqrtf(sumsq / (K * K)));
+			linhadst[x] = (linha0[offset * bytesperline + x] > threshold) ? 255 : 0;
+		}
+
+		for (int x = width - margem; x < width; x++) linhadst[x] = vc_niblack_pixel(datasrc, width, height, bytesperline, x, y, offset, k);
+	}
+}
+
+/**
+ * Função: vc_gray_to_binary_niblack
+ * ---------------------------------
+ * Aplica binarização adaptativa a uma imagem em tons de cinzento usando o método de Niblack.
+ * O limiar é calculado dinamicamente para cada píxel com base na média (mean) e desvio padrão (stdev)
+ * da sua vizinhança (janela). O limiar local é definido como: threshold = mean + k * stdev.
+ *
+ * Parâmetros:
+ *   src        - imagem de entrada em grayscale (1 canal)
+ *   dst        - imagem de saída binária (1 canal)
+ *   kernelSize - tamanho da janela (deve ser ímpar)
+ *   k          - fator multiplicador do desvio padrão (ajusta a sensibilidade)
+ *
+ * Janelas de 3, 5, 7 e 9 usam versões especializadas (vc_gray_to_binary_niblack_k), com o mesmo resultado.
+ * Se src tiver uma borda de guarda de pelo menos kernelSize/2 píxeis (vc_image_new_border), a janela
+ * inclui a borda em vez de ser cortada nos limites.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário
+ */
+
+int vc_gray_to_binary_niblack(IVC* src, IVC* dst, int kernelSize, float k)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int offset = (kernelSize - 1) / 2; // Offset da janela (metade do kernel)
+	int pos;
+	float sum, sumsq;
+	float mean, stdev;
+	unsigned char threshold;
+	int guarda = (src->border >= offset); // Borda de guarda: janela completa sem verificar limites
+
+	// Verificações básicas
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
+		return 0;
+	if (src->channels != 1)
+		return 0;
+
+	// Tamanhos comuns: versão com a janela fixa na compilação
+	if (guarda || ((width >= kernelSize) && (height >= kernelSize)))
+	{
+		int margem = guarda ? 0 : offset;
+
+		switch (kernelSize)
+		{
+		case 3: vc_gray_to_binary_niblack_k<3>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, k); return vc_image_fill_border(dst);
+		case 5: vc_gray_to_binary_niblack_k<5>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, k); return vc_image_fill_border(dst);
+		case 7: vc_gray_to_binary_niblack_k<7>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, k); return vc_image_fill_border(dst);
+		case 9: vc_gray_to_binary_niblack_k<9>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, k); return vc_image_fill_border(dst);
+		}
+	}
+
+	// Binarização usando método de Niblack
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			sum = 0.0;
+			sumsq = 0.0;
+			int counter_mean = 0;
+
+			// Calcula a soma dos valores dos píxeis na vizinhança
+			for (ky = -offset; ky <= offset; ky++)
+			{
+				for (kx = -offset; kx <= offset; kx++)
+				{
+					if (guarda || ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width)))
+					{
+						pos = (y + ky) * bytesperline + (x + kx) * channels;
+						sum += datasrc[pos];
+						counter_mean++; // Número de elementos somados
+					}
+				}
+			}
+
+			mean = sum / counter_mean; // Média da janela
+			int counter_stdev = 0;
+
+			// Calcula o desvio padrão dos valores da janela
+			for (ky = -offset; ky <= offset; ky++)
+			{
+				for (kx = -offset; kx <= offset; kx++)
+				{
+					if (guarda || ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width)))
+					{
+						pos = (y + ky) * bytesperline + (x + kx) * channels;
+						float d = (float)datasrc[pos] - mean;
+						sumsq += d * d; // Soma dos quadrados da diferença
+						counter_stdev++;
+					}
+				}
+			}
+
+			stdev = sqrtf(sumsq / counter_stdev); // Desvio padrão da janela
+
+			// Calcula limiar adaptativo
+			threshold = (unsigned char)(mean + k * stdev);
+
+			pos = y * bytesperline + x * channels;
+
+			// Aplica binarização
+			if (datasrc[pos] > threshold)
+				datadst[y * bytesperlinedst + x * channels] = 255;
+			else
+				datadst[y * bytesperlinedst + x * channels] = 0;
+		}
+	}
+	return vc_image_fill_border(dst);
+}
+
+#pragma endregion
+
+#pragma region Função: vc_binary_dilate
+
+// Dilatação (OR da janela) ou erosão (AND da janela) com o kernel K x K conhecido na compilação.
+// Cada linha é reduzida primeiro na vertical (K linhas) para `coluna` e depois na horizontal (K colunas),
+// com os ciclos da janela desenrolados e sem verificações de limites: fora da imagem, `coluna` tem o
+// elemento neutro da operação, o que equivale à janela cortada da versão genérica. Com borda de
+// guarda (`guarda`), as colunas e linhas fora da imagem são lidas da borda.
+template <int K, int DILATAR>
+static void vc_binary_morph_k(const unsigned char* datasrc, unsigned char* datadst, int width, int height, int bytesperline, int bytesperlinedst, int guarda, unsigned char* coluna)
+{
+	const int offset = K / 2;
+	const unsigned char neutro = DILATAR ? 0 : 0xFF;
+	unsigned char* c = coluna + offset;
+	int x0 = guarda ? -offset : 0;
+	int x1 = guarda ? width + offset : width;
+
+	for (int x = 0; x < offset && !guarda; x++)
+	{
+		coluna[x] = neutro;
+		c[width + x] = neutro;
+	}
+
+	for (int y = 0; y < height; y++)
+	{
+		// Redução vertical
+		if (guarda || ((y >= offset) && (y < height - offset)))
+		{
+			const unsigned char* l = datasrc + (y - offset) * bytesperline;
+
+			for (int x = x0; x < x1; x++)
+			{
+				unsigned char v = l[x];
+				for (int ky = 1; ky < K; ky++) v = DILATAR ? (v | l[ky * bytesperline + x]) : (v & l[ky * bytesperline + x]);
+				c[x] = v;
+			}
+		}
+		else
+		{
+			int y0 = MAX(y - offset, 0), y1 = MIN(y + offset, height - 1);
+
+			memcpy(c, datasrc + y0 * bytesperline, width);
+			for (int yy = y0 + 1; yy <= y1; yy++)
+			{
+				const unsigned char* l = datasrc + yy * bytesperline;
+				for (int x = 0; x < width; x++) c[x] = DILATAR ? (c[x] | l[x]) : (c[x] & l[x]);
+			}
+		}
+
+		// Redução horizontal
+		unsigned char* linhadst = datadst + y * bytesperlinedst;
+
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char v = c[x - offset];
+			for (int kx = 1; kx < K; kx++) v = DILATAR ? (v | c[x - offset + kx]) : (v & c[x - offset + kx]);
+			linhadst[x] = (v != 0);
+		}
+	}
+}
+
+// Escolhe a versão especializada para kernels de 3, 5, 7 e 9 (devolve 0 para os restantes tamanhos)
+static int vc_binary_morph_especializada(const unsigned char* datasrc, unsigned char* datadst, int width, int height, int bytesperline, int bytesperlinedst, int guarda, int kernel, int dilatar)
+{
+	if ((kernel != 3) && (kernel != 5) && (kernel != 7) && (kernel != 9)) return 0;
+
+	unsigned char* coluna = (unsigned char*)malloc(width + kernel);
+	if (coluna == NULL) return 0;
+
+	switch (kernel * 2 + (dilatar ? 1 : 0))
+	{
+	case 3 * 2 + 1: vc_binary_morph_k<3, 1>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	case 5 * 2 + 1: vc_binary_morph_k<5, 1>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	case 7 * 2 + 1: vc_binary_morph_k<7, 1>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	case 9 * 2 + 1: vc_binary_morph_k<9, 1>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	case 3 * 2: vc_binary_morph_k<3, 0>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	case 5 * 2: vc_binary_morph_k<5, 0>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	case 7 * 2: vc_binary_morph_k<7, 0>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	case 9 * 2: vc_binary_morph_k<9, 0>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, coluna); break;
+	}
+
+	free(coluna);
+	return 1;
+}
+
+/**
+ * Função: vc_binary_dilate
+ * -------------------------
+ * Aplica a operação de **dilatação morfológica** a uma imagem binária.
+ * Para cada píxel, verifica se há algum píxel ativo (≠ 0) na vizinhança (definida por um kernel quadrado).
+ * Se houver, o píxel atual será definido como 1 (ativo). Caso contrário, permanece 0.
+ *
+ * Parâmetros:
+ *   src     - imagem binária de entrada (1 canal, valores 0 ou 1)
+ *   dst     - imagem binária de saída (1 canal, mesma dimensão)
+ *   kernel  - tamanho do kernel (deve ser ímpar, ex: 3, 5, 7...)
+ *
+ * Kernels de 3, 5, 7 e 9 usam versões especializadas (vc_binary_morph_k), com o mesmo resultado.
+ * Se src tiver uma borda de guarda de pelo menos kernel/2 píxeis (vc_image_new_border), a janela
+ * inclui a borda em vez de ser cortada nos limites.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+
+int vc_binary_dilate(IVC* src, IVC* dst, int kernel)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int offset = (kernel - 1) / 2; // Metade do tamanho do kernel
+	int pos;
+	int i, j;
+	int pixel;
+	int posk;
+	int guarda = (src->border >= offset); // Borda de guarda: janela completa sem verificar limites
+
+	// Verificações básicas
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
+		return 0;
+	if (src->channels != 1)
+		return 0;
+
+	// Kernels de 3, 5, 7 e 9: versão com o kernel fixo na compilação
+	if (vc_binary_morph_especializada(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, kernel, 1))
+		return vc_image_fill_border(dst);
+
+	// Dilatação
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			pos = y * bytesperline + x * channels;
+			pixel = datasrc[pos]; // Valor atual do píxel
+
+			// Só processa se o pixel atual for 0 (para tentar ativá-lo)
+			if (pixel == 0)
+			{
+				for (ky = -offset; ky <= offset; ky++)
+				{
+					for (kx = -offset; kx <= offset; kx++)
+					{
+						posk = (y + ky) * bytesperline + (x + kx) * channels;
+
+						// Verifica se vizinho está dentro dos limites da imagem
+						if (guarda || ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width)))
+						{
+							// Se algum vizinho estiver ativo, ativa este pixel
+							pixel |= datasrc[posk];
+
+							// Se encontrou algum vizinho ativo, sai da busca
+							if (pixel != 0)
+							{
+								kx = offset;
+								ky = offset;
+							}
+						}
+					}
+				}
+			}
+
+			// Define o novo valor do píxel na imagem de saída
+			if (pixel != 0)
+			{
+				datadst[y * bytesperlinedst + x * channels] = 1;
+			}
+			else
+			{
+				datadst[y * bytesperlinedst + x * channels] = 0;
+			}
+		}
+	}
+	return vc_image_fill_border(dst);
+}
+
+#pragma endregion
+
+#pragma	region Função: vc_binary_erode
+/**
+ * Função: vc_binary_erode
+ * ------------------------
+ * Aplica a operação de **erosão morfológica** a uma imagem binária.
+ * Para cada píxel ativo (valor 1), verifica se **todos os vizinhos** na janela definida pelo kernel
+ * também estão ativos. Se algum vizinho for 0, o píxel será erodido (definido como 0).
+ *
+ * Parâmetros:
+ *   src     - imagem binária de entrada (1 canal, valores 0 ou 1)
+ *   dst     - imagem binária de saída (1 canal, mesma dimensão)
+ *   kernel  - tamanho do kernel (deve ser ímpar, ex: 3, 5, 7...)
+ *
+ * Kernels de 3, 5, 7 e 9 usam versões especializadas (vc_binary_morph_k), com o mesmo resultado.
+ * Se src tiver uma borda de guarda de pelo menos kernel/2 píxeis (vc_image_new_border), a janela
+ * inclui a borda em vez de ser cortada nos limites.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+
+int vc_binary_erode(IVC* src, IVC* dst, int kernel)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int offset = (kernel - 1) / 2; // Metade do tamanho do kernel
+	int pos;
+	int i, j;
+	int pixel;
+	int posk;
+	int guarda = (src->border >= offset); // Borda de guarda: janela completa sem verificar limites
+
+	// Verificações básicas
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if (src->width != dst->width || src->height != dst->height || src->channels != dst->channels)
+		return 0;
+	if (src->channels != 1)
+		return 0;
+
+	// Kernels de 3, 5, 7 e 9: versão com o kernel fixo na compilação
+	if (vc_binary_morph_especializada(datasrc, datadst, width, height, bytesperline, bytesperlinedst, guarda, kernel, 0))
+		return vc_image_fill_border(dst);
+
+	// Erosão
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			pos = y * bytesperline + x * channels;
+			pixel = datasrc[pos]; // Valor do píxel atual
+
+			// Só processa se o pixel for 1 (ativo)
+			if (pixel != 0)
+			{
+				for (ky = -offset; ky <= offset; ky++)
+				{
+					for (kx = -offset; kx <= offset; kx++)
+					{
+						posk = (y + ky) * bytesperline + (x + kx) * channels;
+
+						// Verifica se o vizinho está dentro dos limites da imagem
+						if (guarda || ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width)))
+						{
+							// Erosão: se algum vizinho for 0, o resultado será 0
+							pixel &= datasrc[posk];
+
+							// Se encontrou vizinho 0, pode sair da busca
+							if (pixel == 0)
+							{
+								kx = offset;
+								ky = offset;
+							}
+						}
+					}
+				}
+			}
+
+			// Define o valor do píxel na imagem de saída
+			if (pixel != 0)
+			{
+				datadst[y * bytesperlinedst + x * channels] = 1;
+			}
+			else
+			{
+				datadst[y * bytesperlinedst + x * channels] = 0;
+			}
+		}
+	}
+	return vc_image_fill_border(dst);
+}
+
+#pragma endregion
+
+#pragma	region Função: vc_binary_open
+/**
+ * Função: vc_binary_open
+ * -----------------------
+ * Realiza a operação morfológica **abertura** numa imagem binária.
+ * Abertura = erosão seguida de dilatação. Serve para remover ruído pequeno (pontos brancos isolados).
+ *
+ * Parâmetros:
+ *   src              - imagem binária de entrada (1 canal)
+ *   dst              - imagem binária de saída
+ *   kernelsizeErode  - tamanho do kernel para a erosão
+ *   kernelsizeDilate - tamanho do kernel para a dilatação
+ *
+ * Retorna:
+ *   1 se ambas as operações forem bem-sucedidas, 0 caso contrário.
+ */
+
+int vc_binary_open(IVC* src, IVC* dst, int kernelsizeErode, int kernelsizeDilate)
+{
+	int ret = 1;
+
+	// Cria imagem temporária para armazenar o resultado da erosão
+	IVC* temp = vc_image_new(src->width, src->height, src->channels, src->levels);
+
+	// Aplica erosão e depois dilatação
+	ret &= vc_binary_erode(src, temp, kernelsizeErode);
+	ret &= vc_binary_dilate(temp, dst, kernelsizeDilate);
+
+	// Liberta a memória da imagem temporária
+	vc_image_free(temp);
+
+	return ret;
+}
+
+#pragma endregion
+
+#pragma	region Função: vc_binary_close
+/**
+ * Função: vc_binary_close
+ * ------------------------
+ * Realiza a operação morfológica **fecho (closing)** numa imagem binária.
+ * Fecho = dilatação seguida de erosão. Serve para preencher pequenos buracos ou falhas nos objetos.
+ *
+ * Parâmetros:
+ *   src              - imagem binária de entrada (1 canal)
+ *   dst              - imagem binária de saída
+ *   kernelsizeDilate - tamanho do kernel para a dilatação
+ *   kernelsizeErode  - tamanho do kernel para a erosão
+ *
+ * Retorna:
+ *   1 se ambas as operações forem bem-sucedidas, 0 caso contrário.
+ */
+
+int vc_binary_close(IVC* src, IVC* dst, int kernelsizeDilate, int kernelsizeErode)
+{
+	int ret = 1;
+
+	// Cria imagem temporária para armazenar o resultado da dilatação
+	IVC* temp = vc_image_new(src->width, src->height, src->channels, src->levels);
+
+	// Aplica dilatação seguida de erosão
+	ret &= vc_binary_dilate(src, temp, kernelsizeDilate);
+	ret &= vc_binary_erode(temp, dst, kernelsizeErode);
+
+	// Liberta a imagem temporária
+	vc_image_free(temp);
+
+	return ret;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_binary_blob_labelling
+/**
+ * Função: vc_binary_blob_labelling
+ * --------------------------------
+ * Realiza a etiquetagem de blobs (objetos) numa imagem binária.
+ * Cada blob é identificado com um número inteiro único (>0).
+ * Utiliza algoritmo de duas passagens com resolução de equivalências.
+ *
+ * As etiquetas provisórias estão limitadas a 254. Se não chegarem (muitos blobs, ou blobs que só
+ * se juntam mais abaixo na imagem), a imagem é etiquetada de novo sobre os runs (vc_runs_labelling),
+ * sem limite de etiquetas provisórias; nesse caso as etiquetas são 1 a nblobs e só os primeiros
+ * 255 blobs cabem em dst (os restantes ficam a fundo).
+ *
+ * Parâmetros:
+ *   src - imagem binária de entrada (1 canal, 0 ou 255)
+ *   dst - imagem de saída rotulada (1 canal)
+ *
+ * Retorna:
+ *   Número total de blobs encontrados.
+ */
+// Etiquetagens em que as 254 etiquetas provisórias não chegaram (refeitas sobre os runs)
+long int vc_etiquetas_excedidas = 0;
+
+// Etiquetagem sobre os runs, quando as etiquetas provisórias de vc_binary_blob_labelling não chegam
+static OVC* vc_binary_blob_labelling_runs(IVC* src, IVC* dst, int* nlabels)
+{
+	VC_RUNS* runs = vc_runs_new(1024);
+	OVC* blobs = NULL;
+
+	*nlabels = 0;
+
+	if (runs == NULL) return NULL;
+
+	if (vc_binary_to_runs(src, runs) >= 0)
+	{
+		blobs = vc_runs_labelling(runs, nlabels);
+	}
+
+	// Só as etiquetas até 255 cabem na imagem de saída
+	if (!vc_runs_paint(runs, dst) && (blobs != NULL))
+	{
+		*nlabels = MIN(*nlabels, 255);
+	}
+
+	vc_runs_free(runs);
+
+	return blobs;
+}
+
+OVC* vc_binary_blob_labelling(IVC* src, IVC* dst, int* nlabels)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int channels = src->channels;
+	int x, y, a, b;
+	long int i, size;
+	long int posX, posA, posB, posC, posD;
+	int labeltable[256] = { 0 };
+	int labelarea[256] = { 0 };
+	int label = 1; // Etiqueta inicial.
+	int num, tmplabel;
+	int excedidas = 0;
+	OVC* blobs; // Apontador para array de blobs (objectos) que será retornado desta função.
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return NULL;
+	if (channels != 1) return NULL;
+
+	// Copia dados da imagem binária para imagem grayscale
+	memcpy(datadst, datasrc, bytesperline * height);
+
+	// Todos os pixéis de plano de fundo devem obrigatóriamente ter valor 0
+	// Todos os pixéis de primeiro plano devem obrigatóriamente ter valor 255
+	// Serão atribuídas etiquetas no intervalo [1,254]
+	// Este algoritmo está assim limitado a 255 labels
+	for (i = 0, size = bytesperline * height; i < size; i++)
+	{
+		if (datadst[i] != 0) datadst[i] = 255;
+	}
+
+	// Limpa os rebordos da imagem binária
+	for (y = 0; y < height; y++)
+	{
+		datadst[y * bytesperline + 0 * channels] = 0;
+		datadst[y * bytesperline + (width - 1) * channels] = 0;
+	}
+	for (x = 0; x < width; x++)
+	{
+		datadst[0 * bytesperline + x * channels] = 0;
+		datadst[(height - 1) * bytesperline + x * channels] = 0;
+	}
+
+	// Efectua a etiquetagem
+	for (y = 1; (y < height - 1) && !excedidas; y++)
+	{
+		for (x = 1; x < width - 1; x++)
+		{
+			// Kernel:
+			// A B C
+			// D X
+
+			posA = (y - 1) * bytesperline + (x - 1) * channels; // A
+			posB = (y - 1) * bytesperline + x * channels; // B
+			posC = (y - 1) * bytesperline + (x + 1) * channels; // C
+			posD = y * bytesperline + (x - 1) * channels; // D
+			posX = y * bytesperline + x * channels; // X
+
+			// Se o pixel foi marcado
+			if (datadst[posX] != 0)
+			{
+				if ((datadst[posA] == 0) && (datadst[posB] == 0) && (datadst[posC] == 0) && (datadst[posD] == 0))
+				{
+					// Sem etiquetas livres: a etiquetagem é refeita sobre os runs
+					if (label > 254)
+					{
+						excedidas = 1;
+						break;
+					}
+					datadst[posX] = label;
+					labeltable[label] = label;
+					label++;
+				}
+				else
+				{
+					num = 255;
+
+					// Se A está marcado
+					if (datadst[posA] != 0) num = labeltable[datadst[posA]];
+					// Se B está marcado, e é menor que a etiqueta "num"
+					if ((datadst[posB] != 0) && (labeltable[datadst[posB]] < num)) num = labeltable[datadst[posB]];
+					// Se C está marcado, e é menor que a etiqueta "num"
+					if ((datadst[posC] != 0) && (labeltable[datadst[posC]] < num)) num = labeltable[datadst[posC]];
+					// Se D está marcado, e é menor que a etiqueta "num"
+					if ((datadst[posD] != 0) && (labeltable[datadst[posD]] < num)) num = labeltable[datadst[posD]];
+
+					// Atribui a etiqueta ao pixel
+					datadst[posX] = num;
+					labeltable[num] = num;
+
+					// Actualiza a tabela de etiquetas
+					if (datadst[posA] != 0)
+					{
+						if (labeltable[datadst[posA]] != num)
+						{
+							for (tmplabel = labeltable[datadst[posA]], a = 1; a < label; a++)
+							{
+								if (labeltable[a] == tmplabel)
+								{
+									labeltable[a] = num;
+								}
+							}
+						}
+					}
+					if (datadst[posB] != 0)
+					{
+						if (labeltable[datadst[posB]] != num)
+						{
+							for (tmplabel = labeltable[datadst[posB]], a = 1; a < label; a++)
+							{
+								if (labeltable[a] == tmplabel)
+								{
+									labeltable[a] = num;
+								}
+							}
+						}
+					}
+					if (datadst[posC] != 0)
+					{
+						if (labeltable[datadst[posC]] != num)
+						{
+							for (tmplabel = labeltable[datadst[posC]], a = 1; a < label; a++)
+							{
+								if (labeltable[a] == tmplabel)
+								{
+									labeltable[a] = num;
+								}
+							}
+						}
+					}
+					if (datadst[posD] != 0)
+					{
+						if (labeltable[datadst[posD]] != num)
+						{
+							for (tmplabel = labeltable[datadst[posD]], a = 1; a < label; a++)
+							{
+								if (labeltable[a] == tmplabel)
+								{
+									labeltable[a] = num;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (excedidas)
+	{
+		vc_etiquetas_excedidas++;
+		return vc_binary_blob_labelling_runs(src, dst, nlabels);
+	}
+
+	// Volta a etiquetar a imagem
+	for (y = 1; y < height - 1; y++)
+	{
+		for (x = 1; x < width - 1; x++)
+		{
+			posX = y * bytesperline + x * channels; // X
+
+			if (datadst[posX] != 0)
+			{
+				datadst[posX] = labeltable[datadst[posX]];
+			}
+		}
+	}
+
+	//printf("\nMax Label = %d\n", label);
+
+	// Contagem do número de blobs
+	// Passo 1: Eliminar, da tabela, etiquetas repetidas
+	for (a = 1; a < label - 1; a++)
+	{
+		for (b = a + 1; b < label; b++)
+		{
+			if (labeltable[a] == labeltable[b]) labeltable[b] = 0;
+		}
+	}
+	// Passo 2: Conta etiquetas e organiza a tabela de etiquetas, para que não hajam valores vazios (zero) entre etiquetas
+	*nlabels = 0;
+	for (a = 1; a < label; a++)
+	{
+		if (labeltable[a] != 0)
+		{
+			labeltable[*nlabels] = labeltable[a]; // Organiza tabela de etiquetas
+			(*nlabels)++; // Conta etiquetas
+		}
+	}
+
+	// Se não há blobs
+	if (*nlabels == 0) return NULL;
+
+	// Cria lista de blobs (objectos) e preenche a etiqueta
+	blobs = (OVC*)calloc((*nlabels), sizeof(OVC));
+	if (blobs != NULL)
+	{
+		for (a = 0; a < (*nlabels); a++) blobs[a].label = labeltable[a];
+	}
+	else return NULL;
+
+
+
+	return blobs;
+}
+
+
+#pragma endregion
+
+#pragma region Função: vc_binary_blob_info
+/**
+ * Função: vc_binary_blob_info
+ * ---------------------------
+ * Calcula a área, perímetro e centro de massa de cada blob numa imagem binária.
+ *
+ * Parâmetros:
+ *   src       - imagem binária de entrada (1 canal)
+ *   blobs     - vetor de blobs (saída)
+ *   nblobs    - número total de blobs
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_binary_blob_info(IVC* src, OVC* blobs, int nblobs)
+{
+	unsigned char* data = (unsigned char*)src->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int channels = src->channels;
+	int x, y, i;
+	long int pos;
+	int xmin, ymin, xmax, ymax;
+	long int sumx, sumy;
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+	if (channels != 1) return 0;
+
+	// Conta área de cada blob
+	for (i = 0; i < nblobs; i++)
+	{
+		xmin = width - 1;
+		ymin = height - 1;
+		xmax = 0;
+		ymax = 0;
+
+		sumx = 0;
+		sumy = 0;
+
+		blobs[i].area = 0;
+
+		for (y = 1; y < height - 1; y++)
+		{
+			for (x = 1; x < width - 1; x++)
+			{
+				pos = y * bytesperline + x * channels;
+
+				if (data[pos] == blobs[i].label)
+				{
+					// Área
+					blobs[i].area++;
+
+					// Centro de Gravidade
+					sumx += x;
+					sumy += y;
+
+					// Bounding Box
+					if (xmin > x) xmin = x;
+					if (ymin > y) ymin = y;
+					if (xmax < x) xmax = x;
+					if (ymax < y) ymax = y;
+
+					// Perímetro
+					// Se pelo menos um dos quatro vizinhos não pertence ao mesmo label, então é um pixel de contorno
+					if ((data[pos - 1] != blobs[i].label) || (data[pos + 1] != blobs[i].label) || (data[pos - bytesperline] != blobs[i].label) || (data[pos + bytesperline] != blobs[i].label))
+					{
+						blobs[i].perimetro++;
+					}
+				}
+			}
+		}
+
+		// Bounding Box
+		blobs[i].x = xmin;
+		blobs[i].y = ymin;
+		blobs[i].width = (xmax - xmin) + 1;
+		blobs[i].height = (ymax - ymin) + 1;
+
+		// Centro de Gravidade
+		//blobs[i].xc = (xmax - xmin) / 2;
+		//blobs[i].yc = (ymax - ymin) / 2;
+		//blobs[i].xc = sumx / MAX(blobs[i].area, 1);
+		//blobs[i].yc = sumy / MAX(blobs[i].area, 1);
+		//professor 
+		blobs[i].xc = sumx / (blobs[i].area);
+		//professor 
+		blobs[i].yc = sumy / (blobs[i].area);
+
+		// Diâmetro estimado a partir da bounding box
+		blobs[i].diametro = (blobs[i].width + blobs[i].height) / 2;
+	}
+
+	return 1;
+}
+
+
+#pragma	endregion
+
+#pragma region Função: vc_binary_blob_area
+/**
+ * Função: vc_binary_blob_area
+ * ---------------------------
+ * Calcula a área, a caixa delimitadora e o centro de massa de todos os blobs numa só passagem
+ * pela imagem de etiquetas (a `vc_binary_blob_info` percorre a imagem uma vez por blob).
+ * O perímetro não é calculado (fica a 0; ver `vc_binary_blob_perimeter`).
+ * Os resultados são iguais aos de `vc_binary_blob_info`.
+ *
+ * Parâmetros:
+ *   src       - imagem de etiquetas (1 canal, saída de vc_binary_blob_labelling)
+ *   blobs     - vetor de blobs (com as etiquetas preenchidas)
+ *   nblobs    - número total de blobs
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_binary_blob_area(IVC* src, OVC* blobs, int nblobs)
+{
+	unsigned char* data = (unsigned char*)src->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int x, y, i;
+	int indice[256];
+	std::vector<long int> sumx(MAX(nblobs, 1), 0), sumy(MAX(nblobs, 1), 0);
+	std::vector<int> xmin(MAX(nblobs, 1), width - 1), ymin(MAX(nblobs, 1), height - 1);
+	std::vector<int> xmax(MAX(nblobs, 1), 0), ymax(MAX(nblobs, 1), 0);
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+	if (src->channels != 1) return 0;
+
+	// Etiqueta -> índice do blob
+	for (i = 0; i < 256; i++) indice[i] = -1;
+	for (i = 0; i < nblobs; i++)
+	{
+		if ((blobs[i].label > 0) && (blobs[i].label < 256)) indice[blobs[i].label] = i;
+		blobs[i].area = 0;
+		blobs[i].perimetro = 0;
+	}
+
+	for (y = 1; y < height - 1; y++)
+	{
+		unsigned char* linha = data + (long int)y * bytesperline;
+
+		for (x = 1; x < width - 1; x++)
+		{
+			if (linha[x] == 0) continue;
+
+			i = indice[linha[x]];
+			if (i < 0) continue;
+
+			// Área
+			blobs[i].area++;
+
+			// Centro de Gravidade
+			sumx[i] += x;
+			sumy[i] += y;
+
+			// Bounding Box
+			if (xmin[i] > x) xmin[i] = x;
+			if (ymin[i] > y) ymin[i] = y;
+			if (xmax[i] < x) xmax[i] = x;
+			if (ymax[i] < y) ymax[i] = y;
+		}
+	}
+
+	for (i = 0; i < nblobs; i++)
+	{
+		// Bounding Box
+		blobs[i].x = xmin[i];
+		blobs[i].y = ymin[i];
+		blobs[i].width = (xmax[i] - xmin[i]) + 1;
+		blobs[i].height = (ymax[i] - ymin[i]) + 1;
+
+		// Centro de Gravidade
+		blobs[i].xc = sumx[i] / MAX(blobs[i].area, 1);
+		blobs[i].yc = sumy[i] / MAX(blobs[i].area, 1);
+
+		// Diâmetro estimado a partir da bounding box
+		blobs[i].diametro = (blobs[i].width + blobs[i].height) / 2;
+	}
+
+	return 1;
+}
+#pragma endregion
+
+#pragma region Função: vc_binary_blob_contour
+// Códigos de cadeia (Freeman, vizinhança-8): 0 = Este, 1 = Nordeste, 2 = Norte, ... , 7 = Sudeste
+static const int vc_cadeia_dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int vc_cadeia_dy[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+
+/**
+ * Função: vc_binary_blob_contour
+ * ------------------------------
+ * Segue o contorno exterior de um blob (vizinhança de Moore, conectividade-8) a partir do seu
+ * primeiro píxel (o primeiro da linha de cima da caixa delimitadora) e escreve o código de cadeia.
+ * O custo é proporcional ao comprimento do contorno e não à área da imagem.
+ * O seguimento termina quando o primeiro passo volta a ser dado a partir do píxel inicial.
+ *
+ * Parâmetros:
+ *   src    - imagem de etiquetas (1 canal, com a borda a zero, como a saída de vc_binary_blob_labelling)
+ *   blob   - blob com a etiqueta e a caixa delimitadora preenchidas
+ *   cadeia - vetor de saída com os códigos de cadeia (0 a 7), com pelo menos max elementos
+ *   max    - número máximo de códigos a escrever
+ *
+ * Retorna:
+ *   O comprimento da cadeia (podendo ser superior a max; só os primeiros max códigos são escritos),
+ *   0 para um blob com um só píxel, ou -1 em caso de erro.
+ */
+int vc_binary_blob_contour(IVC* src, OVC* blob, unsigned char* cadeia, int max)
+{
+	unsigned char* data = (unsigned char*)src->data;
+	int bytesperline = src->bytesperline;
+	int label = blob->label;
+	int x, y, x0, y0, dir, n = 0;
+	int primeiro = -1;
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return -1;
+	if (src->channels != 1) return -1;
+	if ((blob->y < 1) || (blob->y >= src->height - 1) || (blob->width <= 0)) return -1;
+
+	// Píxel inicial: o primeiro do blob na linha de cima da caixa delimitadora
+	y0 = blob->y;
+	for (x0 = MAX(blob->x, 1); x0 < MIN(blob->x + blob->width, src->width - 1); x0++)
+	{
+		if (data[y0 * bytesperline + x0] == label) break;
+	}
+	if (x0 >= MIN(blob->x + blob->width, src->width - 1)) return -1;
+
+	x = x0;
+	y = y0;
+	dir = 7;
+
+	while (true)
+	{
+		int k, d = -1;
+
+		// Procura no sentido anti-horário, a começar em (dir + 7) % 8 (dir par) ou (dir + 6) % 8 (dir ímpar)
+		for (k = 0; k < 8; k++)
+		{
+			int c = (dir + ((dir & 1) ? 6 : 7) + k) & 7;
+
+			if (data[(y + vc_cadeia_dy[c]) * bytesperline + (x + vc_cadeia_dx[c])] == label)
+			{
+				d = c;
+				break;
+			}
+		}
+
+		// Píxel isolado
+		if (d < 0) return 0;
+
+		// Fim: o primeiro passo volta a ser dado a partir do píxel inicial
+		if ((x == x0) && (y == y0) && (n > 0) && (d == primeiro)) break;
+
+		if (n == 0) primeiro = d;
+		if (n < max) cadeia[n] = (unsigned char)d;
+		n++;
+
+		x += vc_cadeia_dx[d];
+		y += vc_cadeia_dy[d];
+		dir = d;
+	}
+
+	return n;
+}
+#pragma endregion
+
+#pragma region Função: vc_chain_perimeter
+/**
+ * Função: vc_chain_perimeter
+ * --------------------------
+ * Calcula o perímetro de um contorno a partir do código de cadeia, com correção de cantos
+ * (Vossepoel e Smeulders): P = 0.980 * npares + 1.406 * nimpares - 0.091 * ncantos.
+ * Ao contrário da contagem de píxeis, não subestima o perímetro de círculos e retas inclinadas.
+ *
+ * Parâmetros:
+ *   cadeia - códigos de cadeia (0 a 7)
+ *   n      - comprimento da cadeia
+ *
+ * Retorna:
+ *   O perímetro corrigido (0 para uma cadeia vazia).
+ */
+float vc_chain_perimeter(const unsigned char* cadeia, int n)
+{
+	int npares = 0, nimpares = 0, ncantos = 0;
+	int i;
+
+	for (i = 0; i < n; i++)
+	{
+		if (cadeia[i] & 1) nimpares++;
+		else npares++;
+
+		// Canto: mudança de direção (a cadeia é fechada)
+		if (cadeia[i] != cadeia[(i + 1) % n]) ncantos++;
+	}
+
+	return 0.980f * (float)npares + 1.406f * (float)nimpares - 0.091f * (float)ncantos;
+}
+#pragma endregion
+
+#pragma region Função: vc_binary_blob_perimeter
+/**
+ * Função: vc_binary_blob_perimeter
+ * --------------------------------
+ * Calcula o perímetro de um blob seguindo o seu contorno (ver `vc_binary_blob_contour`):
+ * - perimetroCorrigido: perímetro com correção de cantos, a partir do código de cadeia;
+ * - perimetro: número de píxeis com pelo menos um vizinho-4 de outra etiqueta (igual ao de `vc_binary_blob_info`).
+ *
+ * Se o contorno não passa duas vezes no mesmo píxel e delimita exatamente a área do blob
+ * (teorema de Pick), o blob não tem buracos e o perímetro em píxeis é o número de píxeis do contorno,
+ * com custo proporcional ao contorno. Caso contrário (buracos ou istmos de 1 píxel), os píxeis
+ * de contorno são contados na caixa delimitadora.
+ *
+ * Parâmetros:
+ *   src  - imagem de etiquetas (1 canal)
+ *   blob - blob com a etiqueta, a área e a caixa delimitadora preenchidas (ver vc_binary_blob_area)
+ *
+ * Retorna:
+ *   O perímetro em píxeis, ou -1 em caso de erro.
+ */
+int vc_binary_blob_perimeter(IVC* src, OVC* blob)
+{
+	unsigned char* data = (unsigned char*)src->data;
+	int bytesperline = src->bytesperline;
+	int label = blob->label;
+	int x, y, perimetro = 0;
+	long int pos;
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return -1;
+	if (src->channels != 1) return -1;
+
+	// Contorno e perímetro corrigido
+	std::vector<unsigned char> cadeia(2 * (blob->width + blob->height) + 8);
+	int n = vc_binary_blob_contour(src, blob, cadeia.data(), (int)cadeia.size());
+
+	if (n > (int)cadeia.size())
+	{
+		cadeia.resize(n);
+		n = vc_binary_blob_contour(src, blob, cadeia.data(), n);
+	}
+
+	blob->perimetroCorrigido = (n > 0) ? vc_chain_perimeter(cadeia.data(), n) : 0.0f;
+
+	if (n > 0)
+	{
+		std::vector<long int> posicoes(n);
+		long long area2 = 0;
+
+		// Primeiro píxel do contorno (o mesmo de vc_binary_blob_contour)
+		x = MAX(blob->x, 1);
+		y = blob->y;
+		while (data[y * bytesperline + x] != label) x++;
+
+		for (int i = 0; i < n; i++)
+		{
+			int nx = x + vc_cadeia_dx[cadeia[i]];
+			int ny = y + vc_cadeia_dy[cadeia[i]];
+
+			// Fórmula de Gauss (dobro da área do polígono do contorno)
+			area2 += (long long)x * ny - (long long)nx * y;
+
+			posicoes[i] = (long int)y * bytesperline + x;
+			x = nx;
+			y = ny;
+		}
+
+		std::sort(posicoes.begin(), posicoes.end());
+		int distintos = (int)(std::unique(posicoes.begin(), posicoes.end()) - posicoes.begin());
+
+		// Pick: píxeis delimitados (incluindo o contorno) = área do polígono + n / 2 + 1
+		if ((distintos == n) && ((area2 < 0 ? -area2 : area2) + n + 2 == 2LL * blob->area))
+		{
+			blob->perimetro = n;
+			return n;
+		}
+	}
+
+	// Blob com buracos, istmos ou de um só píxel: contagem na caixa delimitadora
+	int x0 = MAX(blob->x, 1), x1 = MIN(blob->x + blob->width - 1, src->width - 2);
+	int y0 = MAX(blob->y, 1), y1 = MIN(blob->y + blob->height - 1, src->height - 2);
+
+	for (y = y0; y <= y1; y++)
+	{
+		for (x = x0; x <= x1; x++)
+		{
+			pos = y * bytesperline + x;
+
+			if (data[pos] != label) continue;
+
+			// Se pelo menos um dos quatro vizinhos não pertence ao mesmo label, então é um pixel de contorno
+			if ((data[pos - 1] != label) || (data[pos + 1] != label) || (data[pos - bytesperline] != label) || (data[pos + bytesperline] != label))
+			{
+				perimetro++;
+			}
+		}
+	}
+
+	blob->perimetro = perimetro;
+
+	return perimetro;
+}
+#pragma endregion
+
+#pragma region Funções : Tabela de blobs (estrutura de arrays)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//        FUNÇÕES: TABELA DE BLOBS (ESTRUTURA DE ARRAYS)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+// Cada característica dos blobs é um array contíguo (campo[c][i] = característica c do blob i;
+// campof para as características em vírgula flutuante),
+// pelo que um filtro só percorre os campos que testa. Os filtros não apagam blobs um a um:
+// marcam os blobs a manter e compactam depois todos os campos de uma vez, mantendo a ordem.
+
+
+// Alocar uma tabela de blobs com os campos de base (VC_BLOB_X ... VC_BLOB_LABEL)
+VC_BLOBS* vc_blobs_new(int capacidade)
+{
+	VC_BLOBS* blobs = (VC_BLOBS*)calloc(1, sizeof(VC_BLOBS));
+	int c;
+
+	if (blobs == NULL) return NULL;
+
+	blobs->capacidade = MAX(capacidade, 1);
+
+	for (c = 0; c < VC_BLOB_NCAMPOS_BASE; c++)
+	{
+		if (vc_blobs_add_field(blobs) < 0) return vc_blobs_free(blobs);
+	}
+	for (c = 0; c < VC_BLOBF_NCAMPOS_BASE; c++)
+	{
+		if (vc_blobs_add_field_f(blobs) < 0) return vc_blobs_free(blobs);
+	}
+
+	return blobs;
+}
+
+
+// Libertar uma tabela de blobs
+VC_BLOBS* vc_blobs_free(VC_BLOBS* blobs)
+{
+	if (blobs != NULL)
+	{
+		for (int c = 0; c < blobs->ncampos; c++) free(blobs->campo[c]);
+		for (int c = 0; c < blobs->ncamposf; c++) free(blobs->campof[c]);
+		free(blobs);
+	}
+
+	return NULL;
+}
+
+
+// Acrescentar um campo (por exemplo momentos ou cor média), inicializado a zero.
+// Retorna o índice do novo campo, ou -1 em caso de erro.
+int vc_blobs_add_field(VC_BLOBS* blobs)
+{
+	if (blobs->ncampos >= VC_BLOB_MAXCAMPOS) return -1;
+
+	blobs->campo[blobs->ncampos] = (int*)calloc(blobs->capacidade, sizeof(int));
+	if (blobs->campo[blobs->ncampos] == NULL) return -1;
+
+	return blobs->ncampos++;
+}
+
+
+// Acrescentar um campo em vírgula flutuante, inicializado a zero.
+// Retorna o índice do novo campo, ou -1 em caso de erro.
+int vc_blobs_add_field_f(VC_BLOBS* blobs)
+{
+	if (blobs->ncamposf >= VC_BLOB_MAXCAMPOS) return -1;
+
+	blobs->campof[blobs->ncamposf] = (float*)calloc(blobs->capacidade, sizeof(float));
+	if (blobs->campof[blobs->ncamposf] == NULL) return -1;
+
+	return blobs->ncamposf++;
+}
+
+
+// Garante espaço para n blobs em todos os campos (o conteúdo dos primeiros blobs->n é mantido)
+static int vc_blobs_reservar(VC_BLOBS* blobs, int n)
+{
+	int c;
+
+	if (n <= blobs->capacidade) return 1;
+
+	int capacidade = MAX(n, 2 * blobs->capacidade);
+
+	for (c = 0; c < blobs->ncampos; c++)
+	{
+		int* campo = (int*)realloc(blobs->campo[c], capacidade * sizeof(int));
+		if (campo == NULL) return 0;
+		blobs->campo[c] = campo;
+	}
+	for (c = 0; c < blobs->ncamposf; c++)
+	{
+		float* campo = (float*)realloc(blobs->campof[c], capacidade * sizeof(float));
+		if (campo == NULL) return 0;
+		blobs->campof[c] = campo;
+	}
+
+	blobs->capacidade = capacidade;
+
+	return 1;
+}
+
+
+// Preencher a tabela com os blobs de um array OVC (os campos extra ficam a zero).
+// A tabela cresce quando necessário, para poder ser reutilizada de frame para frame.
+int vc_blobs_from_ovc(VC_BLOBS* blobs, OVC* src, int n)
+{
+	int i, c;
+
+	if (!vc_blobs_reservar(blobs, n)) return 0;
+
+	for (i = 0; i < n; i++)
+	{
+		blobs->campo[VC_BLOB_X][i] = src[i].x;
+		blobs->campo[VC_BLOB_Y][i] = src[i].y;
+		blobs->campo[VC_BLOB_WIDTH][i] = src[i].width;
+		blobs->campo[VC_BLOB_HEIGHT][i] = src[i].height;
+		blobs->campo[VC_BLOB_AREA][i] = src[i].area;
+		blobs->campo[VC_BLOB_XC][i] = src[i].xc;
+		blobs->campo[VC_BLOB_YC][i] = src[i].yc;
+		blobs->campo[VC_BLOB_PERIMETRO][i] = src[i].perimetro;
+		blobs->campo[VC_BLOB_LABEL][i] = src[i].label;
+		blobs->campo[VC_BLOB_DIAMETRO][i] = src[i].diametro;
+		blobs->campo[VC_BLOB_ESTADO][i] = src[i].estado;
+		blobs->campof[VC_BLOBF_CIRCULARIDADE][i] = src[i].circularidade;
+		blobs->campof[VC_BLOBF_PERIMETRO_CORRIGIDO][i] = src[i].perimetroCorrigido;
+	}
+
+	for (c = VC_BLOB_NCAMPOS_BASE; c < blobs->ncampos; c++)
+	{
+		memset(blobs->campo[c], 0, n * sizeof(int));
+	}
+	for (c = VC_BLOBF_NCAMPOS_BASE; c < blobs->ncamposf; c++)
+	{
+		memset(blobs->campof[c], 0, n * sizeof(float));
+	}
+
+	blobs->n = n;
+
+	return 1;
+}
+
+
+// Copiar os campos de base da tabela para um array OVC (com pelo menos blobs->n elementos)
+int vc_blobs_to_ovc(VC_BLOBS* blobs, OVC* dst)
+{
+	for (int i = 0; i < blobs->n; i++)
+	{
+		dst[i].x = blobs->campo[VC_BLOB_X][i];
+		dst[i].y = blobs->campo[VC_BLOB_Y][i];
+		dst[i].width = blobs->campo[VC_BLOB_WIDTH][i];
+		dst[i].height = blobs->campo[VC_BLOB_HEIGHT][i];
+		dst[i].area = blobs->campo[VC_BLOB_AREA][i];
+		dst[i].xc = blobs->campo[VC_BLOB_XC][i];
+		dst[i].yc = blobs->campo[VC_BLOB_YC][i];
+		dst[i].perimetro = blobs->campo[VC_BLOB_PERIMETRO][i];
+		dst[i].label = blobs->campo[VC_BLOB_LABEL][i];
+		dst[i].diametro = blobs->campo[VC_BLOB_DIAMETRO][i];
+		dst[i].estado = blobs->campo[VC_BLOB_ESTADO][i];
+		dst[i].circularidade = blobs->campof[VC_BLOBF_CIRCULARIDADE][i];
+		dst[i].perimetroCorrigido = blobs->campof[VC_BLOBF_PERIMETRO_CORRIGIDO][i];
+	}
+
+	return blobs->n;
+}
+
+
+// Marcar (manter[i] &= 1) os blobs cujo campo está em [min, max]; os restantes ficam a 0.
+// manter tem blobs->n elementos, inicializados pelo chamador (normalmente a 1).
+int vc_blobs_range_mask(VC_BLOBS* blobs, int campo, int min, int max, unsigned char* manter)
+{
+	int* v;
+	int i = 0;
+
+	if ((campo < 0) || (campo >= blobs->ncampos)) return 0;
+
+	v = blobs->campo[campo];
+
+#ifdef VC_SSE2
+	__m128i vmin = _mm_set1_epi32(min);
+	__m128i vmax = _mm_set1_epi32(max);
+
+	for (; i + 4 <= blobs->n; i += 4)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(v + i));
+		__m128i fora = _mm_or_si128(_mm_cmplt_epi32(x, vmin), _mm_cmpgt_epi32(x, vmax));
+		int bits = ~_mm_movemask_ps(_mm_castsi128_ps(fora));
+
+		manter[i + 0] &= (bits >> 0) & 1;
+		manter[i + 1] &= (bits >> 1) & 1;
+		manter[i + 2] &= (bits >> 2) & 1;
+		manter[i + 3] &= (bits >> 3) & 1;
+	}
+#endif
+
+	for (; i < blobs->n; i++)
+	{
+		manter[i] &= (unsigned char)((v[i] >= min) & (v[i] <= max));
+	}
+
+	return 1;
+}
+
+
+// Compactar todos os campos, mantendo (pela ordem original) só os blobs com manter[i] != 0.
+// Retorna o novo número de blobs.
+int vc_blobs_compact(VC_BLOBS* blobs, const unsigned char* manter)
+{
+	int i, j = 0, c;
+
+	for (c = 0; c < blobs->ncampos; c++)
+	{
+		int* v = blobs->campo[c];
+
+		// Escrita incondicional e avanço condicional (sem saltos por blob)
+		for (i = 0, j = 0; i < blobs->n; i++)
+		{
+			v[j] = v[i];
+			j += (manter[i] != 0);
+		}
+	}
+
+	for (c = 0; c < blobs->ncamposf; c++)
+	{
+		float* v = blobs->campof[c];
+
+		for (i = 0, j = 0; i < blobs->n; i++)
+		{
+			v[j] = v[i];
+			j += (manter[i] != 0);
+		}
+	}
+
+	blobs->n = j;
+
+	return j;
+}
+
+
+// Filtro compacto num só passo: mantém os blobs cujo campo está em [min, max]
+int vc_blobs_filter_range(VC_BLOBS* blobs, int campo, int min, int max)
+{
+	if (blobs->n == 0) return 0;
+
+	std::vector<unsigned char> manter(blobs->n, 1);
+
+	if (!vc_blobs_range_mask(blobs, campo, min, max, manter.data())) return blobs->n;
+
+	return vc_blobs_compact(blobs, manter.data());
+}
+
+#pragma endregion
+
+#pragma region Funções : Runs (máscaras em RLE)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//              FUNÇÕES: RUNS (MÁSCARAS EM RLE)
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+// Uma máscara binária é guardada como a lista dos seus runs (segmentos horizontais de píxeis
+// diferentes de zero), por ordem de varrimento. As máscaras das moedas são poucos discos cheios,
+// pelo que têm algumas centenas de runs para centenas de milhares de píxeis: a etiquetagem e as
+// características dos blobs calculadas sobre os runs não percorrem os píxeis.
+
+// Número de threads para percorrer uma imagem de width x height píxeis (1 para imagens pequenas,
+// em que criar threads custa mais do que a própria passagem)
+static int vc_linhas_nthreads(int width, int height)
+{
+	long long nthreads = ((long long)width * height) / VC_HISTOGRAMA_PIXEIS_THREAD;
+	long long ncpus = std::thread::hardware_concurrency();
+
+	nthreads = MIN(nthreads, MIN(ncpus, (long long)height));
+	return (nthreads > 1) ? (int)nthreads : 1;
+}
+
+// Chama funcao(t, y0, y1) para `nthreads` blocos contíguos de linhas, um por thread (o bloco 0 na thread atual)
+template <typename F>
+static void vc_linhas_paralelo(int nthreads, int height, F funcao)
+{
+	std::vector<std::thread> threads;
+
+	for (int t = 1; t < nthreads; t++)
+	{
+		threads.emplace_back(funcao, t, (int)((long long)height * t / nthreads), (int)((long long)height * (t + 1) / nthreads));
+	}
+	funcao(0, 0, (int)((long long)height / nthreads));
+	for (std::thread& thread : threads) thread.join();
+}
+
+// Índice do bit menos significativo a 1 (bits != 0)
+static inline int vc_bit_menor(unsigned int bits)
+{
+#ifdef _MSC_VER
+	unsigned long indice;
+	_BitScanForward(&indice, bits);
+	return (int)indice;
+#else
+	return __builtin_ctz(bits);
+#endif
+}
+
+
+// Garante espaço para n runs e para as linhas de uma imagem com a altura dada
+static int vc_runs_reservar(VC_RUNS* runs, int n, int height)
+{
+	if (n > runs->capacidade)
+	{
+		int capacidade = MAX(n, 2 * runs->capacidade);
+		int* y = (int*)realloc(runs->y, capacidade * sizeof(int));
+		if (y != NULL) runs->y = y;
+		int* x0 = (int*)realloc(runs->x0, capacidade * sizeof(int));
+		if (x0 != NULL) runs->x0 = x0;
+		int* x1 = (int*)realloc(runs->x1, capacidade * sizeof(int));
+		if (x1 != NULL) runs->x1 = x1;
+		int* label = (int*)realloc(runs->label, capacidade * sizeof(int));
+		if (label != NULL) runs->label = label;
+		int* seguinte = (int*)realloc(runs->seguinte, capacidade * sizeof(int));
+		if (seguinte != NULL) runs->seguinte = seguinte;
+
+		if ((y == NULL) || (x0 == NULL) || (x1 == NULL) || (label == NULL) || (seguinte == NULL)) return 0;
+
+		runs->capacidade = capacidade;
+	}
+
+	if (height + 1 > runs->capacidadeLinhas)
+	{
+		int* linha = (int*)realloc(runs->linha, (height + 1) * sizeof(int));
+		if (linha == NULL) return 0;
+
+		runs->linha = linha;
+		runs->capacidadeLinhas = height + 1;
+	}
+
+	return 1;
+}
+
+
+// Alocar uma lista de runs (cresce quando necessário)
+VC_RUNS* vc_runs_new(int capacidade)
+{
+	VC_RUNS* runs = (VC_RUNS*)calloc(1, sizeof(VC_RUNS));
+
+	if (runs == NULL) return NULL;
+
+	if (!vc_runs_reservar(runs, MAX(capacidade, 1), 0)) return vc_runs_free(runs);
+
+	return runs;
+}
+
+
+// Libertar uma lista de runs
+VC_RUNS* vc_runs_free(VC_RUNS* runs)
+{
+	if (runs != NULL)
+	{
+		free(runs->y);
+		free(runs->x0);
+		free(runs->x1);
+		free(runs->label);
+		free(runs->seguinte);
+		free(runs->linha);
+		free(runs->primeiro);
+		free(runs);
+	}
+
+	return NULL;
+}
+
+
+// Runs de uma linha (colunas 1 a width - 2), escritos em x0 e x1, com espaço para width / 2 + 1 runs.
+// Retorna o número de runs.
+static int vc_runs_linha(const unsigned char* linha, int width, int* x0, int* x1)
+{
+	int x = 1, n = 0;
+	int dentro = 0;		// O píxel anterior pertence a um run
+
+#ifdef VC_SSE2
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; x + 16 <= width - 1; x += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(linha + x));
+		unsigned int frente = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) & 0xFFFF;
+
+		// Bloco sem transições
+		if (frente == (dentro ? 0xFFFFu : 0u)) continue;
+
+		// Bit i a 1: o píxel x + i é diferente do anterior
+		unsigned int transicoes = (frente ^ ((frente << 1) | (unsigned int)dentro)) & 0xFFFF;
+
+		while (transicoes != 0)
+		{
+			int xi = x + vc_bit_menor(transicoes);
+
+			if (!dentro) x0[n] = xi;
+			else x1[n++] = xi - 1;
+
+			dentro = !dentro;
+			transicoes &= transicoes - 1;
+		}
+	}
+#endif
+
+	for (; x < width - 1; x++)
+	{
+		int frente = (linha[x] != 0);
+
+		if (frente == dentro) continue;
+
+		if (frente) x0[n] = x;
+		else x1[n++] = x - 1;
+
+		dentro = frente;
+	}
+
+	// Run que chega à última coluna útil
+	if (dentro) x1[n++] = width - 2;
+
+	return n;
+}
+
+
+/**
+ * Função: vc_binary_to_runs
+ * -------------------------
+ * Converte uma máscara binária na lista dos seus runs, por ordem de varrimento.
+ * Como em vc_binary_blob_labelling, qualquer valor diferente de zero é primeiro plano e a
+ * primeira e a última linha e coluna são ignoradas (fundo).
+ * Com SSE2, cada linha é lida em blocos de 16 píxeis: os blocos sem transições (todos de fundo
+ * fora de um run, ou todos de primeiro plano dentro de um run) são saltados com uma comparação,
+ * e nos restantes só são visitadas as posições das transições.
+ *
+ * Parâmetros:
+ *   src  - imagem binária de entrada (1 canal)
+ *   runs - lista de runs (saída; os runs anteriores são substituídos)
+ *
+ * Retorna:
+ *   O número de runs, ou -1 em caso de erro.
+ */
+int vc_binary_to_runs(IVC* src, VC_RUNS* runs)
+{
+	unsigned char* data = (unsigned char*)src->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int y, i, k, n = 0;
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return -1;
+	if (src->channels != 1) return -1;
+	if (!vc_runs_reservar(runs, 1, height)) return -1;
+
+	runs->width = width;
+	runs->height = height;
+	runs->nblobs = 0;
+	runs->linha[0] = 0;
+
+	for (y = 1; y < height - 1; y++)
+	{
+		runs->linha[y] = n;
+
+		if (!vc_runs_reservar(runs, n + width / 2 + 1, height)) return -1;
+
+		k = vc_runs_linha(data + (long int)y * bytesperline, width, runs->x0 + n, runs->x1 + n);
+		for (i = n; i < n + k; i++) runs->y[i] = y;
+		n += k;
+	}
+
+	// A última linha (e a primeira, numa imagem com menos de 3 linhas) não tem runs
+	for (y = MAX(height - 1, 1); y <= height; y++) runs->linha[y] = n;
+
+	runs->n = n;
+
+	return n;
+}
+
+
+// Raiz de um run na floresta de equivalências (com compressão do caminho)
+static int vc_runs_raiz(int* pai, int r)
+{
+	while (pai[r] != r)
+	{
+		pai[r] = pai[pai[r]];
+		r = pai[r];
+	}
+
+	return r;
+}
+
+
+// Une os runs [i, fimAcima) de uma linha com os runs [j, fim) da linha seguinte que lhes tocam
+// (conectividade-8). A raiz de cada conjunto é sempre o run com o menor índice.
+static void vc_runs_unir_linhas(const int* x0, const int* x1, int* pai, int i, int fimAcima, int j, int fim)
+{
+	while ((i < fimAcima) && (j < fim))
+	{
+		if (x1[i] + 1 < x0[j]) i++;
+		else if (x1[j] + 1 < x0[i]) j++;
+		else
+		{
+			int a = vc_runs_raiz(pai, i), b = vc_runs_raiz(pai, j);
+
+			if (a < b) pai[b] = a;
+			else pai[a] = b;
+
+			// Avança o run que acaba primeiro (o outro pode tocar no run seguinte)
+			if (x1[i] < x1[j]) i++;
+			else j++;
+		}
+	}
+}
+
+
+// Listas de runs de cada blob (runs->seguinte e runs->primeiro), por ordem de varrimento,
+// a partir das etiquetas dos runs. Retorna 0 se não for possível alocar a lista de blobs.
+static int vc_runs_listas(VC_RUNS* runs, int nblobs)
+{
+	std::vector<int> ultimo(MAX(nblobs, 1), -1);
+	int r;
+
+	if (nblobs > runs->capacidadeBlobs)
+	{
+		int* primeiro = (int*)realloc(runs->primeiro, nblobs * sizeof(int));
+		if (primeiro == NULL) return 0;
+
+		runs->primeiro = primeiro;
+		runs->capacidadeBlobs = nblobs;
+	}
+
+	for (r = 0; r < runs->n; r++)
+	{
+		int b = runs->label[r] - 1;
+
+		if (ultimo[b] < 0) runs->primeiro[b] = r;
+		else runs->seguinte[ultimo[b]] = r;
+
+		ultimo[b] = r;
+		runs->seguinte[r] = -1;
+	}
+
+	runs->nblobs = nblobs;
+
+	return 1;
+}
+
+
+// Lista de blobs (a libertar com free) com as etiquetas 1 a nblobs
+static OVC* vc_runs_blobs(int nblobs)
+{
+	OVC* blobs = (OVC*)calloc(nblobs, sizeof(OVC));
+
+	if (blobs != NULL)
+	{
+		for (int i = 0; i < nblobs; i++) blobs[i].label = i + 1;
+	}
+
+	return blobs;
+}
+
+
+/**
+ * Função: vc_runs_labelling
+ * -------------------------
+ * Etiqueta os runs (conectividade-8): dois runs de linhas consecutivas pertencem ao mesmo blob
+ * se se tocarem, incluindo na diagonal. As equivalências são resolvidas com union-find sobre os
+ * runs e cada blob recebe a raiz com o menor índice, pelo que as etiquetas (1 a nblobs) seguem a
+ * ordem de varrimento do primeiro píxel de cada blob, como em vc_binary_blob_labelling, sem o
+ * limite de 254 etiquetas.
+ * Preenche também a lista de runs de cada blob (runs->primeiro e runs->seguinte), por ordem de
+ * varrimento, para que os passos seguintes visitem só os píxeis desse blob:
+ *
+ *   for (r = runs->primeiro[label - 1]; r >= 0; r = runs->seguinte[r]) ...
+ *
+ * Parâmetros:
+ *   runs    - lista de runs (saída de vc_binary_to_runs); runs->label fica com a etiqueta de cada run
+ *   nlabels - número de blobs (saída)
+ *
+ * Retorna:
+ *   Array de blobs com a etiqueta preenchida (a libertar com free), ou NULL se não houver blobs.
+ */
+OVC* vc_runs_labelling(VC_RUNS* runs, int* nlabels)
+{
+	int n = runs->n;
+	int y, r;
+	int nblobs = 0;
+	std::vector<int> pai(MAX(n, 1));
+
+	*nlabels = 0;
+	runs->nblobs = 0;
+
+	if (n == 0) return NULL;
+
+	for (r = 0; r < n; r++) pai[r] = r;
+
+	// Une os runs que se tocam em cada par de linhas consecutivas
+	for (y = 2; y < runs->height - 1; y++)
+	{
+		vc_runs_unir_linhas(runs->x0, runs->x1, pai.data(), runs->linha[y - 1], runs->linha[y], runs->linha[y], runs->linha[y + 1]);
+	}
+
+	// Etiquetas pela ordem das raízes (a raiz de cada blob é o seu primeiro run)
+	for (r = 0; r < n; r++)
+	{
+		int raiz = vc_runs_raiz(pai.data(), r);
+
+		runs->label[r] = (raiz == r) ? ++nblobs : runs->label[raiz];
+	}
+
+	if (!vc_runs_listas(runs, nblobs)) return NULL;
+
+	OVC* blobs = vc_runs_blobs(nblobs);
+	if (blobs == NULL) return NULL;
+
+	*nlabels = nblobs;
+
+	return blobs;
+}
+
+
+// Somas das características de cada blob (índice do blob), acumuladas sobre um bloco de linhas
+typedef struct {
+	std::vector<int> area, perimetro;
+	std::vector<long long> sumx, sumy;
+	std::vector<int> xmin, ymin, xmax, ymax;
+} VC_RUNS_SOMAS;
+
+static void vc_runs_somas_iniciar(VC_RUNS_SOMAS* s, int nblobs, int width, int height)
+{
+	nblobs = MAX(nblobs, 1);
+
+	s->area.assign(nblobs, 0);
+	s->perimetro.assign(nblobs, 0);
+	s->sumx.assign(nblobs, 0);
+	s->sumy.assign(nblobs, 0);
+	s->xmin.assign(nblobs, width - 1);
+	s->ymin.assign(nblobs, height - 1);
+	s->xmax.assign(nblobs, 0);
+	s->ymax.assign(nblobs, 0);
+}
+
+
+// Número de píxeis de [a, b] cobertos por runs da linha acima e da linha abaixo.
+// *pa e *pb são os primeiros runs de cada linha que podem chegar a a (avançam ao longo da linha).
+static int vc_runs_cobertos(VC_RUNS* runs, int* pa, int fimA, int* pb, int fimB, int a, int b)
+{
+	int i, j, cobertos = 0;
+
+	while ((*pa < fimA) && (runs->x1[*pa] < a)) (*pa)++;
+	while ((*pb < fimB) && (runs->x1[*pb] < a)) (*pb)++;
+
+	for (i = *pa, j = *pb; (i < fimA) && (j < fimB) && (runs->x0[i] <= b) && (runs->x0[j] <= b);)
+	{
+		int lo = MAX(MAX(runs->x0[i], runs->x0[j]), a);
+		int hi = MIN(MIN(runs->x1[i], runs->x1[j]), b);
+
+		if (lo <= hi) cobertos += hi - lo + 1;
+
+		if (runs->x1[i] < runs->x1[j]) i++;
+		else j++;
+	}
+
+	return cobertos;
+}
+
+
+// Acumula em s as características dos blobs nos runs das linhas [y0, y1) (indice: etiqueta -> índice do blob)
+static void vc_runs_somar(VC_RUNS* runs, int y0, int y1, const int* indice, VC_RUNS_SOMAS* s)
+{
+	int y, r, i;
+
+	for (y = MAX(y0, 1); y < MIN(y1, runs->height - 1); y++)
+	{
+		int pa = runs->linha[y - 1], fimA = runs->linha[y];
+		int pb = runs->linha[y + 1], fimB = runs->linha[y + 2];
+
+		for (r = runs->linha[y]; r < runs->linha[y + 1]; r++)
+		{
+			int x0 = runs->x0[r], x1 = runs->x1[r];
+			int comprimento = x1 - x0 + 1;
+
+			i = indice[runs->label[r]];
+			if (i < 0) continue;
+
+			// Área e Centro de Gravidade (soma de x0 a x1)
+			s->area[i] += comprimento;
+			s->sumx[i] += (long long)(x0 + x1) * comprimento / 2;
+			s->sumy[i] += (long long)y * comprimento;
+
+			// Bounding Box
+			if (s->xmin[i] > x0) s->xmin[i] = x0;
+			if (s->ymin[i] > y) s->ymin[i] = y;
+			if (s->xmax[i] < x1) s->xmax[i] = x1;
+			if (s->ymax[i] < y) s->ymax[i] = y;
+
+			// Perímetro: extremos do run e píxeis interiores sem vizinho acima ou abaixo
+			if (comprimento <= 2) s->perimetro[i] += comprimento;
+			else s->perimetro[i] += comprimento - vc_runs_cobertos(runs, &pa, fimA, &pb, fimB, x0 + 1, x1 - 1);
+		}
+	}
+}
+
+
+// Escreve nos blobs as características acumuladas em s
+static void vc_runs_somas_blobs(VC_RUNS_SOMAS* s, OVC* blobs, int nblobs)
+{
+	for (int i = 0; i < nblobs; i++)
+	{
+		blobs[i].area = s->area[i];
+		blobs[i].perimetro = s->perimetro[i];
+
+		// Bounding Box
+		blobs[i].x = s->xmin[i];
+		blobs[i].y = s->ymin[i];
+		blobs[i].width = (s->xmax[i] - s->xmin[i]) + 1;
+		blobs[i].height = (s->ymax[i] - s->ymin[i]) + 1;
+
+		// Centro de Gravidade
+		blobs[i].xc = (int)(s->sumx[i] / MAX(blobs[i].area, 1));
+		blobs[i].yc = (int)(s->sumy[i] / MAX(blobs[i].area, 1));
+
+		// Diâmetro estimado a partir da bounding box
+		blobs[i].diametro = (blobs[i].width + blobs[i].height) / 2;
+	}
+}
+
+
+/**
+ * Função: vc_runs_blob_info
+ * -------------------------
+ * Calcula a área, a caixa delimitadora, o centro de massa e o perímetro de todos os blobs numa só
+ * passagem pelos runs (custo proporcional ao número de runs e não ao número de píxeis).
+ * O perímetro é o número de píxeis do blob com algum dos quatro vizinhos fora do blob (a definição
+ * de vc_binary_blob_info): os extremos de um run são sempre de contorno e os píxeis interiores são
+ * de contorno quando não estão cobertos por runs na linha de cima e na linha de baixo (um run
+ * vizinho que cobre o píxel toca-lhe e pertence por isso ao mesmo blob).
+ * O perímetro corrigido não é calculado (ver vc_binary_blob_perimeter).
+ * Os restantes resultados são iguais aos de vc_binary_blob_area para a mesma máscara.
+ *
+ * Parâmetros:
+ *   runs   - lista de runs etiquetada (saída de vc_runs_labelling)
+ *   blobs  - vetor de blobs (com as etiquetas preenchidas)
+ *   nblobs - número total de blobs
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_runs_blob_info(VC_RUNS* runs, OVC* blobs, int nblobs)
+{
+	std::vector<int> indice(runs->nblobs + 1, -1);
+	VC_RUNS_SOMAS somas;
+
+	// Verificação de erros
+	if ((runs->width <= 0) || (runs->height <= 0)) return 0;
+
+	// Etiqueta -> índice do blob
+	for (int i = 0; i < nblobs; i++)
+	{
+		if ((blobs[i].label > 0) && (blobs[i].label <= runs->nblobs)) indice[blobs[i].label] = i;
+	}
+
+	vc_runs_somas_iniciar(&somas, nblobs, runs->width, runs->height);
+	vc_runs_somar(runs, 0, runs->height, indice.data(), &somas);
+	vc_runs_somas_blobs(&somas, blobs, nblobs);
+
+	return 1;
+}
+
+
+/**
+ * Função: vc_runs_labelling_parallel
+ * ----------------------------------
+ * Converte a máscara em runs, etiqueta-os e calcula as características dos blobs, com a imagem
+ * dividida em faixas horizontais de linhas, uma por thread:
+ *
+ * 1. Cada thread converte as linhas da sua faixa em runs e une os runs da faixa numa floresta
+ *    de equivalências local (índices locais, raiz no menor índice);
+ * 2. Os runs das faixas são copiados (em paralelo) para a lista global, pela ordem das faixas,
+ *    e as florestas locais passam a índices globais;
+ * 3. Só os runs das linhas de junção entre faixas são unidos na floresta global;
+ * 4. As raízes de cada faixa são contadas em paralelo e numeradas a partir do total das faixas
+ *    anteriores (a raiz de um blob é o seu primeiro run, como na etiquetagem em série);
+ * 5. Cada thread acumula as características dos blobs na sua faixa, e as somas parciais são
+ *    reduzidas na tabela global de blobs.
+ *
+ * O resultado (runs, etiquetas, listas de runs de cada blob e blobs) é igual, bit a bit, ao de
+ * vc_binary_to_runs, vc_runs_labelling e vc_runs_blob_info.
+ *
+ * Parâmetros:
+ *   src      - imagem binária de entrada (1 canal)
+ *   runs     - lista de runs (saída)
+ *   nlabels  - número de blobs (saída)
+ *   nthreads - número de faixas (threads); 0 para escolher pelo tamanho da imagem e pelo número
+ *              de processadores (imagens pequenas: uma só thread, em série)
+ *
+ * Retorna:
+ *   Array de blobs com as características preenchidas (a libertar com free), ou NULL se não houver blobs.
+ */
+OVC* vc_runs_labelling_parallel(IVC* src, VC_RUNS* runs, int* nlabels, int nthreads)
+{
+	unsigned char* data = (unsigned char*)src->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int t, y, r;
+	OVC* blobs;
+
+	*nlabels = 0;
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return NULL;
+	if (src->channels != 1) return NULL;
+
+	if (nthreads <= 0) nthreads = vc_linhas_nthreads(width, height);
+	nthreads = MIN(nthreads, height);
+
+	// Em série
+	if (nthreads <= 1)
+	{
+		if (vc_binary_to_runs(src, runs) < 0) return NULL;
+
+		blobs = vc_runs_labelling(runs, nlabels);
+		if (blobs != NULL) vc_runs_blob_info(runs, blobs, *nlabels);
+
+		return blobs;
+	}
+
+	if (!vc_runs_reservar(runs, 1, height)) return NULL;
+
+	runs->width = width;
+	runs->height = height;
+	runs->nblobs = 0;
+
+	// 1. Runs e floresta local de cada faixa
+	std::vector<std::vector<int>> lx0(nthreads), lx1(nthreads), lpai(nthreads), llinha(nthreads);
+	std::vector<int> inicio(nthreads + 1, 0);	// Primeiro run global de cada faixa
+
+	vc_linhas_paralelo(nthreads, height, [&](int t, int y0, int y1)
+	{
+		int y, k, n = 0;
+
+		y0 = MAX(y0, 1);
+		y1 = MIN(y1, height - 1);
+
+		for (y = y0; y < y1; y++)
+		{
+			llinha[t].push_back(n);
+
+			lx0[t].resize(n + width / 2 + 1);
+			lx1[t].resize(n + width / 2 + 1);
+			k = vc_runs_linha(data + (long int)y * bytesperline, width, lx0[t].data() + n, lx1[t].data() + n);
+			n += k;
+		}
+		llinha[t].push_back(n);
+
+		lpai[t].resize(n);
+		for (k = 0; k < n; k++) lpai[t][k] = k;
+
+		for (k = 1; k + 1 < (int)llinha[t].size(); k++)
+		{
+			vc_runs_unir_linhas(lx0[t].data(), lx1[t].data(), lpai[t].data(), llinha[t][k - 1], llinha[t][k], llinha[t][k], llinha[t][k + 1]);
+		}
+	});
+
+	for (t = 0; t < nthreads; t++) inicio[t + 1] = inicio[t] + llinha[t].back();
+
+	int n = inicio[nthreads];
+
+	if (!vc_runs_reservar(runs, n, height)) return NULL;
+
+	// 2. Lista global (runs e floresta com índices globais)
+	std::vector<int> pai(MAX(n, 1)), raiz(MAX(n, 1));
+
+	vc_linhas_paralelo(nthreads, height, [&](int t, int y0, int y1)
+	{
+		int i, k = 0, base = inicio[t];
+
+		y0 = MAX(y0, 1);
+		y1 = MIN(y1, height - 1);
+
+		for (int y = y0; y < y1; y++, k++)
+		{
+			runs->linha[y] = base + llinha[t][k];
+
+			for (i = llinha[t][k]; i < llinha[t][k + 1]; i++)
+			{
+				runs->y[base + i] = y;
+				runs->x0[base + i] = lx0[t][i];
+				runs->x1[base + i] = lx1[t][i];
+				pai[base + i] = base + lpai[t][i];
+			}
+		}
+	});
+
+	runs->linha[0] = 0;
+	for (y = MAX(height - 1, 1); y <= height; y++) runs->linha[y] = n;
+	runs->n = n;
+
+	if (n == 0) return NULL;
+
+	// 3. Junções entre faixas (primeira linha de cada faixa com a última linha da faixa anterior)
+	for (t = 1; t < nthreads; t++)
+	{
+		y = (int)((long long)height * t / nthreads);
+
+		if ((y >= 2) && (y < height - 1))
+		{
+			vc_runs_unir_linhas(runs->x0, runs->x1, pai.data(), runs->linha[y - 1], runs->linha[y], runs->linha[y], runs->linha[y + 1]);
+		}
+	}
+
+	// 4. Raízes (só leitura da floresta) e etiquetas numeradas por faixa
+	std::vector<int> nraizes(nthreads + 1, 0);
+
+	vc_linhas_paralelo(nthreads, nthreads, [&](int t, int, int)
+	{
+		for (int r = inicio[t]; r < inicio[t + 1]; r++)
+		{
+			int a = r;
+
+			while (pai[a] != a) a = pai[a];
+
+			raiz[r] = a;
+			if (a == r) nraizes[t + 1]++;
+		}
+	});
+
+	for (t = 0; t < nthreads; t++) nraizes[t + 1] += nraizes[t];
+
+	vc_linhas_paralelo(nthreads, nthreads, [&](int t, int, int)
+	{
+		int etiqueta = nraizes[t];
+
+		for (int r = inicio[t]; r < inicio[t + 1]; r++)
+		{
+			if (raiz[r] == r) runs->label[r] = ++etiqueta;
+		}
+	});
+
+	// A raiz de um run está numa faixa anterior ou na mesma, já numerada
+	vc_linhas_paralelo(nthreads, nthreads, [&](int t, int, int)
+	{
+		for (int r = inicio[t]; r < inicio[t + 1]; r++)
+		{
+			if (raiz[r] != r) runs->label[r] = runs->label[raiz[r]];
+		}
+	});
+
+	int nblobs = nraizes[nthreads];
+
+	// Listas de runs de cada blob (custo proporcional ao número de runs)
+	if (!vc_runs_listas(runs, nblobs)) return NULL;
+
+	blobs = vc_runs_blobs(nblobs);
+	if (blobs == NULL) return NULL;
+
+	// 5. Características dos blobs: somas parciais por faixa, reduzidas na tabela global
+	std::vector<int> indice(nblobs + 1);
+	std::vector<VC_RUNS_SOMAS> somas(nthreads);
+
+	for (r = 0; r <= nblobs; r++) indice[r] = r - 1;
+
+	vc_linhas_paralelo(nthreads, height, [&](int t, int y0, int y1)
+	{
+		vc_runs_somas_iniciar(&somas[t], nblobs, width, height);
+		vc_runs_somar(runs, y0, y1, indice.data(), &somas[t]);
+	});
+
+	for (t = 1; t < nthreads; t++)
+	{
+		VC_RUNS_SOMAS* s = &somas[t];
+
+		for (int i = 0; i < nblobs; i++)
+		{
+			somas[0].area[i] += s->area[i];
+			somas[0].perimetro[i] += s->perimetro[i];
+			somas[0].sumx[i] += s->sumx[i];
+			somas[0].sumy[i] += s->sumy[i];
+			somas[0].xmin[i] = MIN(somas[0].xmin[i], s->xmin[i]);
+			somas[0].ymin[i] = MIN(somas[0].ymin[i], s->ymin[i]);
+			somas[0].xmax[i] = MAX(somas[0].xmax[i], s->xmax[i]);
+			somas[0].ymax[i] = MAX(somas[0].ymax[i], s->ymax[i]);
+		}
+	}
+
+	vc_runs_somas_blobs(&somas[0], blobs, nblobs);
+
+	*nlabels = nblobs;
+
+	return blobs;
+}
+
+
+/**
+ * Função: vc_runs_filter_area
+ * ---------------------------
+ * Mantém só os blobs com pelo menos `areamin` píxeis e renumera-os de 1 a n, pela mesma ordem.
+ * As etiquetas dos runs são atualizadas percorrendo a lista de runs de cada blob (runs->primeiro
+ * e runs->seguinte); os runs dos blobs removidos ficam com a etiqueta 0 (fundo em vc_runs_paint).
+ * Assim, só os blobs que sobram têm de caber nas 255 etiquetas de uma imagem de 8 bits.
+ *
+ * Parâmetros:
+ *   runs    - lista de runs etiquetada (saída de vc_runs_labelling ou vc_runs_labelling_parallel)
+ *   blobs   - blobs devolvidos pela etiquetagem (blobs[i] com a etiqueta i + 1) e com a área calculada;
+ *             os blobs mantidos são compactados no início do array
+ *   nblobs  - número de blobs
+ *   areamin - área mínima
+ *
+ * Retorna:
+ *   O número de blobs mantidos, ou -1 em caso de erro.
+ */
+int vc_runs_filter_area(VC_RUNS* runs, OVC* blobs, int nblobs, int areamin)
+{
+	int i, r, n = 0;
+
+	// Verificação de erros
+	if ((blobs == NULL) || (nblobs != runs->nblobs)) return -1;
+
+	for (i = 0; i < nblobs; i++)
+	{
+		int etiqueta = (blobs[i].area >= areamin) ? n + 1 : 0;
+
+		for (r = runs->primeiro[i]; r >= 0; r = runs->seguinte[r]) runs->label[r] = etiqueta;
+
+		if (etiqueta == 0) continue;
+
+		// n <= i: a entrada i já foi lida antes de ser substituída
+		runs->primeiro[n] = runs->primeiro[i];
+		blobs[n] = blobs[i];
+		blobs[n].label = etiqueta;
+		n++;
+	}
+
+	runs->nblobs = n;
+
+	return n;
+}
+
+
+/**
+ * Função: vc_runs_paint
+ * ---------------------
+ * Escreve a imagem de etiquetas dos runs (fundo a 0), equivalente à saída de
+ * vc_binary_blob_labelling. Os runs dos blobs com etiqueta superior a 255 (ou 0, ver
+ * vc_runs_filter_area) ficam a fundo.
+ *
+ * Parâmetros:
+ *   runs - lista de runs etiquetada (saída de vc_runs_labelling)
+ *   dst  - imagem de saída (1 canal, com as dimensões da máscara dos runs)
+ *
+ * Retorna:
+ *   1 se todos os blobs foram escritos, 0 caso contrário.
+ */
+int vc_runs_paint(VC_RUNS* runs, IVC* dst)
+{
+	unsigned char* data = (unsigned char*)dst->data;
+	int bytesperline = dst->bytesperline;
+	int y, r;
+
+	// Verificação de erros
+	if ((dst->width != runs->width) || (dst->height != runs->height) || (dst->data == NULL)) return 0;
+	if (dst->channels != 1) return 0;
+
+	for (y = 0; y < dst->height; y++) memset(data + (long int)y * bytesperline, 0, dst->width);
+
+	for (r = 0; r < runs->n; r++)
+	{
+		if (runs->label[r] > 255) continue;
+
+		memset(data + (long int)runs->y[r] * bytesperline + runs->x0[r], runs->label[r], runs->x1[r] - runs->x0[r] + 1);
+	}
+
+	return runs->nblobs <= 255;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_gray_histogram
+
+// Histograma das linhas [y0, y1) com oito sub-histogramas intercalados: píxeis seguidos com o mesmo
+// valor incrementam contadores diferentes, sem esperar que o incremento anterior chegue à memória
+static void vc_histograma_linhas(const unsigned char* data, int width, int bytesperline, int y0, int y1, unsigned int* hist)
+{
+	unsigned int sub[8][256];
+	int x, y, i;
+
+	memset(sub, 0, sizeof(sub));
+
+	for (y = y0; y < y1; y++)
+	{
+		const unsigned char* linha = data + (long long)y * bytesperline;
+
+		// 8 píxeis por leitura de 64 bits
+		for (x = 0; x + 8 <= width; x += 8)
+		{
+			uint64_t v;
+			memcpy(&v, linha + x, 8);
+			sub[0][v & 0xFF]++;
+			sub[1][(v >> 8) & 0xFF]++;
+			sub[2][(v >> 16) & 0xFF]++;
+			sub[3][(v >> 24) & 0xFF]++;
+			sub[4][(v >> 32) & 0xFF]++;
+			sub[5][(v >> 40) & 0xFF]++;
+			sub[6][(v >> 48) & 0xFF]++;
+			sub[7][v >> 56]++;
+		}
+		for (; x < width; x++) sub[0][linha[x]]++;
+	}
+
+	for (i = 0; i < 256; i++) hist[i] = sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i] + sub[4][i] + sub[5][i] + sub[6][i] + sub[7][i];
+}
+
+/**
+ * Função: vc_gray_histogram
+ * -------------------------
+ * Calcula o histograma absoluto (256 níveis) de uma imagem em tons de cinzento. É o cálculo partilhado
+ * pela equalização, pela binarização pela média global e pela visualização do histograma.
+ * Cada linha é contada em oito sub-histogramas intercalados; as imagens grandes são divididas em blocos
+ * de linhas por várias threads (VC_HISTOGRAMA_PIXEIS_THREAD píxeis por thread) e os histogramas somados no fim.
+ *
+ * Parâmetros:
+ *   src  - imagem de entrada (grayscale, 1 canal; respeita bytesperline)
+ *   hist - array de 256 contadores onde é escrito o histograma
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_histogram(IVC* src, unsigned int* hist)
+{
+	if ((src == NULL) || (src->data == NULL) || (hist == NULL)) return 0;
+	if ((src->width <= 0) || (src->height <= 0) || (src->channels != 1)) return 0;
+
+	int nthreads = vc_linhas_nthreads(src->width, src->height);
+	std::vector<unsigned int> parciais(nthreads * 256);
+	int i, t;
+
+	vc_linhas_paralelo(nthreads, src->height, [src, &parciais](int t, int y0, int y1)
+	{
+		vc_histograma_linhas(src->data, src->width, src->bytesperline, y0, y1, &parciais[t * 256]);
+	});
+
+	// Redução dos histogramas das threads
+	for (i = 0; i < 256; i++)
+	{
+		unsigned int soma = 0;
+		for (t = 0; t < nthreads; t++) soma += parciais[t * 256 + i];
+		hist[i] = soma;
+	}
+
+	return 1;
+}
+
+/**
+ * Função: vc_histogram_equalization_lut
+ * -------------------------------------
+ * Calcula a LUT de equalização de um histograma com a CDF em inteiros:
+ * lut[v] = round((cdf[v] - cdfmin) * 255 / (total - cdfmin)), em que cdfmin é a CDF do primeiro nível presente.
+ * Se a imagem só tiver um nível, a LUT é a identidade (não há contraste para redistribuir).
+ *
+ * Parâmetros:
+ *   hist - histograma absoluto (256 níveis)
+ *   lut  - array de 256 entradas onde é escrita a LUT
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 se o histograma estiver vazio.
+ */
+int vc_histogram_equalization_lut(const unsigned int* hist, unsigned char* lut)
+{
+	unsigned long long total = 0, cdf = 0, cdfmin = 0;
+	int i;
+
+	for (i = 0; i < 256; i++)
+	{
+		total += hist[i];
+		if ((cdfmin == 0) && (hist[i] != 0)) cdfmin = hist[i];
+	}
+	if (total == 0) return 0;
+
+	unsigned long long den = total - cdfmin;
+
+	for (i = 0; i < 256; i++)
+	{
+		cdf += hist[i];
+		if (den == 0) lut[i] = (unsigned char)i;
+		else if (cdf < cdfmin) lut[i] = 0;
+		else lut[i] = (unsigned char)(((cdf - cdfmin) * 255 + den / 2) / den);
+	}
+
+	return 1;
+}
+
+/**
+ * Função: vc_gray_lut
+ * -------------------
+ * Substitui cada byte da imagem pela entrada correspondente de uma LUT de 256 entradas (dst = lut[src]).
+ * As imagens grandes são divididas em blocos de linhas por várias threads, como em vc_gray_histogram.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada (qualquer número de canais)
+ *   dst - imagem de saída (mesmas dimensões e canais; pode ser src)
+ *   lut - tabela de 256 entradas
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_lut(IVC* src, IVC* dst, const unsigned char* lut)
+{
+	if ((src == NULL) || (dst == NULL) || (src->data == NULL) || (dst->data == NULL) || (lut == NULL)) return 0;
+	if ((src->width <= 0) || (src->height <= 0)) return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
+
+	int bytes = src->width * src->channels;
+
+	vc_linhas_paralelo(vc_linhas_nthreads(bytes, src->height), src->height, [src, dst, lut, bytes](int /*t*/, int y0, int y1)
+	{
+		for (int y = y0; y < y1; y++)
+		{
+			const unsigned char* l = src->data + (long long)y * src->bytesperline;
+			unsigned char* d = dst->data + (long long)y * dst->bytesperline;
+			int x;
+
+			// 8 bytes por leitura e por escrita de 64 bits (ordem little-endian dos bytes)
+			for (x = 0; x + 8 <= bytes; x += 8)
+			{
+				uint64_t v, r;
+				memcpy(&v, l + x, 8);
+				r = (uint64_t)lut[v & 0xFF] | ((uint64_t)lut[(v >> 8) & 0xFF] << 8) |
+					((uint64_t)lut[(v >> 16) & 0xFF] << 16) | ((uint64_t)lut[(v >> 24) & 0xFF] << 24) |
+					((uint64_t)lut[(v >> 32) & 0xFF] << 32) | ((uint64_t)lut[(v >> 40) & 0xFF] << 40) |
+					((uint64_t)lut[(v >> 48) & 0xFF] << 48) | ((uint64_t)lut[v >> 56] << 56);
+				memcpy(d + x, &r, 8);
+			}
+			for (; x < bytes; x++) d[x] = lut[l[x]];
+		}
+	});
+
+	return 1;
+}
+
+/**
+ * Função: vc_gray_histogram_show
+ * ------------------------------
+ * Gera uma imagem 256x256 com o histograma normalizado (PDF) da imagem em tons de cinzento (grayscale).
+ * Cada coluna da imagem resultante representa a frequência (PDF) de intensidade de cinzento [0-255].
+ * A altura da barra é proporcional à frequência relativa da intensidade na imagem original
+ * (histograma calculado por vc_gray_histogram).
+ *
+ * Parâmetros:
+ *   src - imagem de entrada em grayscale (1 canal)
+ *   dst - imagem de saída 256x256 (1 canal), onde será desenhado o histograma
+ *
+ * Retorna:
+ *   Apontador para a imagem de saída com o histograma, ou NULL em caso de erro.
+ */
+
+IVC* vc_gray_histogram_show(IVC* src, IVC* dst)
+{
+	// Verifica se a imagem de entrada é válida e se é grayscale
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return NULL;
+	if (src->channels != 1)
+		return NULL;
+
+	unsigned int hist[256];       // Histograma absoluto
+	unsigned int histmax = 0;     // Maior contagem (para escalar a altura; a PDF tem o mesmo máximo relativo)
+	int i, x, y;
+
+	// === 1. Calcular histograma absoluto ===
+	vc_gray_histogram(src, hist);
+
+	// === 2. Encontrar o valor máximo do histograma ===
+	for (i = 0; i < 256; i++)
+	{
+		if (hist[i] > histmax)
+		{
+			histmax = hist[i]; // Guarda o máximo para normalizar depois
+		}
+	}
+
+	// === 3. Limpar imagem de saída (assumidamente 256x256 pixels) ===
+	for (y = 0; y < 256; y++)
+	{
+		memset(dst->data + y * dst->bytesperline, 0, 256); // Tudo preto inicialmente
+	}
+
+	// === 4. Desenhar barras verticais do histograma ===
+	for (x = 0; x < 256; x++)
+	{
+		// Altura proporcional à frequência (PDF)
+		int barHeight = (int)((unsigned long long)hist[x] * 256 / histmax);
+
+		// Desenhar barra da base (linha 255) até ao topo da barra
+		for (y = 255; y >= 256 - barHeight; y--)
+		{
+			dst->data[y * dst->bytesperline + x] = 1; // Branco
+		}
+	}
+
+	return dst;
+}
+
+#pragma endregion
+
+#pragma region Função: vc_gray_histogram_equalization
+/**
+ * Função: vc_gray_histogram_equalization
+ * --------------------------------------
+ * Aplica equalização de histograma a uma imagem em tons de cinzento.
+ * A equalização de histograma melhora o contraste da imagem, redistribuindo os níveis de cinza.
+ * O histograma (vc_gray_histogram) dá uma LUT de 256 entradas (vc_histogram_equalization_lut), aplicada
+ * a toda a imagem por vc_gray_lut; não há contas em vírgula flutuante por píxel.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada (grayscale, 1 canal)
+ *   dst - imagem de saída (grayscale, 1 canal)
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_histogram_equalization(IVC* src, IVC* dst)
+{
+	if (src == NULL || dst == NULL || src->data == NULL || dst->data == NULL) return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != 1) || (dst->channels != 1)) return 0;
+
+	unsigned int hist[256];
+	unsigned char lut[256];
+
+	// Histograma, CDF inteira -> LUT de 256 entradas e aplicação da LUT
+	if (!vc_gray_histogram(src, hist)) return 0;
+	if (!vc_histogram_equalization_lut(hist, lut)) return 0;
+
+	return vc_gray_lut(src, dst, lut);
+}
+
+
+#pragma endregion
+
+#pragma region Função: vc_gray_edge_prewitt
+/**
+ * Função: vc_gray_edge_prewitt
+ * -----------------------------
+ * Aplica o operador de Prewitt para detecção de bordas em uma imagem em tons de cinza.
+ * O operador de Prewitt calcula a magnitude do gradiente da imagem, destacando as bordas.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada (grayscale, 1 canal)
+ *   dst - imagem de saída (grayscale, 1 canal)
+ *   th  - limiar para binarização (valores acima deste limiar serão definidos como 255)
+ *
+ * Sem borda de guarda, os píxeis dos limites não são escritos; com uma borda de pelo menos 1 píxel
+ * em src (vc_image_new_border), toda a imagem é processada.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_edge_prewitt(IVC* src, IVC* dst, float th) {
+	unsigned char* data = (unsigned char*)src->data;
+	int width = src->width;
+	int height = src->height;
+	int byteperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y;
+	long int pos;
+	long int posA, posB, posC, posD, posE, posF, posG, posH;
+	double mag, mx, my;
+	int margem = (src->border >= 1) ? 0 : 1; // Com borda de guarda, processa também os limites
+
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
+	if (channels != 1) return 0;
+
+	// Sem borda de guarda, só os píxeis interiores: a janela 3x3 não pode sair da imagem
+	for (y = margem; y < height - margem; y++)
+	{
+		for (x = margem; x < width - margem; x++)
+		{
+			pos = y * bytesperlinedst + x * channels;
+
+			posA = (y - 1) * byteperline + (x - 1) * channels;
+			posB = (y - 1) * byteperline + (x)*channels;
+			posC = (y - 1) * byteperline + (x + 1) * channels;
+			posD = (y)*byteperline + (x - 1) * channels;
+			posE = (y)*byteperline + (x + 1) * channels;
+			posF = (y + 1) * byteperline + (x - 1) * channels;
+			posG = (y + 1) * byteperline + (x)*channels;
+			posH = (y + 1) * byteperline + (x + 1) * channels;
+			mx = ((-1 * data[posA]) + (1 * data[posC]) + (-1 * data[posD]) + (1 * data[posE]) + (-1 * data[posF]) + (1 * data[posH])) / 3; //?
+			my = ((-1 * data[posA]) + (1 * data[posF]) + (-1 * data[posB]) + (1 * data[posG]) + (-1 * data[posC]) + (1 * data[posH])) / 3;
+
+			mag = sqrt((mx * mx) + (my * my));
+
+			if (mag > th)
+				dst->data[pos] = 255;
+			else
+				dst->data[pos] = 0;
+		}
+	}
+	return vc_image_fill_border(dst);
+}
+#pragma endregion
+
+#pragma region Função: vc_gray_edge_sobel
+/**
+ * Função: vc_gray_edge_sobel
+ * ---------------------------
+ * Aplica o operador de Sobel para detecção de bordas em uma imagem em tons de cinza.
+ * O operador de Sobel calcula a magnitude do gradiente da imagem, destacando as bordas.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada (grayscale, 1 canal)
+ *   dst - imagem de saída (grayscale, 1 canal)
+ *   th  - limiar para binarização (valores acima deste limiar serão definidos como 255)
+ *
+ * Sem borda de guarda, os píxeis dos limites não são escritos; com uma borda de pelo menos 1 píxel
+ * em src (vc_image_new_border), toda a imagem é processada.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_edge_sobel(IVC* src, IVC* dst, float th) {
+	unsigned char* data = (unsigned char*)src->data;
+	int width = src->width;
+	int height = src->height;
+	int byteperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y;
+	long int pos;
+	long int posA, posB, posC, posD, posE, posF, posG, posH;
+	double mag, mx, my;
+	int margem = (src->border >= 1) ? 0 : 1; // Com borda de guarda, processa também os limites
+
+	if ((width <= 0) || (height <= 0) || (src->data == NULL)) return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
+	if (channels != 1) return 0;
+
+	// Sem borda de guarda, só os píxeis interiores: a janela 3x3 não pode sair da imagem
+	for (y = margem; y < height - margem; y++)
+	{
+		for (x = margem; x < width - margem; x++)
+		{
+			pos = y * bytesperlinedst + x * channels;
+
+			posA = (y - 1) * byteperline + (x - 1) * channels;
+			posB = (y - 1) * byteperline + (x)*channels;
+			posC = (y - 1) * byteperline + (x + 1) * channels;
+			posD = (y)*byteperline + (x - 1) * channels;
+			posE = (y)*byteperline + (x + 1) * channels;
+			posF = (y + 1) * byteperline + (x - 1) * channels;
+			posG = (y + 1) * byteperline + (x)*channels;
+			posH = (y + 1) * byteperline + (x + 1) * channels;
+
+			mx = ((-1 * data[posA]) + (1 * data[posC]) + (-2 * data[posD]) + (2 * data[posE]) + (-1 * data[posF]) + (1 * data[posH])) / 3;
+			my = ((-1 * data[posA]) + (1 * data[posF]) + (-2 * data[posB]) + (2 * data[posG]) + (-1 * data[posC]) + (1 * data[posH])) / 3;
+
+			mag = sqrt((mx * mx) + (my * my));
+
+			if (mag > th)
+				dst->data[pos] = 255;
+			else
+				dst->data[pos] = 0;
+		}
+	}
+	return vc_image_fill_border(dst);
+}
+#pragma endregion
+
+#pragma region Função: vc_gray_lowpass_mean_filter
+
+// Filtro de média com o kernel K x K conhecido na compilação: soma vertical de K linhas para `coluna`
+// e soma horizontal de K colunas, com os ciclos desenrolados e divisão por uma constante; tal como a
+// versão genérica, só escreve os píxeis a pelo menos `margem` píxeis dos limites
+template <int K>
+static void vc_gray_lowpass_mean_filter_k(const unsigned char* datasrc, unsigned char* datadst, int width, int height, int bytesperline, int bytesperlinedst, int margem, unsigned short* coluna)
+{
+	const int offset = K / 2;
+	unsigned short* c = coluna + offset;	// c[x], com x em [margem - offset, width - margem + offset)
+
+	for (int y = margem; y < height - margem; y++)
+	{
+		const unsigned char* l = datasrc + (y - offset) * bytesperline;
+		unsigned char* linhadst = datadst + y * bytesperlinedst;
+
+		for (int x = margem - offset; x < width - margem + offset; x++)
+		{
+			unsigned short sum = l[x];
+			for (int ky = 1; ky < K; ky++) sum += l[ky * bytesperline + x];
+			c[x] = sum;
+		}
+
+		for (int x = margem; x < width - margem; x++)
+		{
+			unsigned short sum = c[x - offset];
+			for (int kx = 1; kx < K; kx++) sum += c[x - offset + kx];
+			linhadst[x] = (unsigned char)(sum / (K * K));
+		}
+	}
+}
+
+/**
+ * Função: vc_gray_lowpass_mean_filter
+ * -----------------------------------
+ * Aplica um filtro de média (mean filter) a uma imagem em tons de cinza.
+ * O filtro de média suaviza a imagem, reduzindo o ruído.
+ *
+ * Parâmetros:
+ *   src        - imagem de entrada (grayscale, 1 canal)
+ *   dst        - imagem de saída (grayscale, 1 canal)
+ *   kernelsize - tamanho do kernel (deve ser ímpar)
+ *
+ * Kernels de 3, 5, 7 e 9 usam versões especializadas (vc_gray_lowpass_mean_filter_k), com o mesmo resultado.
+ *
+ * Sem borda de guarda, os píxeis a menos de kernelsize/2 dos limites não são escritos; com uma borda
+ * de pelo menos kernelsize/2 píxeis em src (vc_image_new_border), toda a imagem é filtrada.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_lowpass_mean_filter(IVC* src, IVC* dst, int kernelsize)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int offset = (kernelsize - 1) / 2;
+	long int pos, kpos;
+	int sum;
+	int margem = (src->border >= offset) ? 0 : offset; // Com borda de guarda, filtra também os limites
+
+	// Error verification
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels))
+		return 0;
+	if (channels != 1)
+		return 0;
+
+	// Common kernel sizes: compile-time kernel
+	if ((kernelsize == 3) || (kernelsize == 5) || (kernelsize == 7) || (kernelsize == 9))
+	{
+		unsigned short* coluna = (unsigned short*)malloc((width + 2 * offset) * sizeof(unsigned short));
+		if (coluna != NULL)
+		{
+			switch (kernelsize)
+			{
+			case 3: vc_gray_lowpass_mean_filter_k<3>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, coluna); break;
+			case 5: vc_gray_lowpass_mean_filter_k<5>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, coluna); break;
+			case 7: vc_gray_lowpass_mean_filter_k<7>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, coluna); break;
+			case 9: vc_gray_lowpass_mean_filter_k<9>(datasrc, datadst, width, height, bytesperline, bytesperlinedst, margem, coluna); break;
+			}
+			free(coluna);
+			return vc_image_fill_border(dst);
+		}
+	}
+
+	// Apply mean filter
+	for (y = margem; y < height - margem; y++)
+	{
+		for (x = margem; x < width - margem; x++)
+		{
+			sum = 0;
+			for (ky = -offset; ky <= offset; ky++)
+			{
+				for (kx = -offset; kx <= offset; kx++)
+				{
+					kpos = (y + ky) * bytesperline + (x + kx) * channels;
+					sum += datasrc[kpos];
+				}
+			}
+			pos = y * bytesperlinedst + x * channels;
+			datadst[pos] = (unsigned char)(sum / (kernelsize * kernelsize));
+		}
+	}
+
+	return vc_image_fill_border(dst);
+}
+#pragma endregion
+
+#pragma region Função: vc_gray_lowpass_median_filter
+/**
+ * Função: vc_gray_lowpass_median_filter
+ * -------------------------------------
+ * Aplica um filtro de mediana (median filter) a uma imagem em tons de cinza.
+ * O filtro de mediana suaviza a imagem, reduzindo o ruído, preservando bordas.
+ *
+ * Parâmetros:
+ *   src        - imagem de entrada (grayscale, 1 canal)
+ *   dst        - imagem de saída (grayscale, 1 canal)
+ *   kernelsize - tamanho do kernel (deve ser ímpar)
+ *
+ * Com uma borda de guarda de pelo menos kernelsize/2 píxeis em src, também os limites são filtrados.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_lowpass_median_filter(IVC* src, IVC* dst, int kernelsize)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int offset = (kernelsize - 1) / 2;
+	long int pos, kpos;
+	unsigned char* ordem;
+	int i, j;
+	unsigned char temp;
+	int margem = (src->border >= offset) ? 0 : offset; // Com borda de guarda, filtra também os limites
+
+	// Error verification
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels))
+		return 0;
+	if (channels != 1)
+		return 0;
+
+
+	// Allocate memory for the sorting window
+	ordem = (unsigned char*)malloc(kernelsize * kernelsize * sizeof(unsigned char));
+	if (ordem == NULL) return 0;
+
+	// Apply median filter
+	for (y = margem; y < height - margem; y++)
+	{
+		for (x = margem; x < width - margem; x++)
+		{
+			// Collect pixels in the kernel window
+			i = 0;
+			for (ky = -offset; ky <= offset; ky++)
+			{
+				for (kx = -offset; kx <= offset; kx++)
+				{
+					kpos = (y + ky) * bytesperline + (x + kx) * channels;
+					ordem[i++] = datasrc[kpos];
+				}
+			}
+
+			// Sort the window using bubble sort (simple for small kernels)
+			for (i = 0; i < kernelsize * kernelsize - 1; i++)
+			{
+				for (j = i + 1; j < kernelsize * kernelsize; j++)
+				{
+					if (ordem[i] > ordem[j])
+					{
+						temp = ordem[i];
+						ordem[i] = ordem[j];
+						ordem[j] = temp;
+					}
+				}
+			}
+
+			// Get the median value (middle element)
+			pos = y * bytesperlinedst + x * channels;
+			datadst[pos] = (unsigned char)ordem[(kernelsize * kernelsize) / 2];
+		}
+	}
+
+	free(ordem);
+	return vc_image_fill_border(dst);
+}
+#pragma endregion
+
+#pragma region Função vc_gray_lowpass_gaussian_filter
+/**
+ * Função: vc_gray_lowpass_gaussian_filter
+ * ---------------------------------------
+ * Aplica um filtro gaussiano de baixa passagem a uma imagem em tons de cinza.
+ * O filtro gaussiano suaviza a imagem, reduzindo o ruído.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada (grayscale, 1 canal)
+ *   dst - imagem de saída (grayscale, 1 canal)
+ *
+ * Com uma borda de guarda de pelo menos 2 píxeis em src, também os limites são filtrados.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_lowpass_gaussian_filter(IVC* src, IVC* dst)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y, kx, ky;
+	int offset = (5 - 1) / 2;  // Kernel radius (for 5x5 kernel)
+	long int pos, kpos;
+	float sum;
+	int margem = (src->border >= offset) ? 0 : offset; // Com borda de guarda, filtra também os limites
+
+	// Gaussian kernel values (1D) - corrected from the image
+	float gaussarray[5] = { 0.054f, 0.242f, 0.399f, 0.242f, 0.054f };
+
+	// Error checking
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+		return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels))
+		return 0;
+	if (channels != 1)
+		return 0;
+
+	for (y = margem; y < height - margem; y++)
+	{
+		for (x = margem; x < width - margem; x++)
+		{
+			sum = 0.0f;
+
+
+			for (ky = -offset; ky <= offset; ky++)
+			{
+				for (kx = -offset; kx <= offset; kx++)
+				{
+					kpos = (y + ky) * bytesperline + (x + kx) * channels;
+					sum += ((float)datasrc[kpos]) * gaussarray[kx + offset] * gaussarray[ky + offset];
+				}
+			}
+
+			// Store result (no need for normalization as kernel is pre-normalized)
+			pos = y * bytesperlinedst + x * channels;
+			datadst[pos] = (unsigned char)sum;
+		}
+	}
+
+	return vc_image_fill_border(dst);
+}
+#pragma endregion
+
+#pragma region Função vc_gray_highpass_filter
+/**
+ * Função: vc_gray_highpass_filter
+ * -------------------------------
+ * Aplica um filtro passa-alto a uma imagem em tons de cinza.
+ * O filtro passa-alto realça os contornos e detalhes da imagem.
+ *
+ * Parâmetros:
+ *   src - imagem de entrada (grayscale, 1 canal)
+ *   dst - imagem de saída (grayscale, 1 canal)
+ *
+ * Com uma borda de guarda em src, também a primeira e a última linha e coluna são filtradas.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_highpass_filter(IVC* src, IVC* dst)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y;
+	long int posX, posA, posB, posC, posD, posE, posF, posG, posH;
+	int sum;
+	int margem = (src->border >= 1) ? 0 : 1; // Com borda de guarda, filtra também os limites
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
+	if (channels != 1) return 0;
+
+	for (y = margem; y < height - margem; y++)
+	{
+		for (x = margem; x < width - margem; x++)
+		{
+			posX = y * bytesperline + x * channels;
+
+			posA = (y - 1) * bytesperline + (x - 1) * channels;
+			posB = (y - 1) * bytesperline + x * channels;
+			posC = (y - 1) * bytesperline + (x + 1) * channels;
+			posD = y * bytesperline + (x - 1) * channels;
+			posE = y * bytesperline + (x + 1) * channels;
+			posF = (y + 1) * bytesperline + (x - 1) * channels;
+			posG = (y + 1) * bytesperline + x * channels;
+			posH = (y + 1) * bytesperline + (x + 1) * channels;
+
+			// Exemplo 3: kernel passa-alto 3x3 (realçado de contornos)
+			sum = datasrc[posA] * -1;
+			sum += datasrc[posB] * -1;
+			sum += datasrc[posC] * -1;
+			sum += datasrc[posD] * -1;
+			sum += datasrc[posE] * -1;
+			sum += datasrc[posF] * -1;
+			sum += datasrc[posG] * -1;
+			sum += datasrc[posH] * -1;
+			sum += datasrc[posX] * 8;
+
+			datadst[y * bytesperlinedst + x * channels] = (unsigned char)((float)abs(sum) / (float)9 * 20); // normalização e escala
+		}
+	}
+
+	return vc_image_fill_border(dst);
+}
+#pragma endregion
+
+#pragma region Função vc_gray_highpass_filter_enhance
+/**
+ * Função: vc_gray_highpass_filter_enhance
+ * ---------------------------------------
+ * Aplica um filtro passa-alto realçado a uma imagem em tons de cinza.
+ * O filtro realça os contornos e detalhes da imagem, permitindo ajustar o ganho.
+ *
+ * Parâmetros:
+ *   src  - imagem de entrada (grayscale, 1 canal)
+ *   dst  - imagem de saída (grayscale, 1 canal)
+ *   gain - fator de ganho para realçar os contornos
+ *
+ * Com uma borda de guarda em src, também a primeira e a última linha e coluna são filtradas.
+ *
+ * Retorna:
+ *   1 se a operação for bem-sucedida, 0 caso contrário.
+ */
+int vc_gray_highpass_filter_enhance(IVC* src, IVC* dst, int gain)
+{
+	unsigned char* datasrc = (unsigned char*)src->data;
+	unsigned char* datadst = (unsigned char*)dst->data;
+	int width = src->width;
+	int height = src->height;
+	int bytesperline = src->bytesperline;
+	int bytesperlinedst = dst->bytesperline;
+	int channels = src->channels;
+	int x, y;
+	long int posX, posA, posB, posC, posD, posE, posF, posG, posH;
+	int sum;
+	int margem = (src->border >= 1) ? 0 : 1; // Com borda de guarda, filtra também os limites
+
+	// Verificação de erros
+	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
+	if (channels != 1) return 0;
+
+	for (y = margem; y < height - margem; y++)
+	{
+		for (x = margem; x < width - margem; x++)
+		{
+			posX = y * bytesperline + x * channels;
+
+			posA = (y - 1) * bytesperline + (x - 1) * channels;
+			posB = (y - 1) * bytesperline + x * channels;
+			posC = (y - 1) * bytesperline + (x + 1) * channels;
+			posD = y * bytesperline + (x - 1) * channels;
+			posE = y * bytesperline + (x + 1) * channels;
+			posF = (y + 1) * bytesperline + (x - 1) * channels;
+			posG = (y + 1) * bytesperline + x * channels;
+			posH = (y + 1) * bytesperline + (x + 1) * channels;
+
+			// Exemplo 3: kernel passa-alto 3x3 (realçado de contornos)
+			sum = datasrc[posA] * -1;
+			sum += datasrc[posB] * -1;
+			sum += datasrc[posC] * -1;
+			sum += datasrc[posD] * -1;
+			sum += datasrc[posE] * -1;
+			sum += datasrc[posF] * -1;
+			sum += datasrc[posG] * -1;
+			sum += datasrc[posH] * -1;
+			sum += datasrc[posX] * 8;
+
+			datadst[y * bytesperlinedst + x * channels] = (unsigned char)MIN(MAX((float)datasrc[posX] + ((float)sum / 16.0f * (float)gain), 0), 255);
+
+		}
+	}
+
+	return vc_image_fill_border(dst);
+}
+#pragma endregion
+
+#pragma region Função: vc_image_sad
+/**
+ * Função: vc_image_sad
+ * --------------------
+ * Calcula a soma das diferenças absolutas (SAD) entre duas imagens com as mesmas dimensões,
+ * considerando apenas uma linha em cada `passo` (subamostragem vertical).
+ * Cada linha é percorrida byte a byte com instruções SSE2 (16 bytes por iteração), quando disponíveis.
+ *
+ * Parâmetros:
+ *   src1  - primeira imagem (qualquer número de canais)
+ *   src2  - segunda imagem (mesmas dimensões e canais de src1)
+ *   passo - distância entre linhas consideradas (1 = todas as linhas)
+ *
+ * Retorna:
+ *   A soma das diferenças absolutas das linhas consideradas, ou -1 em caso de erro.
+ */
+long long vc_image_sad(IVC* src1, IVC* src2, int passo)
+{
+	int height = src1->height;
+	int bytes = src1->width * src1->channels;
+	int x, y;
+	long long sad = 0;
+
+	// Verificação de erros
+	if ((src1->width <= 0) || (src1->height <= 0) || (src1->data == NULL) || (src2->data == NULL)) return -1;
+	if ((src1->width != src2->width) || (src1->height != src2->height) || (src1->channels != src2->channels)) return -1;
+	if (passo < 1) return -1;
+
+	for (y = 0; y < height; y += passo)
+	{
+		unsigned char* data1 = src1->data + (long int)y * src1->bytesperline;
+		unsigned char* data2 = src2->data + (long int)y * src2->bytesperline;
+
+		x = 0;
+
+#ifdef VC_SSE2
+		// _mm_sad_epu8 soma as diferenças de 8 bytes em cada metade de 64 bits;
+		// por linha, cada metade não ultrapassa 32 bits para qualquer largura realista
+		__m128i acumulador = _mm_setzero_si128();
+
+		for (; x + 16 <= bytes; x += 16)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(data1 + x));
+			__m128i b = _mm_loadu_si128((const __m128i*)(data2 + x));
+
+			acumulador = _mm_add_epi64(acumulador, _mm_sad_epu8(a, b));
+		}
+
+		sad += (unsigned int)_mm_cvtsi128_si32(acumulador);
+		sad += (unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(acumulador, 8));
+#endif
+
+		// Bytes restantes (ou a linha inteira, sem SSE2)
+		for (; x < bytes; x++)
+		{
+			sad += abs((int)data1[x] - (int)data2[x]);
+		}
+	}
+
+	return sad;
+}
+#pragma endregion
+
+#pragma region Função: vc_image_sad_blocos
+/**
+ * Função: vc_image_sad_blocos
+ * ---------------------------
+ * Divide duas imagens com as mesmas dimensões em células de `bloco` x `bloco` píxeis e calcula,
+ * para cada célula, a diferença absoluta média por byte (ver `vc_image_sad`, uma linha em cada `passo`).
+ * Ao contrário da média global, uma alteração localizada (por exemplo, uma moeda a deslocar-se)
+ * não é diluída pelo resto da imagem.
+ *
+ * Parâmetros:
+ *   src1  - primeira imagem (qualquer número de canais)
+ *   src2  - segunda imagem (mesmas dimensões e canais de src1)
+ *   passo - distância entre linhas consideradas (1 = todas as linhas)
+ *   bloco - lado das células, em píxeis
+ *
+ * Retorna:
+ *   A maior diferença média por byte entre todas as células, ou -1 em caso de erro.
+ */
+float vc_image_sad_blocos(IVC* src1, IVC* src2, int passo, int bloco)
+{
+	float maximo = 0.0f;
+	int x, y;
+
+	// Verificação de erros
+	if ((src1->width <= 0) || (src1->height <= 0) || (src1->data == NULL) || (src2->data == NULL)) return -1.0f;
+	if ((src1->width != src2->width) || (src1->height != src2->height) || (src1->channels != src2->channels)) return -1.0f;
+	if ((passo < 1) || (bloco < 1)) return -1.0f;
+
+	for (y = 0; y < src1->height; y += bloco)
+	{
+		for (x = 0; x < src1->width; x += bloco)
+		{
+			// Vistas da célula sobre as duas imagens (sem cópia)
+			IVC celula1 = *src1;
+			IVC celula2 = *src2;
+
+			celula1.width = celula2.width = MIN(bloco, src1->width - x);
+			celula1.height = celula2.height = MIN(bloco, src1->height - y);
+			celula1.data = src1->data + (long int)y * src1->bytesperline + x * src1->channels;
+			celula2.data = src2->data + (long int)y * src2->bytesperline + x * src2->channels;
+
+			long long amostras = (long long)((celula1.height + passo - 1) / passo) * celula1.width * celula1.channels;
+			long long sad = vc_image_sad(&celula1, &celula2, passo);
+
+			if (sad < 0) return -1.0f;
+
+			maximo = MAX(maximo, (float)((double)sad / (double)amostras));
+		}
+	}
+
+	return maximo;
+}
+#pragma endregion
+
+//**************************************//
+// 										//
+//  Trabalho Visão por Computador		//
+//  2024/2025							//
+//										//
+//  Fernando Salgueiro		nº 39		//
+//  Hugo Lopes				nº 30516	//
+//  Claudio Fernandes		nº 30517	//
+//  Nuno Cruz				nº 30518	//
+//										//
+//**************************************//
+
+RASTREADOR rastreador;
+TABELA_MOEDAS tabelaMoedas;
+CASCATA cascata;
+SOBREPOSICAO sobreposicao;
+HUD hud;
+OPCOES opcoes;
+
+#pragma region Função: lerOpcoes
+/**
+ * @brief Lê as opções da linha de comandos.
+ *
+ * Opções reconhecidas:
+ * - `--gravar <ficheiro.vcr>`: grava a máscara de cada frame (comprimida em RLE);
+ * - `--gravar-etiquetas`: grava também a imagem de etiquetas de cada frame;
+ * - `--gravar-frames`: grava também o frame original de cada frame;
+ * - `--reproduzir <ficheiro.vcr>`: processa uma gravação em vez de um vídeo;
+ * - `--movimento <limiar>`: salta o processamento dos frames em que nenhuma célula de 32x32 píxeis
+ *   tem uma diferença média por byte para o último frame processado acima do limiar (ver `verificarMovimento`);
+ * - `--piramide <2|4>`: segmenta a 1/2 ou 1/4 da resolução e mede as moedas à resolução original
+ *   (ver `detetarMoedasPiramide`);
+ * - `--moedas <ficheiro>`: tabela de moedas a usar (por omissão `moedas.txt`, ver `carregarMoedas`);
+ * - `--decimar <fps>`: processa só um frame em cada k, com k escolhido a partir da velocidade
+ *   das moedas e do throughput alvo em frames de vídeo por segundo (0 = sem alvo; ver `calcularDecimacao`);
+ * - `--previsualizar <escala>`: mostra a janela reduzida (ex.: 0.5), útil em ambientes remotos (ver `abrirEcra`);
+ * - `--antecipar <n>`: número de frames descodificados antecipadamente (1 a ANTECIPAR_MAX; ver `abrirDescodificador`);
+ * - `--saida <ficheiro>`: grava o vídeo anotado numa thread própria (ver `abrirEscritor`);
+ * - `--saida-eventos <n>`: só grava os n frames antes e depois de cada moeda contada;
+ * - `--saida-esperar`: com a fila de escrita cheia, o processamento espera em vez de descartar o frame;
+ * - `--entrada-stdin <LxA>`: lê frames em bruto de L x A píxeis do stdin em vez do menu (ver `abrirEntrada`);
+ * - `--entrada-shm <nome>`: lê frames de um anel de memória partilhada POSIX (ver `SHM_CABECALHO`);
+ * - `--entrada-formato <bgr|yuv420>`: formato dos frames do stdin (por omissão bgr);
+ * - `--entrada-fps <fps>`: frames por segundo da entrada em bruto (por omissão 30);
+ * - `--metricas <ficheiro|unix:caminho>`: exporta as métricas do processamento em texto Prometheus (ver `abrirMetricas`);
+ * - `--metricas-periodo <ms>`: período de exportação das métricas (por omissão METRICAS_PERIODO);
+ * - `--eventos <ficheiro>`: escreve as moedas contadas em CSV (.csv) ou NDJSON (ver `abrirEventos`);
+ * - `--gerar <cenário>`: escreve os frames de um vídeo sintético em bruto no stdout (ver `gerarSintetico`);
+ * - `--verdade <ficheiro>`: ficheiro da verdade do vídeo sintético (por omissão verdade.csv);
+ * - `--benchmark <cenários>`: mede a exatidão da contagem e a velocidade em cenários sintéticos (ver `benchmarkSintetico`);
+ * - `--microbenchmark <resoluções>`: mede cada função vc_* e compara-a com o OpenCV (ver `microbenchmark`);
+ * - `--simd <escalar|sse4.1|avx2|avx512>`: nível SIMD máximo das operações ponto a ponto (ver `vc_simd_definir`).
+ *
+ * Sem opções o programa comporta-se como antes (menu de escolha de vídeo).
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos.
+ * @param opcoes Estrutura a preencher.
+ *
+ * @return 1 se as opções são válidas; 0 caso contrário (é mostrada a ajuda).
+ */
+int lerOpcoes(int argc, char** argv, OPCOES* opcoes)
+{
+	memset(opcoes, 0, sizeof(OPCOES));
+	opcoes->simd = -1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--gravar") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->gravar, argv[++i], sizeof(opcoes->gravar) - 1);
+		}
+		else if (strcmp(argv[i], "--gravar-etiquetas") == 0)
+		{
+			opcoes->gravarEtiquetas = 1;
+		}
+		else if (strcmp(argv[i], "--gravar-frames") == 0)
+		{
+			opcoes->gravarFrames = 1;
+		}
+		else if ((strcmp(argv[i], "--reproduzir") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->reproduzir, argv[++i], sizeof(opcoes->reproduzir) - 1);
+		}
+		else if ((strcmp(argv[i], "--movimento") == 0) && (i + 1 < argc) && (atof(argv[i + 1]) > 0.0))
+		{
+			opcoes->movimento = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--piramide") == 0) && (i + 1 < argc) && (atoi(argv[i + 1]) == 2 || atoi(argv[i + 1]) == 4))
+		{
+			opcoes->piramide = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--moedas") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->moedas, argv[++i], sizeof(opcoes->moedas) - 1);
+		}
+		else if ((strcmp(argv[i], "--decimar") == 0) && (i + 1 < argc) && (atof(argv[i + 1]) >= 0.0))
+		{
+			opcoes->decimar = 1;
+			opcoes->decimarAlvo = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--previsualizar") == 0) && (i + 1 < argc) && (atof(argv[i + 1]) > 0.0) && (atof(argv[i + 1]) <= 1.0))
+		{
+			opcoes->previsualizar = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--antecipar") == 0) && (i + 1 < argc) && (atoi(argv[i + 1]) >= 1) && (atoi(argv[i + 1]) <= ANTECIPAR_MAX))
+		{
+			opcoes->antecipar = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--saida") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->saida, argv[++i], sizeof(opcoes->saida) - 1);
+		}
+		else if ((strcmp(argv[i], "--saida-eventos") == 0) && (i + 1 < argc) && (atoi(argv[i + 1]) >= 1) && (atoi(argv[i + 1]) <= ESCRITOR_EVENTOS_MAX))
+		{
+			opcoes->saidaEventos = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--saida-esperar") == 0)
+		{
+			opcoes->saidaEsperar = 1;
+		}
+		else if ((strcmp(argv[i], "--entrada-stdin") == 0) && (i + 1 < argc) &&
+			(sscanf(argv[i + 1], "%dx%d", &opcoes->entrada.width, &opcoes->entrada.height) == 2) &&
+			(opcoes->entrada.width > 0) && (opcoes->entrada.height > 0))
+		{
+			opcoes->entrada.tipo = FONTE_STDIN;
+			i++;
+		}
+		else if ((strcmp(argv[i], "--entrada-shm") == 0) && (i + 1 < argc))
+		{
+			opcoes->entrada.tipo = FONTE_SHM;
+			strncpy(opcoes->entrada.nome, argv[++i], sizeof(opcoes->entrada.nome) - 1);
+		}
+		else if ((strcmp(argv[i], "--entrada-formato") == 0) && (i + 1 < argc) &&
+			((strcmp(argv[i + 1], "bgr") == 0) || (strcmp(argv[i + 1], "yuv420") == 0)))
+		{
+			opcoes->entrada.formato = (strcmp(argv[++i], "bgr") == 0) ? FORMATO_BGR : FORMATO_YUV420;
+		}
+		else if ((strcmp(argv[i], "--entrada-fps") == 0) && (i + 1 < argc) && (atof(argv[i + 1]) > 0.0))
+		{
+			opcoes->entrada.fps = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--metricas") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->metricas, argv[++i], sizeof(opcoes->metricas) - 1);
+		}
+		else if ((strcmp(argv[i], "--metricas-periodo") == 0) && (i + 1 < argc) && (atoi(argv[i + 1]) > 0))
+		{
+			opcoes->metricasPeriodo = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--eventos") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->eventos, argv[++i], sizeof(opcoes->eventos) - 1);
+		}
+		else if ((strcmp(argv[i], "--gerar") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->gerar, argv[++i], sizeof(opcoes->gerar) - 1);
+		}
+		else if ((strcmp(argv[i], "--verdade") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->verdade, argv[++i], sizeof(opcoes->verdade) - 1);
+		}
+		else if ((strcmp(argv[i], "--benchmark") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->benchmark, argv[++i], sizeof(opcoes->benchmark) - 1);
+		}
+		else if ((strcmp(argv[i], "--microbenchmark") == 0) && (i + 1 < argc))
+		{
+			strncpy(opcoes->microbenchmark, argv[++i], sizeof(opcoes->microbenchmark) - 1);
+		}
+		else if ((strcmp(argv[i], "--simd") == 0) && (i + 1 < argc) && (vc_simd_procurar(argv[i + 1]) >= 0))
+		{
+			opcoes->simd = vc_simd_procurar(argv[++i]);
+		}
+		else
+		{
+			printf("Opção desconhecida: %s\n\n", argv[i]);
+			printf("Utilização: %s [opções]\n", argv[0]);
+			printf("  --gravar <ficheiro.vcr>     grava a máscara de cada frame\n");
+			printf("  --gravar-etiquetas          grava também a imagem de etiquetas\n");
+			printf("  --gravar-frames             grava também o frame original\n");
+			printf("  --reproduzir <ficheiro.vcr> processa uma gravação em vez de um vídeo\n");
+			printf("  --movimento <limiar>        salta frames sem movimento (ex.: 1.0)\n");
+			printf("  --piramide <2|4>            segmenta a resolução reduzida, mede à original\n");
+			printf("  --moedas <ficheiro>         tabela de moedas (por omissão moedas.txt)\n");
+			printf("  --decimar <fps>             processa um frame em cada k (fps alvo; 0 = sem alvo)\n");
+			printf("  --previsualizar <escala>    mostra a janela reduzida (0 < escala <= 1, ex.: 0.5)\n");
+			printf("  --antecipar <n>             frames descodificados antecipadamente (1 a %d, por omissão %d)\n", ANTECIPAR_MAX, ANTECIPAR_FRAMES);
+			printf("  --saida <ficheiro>          grava o vídeo anotado (.avi MJPG ou .mp4)\n");
+			printf("  --saida-eventos <n>         só grava n frames antes e depois de cada moeda (1 a %d)\n", ESCRITOR_EVENTOS_MAX);
+			printf("  --saida-esperar             com a fila de escrita cheia, espera em vez de descartar\n");
+			printf("  --entrada-stdin <LxA>       lê frames em bruto de L x A píxeis do stdin\n");
+			printf("  --entrada-shm <nome>        lê frames de um anel de memória partilhada (POSIX)\n");
+			printf("  --entrada-formato <bgr|yuv420> formato dos frames do stdin (por omissão bgr)\n");
+			printf("  --entrada-fps <fps>         frames por segundo da entrada em bruto (por omissão 30)\n");
+			printf("  --metricas <ficheiro|unix:caminho> exporta métricas em texto Prometheus\n");
+			printf("  --metricas-periodo <ms>     período de exportação das métricas (por omissão %d)\n", METRICAS_PERIODO);
+			printf("  --eventos <ficheiro>        escreve as moedas contadas em CSV (.csv) ou NDJSON\n");
+			printf("  --gerar <cenário>           escreve um vídeo sintético em bruto (BGR) no stdout\n");
+			printf("  --verdade <ficheiro>        verdade do vídeo sintético em CSV (por omissão verdade.csv)\n");
+			printf("  --benchmark <cenários>      exatidão e velocidade em cenários sintéticos (ex.: todos)\n");
+			printf("  --microbenchmark <res.>     tempo de cada função vc_* e comparação com o OpenCV (ex.: vga;4k)\n");
+			printf("  --simd <nível>              nível SIMD máximo: escalar, sse4.1, avx2 ou avx512 (por omissão o suportado)\n");
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: escolherVideo
+/**
+ * @brief Permite ao utilizador escolher um vídeo a partir de uma lista de opções apresentadas no terminal.
+ *
+ * A função apresenta um menu com 3 opções:
+ * - Opção 1: Seleciona "video1.mp4" (12 moedas);
+ * - Opção 2: Seleciona "video2.mp4" (29 moedas);
+ * - Opção 0: Sai do programa.
+ *
+ * Se o utilizador escolher uma opção inválida, o menu é repetido até uma opção válida ser selecionada.
+ * O nome do ficheiro escolhido é copiado para a variável `videofile`.
+ *
+ * @param videofile Ponteiro para a string onde será armazenado o nome do vídeo escolhido.
+ *
+ * @return Retorna 1 se a escolha for válida; retorna 0 se o utilizador optar por sair.
+ */
+int escolherVideo(char* videofile)
+{
+	// Exibe cabeçalho institucional e informações sobre o trabalho
+	printf("\t_________________________________________________________________________________________________________________________________________\n\n");
+	printf("\t\t\t\t\t\t\tIPCA\n\n");
+	printf("\t\t\t\t\t\t\tEscola Superior de Tecnologia\n\n");
+	printf("\t\t\t\t\t\t\tEngenharia de Sistemas Informáticos PL\n");
+	printf("\t\t\t\t\t\t\t2024/2025\n\n");
+	printf("\t\t\t\t\t\t\tVisão por Computador\n");
+	printf("\t\t\t\t\t\t\tTrabalho Prático:\n");
+	printf("\t\t\t\t\t\t\tPermite a quantificação automática de dinheiro em vídeos.\n\n");
+	printf("\t__________________________________________________________________________________________________________________________________________\n");
+
+	int escolha = -1;
+
+	// Ciclo até o utilizador escolher uma opção válida (1, 2 ou 0)
+	while ((escolha != 0) && (escolha != 1) && (escolha != 2))
+	{
+		// Exibição do menu de opções
+		printf("\n\n\t\t\t\t\t\t\tEscolha um vídeo : \n\n");
+		printf("\t\t\t\t\t\t\t\tOpção 1 -> Vídeo 1 (12 Moedas)\n\n");
+		printf("\t\t\t\t\t\t\t\tOpção 2 -> Vídeo 2 (29 Moedas)\n\n");
+		printf("\t\t\t\t\t\t\t\tOpção 0 -> Sair\n\n");
+		printf("\t\t\t\t\t\t\tInsira a sua opção: ");
+
+		// Recebe a opção do utilizador
+		scanf("%d", &escolha);
+
+		// Atribuição do nome do vídeo com base na escolha
+		if (escolha == 1)
+		{
+			strcpy(videofile, "video1.mp4");
+		}
+		else if (escolha == 2)
+		{
+			strcpy(videofile, "video2.mp4");
+		}
+		else if (escolha == 0)
+		{
+			// Se escolher sair, limpa o ecrã e retorna 0
+			printf("\n A fechar o programa...\n\n");
+			system("cls");
+			return 0;
+		}
+		else
+		{
+			// Opção inválida: limpar ecrã e mostrar mensagem de erro
+			system("cls");
+			printf("\nOpção errada!\n\n");
+			printf("Tente novamente!\n\n");
+		}
+	}
+
+	// Retorna 1 indicando uma escolha válida
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: filtrarMoedas
+/**
+ * @brief Filtra as moedas na imagem fornecida, utilizando segmentação em HSV e morfologia matemática.
+ *
+ * Esta função realiza a conversão da imagem BGR para RGB, seguida da conversão para HSV.
+ * Depois realiza duas segmentações HSV em diferentes faixas de cor (para capturar diferentes tipos de moedas).
+ * As duas segmentações são somadas, aplica-se uma operação morfológica de abertura para limpar ruído.
+ * Após isso, realiza a etiquetagem dos blobs encontrados e analisa cada blob, contando e desenhando apenas moedas que passem na linha de reconhecimento.
+ * Aplica ainda verificações adicionais de área, perímetro, circularidade e evita duplicação de contagem seguindo cada moeda entre frames.
+ *
+ * @note Equivale a `segmentarMoedas` seguida de `analisarMoedas`, com uma máscara temporária.
+ *
+ * @param frame Imagem de entrada (BGR), será também utilizada para desenhar as anotações.
+ * @param nframe Número do frame.
+ * @param soma Ponteiro para a variável que armazena a soma do valor das moedas detetadas.
+ * @param total Ponteiro para o array que armazena a contagem de moedas por tipo.
+ */
+void filtrarMoedas(cv::Mat& frame, int nframe, float* soma, int* total)
+{
+	IVC* mascara = vc_image_new(frame.cols, frame.rows, 1, 255);
+
+	segmentarMoedas(frame, mascara, 9);
+	analisarMoedas(frame, mascara, nframe, soma, total);
+
+	vc_image_free(mascara);
+}
+
+#pragma endregion
+
+#pragma region Função: segmentarMoedas
+/**
+ * @brief Etapa de píxeis de `filtrarMoedas`: produz a máscara binária (0/255) das moedas.
+ *
+ * Converte o frame BGR para RGB e depois para HSV, segmenta as moedas amarelas e castanhas,
+ * combina as duas máscaras e aplica uma abertura morfológica para remover ruído.
+ *
+ * @param frame Imagem de entrada (BGR); não é alterada.
+ * @param mascara Imagem de 1 canal, com as dimensões do frame, onde é escrita a máscara.
+ * @param kernelSize Tamanho do kernel da abertura (9 à resolução original).
+ */
+void segmentarMoedas(cv::Mat& frame, IVC* mascara, int kernelSize)
+{
+	// Alocação de imagens IVC intermediárias
+	IVC* imagem = vc_image_new(frame.cols, frame.rows, frame.channels(), 255);
+	IVC* hsv = vc_image_new(frame.cols, frame.rows, 3, 255);
+	IVC* binaria = vc_image_new(frame.cols, frame.rows, 1, 255);
+	IVC* binaria2 = vc_image_new(frame.cols, frame.rows, 1, 255);
+
+	// Conversão de BGR (OpenCV) para RGB (IVC)
+	bgr_to_rgb(frame, imagem);
+
+	// Conversão de RGB para HSV
+	vc_rgb_to_hsv(imagem, hsv);
+
+	// Segmentação para moedas amarelas
+	vc_hsv_segmentation(hsv, binaria, 12, 150, 35, 255, 20, 150);
+
+	// Segmentação para moedas castanhas
+	vc_hsv_segmentation(hsv, binaria2, 12, 150, 0, 80, 20, 130);
+
+	// Combinação das duas máscaras numa imagem binária final
+	somarImagens(binaria, binaria2, mascara);
+
+	// Conversão da IVC para Mat para aplicar morfologia com OpenCV
+	cv::Mat bin_mat3(mascara->height, mascara->width, CV_8UC1, mascara->data);
+
+	// Aplicação da abertura morfológica (remove ruídos e pequenos objetos)
+	cv::Mat limpa;
+	cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernelSize, kernelSize));
+	cv::morphologyEx(bin_mat3, limpa, cv::MORPH_OPEN, kernel, cv::Point(-1, -1), 3);
+
+	// Copiar o resultado da operação morfológica de volta para a IVC
+	memcpy(mascara->data, limpa.data, mascara->width * mascara->height);
+
+	// Libertação da memória
+	vc_image_free(imagem);
+	vc_image_free(hsv);
+	vc_image_free(binaria);
+	vc_image_free(binaria2);
+}
+
+#pragma endregion
+
+#pragma region Função: detetarMoedasPiramide
+/**
+ * @brief Deteção em pirâmide: segmenta a uma resolução reduzida e mede à resolução original.
+ *
+ * O frame é reduzido `escala` vezes (2 ou 4) e a segmentação, a abertura morfológica (com o
+ * kernel reduzido na mesma proporção) e a etiquetagem são feitas sobre a imagem reduzida.
+ * Cada blob reduzido com área suficiente para poder ser uma moeda define uma região de interesse
+ * (a sua caixa delimitadora, ampliada e com uma margem), onde a segmentação é repetida à resolução
+ * original. Assim, a área, o perímetro e o diâmetro são exatos e os limiares em píxeis de
+ * `tipoMoedas` continuam válidos, com 4x a 16x menos píxeis processados.
+ *
+ * A região segmentada tem mais 24 píxeis de cada lado (alcance da abertura 9x9 com 3 iterações),
+ * para que a máscara dentro da região seja igual à máscara do frame completo. São aceites os
+ * componentes que não tocam nos limites da região (os restantes pertencem a blobs vizinhos).
+ *
+ * @note Os blobs demasiado pequenos para serem moedas não são medidos (nunca são desenhados nem contados).
+ *
+ * @param frame Imagem de entrada (BGR); não é alterada.
+ * @param escala Fator de redução (2 ou 4).
+ * @param mascara Imagem de 1 canal, com as dimensões do frame, onde é escrita a máscara (0/255)
+ *                dos blobs medidos (por exemplo, para gravação).
+ * @param nblobs Ponteiro onde é devolvido o número de blobs.
+ *
+ * @return Array de blobs medidos à resolução original (a libertar com `free`), ou NULL se não houver blobs.
+ */
+OVC* detetarMoedasPiramide(cv::Mat& frame, int escala, IVC* mascara, int* nblobs)
+{
+	const int alcance = 24;								// Alcance da abertura morfológica 9x9 (3 iterações)
+	const int margem = 2 * escala + 2;					// Erro da caixa delimitadora reduzida
+	int kernel = MAX(9 / escala, 3) | 1;				// Kernel da abertura na imagem reduzida (ímpar)
+	int ngrosseiros = 0;
+	cv::Mat reduzido;
+
+	*nblobs = 0;
+	memset(mascara->data, 0, mascara->bytesperline * mascara->height);
+
+	// Segmentação e etiquetagem à resolução reduzida
+	cv::resize(frame, reduzido, cv::Size(frame.cols / escala, frame.rows / escala), 0, 0, cv::INTER_AREA);
+
+	IVC* mascaraReduzida = vc_image_new(reduzido.cols, reduzido.rows, 1, 255);
+	segmentarMoedas(reduzido, mascaraReduzida, kernel);
+	static VC_RUNS* runs = vc_runs_new(1024);		// Reutilizados de frame para frame (crescem quando necessário)
+	OVC* grosseiros = (runs != NULL) ? vc_runs_labelling_parallel(mascaraReduzida, runs, &ngrosseiros, 0) : NULL;
+	vc_image_free(mascaraReduzida);
+
+	if (grosseiros == NULL) return NULL;
+
+	std::vector<OVC> blobs;
+
+	for (int i = 0; i < ngrosseiros; i++)
+	{
+		OVC* g = &grosseiros[i];
+
+		// Só os blobs que podem ser moedas (metade da área mínima, por segurança)
+		if (g->area * escala * escala < AREA_MINIMA / 2) continue;
+
+		// Região de interesse à resolução original
+		int x0 = MAX(g->x * escala - margem, 0);
+		int y0 = MAX(g->y * escala - margem, 0);
+		int x1 = MIN((g->x + g->width) * escala + margem, frame.cols);
+		int y1 = MIN((g->y + g->height) * escala + margem, frame.rows);
+
+		// Região segmentada (com o alcance da morfologia)
+		int px0 = MAX(x0 - alcance, 0);
+		int py0 = MAX(y0 - alcance, 0);
+		int px1 = MIN(x1 + alcance, frame.cols);
+		int py1 = MIN(y1 + alcance, frame.rows);
+
+		cv::Mat regiao = frame(cv::Rect(px0, py0, px1 - px0, py1 - py0)).clone();
+		IVC* m = vc_image_new(regiao.cols, regiao.rows, 1, 255);
+		int n = 0;
+
+		segmentarMoedas(regiao, m, 9);
+
+		// Fora da região de interesse não há blobs (e os píxeis da borda do frame são ignorados,
+		// como na etiquetagem do frame completo)
+		for (int y = 0; y < m->height; y++)
+		{
+			for (int x = 0; x < m->width; x++)
+			{
+				int fx = x + px0, fy = y + py0;
+
+				if (fx < x0 || fx >= x1 || fy < y0 || fy >= y1 || fx == 0 || fy == 0 || fx == frame.cols - 1 || fy == frame.rows - 1)
+				{
+					m->data[y * m->bytesperline + x] = 0;
+				}
+			}
+		}
+
+		OVC* finos = etiquetarMoedas(m, frame.rows / 4 - py0, &n);
+
+		for (int j = 0; j < n; j++)
+		{
+			OVC b = finos[j];
+
+			// Componentes cortados pela região de interesse pertencem a um blob vizinho
+			if ((b.x + px0 <= x0 && x0 > 0) || (b.y + py0 <= y0 && y0 > 0) ||
+				(b.x + b.width + px0 >= x1 && x1 < frame.cols) || (b.y + b.height + py0 >= y1 && y1 < frame.rows)) continue;
+
+			b.x += px0;
+			b.y += py0;
+			b.xc += px0;
+			b.yc += py0;
+
+			// Componente já medido a partir de outro blob reduzido
+			if (mascara->data[b.yc * mascara->bytesperline + b.xc] != 0) continue;
+
+			// Copia o componente para a máscara do frame completo
+			for (int y = b.y; y < b.y + b.height; y++)
+			{
+				for (int x = b.x; x < b.x + b.width; x++)
+				{
+					if (m->data[(y - py0) * m->bytesperline + (x - px0)] == finos[j].label)
+					{
+						mascara->data[y * mascara->bytesperline + x] = 255;
+					}
+				}
+			}
+
+			b.label = (int)blobs.size() + 1;
+			blobs.push_back(b);
+		}
+
+		free(finos);
+		vc_image_free(m);
+	}
+
+	free(grosseiros);
+
+	if (blobs.empty()) return NULL;
+
+	OVC* resultado = (OVC*)malloc(blobs.size() * sizeof(OVC));
+	memcpy(resultado, blobs.data(), blobs.size() * sizeof(OVC));
+	*nblobs = (int)blobs.size();
+
+	return resultado;
+}
+
+#pragma endregion
+
+#pragma region Função: analisarMoedas
+/**
+ * @brief Etapas seguintes de `filtrarMoedas`: etiqueta a máscara, mede os blobs e conta as moedas.
+ *
+ * Pode ser alimentada tanto pela máscara de `segmentarMoedas` como por uma máscara lida de uma
+ * gravação (.vcr), sem voltar a descodificar o vídeo.
+ *
+ * @note No fim, `mascara` contém a imagem de etiquetas (a etiquetagem é feita sobre a própria máscara).
+ *
+ * @param frame Imagem onde são desenhadas as anotações.
+ * @param mascara Máscara binária (0/255) com as dimensões do frame.
+ * @param nframe Número do frame (usado pelo rastreador para prever a posição das moedas).
+ * @param soma Ponteiro para a variável que armazena a soma do valor das moedas detetadas.
+ * @param total Ponteiro para o array que armazena a contagem de moedas por tipo.
+ */
+void analisarMoedas(cv::Mat& frame, IVC* mascara, int nframe, float* soma, int* total)
+{
+	int nlabels = 0; // Número de blobs encontrados após etiquetagem
+
+	OVC* blobs = etiquetarMoedas(mascara, frame.rows / 4, &nlabels);
+
+	processarBlobs(frame, blobs, nlabels, nframe, soma, total);
+
+	// Libertação da memória
+	free(blobs);
+}
+
+#pragma endregion
+
+#pragma region Função: etiquetarMoedas
+/**
+ * @brief Etiqueta a máscara e avalia os blobs com a cascata de `avaliarBlobs`.
+ *
+ * A máscara é convertida em runs e a etiquetagem, a área, a caixa delimitadora e o centroide são
+ * calculados sobre os runs, sem percorrer os píxeis de cada blob (`vc_runs_labelling_parallel`,
+ * em faixas de linhas paralelas nos frames grandes).
+ *
+ * Os blobs abaixo da área mínima de uma moeda são descartados sobre os runs e os restantes são
+ * renumerados (`vc_runs_filter_area`), tal como na deteção em pirâmide: nunca são desenhados nem
+ * contados, mas entram no total de blobs da cascata.
+ *
+ * @note A máscara fica com a imagem de etiquetas dos blobs mantidos (`vc_runs_paint`), usada no
+ *       seguimento do contorno e na gravação. Só os primeiros 255 cabem na imagem de etiquetas.
+ *
+ * @param mascara Máscara binária (0/255).
+ * @param linha Posição Y da linha de reconhecimento, nas coordenadas da máscara.
+ * @param nlabels Ponteiro onde é devolvido o número de blobs encontrados.
+ *
+ * @return Array de blobs (a libertar com `free`), ou NULL se não houver blobs.
+ */
+OVC* etiquetarMoedas(IVC* mascara, int linha, int* nlabels)
+{
+	static VC_RUNS* runs = vc_runs_new(1024);		// Reutilizados de frame para frame (crescem quando necessário)
+	OVC* blobs = NULL;
+
+	*nlabels = 0;
+
+	// Etiquetagem dos blobs encontrados na imagem binária (sobre os runs, em faixas paralelas nos frames grandes)
+	if (runs != NULL)
+	{
+		blobs = vc_runs_labelling_parallel(mascara, runs, nlabels, 0);
+	}
+
+	if (blobs == NULL) return NULL;
+
+	// Só os blobs com a área mínima de uma moeda têm de caber nas etiquetas de 8 bits
+	int ntotal = *nlabels;
+	int nmoedas = vc_runs_filter_area(runs, blobs, ntotal, AREA_MINIMA);
+	*nlabels = MAX(nmoedas, 0);
+	cascata.nblobs += ntotal - *nlabels;
+
+	// Imagem de etiquetas (as etiquetas acima de 255 não cabem e esses blobs são ignorados)
+	if (!vc_runs_paint(runs, mascara))
+	{
+		*nlabels = 255;
+		metricaContar(METRICA_ETIQUETAS_EXCEDIDAS, 1);
+	}
+
+	if (*nlabels == 0)
+	{
+		free(blobs);
+		return NULL;
+	}
+
+	// Linha de reconhecimento, perímetro e circularidade só para os blobs viáveis
+	avaliarBlobs(mascara, blobs, *nlabels, linha);
+
+	return blobs;
+}
+
+#pragma endregion
+
+#pragma region Função: avaliarBlobs
+/**
+ * @brief Cascata de avaliação dos blobs: as características caras só são calculadas para os blobs
+ * que passam as etapas baratas anteriores.
+ *
+ * 1. Área e caixa delimitadora (já calculadas por `vc_runs_blob_info`): área mínima de uma moeda;
+ * 2. Linha de reconhecimento: guardada no estado do blob, mas não elimina o blob, porque as moedas
+ *    fora da linha também são seguidas e desenhadas;
+ * 3. Perímetro (seguimento do contorno, ver `vc_binary_blob_perimeter`): perímetro mínimo de uma moeda;
+ * 4. Circularidade: circularidade mínima de uma moeda.
+ *
+ * O resultado de cada etapa fica no blob (`estado`, `perimetro`, `perimetroCorrigido`, `circularidade`, `diametro`), para não
+ * voltar a ser calculado no desenho, na classificação e na contagem, e é acumulado em `cascata`.
+ *
+ * @param etiquetas Imagem de etiquetas.
+ * @param blobs Blobs com a área e a caixa delimitadora calculadas.
+ * @param nblobs Número de blobs.
+ * @param linha Posição Y da linha de reconhecimento, nas coordenadas da imagem de etiquetas.
+ */
+void avaliarBlobs(IVC* etiquetas, OVC* blobs, int nblobs, int linha)
+{
+	cascata.nblobs += nblobs;
+
+	for (int i = 0; i < nblobs; i++)
+	{
+		OVC* b = &blobs[i];
+
+		b->estado = 0;
+		b->perimetro = 0;
+		b->perimetroCorrigido = 0.0f;
+		b->circularidade = 0.0f;
+
+		// 1. Área
+		if (b->area < AREA_MINIMA) continue;
+		b->estado |= ETAPA_AREA;
+		cascata.narea++;
+
+		// 2. Linha de reconhecimento
+		if (blobNaLinha(*b, linha))
+		{
+			b->estado |= ETAPA_LINHA;
+			cascata.nlinha++;
+		}
+
+		// 3. Perímetro (seguimento do contorno)
+		vc_binary_blob_perimeter(etiquetas, b);
+		if (b->perimetro < PERIMETRO_MINIMO) continue;
+		b->estado |= ETAPA_PERIMETRO;
+		cascata.nperimetro++;
+
+		// 4. Circularidade
+		b->circularidade = calcular_circularidade(b);
+		if (b->circularidade <= CIRCULARIDADE_MINIMA) continue;
+		b->estado |= ETAPA_CIRCULARIDADE;
+		cascata.ncircularidade++;
+	}
+}
+
+#pragma endregion
+
+#pragma region Função: resumoCascata
+/**
+ * @brief Mostra no terminal quantos blobs passaram cada etapa da cascata de avaliação.
+ *
+ * @param cascata Estatísticas da cascata.
+ */
+void resumoCascata(CASCATA* cascata)
+{
+	printf("\n\t\t\t\t\t\t\tAvaliação dos blobs:\n");
+	printf("\t\t\t\t\t\t\t\tBlobs: %ld\n", cascata->nblobs);
+	printf("\t\t\t\t\t\t\t\tÁrea mínima: %ld (na linha: %ld)\n", cascata->narea, cascata->nlinha);
+	printf("\t\t\t\t\t\t\t\tPerímetro mínimo: %ld\n", cascata->nperimetro);
+	printf("\t\t\t\t\t\t\t\tCircularidade mínima: %ld\n", cascata->ncircularidade);
+}
+
+#pragma endregion
+
+#pragma region Função: processarBlobs
+/**
+ * @brief Desenha e conta as moedas a partir dos blobs já medidos de um frame.
+ *
+ * Separada da etiquetagem para poder ser repetida sobre os blobs do último frame processado
+ * quando o detetor de movimento salta o processamento de um frame (ver `verificarMovimento`).
+ *
+ * Os blobs são copiados para uma tabela em estrutura de arrays (`VC_BLOBS`, reutilizada de frame
+ * para frame) e os que não têm a área e o perímetro mínimos de uma moeda (que nunca são desenhados
+ * nem contados) são removidos logo, com filtros compactos. Só as moedas candidatas que restam são seguidas, classificadas e desenhadas.
+ *
+ * As moedas candidatas são associadas a rastos pelo `rastreador` (ver `atualizarRastreador`).
+ * Cada rasto é contado uma única vez: quando a moeda é vista na linha de reconhecimento, ou
+ * quando o rasto passa de um lado da linha para o outro entre duas observações (frames saltados).
+ *
+ * As anotações (caixas, cruzes e textos) são acumuladas na `sobreposicao` durante a análise e
+ * desenhadas no frame de uma só vez no fim (ver `aplicarSobreposicao`).
+ *
+ * @param frame Imagem onde são desenhadas as anotações.
+ * @param blobs Blobs do frame (saída de `etiquetarMoedas`).
+ * @param nlabels Número de blobs.
+ * @param nframe Número do frame em que os blobs foram medidos.
+ * @param soma Ponteiro para a variável que armazena a soma do valor das moedas detetadas.
+ * @param total Ponteiro para o array que armazena a contagem de moedas por tipo.
+ */
+void processarBlobs(cv::Mat& frame, OVC* blobs, int nlabels, int nframe, float* soma, int* total)
+{
+	static VC_BLOBS* tabela = vc_blobs_new(64);		// Reutilizada de frame para frame (cresce quando necessário)
+	int linha = frame.rows / 4;
+
+	// Anotações do frame
+	iniciarSobreposicao(&sobreposicao);
+
+	// Desenhar a linha de reconhecimento (auxiliar visual)
+	linhaReconhecimento(&sobreposicao, linha, frame.cols);
+
+	// Filtrar por área e perímetro mínimos esperados
+	tabela->n = 0;
+	vc_blobs_from_ovc(tabela, blobs, nlabels);
+	vc_blobs_filter_range(tabela, VC_BLOB_AREA, AREA_MINIMA, INT_MAX);
+	vc_blobs_filter_range(tabela, VC_BLOB_PERIMETRO, PERIMETRO_MINIMO, INT_MAX);
+
+	int n = tabela->n;
+	OVC* candidatas = (OVC*)malloc(MAX(n, 1) * sizeof(OVC));
+
+	metricaContar(METRICA_FRAMES, 1);
+	metricaBlobs(nlabels);
+	metricaContar(METRICA_CANDIDATAS, n);
+	int* rasto = (int*)malloc(MAX(n, 1) * sizeof(int));
+	int* tipo = (int*)malloc(MAX(n, 1) * sizeof(int));
+
+	vc_blobs_to_ovc(tabela, candidatas);
+
+	// Associa as moedas candidatas aos rastos
+	atualizarRastreador(&rastreador, candidatas, n, nframe, rasto);
+
+	// Classifica todas as moedas candidatas do frame de uma só vez
+	classificarMoedas(&tabelaMoedas, tabela, tipo);
+
+	// Ciclo para processar cada moeda candidata
+	for (int i = 0; i < n; i++)
+	{
+		int cx = candidatas[i].xc;
+		int cy = candidatas[i].yc;
+
+		// Verificar se o centro está dentro dos limites da imagem
+		if (cx < 0 || cx >= frame.cols || cy < 0 || cy >= frame.rows) continue;
+
+		// Desenhar caixa ao redor do blob
+		desenhaBox(&sobreposicao, candidatas[i]);
+
+		if (rasto[i] < 0) continue;
+
+		RASTO* r = &rastreador.rastos[rasto[i]];
+		int naLinha = (candidatas[i].estado & ETAPA_LINHA) != 0;
+
+		// Escrever aviso de moeda detetada no frame
+		if (naLinha) escreveMoedaDetetada(&sobreposicao, linha, frame.cols);
+
+		// Verificar se a moeda está na linha de reconhecimento (com tolerância) ou se a atravessou
+		if (!r->contada && (naLinha || (r->yanterior - linha) * (r->y - linha) < 0.0f))
+		{
+			// Conta e acumula a moeda (uma única vez por rasto)
+			contarMoeda(&sobreposicao, candidatas[i], tipo[i], nframe, soma, total);
+			r->contada = 1;
+		}
+	}
+
+	// Desenhar as anotações do frame
+	aplicarSobreposicao(frame, &sobreposicao);
+
+	// Libertação da memória (a tabela é reutilizada no frame seguinte)
+	free(candidatas);
+	free(rasto);
+	free(tipo);
+}
+
+#pragma endregion
+
+#pragma region Função: blobNaLinha
+/**
+ * @brief Verifica se o centro de um blob está na linha de reconhecimento (com tolerância).
+ *
+ * A linha de reconhecimento está a 1/4 da altura do frame.
+ *
+ * @param blob Blob a verificar.
+ * @param linha Posição Y da linha de reconhecimento.
+ *
+ * @return 1 se o blob está na linha de reconhecimento; 0 caso contrário.
+ */
+int blobNaLinha(OVC& blob, int linha)
+{
+	return (linha >= blob.yc - 12 && linha <= blob.yc + 9) ? 1 : 0;
+}
+
+#pragma endregion
+
+#pragma region Função: verificarMovimento
+/**
+ * @brief Detetor de movimento barato, executado antes da segmentação.
+ *
+ * Compara o frame com o último frame processado em células de `movimento->bloco` píxeis
+ * (`vc_image_sad_blocos`, uma linha em cada `movimento->passo`). Se nenhuma célula tiver uma
+ * diferença média por byte acima de `movimento->limiar`, considera-se que nada se moveu: o frame
+ * não precisa de ser segmentado nem etiquetado e os blobs do último frame processado podem ser
+ * reutilizados. Usa-se o máximo por célula e não a média do frame, porque uma única moeda em
+ * movimento altera uma fração muito pequena dos píxeis.
+ *
+ * Mesmo sem movimento acima do limiar, o frame é processado quando uma moeda candidata do último
+ * frame processado está a menos de uma altura da banda da linha de reconhecimento (22 píxeis) mais
+ * o deslocamento esperado desde esse frame (velocidade vertical máxima dos rastos; sem velocidade
+ * observada, uma banda por frame). Como a referência só é atualizada nos frames processados, uma
+ * deriva lenta acaba por ultrapassar o limiar.
+ *
+ * @param movimento Estado do detetor (referência e estatísticas).
+ * @param frame Frame atual (BGR).
+ * @param blobs Blobs do último frame processado.
+ * @param nblobs Número de blobs.
+ * @param linha Posição Y da linha de reconhecimento.
+ * @param nframe Número do frame atual.
+ * @param rastreador Rastreador de moedas (velocidades dos rastos).
+ *
+ * @return 1 se o frame deve ser processado; 0 se pode ser saltado.
+ */
+int verificarMovimento(MOVIMENTO* movimento, cv::Mat& frame, OVC* blobs, int nblobs, int linha, int nframe, RASTREADOR* rastreador)
+{
+	static const float banda = 22.0f;
+	IVC vista = { frame.data, frame.cols, frame.rows, frame.channels(), 256, (int)frame.step, 0, VC_BORDER_REPLICATE, 0 };
+	IVC* referencia = movimento->referencia;
+	int bytes = frame.cols * frame.channels();
+	int processar = 1;
+
+	movimento->nframes++;
+
+	// Primeiro frame (ou mudança de dimensões): não há referência
+	if ((referencia == NULL) || (referencia->width != frame.cols) || (referencia->height != frame.rows) || (referencia->channels != frame.channels()))
+	{
+		vc_image_free(referencia);
+		referencia = movimento->referencia = vc_image_new(frame.cols, frame.rows, frame.channels(), 255);
+		if (referencia == NULL) return 1;
+	}
+	else
+	{
+		float diferenca = vc_image_sad_blocos(&vista, referencia, movimento->passo, movimento->bloco);
+
+		if ((diferenca >= 0.0f) && (diferenca <= movimento->limiar))
+		{
+			float velocidade = -1.0f;
+
+			processar = 0;
+
+			// Deslocamento vertical esperado desde o último frame processado
+			for (int i = 0; i < rastreador->nrastos; i++)
+			{
+				if (rastreador->rastos[i].nassociacoes < 2) continue;
+				velocidade = MAX(velocidade, fabsf(rastreador->rastos[i].vy));
+			}
+			if (velocidade < 0.0f) velocidade = banda;
+
+			float margem = banda + velocidade * (float)MAX(nframe - movimento->nframeReferencia, 1);
+
+			// Moedas candidatas perto da linha de reconhecimento são sempre medidas de novo
+			for (int i = 0; i < nblobs; i++)
+			{
+				if ((blobs[i].estado & ETAPA_PERIMETRO) && (fabsf((float)(blobs[i].yc - linha)) <= margem))
+				{
+					processar = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	if (processar == 0)
+	{
+		movimento->nsaltados++;
+		return 0;
+	}
+
+	// O frame vai ser processado: passa a ser a referência
+	for (int y = 0; y < frame.rows; y++)
+	{
+		memcpy(referencia->data + (long int)y * referencia->bytesperline, frame.data + (long int)y * frame.step, bytes);
+	}
+	movimento->nframeReferencia = nframe;
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: resumoMovimento
+/**
+ * @brief Mostra no terminal as estatísticas do detetor de movimento.
+ *
+ * @param movimento Estado do detetor.
+ */
+void resumoMovimento(MOVIMENTO* movimento)
+{
+	float taxa = (movimento->nframes > 0) ? 100.0f * (float)movimento->nsaltados / (float)movimento->nframes : 0.0f;
+
+	printf("\n\t\t\t\t\t\t\tDetetor de movimento (limiar %.2f por célula de %dx%d):\n", movimento->limiar, movimento->bloco, movimento->bloco);
+	printf("\t\t\t\t\t\t\t\tFrames avaliados: %ld\n", movimento->nframes);
+	printf("\t\t\t\t\t\t\t\tFrames saltados: %ld (%.1f%%)\n", movimento->nsaltados, taxa);
+}
+
+#pragma endregion
+
+#pragma region Função: reproduzirGravacao
+/**
+ * @brief Processa uma gravação .vcr como se fosse um vídeo.
+ *
+ * Cada máscara gravada (VC_REC_MASCARA) é enviada para `analisarMoedas`. Se a gravação também
+ * contiver os frames originais (VC_REC_FRAME), as anotações são desenhadas sobre eles; caso
+ * contrário, sobre um fundo branco. As imagens de etiquetas gravadas são ignoradas.
+ *
+ * @param ficheiro Nome do ficheiro .vcr.
+ * @param soma Ponteiro para a variável que armazena a soma do valor das moedas detetadas.
+ * @param total Ponteiro para o array que armazena a contagem de moedas por tipo.
+ *
+ * @return 1 se a gravação foi processada; 0 se não foi possível abri-la.
+ */
+int reproduzirGravacao(const char* ficheiro, float* soma, int* total)
+{
+	VC_LEITOR* leitor = vc_leitor_abrir(ficheiro);
+	cv::Mat frame;
+	int nframeFrame = -1;
+	int nregistos, nmascaras = 0;
+
+	if (leitor == NULL)
+	{
+		fprintf(stderr, "Erro ao abrir a gravação %s!\n", ficheiro);
+		return 0;
+	}
+
+	ECRA* ecra = abrirEcra("Trabalho de Visao por Computador", opcoes.previsualizar);
+
+	// Conta as máscaras gravadas (total de frames a mostrar no resumo)
+	nregistos = vc_leitor_nregistos(leitor);
+	for (int i = 0; i < nregistos; i++)
+	{
+		int tipo;
+
+		if (vc_leitor_info(leitor, i, NULL, &tipo) && (tipo == VC_REC_MASCARA)) nmascaras++;
+	}
+
+	for (int i = 0; i < nregistos; i++)
+	{
+		int nframe, tipo;
+		IVC* image = vc_leitor_ler(leitor, i, &nframe, &tipo);
+
+		if (image == NULL) break;
+
+		if (tipo == VC_REC_FRAME)
+		{
+			// Guarda o frame original para desenhar as anotações da máscara correspondente
+			cv::Mat(image->height, image->width, CV_8UC3, image->data).copyTo(frame);
+			nframeFrame = nframe;
+		}
+		else if (tipo == VC_REC_MASCARA)
+		{
+			cv::Mat fundo;
+
+			if ((nframeFrame == nframe) && (frame.rows == image->height) && (frame.cols == image->width))
+				fundo = frame;
+			else
+				fundo = cv::Mat(image->height, image->width, CV_8UC3, cv::Scalar(255, 255, 255));
+
+			analisarMoedas(fundo, image, nframe, soma, total);
+			resumoFrame(fundo, total, *soma, image->width, image->height, nmascaras, 0, nframe);
+			mostrarEcra(ecra, fundo);
+
+			if (teclaEcra(ecra) == 27)
+			{
+				vc_image_free(image);
+				break;
+			}
+		}
+
+		vc_image_free(image);
+	}
+
+	vc_leitor_fechar(leitor);
+	fecharEcra(ecra);
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: iniciarDecimacao
+/**
+ * @brief Inicializa o controlo de decimação (processa todos os frames até haver moedas seguidas).
+ *
+ * @param decimacao Estado a inicializar.
+ * @param alvo Throughput alvo, em frames de vídeo por segundo (0 = decimação máxima segura).
+ */
+void iniciarDecimacao(DECIMACAO* decimacao, float alvo)
+{
+	*decimacao = DECIMACAO();
+	decimacao->alvo = alvo;
+	decimacao->k = 1;
+	decimacao->kalvo = 1;
+	decimacao->kmax = 8;
+}
+
+#pragma endregion
+
+#pragma region Função: calcularDecimacao
+/**
+ * @brief Escolhe quantos frames avançar até ao próximo frame processado.
+ *
+ * Chamada uma vez por frame processado, depois de `processarBlobs`. O valor de k é o menor de:
+ * - k seguro: com a velocidade máxima observada das moedas (rastos associados neste frame),
+ *   k frames não podem deslocar uma moeda mais do que a banda da linha de reconhecimento
+ *   (22 píxeis, com margem de 20%), para que cada moeda seja sempre vista na banda;
+ * - k do throughput: ajustado a cada frame (+1/-1) comparando o throughput medido
+ *   (frames de vídeo consumidos por segundo) com o alvo. Sem alvo, usa-se apenas o k seguro.
+ *
+ * Enquanto não houver velocidade observada, todos os frames são processados (k = 1).
+ * A velocidade máxima sobe de imediato e desce lentamente (média exponencial).
+ *
+ * @param decimacao Estado da decimação.
+ * @param rastreador Rastreador de moedas (velocidades dos rastos).
+ * @param nframe Número do frame processado.
+ *
+ * @return O número de frames a avançar (1 = processar o frame seguinte).
+ */
+int calcularDecimacao(DECIMACAO* decimacao, RASTREADOR* rastreador, int nframe)
+{
+	static const float banda = 22.0f * 0.8f;
+	std::chrono::steady_clock::time_point agora = std::chrono::steady_clock::now();
+	float vatual = -1.0f;
+	int kseguro;
+
+	decimacao->nprocessados++;
+
+	// Velocidade máxima das moedas seguidas neste frame
+	for (int i = 0; i < rastreador->nrastos; i++)
+	{
+		RASTO* r = &rastreador->rastos[i];
+
+		if ((r->nframe != nframe) || (r->nassociacoes < 2)) continue;
+
+		vatual = MAX(vatual, sqrtf(r->vx * r->vx + r->vy * r->vy));
+	}
+
+	if (vatual >= 0.0f)
+	{
+		if (vatual > decimacao->vmax) decimacao->vmax = vatual;
+		else decimacao->vmax += 0.1f * (vatual - decimacao->vmax);
+		decimacao->velocidadeConhecida = 1;
+	}
+
+	if (!decimacao->velocidadeConhecida) kseguro = 1;
+	else if (decimacao->vmax * decimacao->kmax <= banda) kseguro = decimacao->kmax;
+	else kseguro = MAX((int)(banda / decimacao->vmax), 1);
+
+	// Throughput medido desde o último frame processado (k frames de vídeo consumidos)
+	if (decimacao->nprocessados > 1)
+	{
+		double segundos = std::chrono::duration<double>(agora - decimacao->anterior).count();
+
+		if (segundos > 0.0)
+		{
+			double throughput = (double)decimacao->k / segundos;
+
+			decimacao->throughput = (decimacao->throughput > 0.0) ? decimacao->throughput + 0.1 * (throughput - decimacao->throughput) : throughput;
+		}
+
+		if (decimacao->alvo > 0.0f)
+		{
+			if (decimacao->throughput < decimacao->alvo) decimacao->kalvo = MIN(decimacao->kalvo + 1, decimacao->kmax);
+			else if ((decimacao->throughput > 1.2 * decimacao->alvo) && (decimacao->kalvo > 1)) decimacao->kalvo--;
+		}
+	}
+	decimacao->anterior = agora;
+
+	decimacao->k = (decimacao->alvo > 0.0f) ? MIN(decimacao->kalvo, kseguro) : kseguro;
+
+	return decimacao->k;
+}
+
+#pragma endregion
+
+#pragma region Função: resumoDecimacao
+/**
+ * @brief Mostra no terminal as estatísticas da decimação.
+ *
+ * @param decimacao Estado da decimação.
+ */
+void resumoDecimacao(DECIMACAO* decimacao)
+{
+	float taxa = (decimacao->nlidos > 0) ? 100.0f * (float)decimacao->nprocessados / (float)decimacao->nlidos : 0.0f;
+
+	printf("\n\t\t\t\t\t\t\tDecimação de frames:\n");
+	printf("\t\t\t\t\t\t\t\tFrames lidos: %ld\n", decimacao->nlidos);
+	printf("\t\t\t\t\t\t\t\tFrames processados: %ld (%.1f%%)\n", decimacao->nprocessados, taxa);
+	printf("\t\t\t\t\t\t\t\tVelocidade máxima das moedas: %.1f píxeis/frame\n", decimacao->vmax);
+	printf("\t\t\t\t\t\t\t\tThroughput: %.1f frames/s\n", decimacao->throughput);
+}
+
+#pragma endregion
+
+#pragma region Função: bgr_to_rgb
+/**
+ * @brief Converte uma imagem no formato BGR (padrão do OpenCV) para o formato RGB,
+ * armazenando o resultado numa estrutura de imagem IVC.
+ *
+ * Esta função converte uma imagem OpenCV (`cv::Mat`) que está no espaço de cor BGR
+ * para RGB, e depois copia os dados linha a linha para a estrutura `IVC`.
+ * Esta conversão é necessária porque a biblioteca OpenCV utiliza BGR por padrão,
+ * enquanto o processamento na framework IVC utiliza RGB.
+ *
+ * @param imagemEntrada Imagem de entrada do OpenCV em BGR (tipo `cv::Mat`).
+ * @param imagemSaida Apontador para a estrutura `IVC` previamente alocada onde será armazenada a imagem convertida em RGB.
+ *
+ * @return Retorna 1 se a conversão foi realizada com sucesso, ou 0 em caso de erro (parâmetros inválidos, dimensões incompatíveis, etc.).
+ */
+int bgr_to_rgb(const cv::Mat& imagemEntrada, IVC* imagemSaida)
+{
+	// Verificar se a imagem de entrada está vazia ou se a imagem de saída é nula
+	if (imagemEntrada.empty() || imagemSaida == nullptr)
+		return 0;
+
+	// Verificar se ambas as imagens possuem 3 canais (BGR e RGB)
+	if (imagemEntrada.channels() != 3 || imagemSaida->channels != 3)
+		return 0;
+
+	// Criação de uma nova imagem RGB temporária usando OpenCV
+	cv::Mat imagemRGB;
+	cv::cvtColor(imagemEntrada, imagemRGB, cv::COLOR_BGR2RGB);
+
+	// Validar se as dimensões da imagem convertida coincidem com a estrutura de saída
+	if (imagemRGB.cols != imagemSaida->width || imagemRGB.rows != imagemSaida->height)
+		return 0;
+
+	// Obter o número de bytes por linha na estrutura IVC
+	int bytesPerLine = imagemSaida->bytesperline;
+
+	// Percorrer todas as linhas da imagem
+	for (int y = 0; y < imagemRGB.rows; y++)
+	{
+		// Ponteiro para a linha atual na imagem OpenCV (RGB)
+		const cv::Vec3b* linha = imagemRGB.ptr<cv::Vec3b>(y);
+
+		// Ponteiro para a linha correspondente na imagem de saída IVC
+		unsigned char* linhaSaida = imagemSaida->data + y * bytesPerLine;
+
+		// Percorrer todos os píxeis da linha
+		for (int x = 0; x < imagemRGB.cols; x++)
+		{
+			// Copiar cada componente RGB para a estrutura IVC
+			linhaSaida[x * 3] = linha[x][0]; // R
+			linhaSaida[x * 3 + 1] = linha[x][1]; // G
+			linhaSaida[x * 3 + 2] = linha[x][2]; // B
+		}
+	}
+
+	// Retorna 1 indicando sucesso
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: tipoMoedas
+
+/**
+ * @brief Determina o tipo de moeda (valor em centavos) com base em várias características geométricas.
+ *
+ * Classifica um único blob com a tabela de moedas carregada (`tabelaMoedas`, ver `carregarMoedas`),
+ * que contém os limites empíricos de cada moeda de euro (ou os de outro ficheiro de moedas).
+ * Caso o blob cumpra os requisitos de uma moeda, retorna o seu valor em centavos (ex: 200 para 2€, 50 para 0.50€, etc.).
+ *
+ * Caso o blob não corresponda a nenhum dos tipos definidos, retorna -1.
+ *
+ * @note Para vários blobs, `classificarMoedas` classifica-os todos de uma vez.
+ *
+ * @param perimetro Valor do perímetro do blob.
+ * @param area Valor da área do blob.
+ * @param circ Valor da circularidade do blob.
+ * @param diametro Estimativa do diâmetro da moeda calculado a partir da bounding box.
+ *
+ * @return Valor da moeda em centavos, ou -1 se não corresponder a nenhuma moeda válida.
+ */
+int tipoMoedas(int perimetro, int area, float circ, int diametro)
+{
+	for (int d = 0; d < tabelaMoedas.n; d++)
+	{
+		if (diametro >= tabelaMoedas.diamMin[d] && diametro <= tabelaMoedas.diamMax[d] &&
+			area >= tabelaMoedas.areaMin[d] && area <= tabelaMoedas.areaMax[d] &&
+			perimetro >= tabelaMoedas.perimMin[d] && perimetro <= tabelaMoedas.perimMax[d] &&
+			circ > tabelaMoedas.circMin[d])
+		{
+			return tabelaMoedas.valor[d];
+		}
+	}
+
+	// Se nenhum critério corresponder, retorna -1 (não reconhecida)
+	return -1;
+}
+
+
+#pragma endregion
+#pragma region Função: carregarMoedas
+/**
+ * @brief Carrega a tabela de moedas de um ficheiro de texto.
+ *
+ * Cada linha descreve uma moeda (as linhas vazias e as começadas por `#` são ignoradas):
+ *
+ *     valor indice diam_min diam_max area_min area_max perim_min perim_max circ_min
+ *
+ * - `valor`: valor da moeda em cêntimos;
+ * - `indice`: posição da moeda no array de contagens (0 a 7, como em `resumoFrame`; -1 = só no total);
+ * - intervalos (inclusivos) do diâmetro, área e perímetro, em píxeis;
+ * - `circ_min`: a circularidade tem de ser superior a este valor.
+ *
+ * A ordem das linhas é a prioridade: um blob que cumpra os intervalos de várias moedas fica com a primeira.
+ * Se `ficheiro` for NULL, ou não puder ser lido, é usada a tabela das moedas de euro (a mesma de `moedas.txt`).
+ *
+ * @param tabela Tabela a preencher.
+ * @param ficheiro Nome do ficheiro (pode ser NULL).
+ *
+ * @return 1 se a tabela foi lida do ficheiro; 0 se foi usada a tabela predefinida.
+ */
+int carregarMoedas(TABELA_MOEDAS* tabela, const char* ficheiro)
+{
+	// Tabela predefinida (moedas de euro, pela ordem de prioridade original)
+	static const float euro[8][9] = {
+		{  50, 5, 177, 181, 24200, 25950, 550, 560, 0.40f },
+		{  20, 4, 158, 165, 19375, 21615, 467, 590, 0.40f },
+		{ 200, 7, 184, 190, 27140, 28140, 575, 605, 0.40f },
+		{  10, 3, 140, 145, 15460, 17210, 430, 460, 0.40f },
+		{   5, 2, 150, 157, 19060, 19844, 450, 493, 0.40f },
+		{ 100, 6, 169, 172, 22145, 23000, 545, 745, 0.40f },
+		{   2, 1, 135, 140, 14920, 15470, 400, 430, 0.40f },
+		{   1, 0, 116, 122, 10740, 11930, 340, 420, 0.40f },
+	};
+	FILE* file = (ficheiro != NULL) ? fopen(ficheiro, "r") : NULL;
+	char linha[256];
+	float c[9];
+
+	memset(tabela, 0, sizeof(TABELA_MOEDAS));
+
+	if (file != NULL)
+	{
+		while ((fgets(linha, sizeof(linha), file) != NULL) && (tabela->n < MAX_MOEDAS))
+		{
+			if (sscanf(linha, "%f %f %f %f %f %f %f %f %f", &c[0], &c[1], &c[2], &c[3], &c[4], &c[5], &c[6], &c[7], &c[8]) != 9) continue;
+
+			int i = tabela->n++;
+			tabela->valor[i] = (int)c[0];
+			tabela->indice[i] = (c[1] >= 0 && c[1] <= 7) ? (int)c[1] : -1;
+			tabela->diamMin[i] = c[2]; tabela->diamMax[i] = c[3];
+			tabela->areaMin[i] = c[4]; tabela->areaMax[i] = c[5];
+			tabela->perimMin[i] = c[6]; tabela->perimMax[i] = c[7];
+			tabela->circMin[i] = c[8];
+		}
+
+		fclose(file);
+
+		if (tabela->n > 0) return 1;
+	}
+
+	for (int i = 0; i < 8; i++)
+	{
+		tabela->valor[i] = (int)euro[i][0];
+		tabela->indice[i] = (int)euro[i][1];
+		tabela->diamMin[i] = euro[i][2]; tabela->diamMax[i] = euro[i][3];
+		tabela->areaMin[i] = euro[i][4]; tabela->areaMax[i] = euro[i][5];
+		tabela->perimMin[i] = euro[i][6]; tabela->perimMax[i] = euro[i][7];
+		tabela->circMin[i] = euro[i][8];
+	}
+	tabela->n = 8;
+
+	return 0;
+}
+
+#pragma endregion
+
+#pragma region Função: classificarMoedas
+/**
+ * @brief Classifica todos os blobs de um frame de uma só vez, com a tabela de moedas.
+ *
+ * Os blobs estão em estrutura de arrays (`VC_BLOBS`): os testes de intervalo de cada moeda da
+ * tabela são calculados para 4 blobs de cada vez com instruções SSE2,
+ * sem saltos por blob. As moedas são percorridas da última para a primeira e cada correspondência
+ * substitui a anterior, pelo que fica a primeira da tabela.
+ *
+ * @param tabela Tabela de moedas (ver `carregarMoedas`).
+ * @param blobs Blobs do frame.
+ * @param tipo Array (blobs->n) onde é devolvido, para cada blob, o índice da moeda na tabela (-1 se não corresponde a nenhuma).
+ */
+void classificarMoedas(TABELA_MOEDAS* tabela, VC_BLOBS* blobs, int* tipo)
+{
+	int nblobs = blobs->n;
+	int n = (nblobs + 3) & ~3;		// Múltiplo de 4 (colunas SSE)
+	int* diametros = blobs->campo[VC_BLOB_DIAMETRO];
+	int* areas = blobs->campo[VC_BLOB_AREA];
+	int* perimetros = blobs->campo[VC_BLOB_PERIMETRO];
+	std::vector<float> diam(n, 0.0f), area(n, 0.0f), perim(n, 0.0f), circ(n, 0.0f);
+	std::vector<int> t(n, -1);
+	int i = 0, d;
+
+	// Características em vírgula flutuante (diâmetro e circularidade já calculados pela cascata, ver `avaliarBlobs`)
+#ifdef VC_SSE2
+	for (; i + 4 <= nblobs; i += 4)
+	{
+		_mm_storeu_ps(&diam[i], _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(diametros + i))));
+		_mm_storeu_ps(&area[i], _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(areas + i))));
+		_mm_storeu_ps(&perim[i], _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(perimetros + i))));
+	}
+#endif
+
+	for (; i < nblobs; i++)
+	{
+		diam[i] = (float)diametros[i];
+		area[i] = (float)areas[i];
+		perim[i] = (float)perimetros[i];
+	}
+
+	memcpy(circ.data(), blobs->campof[VC_BLOBF_CIRCULARIDADE], nblobs * sizeof(float));
+
+	for (d = tabela->n - 1; d >= 0; d--)
+	{
+		i = 0;
+
+#ifdef VC_SSE2
+		__m128 dmin = _mm_set1_ps(tabela->diamMin[d]), dmax = _mm_set1_ps(tabela->diamMax[d]);
+		__m128 amin = _mm_set1_ps(tabela->areaMin[d]), amax = _mm_set1_ps(tabela->areaMax[d]);
+		__m128 pmin = _mm_set1_ps(tabela->perimMin[d]), pmax = _mm_set1_ps(tabela->perimMax[d]);
+		__m128 cmin = _mm_set1_ps(tabela->circMin[d]);
+		__m128i valor = _mm_set1_epi32(d);
+
+		for (; i < n; i += 4)
+		{
+			__m128 vd = _mm_loadu_ps(&diam[i]), va = _mm_loadu_ps(&area[i]);
+			__m128 vp = _mm_loadu_ps(&perim[i]), vc = _mm_loadu_ps(&circ[i]);
+
+			__m128 m = _mm_and_ps(_mm_cmpge_ps(vd, dmin), _mm_cmple_ps(vd, dmax));
+			m = _mm_and_ps(m, _mm_and_ps(_mm_cmpge_ps(va, amin), _mm_cmple_ps(va, amax)));
+			m = _mm_and_ps(m, _mm_and_ps(_mm_cmpge_ps(vp, pmin), _mm_cmple_ps(vp, pmax)));
+			m = _mm_and_ps(m, _mm_cmpgt_ps(vc, cmin));
+
+			// t = m ? d : t
+			__m128i mi = _mm_castps_si128(m);
+			__m128i vt = _mm_loadu_si128((const __m128i*)&t[i]);
+			vt = _mm_or_si128(_mm_and_si128(mi, valor), _mm_andnot_si128(mi, vt));
+			_mm_storeu_si128((__m128i*)&t[i], vt);
+		}
+#endif
+
+		for (; i < n; i++)
+		{
+			int m = (diam[i] >= tabela->diamMin[d]) & (diam[i] <= tabela->diamMax[d]) &
+				(area[i] >= tabela->areaMin[d]) & (area[i] <= tabela->areaMax[d]) &
+				(perim[i] >= tabela->perimMin[d]) & (perim[i] <= tabela->perimMax[d]) &
+				(circ[i] > tabela->circMin[d]);
+
+			t[i] = m ? d : t[i];
+		}
+	}
+
+	for (i = 0; i < nblobs; i++) tipo[i] = t[i];
+}
+
+#pragma endregion
+
+#pragma region Função: contarMoeda
+/**
+ * @brief Conta o valor da moeda detetada, atualiza a soma total e incrementa a contagem por tipo.
+ *
+ * Esta função usa o diâmetro estimado e a circularidade guardados no blob (para as anotações) e obtém da
+ * tabela de moedas o valor monetário correspondente ao tipo dado por `classificarMoedas`.
+ * Se a moeda for reconhecida, atualiza o array de contagem de moedas (`total`), acumula o valor na variável `soma`
+ * e anota visualmente a moeda (acrescenta as informações à sobreposição do frame e regista o evento, que é
+ * escrito no terminal e no ficheiro de eventos pela thread de `abrirEventos`, fora do processamento).
+ *
+ * @param sobreposicao Sobreposição do frame onde a moeda foi detetada (recebe as anotações).
+ * @param blob Estrutura OVC contendo as informações geométricas do blob detetado.
+ * @param tipo Índice da moeda na tabela de moedas (-1 se não foi reconhecida).
+ * @param nframe Número do frame em que a moeda foi medida.
+ * @param soma Ponteiro para a variável que acumula a soma total em euros.
+ * @param total Ponteiro para o array que armazena a contagem de moedas por tipo (índices 0 a 7 por tipo, índice 8 para total geral).
+ */
+void contarMoeda(SOBREPOSICAO* sobreposicao, OVC& blob, int tipo, int nframe, float* soma, int* total)
+{
+	// Diâmetro e circularidade já calculados pela cascata de avaliação (ver `avaliarBlobs`)
+	int diametro = blob.diametro;
+	float circ = blob.circularidade;
+
+	// Valor da moeda (em centavos) segundo a tabela de moedas
+	int valor = (tipo >= 0 && tipo < tabelaMoedas.n) ? tabelaMoedas.valor[tipo] : -1;
+
+	// Atualizar as contagens e soma com base no valor da moeda
+	if (valor != -1)
+	{
+		if (tabelaMoedas.indice[tipo] >= 0) total[tabelaMoedas.indice[tipo]]++;
+		*soma += (float)valor / 100.0f;
+	}
+
+	// Se a moeda foi reconhecida (valor diferente de -1)
+	if (valor != -1)
+	{
+		// Atualiza o total geral de moedas detetadas (índice 8)
+		total[8]++;
+		metricaMoeda(tipo);
+
+		// Regista as características da moeda detetada (escritas no terminal por outra thread)
+		EVENTO_MOEDA evento = { nframe, 0, valor, blob.area, blob.perimetro, diametro, circ, blob.xc, blob.yc };
+		registarMoeda(&evento);
+
+		// Acrescenta as informações da moeda à sobreposição do frame (overlay gráfico)
+		escreverInfoMoeda(sobreposicao, blob, valor, circ);
+	}
+}
+
+#pragma endregion
+
+#pragma region Função: iniciarRastreador
+/**
+ * @brief Reinicia o rastreador de moedas (sem rastos, identificadores a partir de 1).
+ *
+ * Deve ser chamada no início de cada vídeo ou gravação.
+ *
+ * @param rastreador Rastreador a reiniciar.
+ */
+void iniciarRastreador(RASTREADOR* rastreador)
+{
+	memset(rastreador, 0, sizeof(RASTREADOR));
+	rastreador->proximoId = 1;
+	rastreador->maxPerdido = 15;
+}
+
+#pragma endregion
+
+#pragma region Função: atualizarRastreador
+/**
+ * @brief Associa as moedas candidatas de um frame aos rastos existentes.
+ *
+ * Substitui a antiga `verificaRepeticao`, que só comparava o `xc` da moeda com o da última moeda
+ * contada (±8 píxeis) e falhava quando duas moedas passavam em sequência rápida.
+ *
+ * Cada rasto tem um identificador persistente e uma velocidade constante estimada (píxeis por frame),
+ * usada para prever a posição no frame `nframe`. A associação é feita pelo vizinho mais próximo,
+ * de forma gulosa (primeiro os pares mais próximos), e só dentro de uma janela de validação
+ * (gate) com raio igual ao raio da moeda mais metade do deslocamento previsto. Como a previsão usa
+ * o número de frames decorridos, a associação continua válida quando há frames saltados.
+ *
+ * - Candidatas sem rasto dentro da janela dão origem a rastos novos;
+ * - Rastos sem associação durante mais de `maxPerdido` frames são removidos;
+ * - Voltar a chamar a função com o mesmo `nframe` (blobs reutilizados) não altera a velocidade.
+ *
+ * @param rastreador Estado do rastreador.
+ * @param blobs Blobs do frame.
+ * @param nblobs Número de blobs.
+ * @param nframe Número do frame em que os blobs foram medidos.
+ * @param rasto Array (nblobs) onde é devolvido, para cada blob, o índice do rasto associado (-1 se não é candidata).
+ */
+void atualizarRastreador(RASTREADOR* rastreador, OVC* blobs, int nblobs, int nframe, int* rasto)
+{
+	int livres[MAX_RASTOS];
+	int i, j;
+
+	// Remove os rastos perdidos há demasiado tempo
+	for (i = 0, j = 0; i < rastreador->nrastos; i++)
+	{
+		if (nframe - rastreador->rastos[i].nframe <= rastreador->maxPerdido)
+		{
+			rastreador->rastos[j++] = rastreador->rastos[i];
+		}
+	}
+	rastreador->nrastos = j;
+
+	for (j = 0; j < rastreador->nrastos; j++) livres[j] = 1;
+
+	// Só as moedas candidatas (área e perímetro mínimos) são seguidas
+	for (i = 0; i < nblobs; i++)
+	{
+		rasto[i] = (blobs[i].area < AREA_MINIMA || blobs[i].perimetro < PERIMETRO_MINIMO) ? -1 : -2;
+	}
+
+	// Associação gulosa: em cada passo, o par (blob, rasto) livre mais próximo dentro da janela
+	while (true)
+	{
+		float melhor = -1.0f;
+		int bi = -1, rj = -1;
+
+		for (i = 0; i < nblobs; i++)
+		{
+			if (rasto[i] != -2) continue;
+
+			for (j = 0; j < rastreador->nrastos; j++)
+			{
+				RASTO* r = &rastreador->rastos[j];
+				int dt = nframe - r->nframe;
+				float px, py, dx, dy, d2, gate;
+
+				if (!livres[j]) continue;
+
+				// Posição prevista (velocidade constante)
+				px = r->x + r->vx * (float)dt;
+				py = r->y + r->vy * (float)dt;
+				dx = (float)blobs[i].xc - px;
+				dy = (float)blobs[i].yc - py;
+				d2 = dx * dx + dy * dy;
+
+				gate = r->raio + 0.5f * sqrtf(r->vx * r->vx + r->vy * r->vy) * (float)abs(dt);
+
+				if (d2 > gate * gate) continue;
+
+				if (melhor < 0.0f || d2 < melhor)
+				{
+					melhor = d2;
+					bi = i;
+					rj = j;
+				}
+			}
+		}
+
+		if (bi < 0) break;
+
+		// Atualiza o rasto com a nova medição
+		RASTO* r = &rastreador->rastos[rj];
+		int dt = nframe - r->nframe;
+
+		if (dt > 0)
+		{
+			float vx = ((float)blobs[bi].xc - r->x) / (float)dt;
+			float vy = ((float)blobs[bi].yc - r->y) / (float)dt;
+
+			if (r->nassociacoes == 1)
+			{
+				r->vx = vx;
+				r->vy = vy;
+			}
+			else
+			{
+				r->vx += 0.5f * (vx - r->vx);
+				r->vy += 0.5f * (vy - r->vy);
+			}
+
+			r->yanterior = r->y;
+			r->nassociacoes++;
+		}
+
+		r->x = (float)blobs[bi].xc;
+		r->y = (float)blobs[bi].yc;
+		r->raio = (float)(blobs[bi].width + blobs[bi].height) / 4.0f;
+		r->nframe = nframe;
+
+		livres[rj] = 0;
+		rasto[bi] = rj;
+	}
+
+	// Candidatas sem rasto: novos rastos
+	for (i = 0; i < nblobs; i++)
+	{
+		RASTO* r;
+
+		if (rasto[i] != -2) continue;
+
+		if (rastreador->nrastos < MAX_RASTOS)
+		{
+			j = rastreador->nrastos++;
+		}
+		else
+		{
+			// Sem espaço: substitui o rasto livre há mais tempo sem associação
+			j = -1;
+			for (int k = 0; k < rastreador->nrastos; k++)
+			{
+				if (livres[k] && (j < 0 || rastreador->rastos[k].nframe < rastreador->rastos[j].nframe)) j = k;
+			}
+			if (j < 0)
+			{
+				rasto[i] = -1;
+				continue;
+			}
+		}
+
+		r = &rastreador->rastos[j];
+		memset(r, 0, sizeof(RASTO));
+		r->id = rastreador->proximoId++;
+		r->x = (float)blobs[i].xc;
+		r->y = (float)blobs[i].yc;
+		r->yanterior = r->y;
+		r->raio = (float)(blobs[i].width + blobs[i].height) / 4.0f;
+		r->nframe = nframe;
+		r->nassociacoes = 1;
+
+		livres[j] = 0;
+		rasto[i] = j;
+	}
+}
+
+#pragma endregion
+
+#pragma region Função: calcular_circularidade
+/**
+ * @brief Calcula a circularidade de um blob com base na fórmula padrão.
+ *
+ * A circularidade é uma medida adimensional que indica o quão próximo de um círculo perfeito é um objeto.
+ * A fórmula utilizada é: \f$ Circularidade = \frac{4 \times \pi \times Área}{Perímetro^2} \f$
+ * - Um círculo perfeito tem circularidade = 1.
+ * - Objetos mais alongados ou com contornos irregulares terão circularidade inferior a 1.
+ *
+ * Usa o perímetro com correção de cantos (`perimetroCorrigido`), quando calculado: a contagem de píxeis
+ * de contorno subestima o perímetro de um círculo (circularidade acima de 1).
+ *
+ * @note Caso o blob seja nulo ou o perímetro seja 0 (evitando divisão por zero), a função retorna 0.
+ *
+ * @param blob Ponteiro para a estrutura `OVC` contendo as informações do blob (área e perímetro).
+ *
+ * @return A circularidade calculada como float. Retorna 0.0f em caso de erro.
+ */
+float calcular_circularidade(OVC* blob)
+{
+	// Verificação de segurança: blob nulo ou perímetro zero retorna circularidade 0 (evita divisão por zero)
+	if (blob == NULL || blob->perimetro == 0)
+		return 0.0f;
+
+	// Definição de PI com precisão de float
+	const float PI = 3.14159265358979323846f;
+
+	// Perímetro com correção de cantos, se disponível
+	float perimetro = (blob->perimetroCorrigido > 0.0f) ? blob->perimetroCorrigido : (float)blob->perimetro;
+
+	// Cálculo da circularidade: (4 * PI * área) / (perímetro²)
+	return (4.0f * PI * (float)blob->area) / (perimetro * perimetro);
+}
+
+#pragma endregion
+
+#pragma region Função: escreverInfoMoeda
+/**
+ * @brief Escreve informações detalhadas sobre a moeda na sobreposição do frame.
+ *
+ * Esta função acrescenta à sobreposição do frame (desenhada por `aplicarSobreposicao`) as informações:
+ * - Valor da moeda (em euros ou cêntimos);
+ * - Área do blob (número de píxeis);
+ * - Circularidade calculada.
+ *
+ * As informações são escritas à direita da bounding box da moeda, usando a fonte simples do OpenCV.
+ *
+ * @param sobreposicao Sobreposição do frame onde será desenhada a informação.
+ * @param blob Estrutura `OVC` com as informações geométricas da moeda.
+ * @param valor Valor da moeda detetada (em centavos).
+ * @param circ Circularidade calculada da moeda.
+ */
+void escreverInfoMoeda(SOBREPOSICAO* sobreposicao, OVC& blob, int valor, float circ)
+{
+	char texto[100];                                // Buffer para as mensagens de texto
+	cv::Scalar corTexto(255, 0, 0);                 // Cor do texto (Azul em BGR)
+	float fontScale = 0.4f;                         // Escala da fonte
+
+	// Posição inicial do texto (à direita da bounding box da moeda)
+	int xText = blob.x + blob.width + 5;
+	int yText = blob.y;
+
+	// Primeira linha: Valor da moeda
+	if (valor >= 100)
+		sprintf(texto, "%d euro", valor / 100);     // Exibe em euros (ex.: 2 euro)
+	else if (valor > 0)
+		sprintf(texto, "%d cent", valor);           // Exibe em cêntimos (ex.: 50 cent)
+	else
+		sprintf(texto, "valor: 0");                 // Valor não reconhecido
+
+	adicionarTexto(sobreposicao, texto, xText, yText, fontScale, corTexto);
+
+	// Segunda linha: Área do blob (em píxeis)
+	sprintf(texto, "Area: %d", blob.area);
+	adicionarTexto(sobreposicao, texto, xText, yText + 15, fontScale, corTexto);
+
+	// Terceira linha: Circularidade calculada
+	sprintf(texto, "Circ: %.2f", circ);
+	adicionarTexto(sobreposicao, texto, xText, yText + 30, fontScale, corTexto);
+}
+
+
+#pragma endregion
+
+#pragma region Função: somarImagens
+/**
+ * @brief Realiza a operação lógica OR entre duas imagens binárias e armazena o resultado numa terceira imagem.
+ *
+ * Esta função percorre duas imagens binárias (`src1` e `src2`) de mesmo tamanho e combina-as
+ * aplicando uma operação de soma lógica (OR pixel a pixel). Se qualquer um dos píxeis for 255 (branco),
+ * o resultado será 255; caso contrário, será 0. Cada linha é processada pelo kernel do nível SIMD
+ * em uso (ver `vc_simd_nivel`).
+ *
+ * @note Todas as imagens devem ter 1 canal (binárias) e as mesmas dimensões.
+ *
+ * @param src1 Ponteiro para a primeira imagem binária de entrada.
+ * @param src2 Ponteiro para a segunda imagem binária de entrada.
+ * @param dst Ponteiro para a imagem de saída onde será armazenado o resultado da soma.
+ *
+ * @return Retorna 1 se a operação for bem-sucedida; caso contrário, retorna 0 (erro de parâmetros ou incompatibilidade).
+ */
+int somarImagens(IVC* src1, IVC* src2, IVC* dst)
+{
+	// Verificação de ponteiros válidos
+	if (!src1 || !src2 || !dst)
+		return 0;
+
+	// Verificação se as dimensões das imagens de entrada coincidem
+	if (src1->width != src2->width || src1->height != src2->height)
+		return 0;
+
+	// Verificação se todas as imagens têm apenas 1 canal (binário)
+	if (src1->channels != 1 || src2->channels != 1 || dst->channels != 1)
+		return 0;
+
+	const VC_SIMD_KERNELS* simd = vc_simd();
+
+	// Soma lógica de cada linha: se qualquer um dos píxeis for 255, o resultado será 255; caso contrário, 0
+	for (int y = 0; y < src1->height; y++)
+	{
+		long int pos = (long int)y * src1->bytesperline;
+
+		simd->ou(src1->data + pos, src2->data + pos, dst->data + pos, src1->width);
+	}
+
+	// Retorna 1 indicando sucesso
+	return 1;
+}
+#pragma endregion
+
+#pragma region Função: iniciarSobreposicao
+/**
+ * @brief Esvazia a sobreposição (início de um novo frame).
+ *
+ * @param sobreposicao Sobreposição a reiniciar.
+ */
+void iniciarSobreposicao(SOBREPOSICAO* sobreposicao)
+{
+	sobreposicao->n = 0;
+}
+
+#pragma endregion
+
+#pragma region Função: adicionarPrimitiva
+/**
+ * @brief Acrescenta uma primitiva à sobreposição do frame.
+ *
+ * A primitiva só é desenhada em `aplicarSobreposicao`. Se a sobreposição estiver cheia, a primitiva
+ * é descartada (e contada em `ndescartadas`).
+ *
+ * @param sobreposicao Sobreposição do frame.
+ * @param tipo Tipo da primitiva (`PRIMITIVA_CAIXA`, `PRIMITIVA_CRUZ`, `PRIMITIVA_LINHA` ou `PRIMITIVA_TEXTO`).
+ * @param x Posição X (ver `PRIMITIVA_*`).
+ * @param y Posição Y (ver `PRIMITIVA_*`).
+ * @param width Largura, comprimento ou braço (ver `PRIMITIVA_*`).
+ * @param height Altura (caixa).
+ * @param cor Cor em BGR (ordem do `cv::Scalar` do OpenCV).
+ *
+ * @return Ponteiro para a primitiva acrescentada, ou NULL se foi descartada.
+ */
+PRIMITIVA* adicionarPrimitiva(SOBREPOSICAO* sobreposicao, int tipo, int x, int y, int width, int height, cv::Scalar cor)
+{
+	if (sobreposicao->n >= MAX_PRIMITIVAS)
+	{
+		sobreposicao->ndescartadas++;
+		return NULL;
+	}
+
+	PRIMITIVA* p = &sobreposicao->primitivas[sobreposicao->n++];
+
+	p->tipo = tipo;
+	p->x = x;
+	p->y = y;
+	p->width = width;
+	p->height = height;
+	p->cor[0] = (unsigned char)cor[0];
+	p->cor[1] = (unsigned char)cor[1];
+	p->cor[2] = (unsigned char)cor[2];
+	memcpy(p->corHorizontal, p->cor, sizeof(p->cor));
+	p->escala = 0.0f;
+	p->texto[0] = '\0';
+
+	return p;
+}
+
+#pragma endregion
+
+#pragma region Função: adicionarTexto
+/**
+ * @brief Acrescenta um texto à sobreposição do frame (fonte `cv::FONT_HERSHEY_SIMPLEX`).
+ *
+ * @param sobreposicao Sobreposição do frame.
+ * @param texto Texto a escrever (truncado ao tamanho de `PRIMITIVA::texto`).
+ * @param x Posição X da origem do texto (canto inferior esquerdo).
+ * @param y Posição Y da origem do texto.
+ * @param escala Escala da fonte.
+ * @param cor Cor em BGR.
+ */
+void adicionarTexto(SOBREPOSICAO* sobreposicao, const char* texto, int x, int y, float escala, cv::Scalar cor)
+{
+	PRIMITIVA* p = adicionarPrimitiva(sobreposicao, PRIMITIVA_TEXTO, x, y, 0, 0, cor);
+
+	if (p == NULL) return;
+
+	p->escala = escala;
+	snprintf(p->texto, sizeof(p->texto), "%s", texto);
+}
+
+#pragma endregion
+
+#pragma region Função: aplicarSobreposicao
+// Desenha um segmento horizontal (x0..x1, inclusivo) recortado aos limites da imagem
+static void sobreposicaoHorizontal(cv::Mat& frame, int x0, int x1, int y, const unsigned char* cor)
+{
+	int channels = frame.channels();
+
+	if (y < 0 || y >= frame.rows) return;
+	x0 = MAX(x0, 0);
+	x1 = MIN(x1, frame.cols - 1);
+
+	unsigned char* pos = frame.ptr(y) + x0 * channels;
+
+	if (channels == 1)
+	{
+		// Imagem em níveis de cinzento: luminância da cor
+		unsigned char cinzento = (unsigned char)((cor[0] * 29 + cor[1] * 150 + cor[2] * 77) >> 8);
+		for (int x = x0; x <= x1; x++, pos++) *pos = cinzento;
+	}
+	else
+	{
+		// BGR ou BGRA (o canal alfa não é alterado)
+		for (int x = x0; x <= x1; x++, pos += channels)
+		{
+			pos[0] = cor[0];
+			pos[1] = cor[1];
+			pos[2] = cor[2];
+		}
+	}
+}
+
+// Desenha um segmento vertical (y0..y1, inclusivo) recortado aos limites da imagem
+static void sobreposicaoVertical(cv::Mat& frame, int x, int y0, int y1, const unsigned char* cor)
+{
+	int channels = frame.channels();
+	size_t step = frame.step;
+
+	if (x < 0 || x >= frame.cols) return;
+	y0 = MAX(y0, 0);
+	y1 = MIN(y1, frame.rows - 1);
+	if (y0 > y1) return;
+
+	unsigned char* pos = frame.ptr(y0) + x * channels;
+
+	if (channels == 1)
+	{
+		unsigned char cinzento = (unsigned char)((cor[0] * 29 + cor[1] * 150 + cor[2] * 77) >> 8);
+		for (int y = y0; y <= y1; y++, pos += step) *pos = cinzento;
+	}
+	else
+	{
+		for (int y = y0; y <= y1; y++, pos += step)
+		{
+			pos[0] = cor[0];
+			pos[1] = cor[1];
+			pos[2] = cor[2];
+		}
+	}
+}
+
+/**
+ * @brief Desenha no frame todas as primitivas acumuladas na sobreposição, pela ordem em que foram acrescentadas.
+ *
+ * Caixas, cruzes e linhas são desenhadas segmento a segmento, escrevendo apenas os píxeis da borda
+ * (o custo depende do perímetro das caixas e não da sua área). Os textos são desenhados com `cv::putText`
+ * e o aviso de moeda detetada é copiado da camada do HUD (ver `construirAvisoHud`).
+ *
+ * @note Aceita imagens de 8 bits com 1 canal (cor convertida em luminância), 3 canais (BGR) ou 4 canais (BGRA).
+ *
+ * @param frame Imagem onde são desenhadas as primitivas.
+ * @param sobreposicao Sobreposição do frame (é esvaziada no fim).
+ *
+ * @return Número de primitivas desenhadas; 0 se a imagem não for suportada.
+ */
+int aplicarSobreposicao(cv::Mat& frame, SOBREPOSICAO* sobreposicao)
+{
+	int n = sobreposicao->n;
+
+	sobreposicao->n = 0;
+
+	// Verificação de erros
+	if (frame.empty() || frame.depth() != CV_8U) return 0;
+	if (frame.channels() != 1 && frame.channels() != 3 && frame.channels() != 4) return 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		PRIMITIVA* p = &sobreposicao->primitivas[i];
+
+		switch (p->tipo)
+		{
+		case PRIMITIVA_CAIXA:
+			// Bordas de cima e de baixo, bordas da esquerda e da direita
+			sobreposicaoHorizontal(frame, p->x, p->x + p->width, p->y, p->cor);
+			sobreposicaoHorizontal(frame, p->x, p->x + p->width, p->y + p->height, p->cor);
+			sobreposicaoVertical(frame, p->x, p->y + 1, p->y + p->height - 1, p->cor);
+			sobreposicaoVertical(frame, p->x + p->width, p->y + 1, p->y + p->height - 1, p->cor);
+			break;
+		case PRIMITIVA_CRUZ:
+			sobreposicaoVertical(frame, p->x, p->y - p->width, p->y + p->width, p->cor);
+			sobreposicaoHorizontal(frame, p->x - p->width, p->x + p->width, p->y, p->corHorizontal);
+			break;
+		case PRIMITIVA_LINHA:
+			sobreposicaoHorizontal(frame, p->x, p->x + p->width - 1, p->y, p->cor);
+			break;
+		case PRIMITIVA_TEXTO:
+			cv::putText(frame, p->texto, cv::Point(p->x, p->y), cv::FONT_HERSHEY_SIMPLEX, p->escala,
+				cv::Scalar(p->cor[0], p->cor[1], p->cor[2]));
+			break;
+		case PRIMITIVA_AVISO:
+			// Camada estática do HUD (desenhada só na primeira vez ou se a resolução mudar)
+			construirAvisoHud(&hud.aviso, frame, p->y);
+			desenharCamadaHud(frame, &hud.aviso);
+			break;
+		}
+	}
+
+	return n;
+}
+
+#pragma endregion
+
+#pragma region Função: desenhaBox
+/**
+ * @brief Desenha uma caixa delimitadora (bounding box) em torno da moeda e uma cruz no seu centro de massa.
+ *
+ * Esta função acrescenta à sobreposição do frame a bounding box (em verde) ao redor do blob (moeda)
+ * e uma cruz no centro de massa (em vermelho). O desenho é feito por `aplicarSobreposicao`.
+ * Antes de desenhar, verifica se a moeda cumpre os critérios mínimos de área, perímetro, circularidade e diâmetro.
+ *
+ * @param sobreposicao Sobreposição do frame onde será desenhada a caixa e a cruz.
+ * @param blob Estrutura `OVC` contendo as informações geométricas da moeda (bounding box, centro, etc.).
+ *
+ * @return Retorna 1 se a caixa e cruz foram acrescentadas com sucesso; 0 caso contrário (blob não cumpre critérios mínimos).
+ */
+int desenhaBox(SOBREPOSICAO* sobreposicao, OVC& blob)
+{
+	// Verificação rápida para rejeitar blobs que não cumprem os requisitos mínimos de moeda
+	// (circularidade e diâmetro já calculados pela cascata de avaliação, ver `avaliarBlobs`)
+	if (blob.area <= AREA_MINIMA || blob.perimetro < PERIMETRO_MINIMO || blob.circularidade <= CIRCULARIDADE_CAIXA || blob.diametro < DIAMETRO_MINIMO)
+		return 0;
+
+	// Bounding box verde
+	adicionarPrimitiva(sobreposicao, PRIMITIVA_CAIXA, blob.x, blob.y, blob.width, blob.height, cv::Scalar(0, 255, 0));
+
+	// Cruz vermelha no centro de massa (braços de 10 píxeis; o braço horizontal tem o verde a 8)
+	PRIMITIVA* cruz = adicionarPrimitiva(sobreposicao, PRIMITIVA_CRUZ, blob.xc, blob.yc, 10, 10, cv::Scalar(0, 0, 255));
+	if (cruz != NULL) cruz->corHorizontal[1] = 8;
+
+	// Retorna 1 indicando que foi desenhado com sucesso
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: escreveMoedaDetetada
+/**
+ * @brief Escreve uma mensagem visual na imagem indicando que uma moeda foi detetada.
+ *
+ * Esta função acrescenta à sobreposição do frame o aviso de moeda detetada (ver `construirAvisoHud`):
+ * - Duas linhas de texto informativas (em vermelho) com a mensagem "MOEDA DETETADA !!".
+ * - Uma linha horizontal de separação em vermelho (linha de reconhecimento visual).
+ *
+ * A mensagem é desenhada numa área fixa horizontal, em torno da linha de reconhecimento.
+ *
+ * @param sobreposicao Sobreposição do frame onde será desenhada a mensagem.
+ * @param linha Posição Y da linha de reconhecimento (1/4 da altura do frame).
+ * @param largura Largura do frame.
+ */
+void escreveMoedaDetetada(SOBREPOSICAO* sobreposicao, int linha, int largura)
+{
+	// Textos e linha vermelha vêm já desenhados da camada do HUD
+	adicionarPrimitiva(sobreposicao, PRIMITIVA_AVISO, 0, linha, largura, 1, cv::Scalar(0, 0, 255));
+}
+
+#pragma endregion
+
+#pragma region Função: linhaReconhecimento
+/**
+ * @brief Desenha uma linha horizontal de reconhecimento na imagem.
+ *
+ * Esta linha serve como referência visual no vídeo, permitindo ao utilizador identificar
+ * a zona onde as moedas devem cruzar para serem consideradas válidas (por exemplo, para evitar contagens duplicadas).
+ * A linha é acrescentada à sobreposição do frame e ocupa toda a largura do frame.
+ *
+ * @param sobreposicao Sobreposição do frame onde a linha será desenhada.
+ * @param linha Posição Y da linha (1/4 da altura do frame).
+ * @param largura Largura do frame.
+ */
+void linhaReconhecimento(SOBREPOSICAO* sobreposicao, int linha, int largura)
+{
+	// Linha preta (BGR) ao longo de toda a largura
+	adicionarPrimitiva(sobreposicao, PRIMITIVA_LINHA, 0, linha, largura, 1, cv::Scalar(0, 0, 0));
+}
+
+#pragma endregion
+
+#pragma region Função: vc_timer
+/**
+ * @brief Função de temporização simples que mede e exibe o tempo decorrido entre duas chamadas consecutivas.
+ *
+ * Esta função utiliza `std::chrono` para calcular o tempo decorrido em segundos desde a primeira chamada.
+ * Na primeira execução, apenas ativa o modo de contagem (inicializa o `previousTime`).
+ * Na segunda chamada (ou seguintes), calcula o tempo decorrido e exibe no terminal.
+ *
+ * @note Após mostrar o tempo decorrido, aguarda uma tecla do utilizador (`std::cin.get()`) antes de prosseguir.
+ *
+ * @warning Esta função utiliza variáveis estáticas locais, o que significa que o temporizador mantém o estado entre chamadas.
+ */
+void vc_timer(void)
+{
+	// Variável estática que controla se a função já foi chamada anteriormente
+	static bool running = false;
+
+	// Variável estática que armazena o momento da primeira chamada
+	static std::chrono::steady_clock::time_point previousTime = std::chrono::steady_clock::now();
+
+	// Primeira chamada: apenas ativa o modo de contagem e não faz mais nada
+	if (!running)
+	{
+		running = true;
+	}
+	// Segunda chamada (ou seguintes): calcula e exibe o tempo decorrido
+	else
+	{
+		// Captura o tempo atual
+		std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+
+		// Calcula a duração entre o tempo atual e o tempo anterior
+		std::chrono::steady_clock::duration elapsedTime = currentTime - previousTime;
+
+		// Converte a duração para segundos em formato double
+		std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>>(elapsedTime);
+		double nseconds = time_span.count();
+
+		// Exibe o tempo decorrido no terminal
+		std::cout << "Tempo decorrido: " << nseconds << " segundos" << std::endl;
+
+		// Aguarda o utilizador pressionar Enter
+		std::cin.get();
+	}
+}
+
+#pragma endregion
+
+#pragma region Função: construirCamadaHud
+// Escreve um texto no sprite (com a sua cor) e na máscara da camada
+static void textoHud(cv::Mat& sprite, cv::Mat& mascara, const char* texto, cv::Point posicao, double escala, cv::Scalar cor)
+{
+	cv::putText(sprite, texto, posicao, cv::FONT_HERSHEY_SIMPLEX, escala, cor);
+	cv::putText(mascara, texto, posicao, cv::FONT_HERSHEY_SIMPLEX, escala, cv::Scalar(255));
+}
+
+// Verifica se a camada já foi desenhada para este frame e estes parâmetros; se não, prepara o sprite e a máscara
+static int iniciarCamadaHud(CAMADA_HUD* camada, cv::Mat& frame, int a, int b, int c, cv::Mat& mascara)
+{
+	if (camada->width == frame.cols && camada->height == frame.rows && camada->type == frame.type() &&
+		camada->chave[0] == a && camada->chave[1] == b && camada->chave[2] == c)
+		return 0;
+
+	camada->width = frame.cols;
+	camada->height = frame.rows;
+	camada->type = frame.type();
+	camada->chave[0] = a;
+	camada->chave[1] = b;
+	camada->chave[2] = c;
+	camada->sprite = cv::Mat(frame.rows, frame.cols, frame.type(), cv::Scalar(0, 0, 0, 0));
+	mascara = cv::Mat(frame.rows, frame.cols, CV_8UC1, cv::Scalar(0));
+
+	hud.ndesenhadas++;
+
+	return 1;
+}
+
+// Converte a máscara da camada em segmentos horizontais de píxeis com conteúdo
+static void terminarCamadaHud(CAMADA_HUD* camada, cv::Mat& mascara)
+{
+	camada->segmentos.clear();
+
+	for (int y = 0; y < mascara.rows; y++)
+	{
+		const unsigned char* linha = mascara.ptr(y);
+
+		for (int x = 0; x < mascara.cols; x++)
+		{
+			if (linha[x] == 0) continue;
+
+			SEGMENTO_HUD segmento;
+			segmento.y = y;
+			segmento.x0 = x;
+			while (x + 1 < mascara.cols && linha[x + 1] != 0) x++;
+			segmento.x1 = x;
+
+			camada->segmentos.push_back(segmento);
+		}
+	}
+}
+
+/**
+ * @brief Desenha a camada estática de `resumoFrame` (rótulos, identificação e instruções).
+ *
+ * A camada só é desenhada quando muda a resolução ou o tipo do frame, ou os dados fixos do vídeo;
+ * nos restantes frames é apenas copiada (ver `desenharCamadaHud`).
+ *
+ * @param camada Camada do HUD (normalmente `hud.resumo`).
+ * @param frame Frame de referência (resolução e tipo).
+ * @param width Largura do vídeo.
+ * @param height Altura do vídeo.
+ * @param totalFrames Número total de frames do vídeo.
+ * @param fps Taxa de frames por segundo.
+ *
+ * @return 1 se a camada foi desenhada; 0 se já estava em cache.
+ */
+int construirResumoHud(CAMADA_HUD* camada, cv::Mat& frame, int width, int height, int totalFrames, int fps)
+{
+	cv::Mat mascara;
+	char buffer[200];
+	int yStart = 230;   // Posição vertical inicial para o resumo das moedas
+	int yStep = 20;     // Espaçamento vertical entre linhas
+
+	// A resolução (width x height) é escrita e faz parte da chave
+	if (!iniciarCamadaHud(camada, frame, width * 65536 + height, totalFrames, fps, mascara))
+		return 0;
+
+	cv::Mat& sprite = camada->sprite;
+
+	// Cores para textos
+	cv::Scalar corFonte(0, 0, 0);       // Preto
+	cv::Scalar corFonte2(100, 0, 0);    // Vermelho escuro
+
+	// Informações fixas do vídeo
+	sprintf(buffer, "RESOLUCAO: %dx%d", width, height);
+	textoHud(sprite, mascara, buffer, cv::Point(yStep, 25), 0.7, corFonte);
+	sprintf(buffer, "TOTAL DE FRAMES: %d", totalFrames);
+	textoHud(sprite, mascara, buffer, cv::Point(yStep, 50), 0.7, corFonte);
+	sprintf(buffer, "FRAME RATE: %d", fps);
+	textoHud(sprite, mascara, buffer, cv::Point(yStep, 75), 0.7, corFonte);
+	textoHud(sprite, mascara, "N. FRAME: ", cv::Point(yStep, 100), 0.7, corFonte);
+
+	// Rótulos das contagens (os valores são escritos em cada frame)
+	textoHud(sprite, mascara, "Total de moedas:", cv::Point(20, yStart), 0.5, cv::Scalar(255, 0, 0));
+
+	const char* nomes[] = {
+		"Moedas 2 Eur: ", "Moedas 1 Eur: ", "Moedas 0,50 Eur: ", "Moedas 0,20 Eur: ",
+		"Moedas 0,10 Eur: ", "Moedas 0,05 Eur: ", "Moedas 0,02 Eur: ", "Moedas 0,01 Eur: "
+	};
+
+	for (int i = 0; i < 8; i++)
+	{
+		textoHud(sprite, mascara, nomes[i], cv::Point(20, yStart + (i + 1) * yStep), 0.5, corFonte2);
+	}
+
+	textoHud(sprite, mascara, "Soma:", cv::Point(20, yStart + 9 * yStep), 0.5, cv::Scalar(255, 0, 0));
+
+	// Identificação institucional
+	textoHud(sprite, mascara, "IPCA", cv::Point(yStep, yStart + 13 * yStep), 0.6, cv::Scalar(0, 120, 0));
+	textoHud(sprite, mascara, "Escola Superior de Tecnologia", cv::Point(yStep, yStart + 14 * yStep), 0.4, cv::Scalar(150, 0, 0));
+	textoHud(sprite, mascara, "Engenharia de Sistemas Informaticos PL", cv::Point(yStep, yStart + 15 * yStep), 0.4, corFonte2);
+	textoHud(sprite, mascara, "2024/2025", cv::Point(yStep, yStart + 16 * yStep), 0.4, corFonte2);
+	textoHud(sprite, mascara, "Visao por Computador", cv::Point(yStep, yStart + 17 * yStep), 0.4, corFonte2);
+	textoHud(sprite, mascara, "Professor: Simao Valente", cv::Point(yStep, yStart + 18 * yStep), 0.4, corFonte2);
+
+	// Lista dos alunos
+	textoHud(sprite, mascara, "Alunos:", cv::Point(yStep, yStart + 19 * yStep), 0.4, corFonte2);
+	textoHud(sprite, mascara, "    Fernando Salgueiro n. 39", cv::Point(yStep, yStart + 20 * yStep), 0.4, corFonte2);
+	textoHud(sprite, mascara, "    Hugo Lopes n. 30516", cv::Point(yStep, yStart + 21 * yStep), 0.4, corFonte2);
+	textoHud(sprite, mascara, "    Claudio Fernandes n. 30517", cv::Point(yStep, yStart + 22 * yStep), 0.4, corFonte2);
+	textoHud(sprite, mascara, "    Nuno Cruz n. 30518", cv::Point(yStep, yStart + 23 * yStep), 0.4, corFonte2);
+
+	// Mensagem de instrução
+	textoHud(sprite, mascara, "Prima ESC para sair", cv::Point(1100, yStart + 23 * yStep), 0.4, corFonte);
+
+	terminarCamadaHud(camada, mascara);
+
+	return 1;
+}
+
+/**
+ * @brief Desenha a camada do aviso de moeda detetada (dois textos e a linha de reconhecimento vermelha).
+ *
+ * @param camada Camada do HUD (normalmente `hud.aviso`).
+ * @param frame Frame de referência (resolução e tipo).
+ * @param linha Posição Y da linha de reconhecimento.
+ *
+ * @return 1 se a camada foi desenhada; 0 se já estava em cache.
+ */
+int construirAvisoHud(CAMADA_HUD* camada, cv::Mat& frame, int linha)
+{
+	cv::Mat mascara;
+
+	if (!iniciarCamadaHud(camada, frame, linha, 0, 0, mascara))
+		return 0;
+
+	// Mensagem de aviso, um pouco acima e abaixo da linha de reconhecimento
+	const char* texto = "    !!MOEDA DETETADA !!                                                                                                              !! MOEDA DETETADA !!     ";
+	cv::Scalar cor(0, 0, 255);                   // Cor vermelha (BGR)
+
+	textoHud(camada->sprite, mascara, texto, cv::Point(20, linha - 10), 0.5, cor);
+	textoHud(camada->sprite, mascara, texto, cv::Point(20, linha + 15), 0.5, cor);
+
+	// Linha de reconhecimento vermelha ao longo de toda a largura
+	if (linha >= 0 && linha < frame.rows)
+	{
+		camada->sprite.row(linha).setTo(cor);
+		mascara.row(linha).setTo(cv::Scalar(255));
+	}
+
+	terminarCamadaHud(camada, mascara);
+
+	return 1;
+}
+
+/**
+ * @brief Copia para o frame os píxeis com conteúdo de uma camada do HUD.
+ *
+ * Só são copiados os segmentos da máscara da camada, pelo que o custo depende da quantidade de texto
+ * e não da área do frame.
+ *
+ * @note A camada tem de ter sido construída para a resolução e tipo deste frame.
+ *
+ * @param frame Frame onde a camada é desenhada.
+ * @param camada Camada do HUD.
+ */
+void desenharCamadaHud(cv::Mat& frame, CAMADA_HUD* camada)
+{
+	if (camada->width != frame.cols || camada->height != frame.rows || camada->type != frame.type())
+		return;
+
+	size_t elemSize = frame.elemSize();
+
+	for (size_t i = 0; i < camada->segmentos.size(); i++)
+	{
+		const SEGMENTO_HUD& segmento = camada->segmentos[i];
+
+		memcpy(frame.ptr(segmento.y) + segmento.x0 * elemSize,
+			camada->sprite.ptr(segmento.y) + segmento.x0 * elemSize,
+			(segmento.x1 - segmento.x0 + 1) * elemSize);
+	}
+}
+
+#pragma endregion
+
+#pragma region Função: resumoFrame
+/**
+ * @brief Desenha no frame um resumo visual do processamento de moedas.
+ *
+ * Exibe no vídeo as estatísticas do processamento atual:
+ * - Resolução do vídeo;
+ * - Total de frames e taxa de frames por segundo (FPS);
+ * - Número do frame atual;
+ * - Total de moedas detetadas (geral e por tipo);
+ * - Soma total das moedas;
+ * - Identificação da instituição, curso, disciplina, professor e alunos;
+ * - Mensagem de instrução ("Prima ESC para sair").
+ *
+ * Os textos fixos vêm da camada `hud.resumo` (ver `construirResumoHud`); em cada frame só são escritos
+ * os valores (número do frame, contagens e soma).
+ *
+ * @note O frame não é mostrado aqui; ver `mostrarEcra`.
+ *
+ * @param frame Imagem (`cv::Mat`) onde será desenhado o resumo.
+ * @param total Ponteiro para o array com as contagens por tipo de moeda (total[8] contém o total geral).
+ * @param soma Soma total calculada das moedas em euros.
+ * @param width Largura do frame.
+ * @param height Altura do frame.
+ * @param totalFrames Número total de frames do vídeo.
+ * @param fps Taxa de frames por segundo.
+ * @param nframe Número do frame atual.
+ */
+void resumoFrame(cv::Mat& frame, int* total, float soma, int width, int height, int totalFrames, int fps, int nframe)
+{
+	char buffer[200];
+	int yStart = 230;   // Posição vertical inicial para o resumo das moedas
+	int yStep = 20;     // Espaçamento vertical entre linhas
+	int baseline;
+
+	// Configurações da fonte
+	int fontFace = cv::FONT_HERSHEY_SIMPLEX;
+	double fontScale = 0.5;
+	double fontScale2 = 0.7;
+
+	// Textos fixos (desenhados só no primeiro frame ou quando a resolução muda)
+	construirResumoHud(&hud.resumo, frame, width, height, totalFrames, fps);
+	desenharCamadaHud(frame, &hud.resumo);
+
+	// Número do frame atual, à frente do rótulo
+	int x = yStep + cv::getTextSize("N. FRAME: ", fontFace, fontScale2, 1, &baseline).width;
+	sprintf(buffer, "%d", nframe);
+	cv::putText(frame, buffer, cv::Point(x, 100), fontFace, fontScale2, cv::Scalar(0, 0, 0));
+
+	// Total geral de moedas
+	sprintf(buffer, "%d", total[8]);
+	cv::putText(frame, buffer, cv::Point(165, yStart), fontFace, fontScale, cv::Scalar(0, 0, 255));
+
+	// Contagem por tipo de moeda (em ordem de valor decrescente)
+	const char* nomes[] = {
+		"Moedas 2 Eur: ", "Moedas 1 Eur: ", "Moedas 0,50 Eur: ", "Moedas 0,20 Eur: ",
+		"Moedas 0,10 Eur: ", "Moedas 0,05 Eur: ", "Moedas 0,02 Eur: ", "Moedas 0,01 Eur: "
+	};
+
+	for (int i = 0; i < 8; i++)
+	{
+		int idx = 7 - i; // Ordem inversa (do maior valor para o menor)
+		x = 20 + cv::getTextSize(nomes[i], fontFace, fontScale, 1, &baseline).width;
+		sprintf(buffer, "%d", total[idx]);
+		cv::putText(frame, buffer, cv::Point(x, yStart + (i + 1) * yStep), fontFace, fontScale, cv::Scalar(100, 0, 0));
+	}
+
+	// Soma total em euros
+	sprintf(buffer, "%.2f Euros", soma);
+	cv::putText(frame, buffer, cv::Point(70, yStart + 9 * yStep), fontFace, fontScale, cv::Scalar(0, 0, 255));
+}
+
+#pragma endregion
+
+#pragma region Função: resumoTerminal
+/**
+ * @brief Exibe no terminal um resumo final da contagem de moedas e do valor total.
+ *
+ * Esta função apresenta no terminal:
+ * - Total geral de moedas detetadas;
+ * - Contagem por tipo de moeda (de 1 cêntimo até 2 euros);
+ * - Valor total em euros;
+ * - Informação adicional sobre como consultar características de cada moeda;
+ * - Identificação da instituição, disciplina, professor e alunos.
+ *
+ * @param total Ponteiro para o array com as contagens por tipo de moeda (total[8] contém o total geral).
+ * @param soma Valor total acumulado em euros.
+ */
+void resumoTerminal(int* total, float soma)
+{
+	// Cabeçalho do resumo
+	printf("\n\t\t\t\t\t\t\t*********** Resumo final ***************\n");
+	printf("\t\t\t\t\t\t\t---------------------------------------\n\n");
+
+	// Total geral de moedas
+	printf("\t\t\t\t\t\t\t\tTotal de moedas: %d \n\n", total[8]);
+
+	// Cabeçalho da tabela
+	printf("\t\t\t\t\t\t\t\tvalor\t\t\tQuant.\n");
+
+	// Contagem por tipo de moeda (em ordem crescente de valor)
+	printf("\t\t\t\t\t\t\t\tt1\tcêntimo:\t%d \n", total[0]);
+	printf("\t\t\t\t\t\t\t\t2\tcêntimos:\t%d \n", total[1]);
+	printf("\t\t\t\t\t\t\t\t5\tcêntimos:\t%d \n", total[2]);
+	printf("\t\t\t\t\t\t\t\t10\tcêntimos:\t%d \n", total[3]);
+	printf("\t\t\t\t\t\t\t\t20\tcêntimos:\t%d \n", total[4]);
+	printf("\t\t\t\t\t\t\t\t50\tcêntimos:\t%d \n", total[5]);
+	printf("\t\t\t\t\t\t\t\t1\teuro:\t\t%d \n", total[6]);
+	printf("\t\t\t\t\t\t\t\t2\teuros:\t\t%d \n", total[7]);
+
+	printf("\t\t\t\t\t\t\t---------------------------------------\n");
+
+	// Valor total calculado em euros
+	printf("\t\t\t\t\t\t\t\tValor total: %.2f euros \n", soma);
+
+	printf("\n\t\t\t\t\t\t\t***************************************\n\n");
+
+	// Nota adicional explicativa
+	printf("\t\tNota: pode consultar acima as informações sobre cada moeda (Área(A), Perímetro(P), Circularidade(C), Diâmetro(Ø), Centro(x,y))\n");
+	printf("\t_________________________________________________________________________________________________________________________________________\n\n");
+
+	// Informações institucionais e de identificação
+	printf("\t\t\t\t\t\t\tIPCA\n");
+	printf("\t\t\t\t\t\t\tEscola Superior de Tecnologia\n");
+	printf("\t\t\t\t\t\t\tEngenharia de Sistemas Informáticos PL\n");
+	printf("\t\t\t\t\t\t\t2024/2025\n\n");
+	printf("\t\t\t\t\t\t\tVisão por Computador\n");
+	printf("\t\t\t\t\t\t\tProfessor: Simão Valente\n\n");
+	printf("\t\t\t\t\t\t\tAlunos:\n");
+	printf("\t\t\t\t\t\t\t\tFernando Salgueiro n. 39\n");
+	printf("\t\t\t\t\t\t\t\tHugo Lopes n. 30516\n");
+	printf("\t\t\t\t\t\t\t\tCláudio Fernandes n. 30517\n");
+	printf("\t\t\t\t\t\t\t\tNuno Cruz n. 30518\n\n");
+
+	// Mensagem de encerramento
+	printf("\t\t\t\t\t\t\t\tObrigado                      ");
+	printf("\n\t_________________________________________________________________________________________________________________________________________\n\n");
+}
+
+#pragma endregion
+
+#pragma region Função: abrirEcra
+// Janela de visualização: caixa de correio com um único lugar (o frame mais recente) e uma thread de visualização
+struct ECRA {
+	std::string janela;
+	float escala;				// Escala da pré-visualização (0 = tamanho original)
+	cv::Mat entrada;			// Cópia do frame a enviar (só usada pela thread de processamento)
+	cv::Mat caixa;				// Frame mais recente ainda não mostrado
+	bool cheia;					// 1 se a caixa tem um frame por mostrar
+	bool terminar;
+	std::mutex mutex;
+	std::condition_variable novo;	// Acorda a thread de visualização
+	std::atomic<int> tecla;		// Última tecla premida (-1 = nenhuma)
+	long int nenviados;			// Frames enviados para a janela
+	long int nmostrados;		// Frames mostrados
+	long int ndescartados;		// Frames substituídos na caixa antes de serem mostrados
+	std::thread thread;
+};
+
+// Thread de visualização: mostra o frame mais recente e trata os eventos da janela
+static void ecraThread(ECRA* ecra)
+{
+	cv::Mat mostrado, reduzido;
+
+	cv::namedWindow(ecra->janela, cv::WINDOW_AUTOSIZE);
 
-	// Erosão
-	for (y = 0; y < height; y++)
+	for (;;)
 	{
-		for (x = 0; x < width; x++)
-		{
-			pos = y * bytesperline + x * channels;
-			pixel = datasrc[pos]; // Valor do píxel atual
+		bool novo = false;
 
-			// Só processa se o pixel for 1 (ativo)
-			if (pixel != 0)
+		{
+			std::unique_lock<std::mutex> lock(ecra->mutex);
+			// Sem frames novos, acorda na mesma a cada 10 ms para tratar os eventos da janela
+			ecra->novo.wait_for(lock, std::chrono::milliseconds(10), [ecra] { return ecra->terminar || ecra->cheia; });
+			if (ecra->cheia)
 			{
-				for (ky = -offset; ky <= offset; ky++)
-				{
-					for (kx = -offset; kx <= offset; kx++)
-					{
-						posk = (y + ky) * bytesperline + (x + kx) * channels;
-
-						// Verifica se o vizinho está dentro dos limites da imagem
-						if ((y + ky >= 0) && (y + ky < height) && (x + kx >= 0) && (x + kx < width))
-						{
-							// Erosão: se algum vizinho for 0, o resultado será 0
-							pixel &= datasrc[posk];
-
-							// Se encontrou vizinho 0, pode sair da busca
-							if (pixel == 0)
-							{
-								kx = offset;
-								ky = offset;
-							}
-						}
-					}
-				}
+				std::swap(mostrado, ecra->caixa);
+				ecra->cheia = false;
+				novo = true;
+			}
+			else if (ecra->terminar)
+			{
+				break;
 			}
+		}
 
-			// Define o valor do píxel na imagem de saída
-			if (pixel != 0)
+		if (novo)
+		{
+			if (ecra->escala > 0.0f && ecra->escala < 1.0f)
 			{
-				datadst[pos] = 1;
+				cv::resize(mostrado, reduzido, cv::Size(), ecra->escala, ecra->escala, cv::INTER_AREA);
+				cv::imshow(ecra->janela, reduzido);
 			}
 			else
 			{
-				datadst[pos] = 0;
+				cv::imshow(ecra->janela, mostrado);
 			}
+			ecra->nmostrados++;
 		}
+
+		int tecla = cv::waitKey(1);
+		if (tecla >= 0) ecra->tecla = tecla;
 	}
-	return 1;
-}
 
-#pragma endregion
+	cv::destroyWindow(ecra->janela);
+}
 
-#pragma	region Função: vc_binary_open
 /**
- * Função: vc_binary_open
- * -----------------------
- * Realiza a operação morfológica **abertura** numa imagem binária.
- * Abertura = erosão seguida de dilatação. Serve para remover ruído pequeno (pontos brancos isolados).
+ * @brief Cria a janela de visualização e a thread que a atualiza.
  *
- * Parâmetros:
- *   src              - imagem binária de entrada (1 canal)
- *   dst              - imagem binária de saída
- *   kernelsizeErode  - tamanho do kernel para a erosão
- *   kernelsizeDilate - tamanho do kernel para a dilatação
+ * O processamento nunca espera pela janela: `mostrarEcra` apenas deixa uma cópia do frame numa caixa
+ * com um único lugar. A thread de visualização mostra sempre o frame mais recente; os frames que
+ * são substituídos antes de serem mostrados são descartados (e contados).
  *
- * Retorna:
- *   1 se ambas as operações forem bem-sucedidas, 0 caso contrário.
+ * @param janela Nome da janela.
+ * @param escala Escala da pré-visualização (0 < escala < 1 reduz a janela; 0 = tamanho original).
+ *
+ * @return Ponteiro para o ecrã (libertado por `fecharEcra`).
  */
-
-int vc_binary_open(IVC* src, IVC* dst, int kernelsizeErode, int kernelsizeDilate)
+ECRA* abrirEcra(const char* janela, float escala)
 {
-	int ret = 1;
-
-	// Cria imagem temporária para armazenar o resultado da erosão
-	IVC* temp = vc_image_new(src->width, src->height, src->channels, src->levels);
-
-	// Aplica erosão e depois dilatação
-	ret &= vc_binary_erode(src, temp, kernelsizeErode);
-	ret &= vc_binary_dilate(temp, dst, kernelsizeDilate);
-
-	// Liberta a memória da imagem temporária
-	vc_image_free(temp);
-
-	return ret;
+	ECRA* ecra = new ECRA();
+
+	ecra->janela = janela;
+	ecra->escala = escala;
+	ecra->cheia = false;
+	ecra->terminar = false;
+	ecra->tecla = -1;
+	ecra->nenviados = 0;
+	ecra->nmostrados = 0;
+	ecra->ndescartados = 0;
+	ecra->thread = std::thread(ecraThread, ecra);
+
+	return ecra;
 }
 
 #pragma endregion
 
-#pragma	region Função: vc_binary_close
+#pragma region Função: mostrarEcra
 /**
- * Função: vc_binary_close
- * ------------------------
- * Realiza a operação morfológica **fecho (closing)** numa imagem binária.
- * Fecho = dilatação seguida de erosão. Serve para preencher pequenos buracos ou falhas nos objetos.
+ * @brief Envia um frame para a janela de visualização, sem esperar que seja mostrado.
  *
- * Parâmetros:
- *   src              - imagem binária de entrada (1 canal)
- *   dst              - imagem binária de saída
- *   kernelsizeDilate - tamanho do kernel para a dilatação
- *   kernelsizeErode  - tamanho do kernel para a erosão
+ * O frame é copiado (pode ser alterado logo a seguir). Se o frame anterior ainda não tiver sido
+ * mostrado, é substituído por este e contado como descartado.
  *
- * Retorna:
- *   1 se ambas as operações forem bem-sucedidas, 0 caso contrário.
+ * @param ecra Ecrã devolvido por `abrirEcra`.
+ * @param frame Frame a mostrar.
  */
-
-int vc_binary_close(IVC* src, IVC* dst, int kernelsizeDilate, int kernelsizeErode)
+void mostrarEcra(ECRA* ecra, cv::Mat& frame)
 {
-	int ret = 1;
-
-	// Cria imagem temporária para armazenar o resultado da dilatação
-	IVC* temp = vc_image_new(src->width, src->height, src->channels, src->levels);
-
-	// Aplica dilatação seguida de erosão
-	ret &= vc_binary_dilate(src, temp, kernelsizeDilate);
-	ret &= vc_binary_erode(temp, dst, kernelsizeErode);
+	if (ecra == NULL || frame.empty()) return;
 
-	// Liberta a imagem temporária
-	vc_image_free(temp);
+	// A cópia é feita fora da secção crítica, para um buffer só desta thread
+	frame.copyTo(ecra->entrada);
 
-	return ret;
+	{
+		std::lock_guard<std::mutex> lock(ecra->mutex);
+		if (ecra->cheia)
+		{
+			ecra->ndescartados++;
+			metricaContar(METRICA_ECRA_DESCARTADOS, 1);
+		}
+		std::swap(ecra->entrada, ecra->caixa);
+		ecra->cheia = true;
+		ecra->nenviados++;
+	}
+	ecra->novo.notify_one();
 }
 
 #pragma endregion
 
-#pragma region Função: vc_binary_blob_labelling
+#pragma region Função: teclaEcra
 /**
- * Função: vc_binary_blob_labelling
- * --------------------------------
- * Realiza a etiquetagem de blobs (objetos) numa imagem binária.
- * Cada blob é identificado com um número inteiro único (>0).
- * Utiliza algoritmo de duas passagens com resolução de equivalências.
+ * @brief Devolve a última tecla premida na janela (e esquece-a).
  *
- * Parâmetros:
- *   src - imagem binária de entrada (1 canal, 0 ou 255)
- *   dst - imagem de saída rotulada (1 canal)
+ * @param ecra Ecrã devolvido por `abrirEcra`.
  *
- * Retorna:
- *   Número total de blobs encontrados.
+ * @return Código da tecla, ou -1 se nenhuma tecla foi premida desde a última chamada.
  */
-OVC* vc_binary_blob_labelling(IVC* src, IVC* dst, int* nlabels)
+int teclaEcra(ECRA* ecra)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, a, b;
-	long int i, size;
-	long int posX, posA, posB, posC, posD;
-	int labeltable[256] = { 0 };
-	int labelarea[256] = { 0 };
-	int label = 1; // Etiqueta inicial.
-	int num, tmplabel;
-	OVC* blobs; // Apontador para array de blobs (objectos) que será retornado desta função.
+	if (ecra == NULL) return -1;
 
-	// Verificação de erros
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return NULL;
-	if (channels != 1) return NULL;
+	return ecra->tecla.exchange(-1);
+}
 
-	// Copia dados da imagem binária para imagem grayscale
-	memcpy(datadst, datasrc, bytesperline * height);
+#pragma endregion
 
-	// Todos os pixéis de plano de fundo devem obrigatóriamente ter valor 0
-	// Todos os pixéis de primeiro plano devem obrigatóriamente ter valor 255
-	// Serão atribuídas etiquetas no intervalo [1,254]
-	// Este algoritmo está assim limitado a 255 labels
-	for (i = 0, size = bytesperline * height; i < size; i++)
-	{
-		if (datadst[i] != 0) datadst[i] = 255;
-	}
+#pragma region Função: fecharEcra
+/**
+ * @brief Termina a thread de visualização, fecha a janela e mostra no terminal os frames mostrados e descartados.
+ *
+ * @param ecra Ecrã a fechar (é libertado).
+ */
+void fecharEcra(ECRA* ecra)
+{
+	if (ecra == NULL) return;
 
-	// Limpa os rebordos da imagem binária
-	for (y = 0; y < height; y++)
-	{
-		datadst[y * bytesperline + 0 * channels] = 0;
-		datadst[y * bytesperline + (width - 1) * channels] = 0;
-	}
-	for (x = 0; x < width; x++)
 	{
-		datadst[0 * bytesperline + x * channels] = 0;
-		datadst[(height - 1) * bytesperline + x * channels] = 0;
+		std::lock_guard<std::mutex> lock(ecra->mutex);
+		ecra->terminar = true;
 	}
+	ecra->novo.notify_one();
+	ecra->thread.join();
 
-	// Efectua a etiquetagem
-	for (y = 1; y < height - 1; y++)
-	{
-		for (x = 1; x < width - 1; x++)
-		{
-			// Kernel:
-			// A B C
-			// D X
-
-			posA = (y - 1) * bytesperline + (x - 1) * channels; // A
-			posB = (y - 1) * bytesperline + x * channels; // B
-			posC = (y - 1) * bytesperline + (x + 1) * channels; // C
-			posD = y * bytesperline + (x - 1) * channels; // D
-			posX = y * bytesperline + x * channels; // X
-
-			// Se o pixel foi marcado
-			if (datadst[posX] != 0)
-			{
-				if ((datadst[posA] == 0) && (datadst[posB] == 0) && (datadst[posC] == 0) && (datadst[posD] == 0))
-				{
-					datadst[posX] = label;
-					labeltable[label] = label;
-					label++;
-				}
-				else
-				{
-					num = 255;
+	float taxa = (ecra->nenviados > 0) ? 100.0f * (float)ecra->ndescartados / (float)ecra->nenviados : 0.0f;
 
-					// Se A está marcado
-					if (datadst[posA] != 0) num = labeltable[datadst[posA]];
-					// Se B está marcado, e é menor que a etiqueta "num"
-					if ((datadst[posB] != 0) && (labeltable[datadst[posB]] < num)) num = labeltable[datadst[posB]];
-					// Se C está marcado, e é menor que a etiqueta "num"
-					if ((datadst[posC] != 0) && (labeltable[datadst[posC]] < num)) num = labeltable[datadst[posC]];
-					// Se D está marcado, e é menor que a etiqueta "num"
-					if ((datadst[posD] != 0) && (labeltable[datadst[posD]] < num)) num = labeltable[datadst[posD]];
+	printf("\n\t\t\t\t\t\t\tJanela de visualização:\n");
+	printf("\t\t\t\t\t\t\t\tFrames mostrados: %ld de %ld\n", ecra->nmostrados, ecra->nenviados);
+	printf("\t\t\t\t\t\t\t\tFrames descartados: %ld (%.1f%%)\n", ecra->ndescartados, taxa);
 
-					// Atribui a etiqueta ao pixel
-					datadst[posX] = num;
-					labeltable[num] = num;
+	delete ecra;
+}
 
-					// Actualiza a tabela de etiquetas
-					if (datadst[posA] != 0)
-					{
-						if (labeltable[datadst[posA]] != num)
-						{
-							for (tmplabel = labeltable[datadst[posA]], a = 1; a < label; a++)
-							{
-								if (labeltable[a] == tmplabel)
-								{
-									labeltable[a] = num;
-								}
-							}
-						}
-					}
-					if (datadst[posB] != 0)
-					{
-						if (labeltable[datadst[posB]] != num)
-						{
-							for (tmplabel = labeltable[datadst[posB]], a = 1; a < label; a++)
-							{
-								if (labeltable[a] == tmplabel)
-								{
-									labeltable[a] = num;
-								}
-							}
-						}
-					}
-					if (datadst[posC] != 0)
-					{
-						if (labeltable[datadst[posC]] != num)
-						{
-							for (tmplabel = labeltable[datadst[posC]], a = 1; a < label; a++)
-							{
-								if (labeltable[a] == tmplabel)
-								{
-									labeltable[a] = num;
-								}
-							}
-						}
-					}
-					if (datadst[posD] != 0)
-					{
-						if (labeltable[datadst[posD]] != num)
-						{
-							for (tmplabel = labeltable[datadst[posC]], a = 1; a < label; a++)
-							{
-								if (labeltable[a] == tmplabel)
-								{
-									labeltable[a] = num;
-								}
-							}
-						}
-					}
-				}
-			}
-		}
+#pragma endregion
+
+#pragma region Função: abrirVideo
+/**
+ * @brief Abre um vídeo pedindo ao backend que descodifique com várias threads.
+ *
+ * Se o backend não aceitar `cv::CAP_PROP_N_THREADS`, o vídeo é aberto sem parâmetros.
+ *
+ * @param capture Captura a abrir.
+ * @param videofile Nome do ficheiro de vídeo.
+ *
+ * @return 1 se o vídeo foi aberto; 0 caso contrário.
+ */
+int abrirVideo(cv::VideoCapture& capture, const char* videofile)
+{
+	std::vector<int> parametros = { cv::CAP_PROP_N_THREADS, cv::getNumberOfCPUs() };
+
+	if (capture.open(videofile, cv::CAP_ANY, parametros))
+		return 1;
+
+	return capture.open(videofile) ? 1 : 0;
+}
+
+#pragma endregion
+
+#pragma region Função: abrirDescodificador
+// Descodificador: anel de frames pré-alocados, preenchido por uma thread e consumido pelo processamento
+struct DESCODIFICADOR {
+	cv::VideoCapture* capture;	// Só usada pela thread do descodificador enquanto esta existir (NULL: entrada em bruto)
+	FONTE fonte;				// Entrada em bruto (stdin ou memória partilhada)
+	cv::Mat yuv;				// Frame YUV 4:2:0 lido antes da conversão para BGR
+	unsigned char* shm;			// Memória partilhada mapeada
+	size_t shmTamanho;
+	uint64_t shmProximo;		// Próximo frame a ler do anel de memória partilhada
+	std::chrono::steady_clock::time_point arranque;	// Instante de referência dos tempos da entrada em bruto
+	std::vector<cv::Mat> frames;	// Anel de frames
+	std::vector<int> nframe;	// Número de cada frame (como CAP_PROP_POS_FRAMES depois da leitura)
+	std::vector<double> tempo;	// Instante de cada frame (ms)
+	int inicio;					// Próximo frame a entregar ao processamento
+	int n;						// Frames descodificados no anel (incluindo o que está a ser processado)
+	int emUso;					// 1 se o frame do início está a ser processado
+	bool fim;					// O vídeo terminou (ou houve um erro de leitura)
+	bool terminar;
+	std::atomic<int> k;			// Frames a avançar por cada frame descodificado (decimação)
+	std::mutex mutex;
+	std::condition_variable cheio;	// Acorda o processamento (há um frame novo ou o vídeo terminou)
+	std::condition_variable livre;	// Acorda a thread do descodificador (há um lugar livre)
+	long int ndescodificados;	// Frames descodificados (retrieve)
+	long int navancados;		// Frames avançados sem descodificação (grab)
+	long int nesperas;			// Vezes em que o processamento esperou por um frame
+	std::thread thread;
+};
+
+// Lê o próximo frame de um vídeo: avança k - 1 frames (grab) e descodifica o seguinte
+static bool lerVideo(DESCODIFICADOR* descodificador, cv::Mat& frame, int k, int* nframe, double* tempo)
+{
+	for (int i = 1; i < k; i++)
+	{
+		if (!descodificador->capture->grab()) return false;
+		(*nframe)++;
+		descodificador->navancados++;
 	}
 
-	// Volta a etiquetar a imagem
-	for (y = 1; y < height - 1; y++)
+	if (!descodificador->capture->read(frame)) return false;
+	(*nframe)++;
+	*tempo = descodificador->capture->get(cv::CAP_PROP_POS_MSEC);
+
+	return true;
+}
+
+// Lê exatamente n bytes do stdin. Em POSIX a leitura espera por dados com poll() em intervalos de
+// 100 ms e desiste quando o descodificador é fechado; no Windows o fread bloqueia até chegarem os
+// n bytes ou o fim do stdin (e o fecharDescodificador espera por isso)
+static bool lerStdin(DESCODIFICADOR* descodificador, unsigned char* dados, size_t n)
+{
+#ifdef _WIN32
+	(void)descodificador;
+	return fread(dados, 1, n, stdin) == n;
+#else
+	size_t lidos = 0;
+
+	while (lidos < n)
 	{
-		for (x = 1; x < width - 1; x++)
+		struct pollfd entrada = { STDIN_FILENO, POLLIN, 0 };
+		int pronto = poll(&entrada, 1, 100);
+
+		if ((pronto < 0) && (errno != EINTR)) return false;
+		if (pronto <= 0)
 		{
-			posX = y * bytesperline + x * channels; // X
+			std::lock_guard<std::mutex> lock(descodificador->mutex);
+			if (descodificador->terminar) return false;
+			continue;
+		}
 
-			if (datadst[posX] != 0)
+		ssize_t k = read(STDIN_FILENO, dados + lidos, n - lidos);
+		if ((k < 0) && ((errno == EINTR) || (errno == EAGAIN))) continue;
+		if (k <= 0) return false;
+		lidos += (size_t)k;
+	}
+
+	return true;
+#endif
+}
+
+// Lê o próximo frame do stdin (os k - 1 anteriores são lidos e ignorados)
+static bool lerEntradaStdin(DESCODIFICADOR* descodificador, cv::Mat& frame, int k, int* nframe)
+{
+	for (int i = 0; i < k; i++)
+	{
+		bool lido;
+
+		if (descodificador->fonte.formato == FORMATO_YUV420)
+			lido = lerStdin(descodificador, descodificador->yuv.data, descodificador->yuv.total());
+		else
+			lido = lerStdin(descodificador, frame.data, frame.total() * frame.elemSize());	// Diretamente para o lugar do anel
+
+		if (!lido) return false;
+		(*nframe)++;
+		if (i < k - 1) descodificador->navancados++;
+	}
+
+	if (descodificador->fonte.formato == FORMATO_YUV420)
+		cv::cvtColor(descodificador->yuv, frame, cv::COLOR_YUV2BGR_I420);
+
+	return true;
+}
+
+#ifndef _WIN32
+// Lê o próximo frame do anel de memória partilhada (salta k - 1 frames; se o processo de captura
+// estiver mais de um anel à frente, salta para o frame completo mais recente)
+static bool lerEntradaShm(DESCODIFICADOR* descodificador, cv::Mat& frame, int k, int* nframe)
+{
+	SHM_CABECALHO* cabecalho = (SHM_CABECALHO*)descodificador->shm;
+	uint64_t nlugares = cabecalho->nlugares;
+	size_t bytes = (descodificador->fonte.formato == FORMATO_YUV420) ? descodificador->yuv.total() : frame.total() * frame.elemSize();
+	unsigned char* destino = (descodificador->fonte.formato == FORMATO_YUV420) ? descodificador->yuv.data : frame.data;
+
+	descodificador->shmProximo += k - 1;
+
+	for (;;)
+	{
+		uint64_t escritos = cabecalho->escritos.load(std::memory_order_acquire);
+
+		// Ainda não há frame novo: espera (ou termina, se o processo de captura terminou)
+		if (escritos <= descodificador->shmProximo)
+		{
+			if (cabecalho->fim.load(std::memory_order_acquire)) return false;
 			{
-				datadst[posX] = labeltable[datadst[posX]];
+				std::lock_guard<std::mutex> lock(descodificador->mutex);
+				if (descodificador->terminar) return false;
 			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// O frame pedido já foi substituído (ou está a ser): salta para o mais recente
+		if (escritos - descodificador->shmProximo >= nlugares)
+		{
+			descodificador->navancados += (long int)(escritos - 1 - descodificador->shmProximo);
+			descodificador->shmProximo = escritos - 1;
 		}
+
+		uint64_t lugar = descodificador->shmProximo % nlugares;
+		memcpy(destino, descodificador->shm + SHM_DADOS + lugar * cabecalho->tamanho, bytes);
+
+		// Se o lugar começou a ser reescrito durante a cópia, tenta de novo (a barreira impede que
+		// as leituras da cópia passem para depois da nova leitura de escritos)
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (cabecalho->escritos.load(std::memory_order_acquire) - descodificador->shmProximo >= nlugares) continue;
+
+		descodificador->shmProximo++;
+		*nframe = (int)descodificador->shmProximo;
+		break;
 	}
 
-	//printf("\nMax Label = %d\n", label);
+	if (descodificador->fonte.formato == FORMATO_YUV420)
+		cv::cvtColor(descodificador->yuv, frame, cv::COLOR_YUV2BGR_I420);
 
-	// Contagem do número de blobs
-	// Passo 1: Eliminar, da tabela, etiquetas repetidas
-	for (a = 1; a < label - 1; a++)
+	return true;
+}
+#endif
+
+// Thread do descodificador: lê o próximo frame da fonte para um lugar livre do anel
+static void descodificadorThread(DESCODIFICADOR* descodificador)
+{
+	int profundidade = (int)descodificador->frames.size();
+	int nframe = (descodificador->capture != NULL) ? (int)descodificador->capture->get(cv::CAP_PROP_POS_FRAMES) : 0;
+
+	for (;;)
 	{
-		for (b = a + 1; b < label; b++)
+		int posicao;
+
 		{
-			if (labeltable[a] == labeltable[b]) labeltable[b] = 0;
+			std::unique_lock<std::mutex> lock(descodificador->mutex);
+			descodificador->livre.wait(lock, [descodificador, profundidade] { return descodificador->terminar || descodificador->n < profundidade; });
+			if (descodificador->terminar) break;
+			posicao = (descodificador->inicio + descodificador->n) % profundidade;
+		}
+
+		// O lugar livre só é acedido por esta thread até ser entregue
+		bool lido = false;
+		double tempo = 0.0;
+		int k = descodificador->k;
+		cv::Mat& frame = descodificador->frames[posicao];
+
+		if (descodificador->capture != NULL)
+		{
+			lido = lerVideo(descodificador, frame, k, &nframe, &tempo);
+		}
+		else
+		{
+			if (descodificador->fonte.tipo == FONTE_STDIN)
+				lido = lerEntradaStdin(descodificador, frame, k, &nframe);
+#ifndef _WIN32
+			else if (descodificador->fonte.tipo == FONTE_SHM)
+				lido = lerEntradaShm(descodificador, frame, k, &nframe);
+#endif
+
+			// Instante de chegada do frame
+			tempo = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - descodificador->arranque).count();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(descodificador->mutex);
+			if (lido)
+			{
+				descodificador->ndescodificados++;
+				descodificador->nframe[posicao] = nframe;
+				descodificador->tempo[posicao] = tempo;
+				descodificador->n++;
+				metricaFila(FILA_DESCODIFICADOR, descodificador->n);
+			}
+			else
+			{
+				descodificador->fim = true;
+			}
 		}
+		descodificador->cheio.notify_one();
+
+		if (!lido) break;
 	}
-	// Passo 2: Conta etiquetas e organiza a tabela de etiquetas, para que não hajam valores vazios (zero) entre etiquetas
-	*nlabels = 0;
-	for (a = 1; a < label; a++)
+}
+
+// Cria o descodificador com o anel de frames pré-alocados (a thread é arrancada por quem chama)
+static DESCODIFICADOR* novoDescodificador(int profundidade, int width, int height)
+{
+	DESCODIFICADOR* descodificador = new DESCODIFICADOR();
+
+	profundidade = MAX(1, MIN(profundidade, ANTECIPAR_MAX));
+
+	descodificador->capture = NULL;
+	memset(&descodificador->fonte, 0, sizeof(FONTE));
+	descodificador->shm = NULL;
+	descodificador->shmTamanho = 0;
+	descodificador->shmProximo = 0;
+	descodificador->arranque = std::chrono::steady_clock::now();
+	descodificador->frames.resize(profundidade);
+	descodificador->nframe.resize(profundidade, 0);
+	descodificador->tempo.resize(profundidade, 0.0);
+	for (int i = 0; i < profundidade; i++)
 	{
-		if (labeltable[a] != 0)
+		// Pré-alocação (a leitura reutiliza o buffer se as dimensões coincidirem)
+		descodificador->frames[i].create(height, width, CV_8UC3);
+	}
+	descodificador->inicio = 0;
+	descodificador->n = 0;
+	descodificador->emUso = 0;
+	descodificador->fim = false;
+	descodificador->terminar = false;
+	descodificador->k = 1;
+	descodificador->ndescodificados = 0;
+	descodificador->navancados = 0;
+	descodificador->nesperas = 0;
+
+	return descodificador;
+}
+
+/**
+ * @brief Arranca a descodificação antecipada de um vídeo numa thread própria.
+ *
+ * A thread do descodificador preenche um anel de `profundidade` frames pré-alocados; o processamento
+ * obtém os frames já descodificados com `obterFrame` e devolve-os com `libertarFrame`, sem esperar
+ * pela leitura do ficheiro nem pela descodificação (exceto se o anel ficar vazio).
+ * O número e o instante de cada frame acompanham o frame no anel.
+ *
+ * @note Depois desta chamada, a captura só pode voltar a ser usada depois de `fecharDescodificador`.
+ *
+ * @param capture Captura aberta (ver `abrirVideo`).
+ * @param profundidade Número de frames do anel (1 a ANTECIPAR_MAX).
+ * @param width Largura dos frames.
+ * @param height Altura dos frames.
+ *
+ * @return Ponteiro para o descodificador (libertado por `fecharDescodificador`).
+ */
+DESCODIFICADOR* abrirDescodificador(cv::VideoCapture* capture, int profundidade, int width, int height)
+{
+	DESCODIFICADOR* descodificador = novoDescodificador(profundidade, width, height);
+
+	descodificador->capture = capture;
+	descodificador->thread = std::thread(descodificadorThread, descodificador);
+
+	return descodificador;
+}
+
+#pragma endregion
+
+#pragma region Função: abrirEntrada
+/**
+ * @brief Arranca a leitura de frames em bruto (stdin ou memória partilhada) numa thread própria.
+ *
+ * Funciona como `abrirDescodificador`, mas sem `cv::VideoCapture`:
+ * - `FONTE_STDIN`: frames de `fonte->width` x `fonte->height` píxeis, lidos do stdin (em modo binário)
+ *   diretamente para o anel (BGR) ou para um buffer YUV 4:2:0 convertido para o anel;
+ * - `FONTE_SHM`: frames copiados do anel de memória partilhada `fonte->nome` (ver `SHM_CABECALHO`);
+ *   as dimensões e o formato são lidos do cabeçalho e escritos em `fonte`.
+ *
+ * O instante de cada frame é o instante de chegada, em milissegundos desde a abertura.
+ *
+ * @note A memória partilhada só é suportada em sistemas POSIX (no Windows a função retorna NULL).
+ *       No Windows a leitura do stdin não é interrompível: `fecharDescodificador` espera que chegue
+ *       o frame em leitura ou o fim do stdin.
+ *
+ * @param fonte Fonte dos frames (é atualizada com as dimensões da memória partilhada).
+ * @param profundidade Número de frames do anel (1 a ANTECIPAR_MAX).
+ *
+ * @return Ponteiro para o descodificador (libertado por `fecharDescodificador`), ou NULL em caso de erro.
+ */
+DESCODIFICADOR* abrirEntrada(FONTE* fonte, int profundidade)
+{
+	unsigned char* shm = NULL;
+	size_t shmTamanho = 0;
+
+	if (fonte->tipo == FONTE_STDIN)
+	{
+#ifdef _WIN32
+		// O stdin tem de estar em modo binário
+		_setmode(_fileno(stdin), _O_BINARY);
+#endif
+	}
+	else if (fonte->tipo == FONTE_SHM)
+	{
+#ifdef _WIN32
+		fprintf(stderr, "A entrada por memória partilhada não é suportada no Windows!\n");
+		return NULL;
+#else
+		int fd = shm_open(fonte->nome, O_RDONLY, 0);
+		struct stat estado;
+
+		if (fd < 0) return NULL;
+		if ((fstat(fd, &estado) != 0) || ((size_t)estado.st_size < SHM_DADOS))
 		{
-			labeltable[*nlabels] = labeltable[a]; // Organiza tabela de etiquetas
-			(*nlabels)++; // Conta etiquetas
+			close(fd);
+			return NULL;
+		}
+
+		shmTamanho = (size_t)estado.st_size;
+		void* mapa = mmap(NULL, shmTamanho, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapa == MAP_FAILED) return NULL;
+		shm = (unsigned char*)mapa;
+
+		// Validação do cabeçalho
+		SHM_CABECALHO* cabecalho = (SHM_CABECALHO*)shm;
+		size_t bytes = (size_t)cabecalho->width * cabecalho->height * ((cabecalho->formato == FORMATO_YUV420) ? 1 : 3);
+		if (cabecalho->formato == FORMATO_YUV420) bytes = bytes * 3 / 2;
+
+		if ((memcmp(cabecalho->magic, "VCSH", 4) != 0) || (cabecalho->width == 0) || (cabecalho->height == 0) ||
+			(cabecalho->formato > FORMATO_YUV420) || (cabecalho->nlugares == 0) || (cabecalho->tamanho < bytes) ||
+			(SHM_DADOS + (size_t)cabecalho->nlugares * cabecalho->tamanho > shmTamanho))
+		{
+			munmap(shm, shmTamanho);
+			return NULL;
 		}
+
+		fonte->width = (int)cabecalho->width;
+		fonte->height = (int)cabecalho->height;
+		fonte->formato = (int)cabecalho->formato;
+#endif
+	}
+	else
+	{
+		return NULL;
 	}
 
-	// Se não há blobs
-	if (*nlabels == 0) return NULL;
+	if ((fonte->width <= 0) || (fonte->height <= 0)) return NULL;
+	if ((fonte->formato == FORMATO_YUV420) && ((fonte->width % 2) || (fonte->height % 2))) return NULL;
 
-	// Cria lista de blobs (objectos) e preenche a etiqueta
-	blobs = (OVC*)calloc((*nlabels), sizeof(OVC));
-	if (blobs != NULL)
+	DESCODIFICADOR* descodificador = novoDescodificador(profundidade, fonte->width, fonte->height);
+
+	descodificador->fonte = *fonte;
+	descodificador->shm = shm;
+	descodificador->shmTamanho = shmTamanho;
+	if (shm != NULL)
 	{
-		for (a = 0; a < (*nlabels); a++) blobs[a].label = labeltable[a];
+		// Começa no frame completo mais recente (fonte ao vivo)
+		uint64_t escritos = ((SHM_CABECALHO*)shm)->escritos.load(std::memory_order_acquire);
+		descodificador->shmProximo = (escritos > 0) ? escritos - 1 : 0;
 	}
-	else return NULL;
+	if (fonte->formato == FORMATO_YUV420)
+	{
+		descodificador->yuv.create(fonte->height * 3 / 2, fonte->width, CV_8UC1);
+	}
+	descodificador->thread = std::thread(descodificadorThread, descodificador);
 
+	return descodificador;
+}
 
+#pragma endregion
 
-	return blobs;
+#pragma region Função: obterFrame
+/**
+ * @brief Obtém o próximo frame descodificado (espera apenas se o anel estiver vazio).
+ *
+ * O frame pertence ao processamento até `libertarFrame`; se o frame anterior não tiver sido
+ * libertado, é libertado aqui.
+ *
+ * @param descodificador Descodificador devolvido por `abrirDescodificador`.
+ * @param nframe Número do frame (como `CAP_PROP_POS_FRAMES` depois da leitura). Pode ser NULL.
+ * @param tempo Instante do frame em milissegundos. Pode ser NULL.
+ *
+ * @return Ponteiro para o frame no anel, ou NULL no fim do vídeo.
+ */
+cv::Mat* obterFrame(DESCODIFICADOR* descodificador, int* nframe, double* tempo)
+{
+	if (descodificador->emUso) libertarFrame(descodificador);
+
+	std::unique_lock<std::mutex> lock(descodificador->mutex);
+
+	if (descodificador->n == 0 && !descodificador->fim) descodificador->nesperas++;
+	descodificador->cheio.wait(lock, [descodificador] { return descodificador->fim || descodificador->n > 0; });
+	if (descodificador->n == 0) return NULL;
+
+	int posicao = descodificador->inicio;
+	descodificador->emUso = 1;
+
+	if (nframe != NULL) *nframe = descodificador->nframe[posicao];
+	if (tempo != NULL) *tempo = descodificador->tempo[posicao];
+
+	return &descodificador->frames[posicao];
 }
 
+#pragma endregion
+
+#pragma region Função: libertarFrame
+/**
+ * @brief Devolve ao anel o frame obtido com `obterFrame` (o lugar pode voltar a ser preenchido).
+ *
+ * @param descodificador Descodificador devolvido por `abrirDescodificador`.
+ */
+void libertarFrame(DESCODIFICADOR* descodificador)
+{
+	{
+		std::lock_guard<std::mutex> lock(descodificador->mutex);
+		if (!descodificador->emUso) return;
+		descodificador->emUso = 0;
+		descodificador->inicio = (descodificador->inicio + 1) % (int)descodificador->frames.size();
+		descodificador->n--;
+		metricaFila(FILA_DESCODIFICADOR, descodificador->n);
+	}
+	descodificador->livre.notify_one();
+}
 
 #pragma endregion
 
-#pragma region Função: vc_binary_blob_info
+#pragma region Função: saltarFrames
 /**
- * Função: vc_binary_blob_info
- * ---------------------------
- * Calcula a área, perímetro e centro de massa de cada blob numa imagem binária.
+ * @brief Define quantos frames o descodificador avança por cada frame descodificado (decimação).
  *
- * Parâmetros:
- *   src       - imagem binária de entrada (1 canal)
- *   blobs     - vetor de blobs (saída)
- *   nblobs    - número total de blobs
+ * Os k - 1 frames intermédios são apenas avançados (grab), sem descodificação. O novo valor aplica-se
+ * aos frames ainda não descodificados; os que já estão no anel mantêm o k com que foram lidos.
  *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ * @param descodificador Descodificador devolvido por `abrirDescodificador`.
+ * @param k Frames a avançar (>= 1).
  */
-int vc_binary_blob_info(IVC* src, OVC* blobs, int nblobs)
+void saltarFrames(DESCODIFICADOR* descodificador, int k)
 {
-	unsigned char* data = (unsigned char*)src->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, i;
-	long int pos;
-	int xmin, ymin, xmax, ymax;
-	long int sumx, sumy;
+	descodificador->k = MAX(k, 1);
+}
 
-	// Verificação de erros
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
-	if (channels != 1) return 0;
+#pragma endregion
+
+#pragma region Função: fecharDescodificador
+/**
+ * @brief Termina a thread do descodificador e mostra no terminal as estatísticas da descodificação.
+ *
+ * A leitura em curso do stdin ou da memória partilhada desiste em até 100 ms (no Windows, a leitura
+ * do stdin só termina quando chega o frame ou o fim do stdin).
+ *
+ * @param descodificador Descodificador a fechar (é libertado; a captura pode voltar a ser usada).
+ */
+void fecharDescodificador(DESCODIFICADOR* descodificador)
+{
+	if (descodificador == NULL) return;
 
-	// Conta área de cada blob
-	for (i = 0; i < nblobs; i++)
 	{
-		xmin = width - 1;
-		ymin = height - 1;
-		xmax = 0;
-		ymax = 0;
+		std::lock_guard<std::mutex> lock(descodificador->mutex);
+		descodificador->terminar = true;
+	}
+	descodificador->livre.notify_one();
+	descodificador->thread.join();
 
-		sumx = 0;
-		sumy = 0;
+	printf("\n\t\t\t\t\t\t\tDescodificação (anel de %d frames):\n", (int)descodificador->frames.size());
+	printf("\t\t\t\t\t\t\t\tFrames descodificados: %ld\n", descodificador->ndescodificados);
+	printf("\t\t\t\t\t\t\t\tFrames avançados sem descodificação: %ld\n", descodificador->navancados);
+	printf("\t\t\t\t\t\t\t\tEsperas do processamento: %ld\n", descodificador->nesperas);
 
-		blobs[i].area = 0;
+#ifndef _WIN32
+	if (descodificador->shm != NULL) munmap(descodificador->shm, descodificador->shmTamanho);
+#endif
+
+	delete descodificador;
+}
+
+#pragma endregion
+
+#pragma region Função: abrirEscritor
+// Escritor: fila limitada de frames anotados, codificados por uma thread com cv::VideoWriter
+struct ESCRITOR {
+	cv::VideoWriter writer;		// Só usado pela thread do escritor
+	std::deque<cv::Mat> fila;	// Frames à espera de codificação
+	std::vector<cv::Mat> livres;	// Buffers já codificados, para reutilizar
+	int esperar;				// 1: o processamento espera com a fila cheia; 0: descarta o frame
+	int eventos;				// Frames antes e depois de cada evento (0 = grava todos)
+	std::vector<cv::Mat> anteriores;	// Anel dos últimos frames (modo de eventos; só do processamento)
+	int nanteriores;			// Frames no anel
+	int proximo;				// Próxima posição do anel
+	int restantes;				// Frames ainda a gravar depois do último evento
+	bool terminar;
+	std::mutex mutex;
+	std::condition_variable filacheia;	// Acorda a thread do escritor
+	std::condition_variable filalivre;	// Acorda o processamento à espera de espaço na fila
+	long int nescritos;			// Frames codificados
+	long int ndescartados;		// Frames descartados com a fila cheia
+	long int neventos;			// Eventos recebidos
+	std::thread thread;
+};
+
+// Thread do escritor: retira os frames da fila e codifica-os
+static void escritorThread(ESCRITOR* escritor)
+{
+	for (;;)
+	{
+		cv::Mat frame;
 
-		for (y = 1; y < height - 1; y++)
 		{
-			for (x = 1; x < width - 1; x++)
-			{
-				pos = y * bytesperline + x * channels;
+			std::unique_lock<std::mutex> lock(escritor->mutex);
+			escritor->filacheia.wait(lock, [escritor] { return escritor->terminar || !escritor->fila.empty(); });
+			if (escritor->fila.empty()) break;
+			std::swap(frame, escritor->fila.front());
+			escritor->fila.pop_front();
+			metricaFila(FILA_ESCRITOR, (int)escritor->fila.size());
+		}
+		escritor->filalivre.notify_one();
 
-				if (data[pos] == blobs[i].label)
-				{
-					// Área
-					blobs[i].area++;
+		escritor->writer.write(frame);
+		escritor->nescritos++;
 
-					// Centro de Gravidade
-					sumx += x;
-					sumy += y;
+		{
+			std::lock_guard<std::mutex> lock(escritor->mutex);
+			escritor->livres.push_back(frame);
+		}
+	}
+}
 
-					// Bounding Box
-					if (xmin > x) xmin = x;
-					if (ymin > y) ymin = y;
-					if (xmax < x) xmax = x;
-					if (ymax < y) ymax = y;
+// Coloca uma cópia do frame na fila (espera ou descarta se a fila estiver cheia; com `esperar` a 1,
+// espera sempre, para que uma rajada maior do que a fila não perca frames)
+static void escritorFila(ESCRITOR* escritor, cv::Mat& frame, int esperar)
+{
+	cv::Mat copia;
 
-					// Perímetro
-					// Se pelo menos um dos quatro vizinhos não pertence ao mesmo label, então é um pixel de contorno
-					if ((data[pos - 1] != blobs[i].label) || (data[pos + 1] != blobs[i].label) || (data[pos - bytesperline] != blobs[i].label) || (data[pos + bytesperline] != blobs[i].label))
-					{
-						blobs[i].perimetro++;
-					}
-				}
+	{
+		std::unique_lock<std::mutex> lock(escritor->mutex);
+		if (escritor->fila.size() >= ESCRITOR_FILA_MAX)
+		{
+			if (!escritor->esperar && !esperar)
+			{
+				escritor->ndescartados++;
+				metricaContar(METRICA_ESCRITOR_DESCARTADOS, 1);
+				return;
 			}
+			escritor->filalivre.wait(lock, [escritor] { return escritor->fila.size() < ESCRITOR_FILA_MAX; });
+		}
+		if (!escritor->livres.empty())
+		{
+			std::swap(copia, escritor->livres.back());
+			escritor->livres.pop_back();
 		}
+	}
 
-		// Bounding Box
-		blobs[i].x = xmin;
-		blobs[i].y = ymin;
-		blobs[i].width = (xmax - xmin) + 1;
-		blobs[i].height = (ymax - ymin) + 1;
+	// Cópia fora da secção crítica (reutiliza um buffer já codificado, se houver)
+	frame.copyTo(copia);
 
-		// Centro de Gravidade
-		//blobs[i].xc = (xmax - xmin) / 2;
-		//blobs[i].yc = (ymax - ymin) / 2;
-		//blobs[i].xc = sumx / MAX(blobs[i].area, 1);
-		//blobs[i].yc = sumy / MAX(blobs[i].area, 1);
-		//professor 
-		blobs[i].xc = sumx / (blobs[i].area);
-		//professor 
-		blobs[i].yc = sumy / (blobs[i].area);
+	{
+		std::lock_guard<std::mutex> lock(escritor->mutex);
+		escritor->fila.push_back(copia);
+		metricaFila(FILA_ESCRITOR, (int)escritor->fila.size());
 	}
-
-	return 1;
+	escritor->filacheia.notify_one();
 }
 
-
-#pragma	endregion
-
-#pragma region Função: vc_gray_histogram
 /**
- * Função: vc_gray_histogram_show
- * ------------------------------
- * Gera uma imagem 256x256 com o histograma normalizado (PDF) da imagem em tons de cinzento (grayscale).
- * Cada coluna da imagem resultante representa a frequência (PDF) de intensidade de cinzento [0-255].
- * A altura da barra é proporcional à frequência relativa da intensidade na imagem original.
+ * @brief Cria o vídeo anotado e arranca a thread que o codifica.
  *
- * Parâmetros:
- *   src - imagem de entrada em grayscale (1 canal)
- *   dst - imagem de saída 256x256 (1 canal), onde será desenhado o histograma
+ * Os frames são copiados para uma fila limitada (ESCRITOR_FILA_MAX) e codificados em segundo plano,
+ * sem atrasar a contagem. Com a fila cheia, o frame é descartado (e contado) ou, se `esperar` for 1,
+ * o processamento espera por espaço na fila.
  *
- * Retorna:
- *   Apontador para a imagem de saída com o histograma, ou NULL em caso de erro.
+ * No modo de eventos (`eventos` > 0), só são gravados os `eventos` frames anteriores e seguintes
+ * a cada frame com uma moeda contada. Os frames anteriores (até ESCRITOR_EVENTOS_MAX, mais do que
+ * cabem na fila) e o frame do evento são enviados de uma só vez e nunca são descartados: o
+ * processamento espera por espaço na fila durante essa rajada.
+ *
+ * @param ficheiro Nome do vídeo a criar (.mp4: mp4v; restantes: MJPG).
+ * @param fps Frames por segundo do vídeo criado.
+ * @param width Largura dos frames.
+ * @param height Altura dos frames.
+ * @param eventos Frames antes e depois de cada evento (0 = grava todos os frames).
+ * @param esperar 1 para esperar com a fila cheia; 0 para descartar.
+ *
+ * @return Ponteiro para o escritor (libertado por `fecharEscritor`), ou NULL se o vídeo não foi criado.
  */
-
-IVC* vc_gray_histogram_show(IVC* src, IVC* dst)
+ESCRITOR* abrirEscritor(const char* ficheiro, double fps, int width, int height, int eventos, int esperar)
 {
-	// Verifica se a imagem de entrada é válida e se é grayscale
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return NULL;
-	if (src->channels != 1)
+	const char* extensao = strrchr(ficheiro, '.');
+	int fourcc = ((extensao != NULL) && (strcmp(extensao, ".mp4") == 0)) ?
+		cv::VideoWriter::fourcc('m', 'p', '4', 'v') : cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+
+	ESCRITOR* escritor = new ESCRITOR();
+
+	if (!escritor->writer.open(ficheiro, fourcc, (fps > 0.0) ? fps : 30.0, cv::Size(width, height)))
+	{
+		delete escritor;
 		return NULL;
+	}
 
-	unsigned char* datasrc = (unsigned char*)src->data;
-	int nPixels = src->width * src->height;
-	int hist[256] = { 0 };        // Histograma absoluto
-	float pdf[256] = { 0.0f };    // Distribuição de probabilidade (PDF)
-	float histmax = 0.0f;         // Maior valor do PDF (para escalar a altura)
-	int i, x, y;
+	escritor->esperar = esperar;
+	escritor->eventos = MAX(0, MIN(eventos, ESCRITOR_EVENTOS_MAX));
+	escritor->anteriores.resize(escritor->eventos);
+	escritor->nanteriores = 0;
+	escritor->proximo = 0;
+	escritor->restantes = 0;
+	escritor->terminar = false;
+	escritor->nescritos = 0;
+	escritor->ndescartados = 0;
+	escritor->neventos = 0;
+	escritor->thread = std::thread(escritorThread, escritor);
+
+	return escritor;
+}
 
-	// === 1. Calcular histograma absoluto ===
-	for (int pos = 0; pos < nPixels; pos++)
+#pragma endregion
+
+#pragma region Função: escreverEscritor
+/**
+ * @brief Envia um frame anotado para o vídeo de saída.
+ *
+ * No modo de eventos, o frame é guardado no anel dos frames anteriores; quando `evento` é 1, os frames
+ * do anel são enviados para a fila (esperando por espaço, mesmo sem `esperar`), seguidos deste frame
+ * e dos `eventos` frames seguintes.
+ *
+ * @param escritor Escritor devolvido por `abrirEscritor` (NULL: não faz nada).
+ * @param frame Frame anotado.
+ * @param evento 1 se foi contada uma moeda neste frame.
+ */
+void escreverEscritor(ESCRITOR* escritor, cv::Mat& frame, int evento)
+{
+	if (escritor == NULL || frame.empty()) return;
+
+	// Grava todos os frames
+	if (escritor->eventos == 0)
 	{
-		hist[datasrc[pos]]++; // Incrementa a contagem para o valor de intensidade
+		escritorFila(escritor, frame, 0);
+		return;
 	}
 
-	// === 2. Calcular PDF (frequência relativa) e encontrar o valor máximo do PDF ===
-	for (i = 0; i < 256; i++)
+	if (evento)
 	{
-		pdf[i] = (float)hist[i] / (float)nPixels;
-		if (pdf[i] > histmax)
+		escritor->neventos++;
+
+		// Frames anteriores ao evento, do mais antigo para o mais recente
+		int n = escritor->nanteriores;
+		for (int i = 0; i < n; i++)
 		{
-			histmax = pdf[i]; // Guarda o máximo para normalizar depois
+			int posicao = (escritor->proximo - n + i + escritor->eventos) % escritor->eventos;
+			escritorFila(escritor, escritor->anteriores[posicao], 1);
 		}
+		escritor->nanteriores = 0;
+		escritor->restantes = escritor->eventos;
+
+		escritorFila(escritor, frame, 1);
+	}
+	else if (escritor->restantes > 0)
+	{
+		// Frames seguintes ao evento
+		escritor->restantes--;
+		escritorFila(escritor, frame, 0);
 	}
+	else
+	{
+		// Guarda o frame no anel (o mais antigo é substituído)
+		frame.copyTo(escritor->anteriores[escritor->proximo]);
+		escritor->proximo = (escritor->proximo + 1) % escritor->eventos;
+		escritor->nanteriores = MIN(escritor->nanteriores + 1, escritor->eventos);
+	}
+}
+
+#pragma endregion
+
+#pragma region Função: fecharEscritor
+/**
+ * @brief Espera que a fila fique vazia, fecha o vídeo de saída e mostra no terminal as estatísticas da gravação.
+ *
+ * @param escritor Escritor a fechar (é libertado).
+ */
+void fecharEscritor(ESCRITOR* escritor)
+{
+	if (escritor == NULL) return;
 
-	// === 3. Limpar imagem de saída (assumidamente 256x256 pixels) ===
-	for (int pos = 0; pos < (256 * 256); pos++)
 	{
-		dst->data[pos] = 0; // Tudo preto inicialmente
+		std::lock_guard<std::mutex> lock(escritor->mutex);
+		escritor->terminar = true;
+	}
+	escritor->filacheia.notify_one();
+	escritor->thread.join();
+	escritor->writer.release();
+
+	printf("\n\t\t\t\t\t\t\tVídeo anotado:\n");
+	printf("\t\t\t\t\t\t\t\tFrames gravados: %ld\n", escritor->nescritos);
+	printf("\t\t\t\t\t\t\t\tFrames descartados (fila cheia): %ld\n", escritor->ndescartados);
+	if (escritor->eventos > 0)
+	{
+		printf("\t\t\t\t\t\t\t\tEventos: %ld\n", escritor->neventos);
 	}
 
-	// === 4. Desenhar barras verticais do histograma ===
-	for (x = 0; x < 256; x++)
+	delete escritor;
+}
+
+#pragma endregion
+
+#pragma region Função: abrirMetricas
+// Contadores de uma thread: só essa thread escreve (sem instruções atómicas de leitura-modificação-escrita);
+// a thread de exportação só lê e soma os blocos de todas as threads
+typedef struct {
+	std::atomic<long long> contadores[METRICA_NCONTADORES];
+	std::atomic<long long> moedas[MAX_MOEDAS];
+	std::atomic<long long> tempos[METRICA_NTEMPOS][METRICA_NBALDES + 1];
+	std::atomic<long long> temposSoma[METRICA_NTEMPOS];	// ns
+	std::atomic<long long> blobs[METRICA_NBALDES + 1];
+	std::atomic<long long> blobsSoma;
+} BLOCO_METRICAS;
+
+// Limites superiores (inclusivos) dos baldes dos histogramas; os textos não dependem do locale (vírgula decimal)
+static const double baldesTempo[METRICA_NBALDES] = { 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.0 };
+static const char* textosTempo[METRICA_NBALDES] = { "0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05", "0.1", "0.25", "0.5", "1", "2" };
+static const int baldesBlobs[METRICA_NBALDES] = { 0, 1, 2, 3, 5, 10, 20, 50, 100, 150, 200, 254 };
+
+static const char* nomesContadores[METRICA_NCONTADORES][2] = {
+	{ "moedas_frames_total", "Frames processados." },
+	{ "moedas_frames_sem_movimento_total", "Frames com a segmentacao saltada pelo detetor de movimento." },
+	{ "moedas_candidatas_total", "Blobs com a area e o perimetro minimos de uma moeda." },
+	{ "moedas_etiquetagens_excedidas_total", "Etiquetagens com mais blobs do que etiquetas disponiveis." },
+	{ "moedas_ecra_descartados_total", "Frames substituidos antes de serem mostrados." },
+	{ "moedas_escritor_descartados_total", "Frames nao gravados por a fila de escrita estar cheia." },
+};
+static const char* nomesTempos[METRICA_NTEMPOS] = { "segmentacao", "etiquetagem", "piramide", "analise", "apresentacao", "frame" };
+static const char* nomesFilas[METRICA_NFILAS] = { "descodificador", "escritor" };
+
+static struct {
+	std::atomic<bool> ativas;
+	std::mutex mutex;						// Protege a lista de blocos
+	std::vector<BLOCO_METRICAS*> blocos;	// Um bloco por thread (mantidos até ao fim do programa)
+	std::atomic<int> filas[METRICA_NFILAS];
+	std::string destino;
+	int periodo;
+	int servidor;							// Socket de escuta (-1 = exportação para ficheiro)
+	std::mutex controlo;
+	std::condition_variable acordar;
+	std::atomic<bool> terminar;
+	std::thread thread;
+	long int nexportacoes, nerros, npedidos;
+} metricas;
+
+static thread_local BLOCO_METRICAS* blocoThread = NULL;
+
+static inline BLOCO_METRICAS* blocoMetricas(void)
+{
+	if (blocoThread == NULL)
 	{
-		// Altura proporcional à frequência (PDF)
-		int barHeight = (int)((pdf[x] / histmax) * 256);
+		blocoThread = new BLOCO_METRICAS();
+		std::lock_guard<std::mutex> lock(metricas.mutex);
+		metricas.blocos.push_back(blocoThread);
+	}
+	return blocoThread;
+}
 
-		// Desenhar barra da base (linha 255) até ao topo da barra
-		for (y = 255; y >= 256 - barHeight; y--)
+// Incremento de um contador com um único escritor
+static inline void somarMetrica(std::atomic<long long>& contador, long long n)
+{
+	contador.store(contador.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// Escreve o texto num ficheiro temporário e substitui o destino (os leitores nunca veem um ficheiro a meio)
+static int exportarFicheiro(const std::string& texto)
+{
+	std::string temporario = metricas.destino + ".tmp";
+	FILE* f = fopen(temporario.c_str(), "wb");
+	if (f == NULL) return 0;
+	int ok = (fwrite(texto.data(), 1, texto.size(), f) == texto.size());
+	if (fclose(f) != 0) ok = 0;
+	if (!ok) return 0;
+#ifdef _WIN32
+	remove(metricas.destino.c_str());
+#endif
+	return rename(temporario.c_str(), metricas.destino.c_str()) == 0;
+}
+
+#ifndef _WIN32
+// Atende um cliente do socket: descarta o pedido (se houver) e responde com o texto em HTTP/1.0
+static void atenderMetricas(int cliente, const std::string& texto)
+{
+	char pedido[1024];
+	struct pollfd p = { cliente, POLLIN, 0 };
+	if (poll(&p, 1, 50) > 0) (void)!recv(cliente, pedido, sizeof(pedido), 0);
+
+	char cabecalho[128];
+	int n = snprintf(cabecalho, sizeof(cabecalho),
+		"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", texto.size());
+	int ok = (send(cliente, cabecalho, n, MSG_NOSIGNAL) == n);
+	size_t enviados = 0;
+	while (ok && enviados < texto.size())
+	{
+		ssize_t r = send(cliente, texto.data() + enviados, texto.size() - enviados, MSG_NOSIGNAL);
+		if (r <= 0) ok = 0;
+		else enviados += (size_t)r;
+	}
+	if (!ok) metricas.nerros++;
+	shutdown(cliente, SHUT_WR);
+	close(cliente);
+	metricas.npedidos++;
+}
+#endif
+
+// Agrega os blocos a cada período; com socket, responde aos clientes com o último texto agregado
+static void metricasThread(void)
+{
+	std::string texto;
+	textoMetricas(texto);
+	auto proxima = std::chrono::steady_clock::now();
+
+	while (true)
+	{
+		bool terminar = metricas.terminar.load();
+		auto agora = std::chrono::steady_clock::now();
+
+		if (terminar || agora >= proxima)
 		{
-			dst->data[y * dst->bytesperline + x] = 1; // Branco
+			textoMetricas(texto);
+			proxima = agora + std::chrono::milliseconds(metricas.periodo);
+			if (metricas.servidor < 0)
+			{
+				if (exportarFicheiro(texto)) metricas.nexportacoes++;
+				else metricas.nerros++;
+			}
+			else
+			{
+				metricas.nexportacoes++;
+			}
 		}
-	}
+		if (terminar) break;
 
-	return dst;
-}
+		int espera = (int)std::chrono::duration_cast<std::chrono::milliseconds>(proxima - std::chrono::steady_clock::now()).count();
+		espera = MAX(espera, 0);
 
-#pragma endregion
+#ifndef _WIN32
+		if (metricas.servidor >= 0)
+		{
+			// Fatias curtas para ver o pedido de terminação
+			struct pollfd p = { metricas.servidor, POLLIN, 0 };
+			if (poll(&p, 1, MIN(espera, 100)) > 0)
+			{
+				int cliente = accept(metricas.servidor, NULL, NULL);
+				if (cliente >= 0) atenderMetricas(cliente, texto);
+			}
+			continue;
+		}
+#endif
+		std::unique_lock<std::mutex> lock(metricas.controlo);
+		metricas.acordar.wait_for(lock, std::chrono::milliseconds(espera), [] { return metricas.terminar.load(); });
+	}
+}
 
-#pragma region Função: vc_gray_histogram_equalization
 /**
- * Função: vc_gray_histogram_equalization
- * --------------------------------------
- * Aplica equalização de histograma a uma imagem em tons de cinzento.
- * A equalização de histograma melhora o contraste da imagem, redistribuindo os níveis de cinza.
+ * @brief Ativa as métricas do processamento e inicia a thread que as exporta em formato de texto Prometheus.
  *
- * Parâmetros:
- *   src - imagem de entrada (grayscale, 1 canal)
- *   dst - imagem de saída (grayscale, 1 canal)
+ * As threads de processamento só atualizam contadores próprios (ver `metricaContar`, `metricaTempo`);
+ * a agregação e a escrita são feitas pela thread de exportação, a cada `periodo` ms:
+ * - ficheiro: o texto é escrito num ficheiro temporário que substitui o destino (para um node exporter
+ *   com textfile collector, por exemplo);
+ * - "unix:<caminho>": socket Unix onde cada ligação recebe o último texto agregado numa resposta HTTP/1.0
+ *   (ex.: `curl --unix-socket <caminho> http://localhost/metrics`). Não suportado em Windows.
  *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ * @param destino Ficheiro ou "unix:<caminho>".
+ * @param periodo Período de exportação em ms (0 = METRICAS_PERIODO).
+ *
+ * @return 1 se as métricas foram ativadas; 0 caso contrário.
  */
-int vc_gray_histogram_equalization(IVC* src, IVC* dst)
+int abrirMetricas(const char* destino, int periodo)
 {
-	if (src == NULL || dst == NULL || src->data == NULL || dst->data == NULL) return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != 1) || (dst->channels != 1)) return 0;
+	if (destino == NULL || destino[0] == '\0' || metricas.ativas.load()) return 0;
 
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	long int size = width * height;
-	int x, y, i;
-	int hist[256] = { 0 };
-	float pdf[256] = { 0.0f }, cdf[256] = { 0.0f };
-	float cdfmin = 0.0f;
+	metricas.destino = destino;
+	metricas.periodo = (periodo > 0) ? periodo : METRICAS_PERIODO;
+	metricas.servidor = -1;
 
-	// Calcular o histograma
-	for (y = 0; y < height; y++)
+	if (strncmp(destino, "unix:", 5) == 0)
 	{
-		for (x = 0; x < width; x++)
+#ifdef _WIN32
+		fprintf(stderr, "Métricas em socket Unix não suportadas nesta plataforma!\n");
+		return 0;
+#else
+		struct sockaddr_un endereco;
+		memset(&endereco, 0, sizeof(endereco));
+		endereco.sun_family = AF_UNIX;
+		if (strlen(destino + 5) >= sizeof(endereco.sun_path)) return 0;
+		strcpy(endereco.sun_path, destino + 5);
+
+		int servidor = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (servidor < 0) return 0;
+		unlink(endereco.sun_path);
+		if (bind(servidor, (struct sockaddr*)&endereco, sizeof(endereco)) != 0 || listen(servidor, 4) != 0)
 		{
-			hist[datasrc[y * bytesperline + x]]++;
+			close(servidor);
+			return 0;
 		}
+		metricas.servidor = servidor;
+#endif
 	}
 
-	// Calcular pdf e cdf
-	for (i = 0; i < 256; i++)
+	metricas.nexportacoes = 0;
+	metricas.nerros = 0;
+	metricas.npedidos = 0;
+	metricas.terminar = false;
+	metricas.ativas = true;
+	metricas.thread = std::thread(metricasThread);
+
+	return 1;
+}
+
+#pragma endregion
+
+#pragma region Função: fecharMetricas
+/**
+ * @brief Faz a última exportação, termina a thread das métricas e mostra no terminal as estatísticas da exportação.
+ */
+void fecharMetricas(void)
+{
+	if (!metricas.ativas.load()) return;
+
 	{
-		pdf[i] = (float)hist[i] / size;
-		cdf[i] = (i == 0) ? pdf[i] : cdf[i - 1] + pdf[i];
+		std::lock_guard<std::mutex> lock(metricas.controlo);
+		metricas.terminar = true;
 	}
+	metricas.acordar.notify_one();
+	metricas.thread.join();
+	metricas.ativas = false;
 
-	// Encontrar o primeiro valor não-zero da CDF
-	for (i = 0; i < 256; i++)
+#ifndef _WIN32
+	if (metricas.servidor >= 0)
 	{
-		if (cdf[i] > 0.0f)
-		{
-			cdfmin = cdf[i];
-			break;
-		}
+		close(metricas.servidor);
+		unlink(metricas.destino.c_str() + 5);
+		metricas.servidor = -1;
 	}
+#endif
 
-	// Aplicar equalização
-	for (y = 0; y < height; y++)
+	printf("\n\t\t\t\t\t\t\tMétricas (%s):\n", metricas.destino.c_str());
+	printf("\t\t\t\t\t\t\t\tExportações: %ld\n", metricas.nexportacoes);
+	if (metricas.npedidos > 0)
 	{
-		for (x = 0; x < width; x++)
-		{
-			int val = datasrc[y * bytesperline + x];
-			datadst[y * bytesperline + x] = (unsigned char)(((cdf[val] - cdfmin) / (1.0f - cdfmin)) * 255.0f + 0.5f);
-		}
+		printf("\t\t\t\t\t\t\t\tPedidos atendidos: %ld\n", metricas.npedidos);
 	}
+	printf("\t\t\t\t\t\t\t\tErros: %ld\n", metricas.nerros);
+}
 
-	return 1;
+#pragma endregion
+
+#pragma region Função: metricaContar
+/**
+ * @brief Soma `n` a um contador de métricas da thread atual (sem efeito com as métricas desativadas).
+ *
+ * @param contador Contador (METRICA_*).
+ * @param n Valor a somar.
+ */
+void metricaContar(int contador, long int n)
+{
+	if (!metricas.ativas.load(std::memory_order_relaxed) || contador < 0 || contador >= METRICA_NCONTADORES) return;
+	somarMetrica(blocoMetricas()->contadores[contador], n);
+}
+
+/**
+ * @brief Conta uma moeda do tipo dado (índice na tabela de moedas) nas métricas.
+ *
+ * @param tipo Índice da moeda na tabela de moedas.
+ */
+void metricaMoeda(int tipo)
+{
+	if (!metricas.ativas.load(std::memory_order_relaxed) || tipo < 0 || tipo >= MAX_MOEDAS) return;
+	somarMetrica(blocoMetricas()->moedas[tipo], 1);
 }
 
+/**
+ * @brief Regista o número de blobs de um frame no histograma de blobs por frame.
+ *
+ * @param nblobs Número de blobs etiquetados no frame.
+ */
+void metricaBlobs(int nblobs)
+{
+	if (!metricas.ativas.load(std::memory_order_relaxed)) return;
+
+	BLOCO_METRICAS* bloco = blocoMetricas();
+	int i = 0;
+	while (i < METRICA_NBALDES && nblobs > baldesBlobs[i]) i++;
+	somarMetrica(bloco->blobs[i], 1);
+	somarMetrica(bloco->blobsSoma, nblobs);
+}
 
 #pragma endregion
 
-#pragma region Função: vc_gray_edge_prewitt
+#pragma region Função: metricaTempo
 /**
- * Função: vc_gray_edge_prewitt
- * -----------------------------
- * Aplica o operador de Prewitt para detecção de bordas em uma imagem em tons de cinza.
- * O operador de Prewitt calcula a magnitude do gradiente da imagem, destacando as bordas.
+ * @brief Instante atual para medir uma etapa com `metricaTempo`.
  *
- * Parâmetros:
- *   src - imagem de entrada (grayscale, 1 canal)
- *   dst - imagem de saída (grayscale, 1 canal)
- *   th  - limiar para binarização (valores acima deste limiar serão definidos como 255)
+ * @return Instante em segundos, ou 0 com as métricas desativadas (a medição é então ignorada).
+ */
+double metricaRelogio(void)
+{
+	if (!metricas.ativas.load(std::memory_order_relaxed)) return 0.0;
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Regista a duração de uma etapa no histograma de tempos dessa etapa.
  *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ * @param etapa Etapa medida (TEMPO_*).
+ * @param inicio Instante devolvido por `metricaRelogio` no início da etapa.
  */
-int vc_gray_edge_prewitt(IVC* src, IVC* dst, float th) {
-	unsigned char* data = (unsigned char*)src->data;
-	int width = src->width;
-	int height = src->height;
-	int byteperline = src->width * src->channels;
-	int channels = src->channels;
-	int x, y;
-	long int pos;
-	long int posA, posB, posC, posD, posE, posF, posG, posH;
-	double mag, mx, my;
+void metricaTempo(int etapa, double inicio)
+{
+	if (inicio <= 0.0 || etapa < 0 || etapa >= METRICA_NTEMPOS || !metricas.ativas.load(std::memory_order_relaxed)) return;
+
+	double duracao = metricaRelogio() - inicio;
+	BLOCO_METRICAS* bloco = blocoMetricas();
+	int i = 0;
+	while (i < METRICA_NBALDES && duracao > baldesTempo[i]) i++;
+	somarMetrica(bloco->tempos[etapa][i], 1);
+	somarMetrica(bloco->temposSoma[etapa], (long long)(duracao * 1e9));
+}
 
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
-	if (channels != 1) return 0;
+/**
+ * @brief Atualiza a profundidade atual de uma fila (medidor; o último valor prevalece).
+ *
+ * @param fila Fila (FILA_*).
+ * @param profundidade Número de elementos na fila.
+ */
+void metricaFila(int fila, int profundidade)
+{
+	if (!metricas.ativas.load(std::memory_order_relaxed) || fila < 0 || fila >= METRICA_NFILAS) return;
+	metricas.filas[fila].store(profundidade, std::memory_order_relaxed);
+}
+
+#pragma endregion
+
+#pragma region Função: textoMetricas
+/**
+ * @brief Soma os contadores de todas as threads e escreve-os em formato de texto Prometheus (versão 0.0.4).
+ *
+ * @param texto String que recebe o texto (é substituída).
+ */
+void textoMetricas(std::string& texto)
+{
+	long long contadores[METRICA_NCONTADORES] = { 0 };
+	long long moedas[MAX_MOEDAS] = { 0 };
+	long long tempos[METRICA_NTEMPOS][METRICA_NBALDES + 1] = { { 0 } };
+	long long temposSoma[METRICA_NTEMPOS] = { 0 };
+	long long blobs[METRICA_NBALDES + 1] = { 0 };
+	long long blobsSoma = 0;
+	char linha[256];
+	int i, j;
 
-	for (y = 1; y < height; y++)
 	{
-		for (x = 1; x < width; x++)
+		std::lock_guard<std::mutex> lock(metricas.mutex);
+		for (BLOCO_METRICAS* b : metricas.blocos)
 		{
-			pos = y * byteperline + x * channels;
+			for (i = 0; i < METRICA_NCONTADORES; i++) contadores[i] += b->contadores[i].load(std::memory_order_relaxed);
+			for (i = 0; i < MAX_MOEDAS; i++) moedas[i] += b->moedas[i].load(std::memory_order_relaxed);
+			for (i = 0; i < METRICA_NTEMPOS; i++)
+			{
+				for (j = 0; j <= METRICA_NBALDES; j++) tempos[i][j] += b->tempos[i][j].load(std::memory_order_relaxed);
+				temposSoma[i] += b->temposSoma[i].load(std::memory_order_relaxed);
+			}
+			for (j = 0; j <= METRICA_NBALDES; j++) blobs[j] += b->blobs[j].load(std::memory_order_relaxed);
+			blobsSoma += b->blobsSoma.load(std::memory_order_relaxed);
+		}
+	}
 
-			posA = (y - 1) * byteperline + (x - 1) * channels;
-			posB = (y - 1) * byteperline + (x)*channels;
-			posC = (y - 1) * byteperline + (x + 1) * channels;
-			posD = (y)*byteperline + (x - 1) * channels;
-			posE = (y)*byteperline + (x + 1) * channels;
-			posF = (y + 1) * byteperline + (x - 1) * channels;
-			posG = (y + 1) * byteperline + (x)*channels;
-			posH = (y + 1) * byteperline + (x + 1) * channels;
-			mx = ((-1 * data[posA]) + (1 * data[posC]) + (-1 * data[posD]) + (1 * data[posE]) + (-1 * data[posF]) + (1 * data[posH])) / 3; //?
-			my = ((-1 * data[posA]) + (1 * data[posF]) + (-1 * data[posB]) + (1 * data[posG]) + (-1 * data[posC]) + (1 * data[posH])) / 3;
+	texto.clear();
 
-			mag = sqrt((mx * mx) + (my * my));
+	for (i = 0; i < METRICA_NCONTADORES; i++)
+	{
+		snprintf(linha, sizeof(linha), "# HELP %s %s\n# TYPE %s counter\n%s %lld\n",
+			nomesContadores[i][0], nomesContadores[i][1], nomesContadores[i][0], nomesContadores[i][0], contadores[i]);
+		texto += linha;
+	}
 
-			if (mag > th)
-				dst->data[pos] = 255;
+	texto += "# HELP moedas_contadas_total Moedas contadas por valor (euros).\n# TYPE moedas_contadas_total counter\n";
+	for (i = 0; i < tabelaMoedas.n; i++)
+	{
+		snprintf(linha, sizeof(linha), "moedas_contadas_total{valor=\"%d.%02d\"} %lld\n", tabelaMoedas.valor[i] / 100, tabelaMoedas.valor[i] % 100, moedas[i]);
+		texto += linha;
+	}
+
+	// Histogramas cumulativos (cada balde inclui os anteriores)
+	texto += "# HELP moedas_etapa_segundos Duracao de cada etapa do processamento de um frame.\n# TYPE moedas_etapa_segundos histogram\n";
+	for (i = 0; i < METRICA_NTEMPOS; i++)
+	{
+		long long acumulado = 0;
+		for (j = 0; j <= METRICA_NBALDES; j++)
+		{
+			acumulado += tempos[i][j];
+			if (j < METRICA_NBALDES)
+				snprintf(linha, sizeof(linha), "moedas_etapa_segundos_bucket{etapa=\"%s\",le=\"%s\"} %lld\n", nomesTempos[i], textosTempo[j], acumulado);
 			else
-				dst->data[pos] = 0;
+				snprintf(linha, sizeof(linha), "moedas_etapa_segundos_bucket{etapa=\"%s\",le=\"+Inf\"} %lld\n", nomesTempos[i], acumulado);
+			texto += linha;
 		}
+		snprintf(linha, sizeof(linha), "moedas_etapa_segundos_sum{etapa=\"%s\"} %lld.%09lld\nmoedas_etapa_segundos_count{etapa=\"%s\"} %lld\n",
+			nomesTempos[i], temposSoma[i] / 1000000000LL, temposSoma[i] % 1000000000LL, nomesTempos[i], acumulado);
+		texto += linha;
+	}
+
+	texto += "# HELP moedas_blobs_por_frame Blobs etiquetados em cada frame processado.\n# TYPE moedas_blobs_por_frame histogram\n";
+	long long acumulado = 0;
+	for (j = 0; j <= METRICA_NBALDES; j++)
+	{
+		acumulado += blobs[j];
+		if (j < METRICA_NBALDES)
+			snprintf(linha, sizeof(linha), "moedas_blobs_por_frame_bucket{le=\"%d\"} %lld\n", baldesBlobs[j], acumulado);
+		else
+			snprintf(linha, sizeof(linha), "moedas_blobs_por_frame_bucket{le=\"+Inf\"} %lld\n", acumulado);
+		texto += linha;
+	}
+	snprintf(linha, sizeof(linha), "moedas_blobs_por_frame_sum %lld\nmoedas_blobs_por_frame_count %lld\n", blobsSoma, acumulado);
+	texto += linha;
+
+	texto += "# HELP moedas_fila_profundidade Elementos em cada fila entre threads.\n# TYPE moedas_fila_profundidade gauge\n";
+	for (i = 0; i < METRICA_NFILAS; i++)
+	{
+		snprintf(linha, sizeof(linha), "moedas_fila_profundidade{fila=\"%s\"} %d\n", nomesFilas[i], metricas.filas[i].load(std::memory_order_relaxed));
+		texto += linha;
 	}
-	return 1;
 }
+
 #pragma endregion
 
-#pragma region Função: vc_gray_edge_sobel
-/**
- * Função: vc_gray_edge_sobel
- * ---------------------------
- * Aplica o operador de Sobel para detecção de bordas em uma imagem em tons de cinza.
- * O operador de Sobel calcula a magnitude do gradiente da imagem, destacando as bordas.
- *
- * Parâmetros:
- *   src - imagem de entrada (grayscale, 1 canal)
- *   dst - imagem de saída (grayscale, 1 canal)
- *   th  - limiar para binarização (valores acima deste limiar serão definidos como 255)
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
- */
-int vc_gray_edge_sobel(IVC* src, IVC* dst, float th) {
-	unsigned char* data = (unsigned char*)src->data;
-	int width = src->width;
-	int height = src->height;
-	int byteperline = src->width * src->channels;
-	int channels = src->channels;
-	int x, y;
-	long int pos;
-	long int posA, posB, posC, posD, posE, posF, posG, posH;
-	double mag, mx, my;
+#pragma region Função: abrirEventos
+// Anel de eventos: só contarMoeda (thread de processamento) escreve e só a thread de eventos lê.
+// Cada índice só é escrito por uma das threads; a ordem é garantida por release/acquire.
+static struct {
+	EVENTO_MOEDA anel[EVENTOS_CAPACIDADE];
+	std::atomic<unsigned long long> escritos;	// Eventos colocados (produtor)
+	std::atomic<unsigned long long> lidos;		// Eventos escritos (consumidor)
+	std::atomic<bool> ativo;
+	std::atomic<bool> terminar;
+	std::chrono::steady_clock::time_point inicio;
+	FILE* ficheiro;
+	int ndjson;
+	long int ndescartados;						// Anel cheio (só o produtor escreve)
+	std::thread thread;
+} eventos;
+
+// Números sem printf de vírgula flutuante: o locale do programa usa vírgula decimal
+static void escreverEvento(const EVENTO_MOEDA* e)
+{
+	int circ = (int)(e->circularidade * 1000.0f + 0.5f);
 
-	if ((width <= 0) || (height <= 0) || (src->data == NULL)) return 0;
-	if (channels != 1) return 0;
+	printf("\n\t\t\t\t\tMoeda de %.2f Eur -> A: %d, P: %d, C: %.2f, Ø: %d, (x,y): (%d,%d)\n",
+		(float)e->valor / 100.0f, e->area, e->perimetro, e->circularidade, e->diametro, e->xc, e->yc);
 
-	for (y = 1; y < height; y++)
-	{
-		for (x = 1; x < width; x++)
-		{
-			pos = y * byteperline + x * channels;
+	if (eventos.ficheiro == NULL) return;
 
-			posA = (y - 1) * byteperline + (x - 1) * channels;
-			posB = (y - 1) * byteperline + (x)*channels;
-			posC = (y - 1) * byteperline + (x + 1) * channels;
-			posD = (y)*byteperline + (x - 1) * channels;
-			posE = (y)*byteperline + (x + 1) * channels;
-			posF = (y + 1) * byteperline + (x - 1) * channels;
-			posG = (y + 1) * byteperline + (x)*channels;
-			posH = (y + 1) * byteperline + (x + 1) * channels;
+	if (eventos.ndjson)
+	{
+		fprintf(eventos.ficheiro,
+			"{\"frame\":%d,\"tempo_ms\":%lld.%03lld,\"valor\":%d.%02d,\"area\":%d,\"perimetro\":%d,"
+			"\"circularidade\":%d.%03d,\"diametro\":%d,\"xc\":%d,\"yc\":%d}\n",
+			e->nframe, e->tempo / 1000, e->tempo % 1000, e->valor / 100, e->valor % 100, e->area, e->perimetro,
+			circ / 1000, circ % 1000, e->diametro, e->xc, e->yc);
+	}
+	else
+	{
+		fprintf(eventos.ficheiro, "%d,%lld.%03lld,%d.%02d,%d,%d,%d.%03d,%d,%d,%d\n",
+			e->nframe, e->tempo / 1000, e->tempo % 1000, e->valor / 100, e->valor % 100, e->area, e->perimetro,
+			circ / 1000, circ % 1000, e->diametro, e->xc, e->yc);
+	}
+}
 
-			mx = ((-1 * data[posA]) + (1 * data[posC]) + (-2 * data[posD]) + (2 * data[posE]) + (-1 * data[posF]) + (1 * data[posH])) / 3;
-			my = ((-1 * data[posA]) + (1 * data[posF]) + (-2 * data[posB]) + (2 * data[posG]) + (-1 * data[posC]) + (1 * data[posH])) / 3;
+// Thread de eventos: escreve os eventos do anel; sem eventos, dorme alguns ms (o produtor nunca a acorda)
+static void eventosThread(void)
+{
+	for (;;)
+	{
+		bool terminar = eventos.terminar.load(std::memory_order_acquire);
+		unsigned long long lidos = eventos.lidos.load(std::memory_order_relaxed);
+		unsigned long long escritos = eventos.escritos.load(std::memory_order_acquire);
 
-			mag = sqrt((mx * mx) + (my * my));
+		if (lidos == escritos)
+		{
+			if (terminar) break;
+			if (eventos.ficheiro != NULL) fflush(eventos.ficheiro);
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			continue;
+		}
 
-			if (mag > th)
-				dst->data[pos] = 255;
-			else
-				dst->data[pos] = 0;
+		for (; lidos < escritos; lidos++)
+		{
+			escreverEvento(&eventos.anel[lidos & (EVENTOS_CAPACIDADE - 1)]);
 		}
+		eventos.lidos.store(lidos, std::memory_order_release);
 	}
-	return 1;
 }
-#pragma endregion
 
-#pragma region Função: vc_gray_lowpass_mean_filter
 /**
- * Função: vc_gray_lowpass_mean_filter
- * -----------------------------------
- * Aplica um filtro de média (mean filter) a uma imagem em tons de cinza.
- * O filtro de média suaviza a imagem, reduzindo o ruído.
+ * @brief Inicia a thread que escreve as moedas contadas no terminal e, opcionalmente, num ficheiro de eventos.
  *
- * Parâmetros:
- *   src        - imagem de entrada (grayscale, 1 canal)
- *   dst        - imagem de saída (grayscale, 1 canal)
- *   kernelsize - tamanho do kernel (deve ser ímpar)
+ * Os eventos registados por `registarMoeda` ficam num anel de EVENTOS_CAPACIDADE posições; o processamento
+ * nunca espera pela consola nem pelo disco (com o anel cheio, o evento é descartado e contado).
+ * O formato do ficheiro é escolhido pela extensão: .csv (com cabeçalho) ou NDJSON (um objeto JSON por linha).
  *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ * @param ficheiro Ficheiro de eventos, ou NULL/vazio para escrever só no terminal.
+ *
+ * @return 1 se o registo foi iniciado; 0 se o ficheiro não pôde ser criado (o registo fica só no terminal).
  */
-int vc_gray_lowpass_mean_filter(IVC* src, IVC* dst, int kernelsize)
+int abrirEventos(const char* ficheiro)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int offset = (kernelsize - 1) / 2;
-	long int pos, kpos;
-	int sum;
+	int ok = 1;
 
-	// Error verification
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels))
-		return 0;
-	if (channels != 1)
-		return 0;
+	if (eventos.ativo.load()) return 1;
 
-	// Apply mean filter
-	for (y = offset; y < height - offset; y++)
+	eventos.ficheiro = NULL;
+	eventos.ndjson = 0;
+	if (ficheiro != NULL && ficheiro[0] != '\0')
 	{
-		for (x = offset; x < width - offset; x++)
-		{
-			sum = 0;
-			for (ky = -offset; ky <= offset; ky++)
-			{
-				for (kx = -offset; kx <= offset; kx++)
-				{
-					kpos = (y + ky) * bytesperline + (x + kx) * channels;
-					sum += datasrc[kpos];
-				}
-			}
-			pos = y * bytesperline + x * channels;
-			datadst[pos] = (unsigned char)(sum / (kernelsize * kernelsize));
-		}
+		const char* extensao = strrchr(ficheiro, '.');
+		eventos.ndjson = (extensao == NULL) || (strcmp(extensao, ".csv") != 0);
+		eventos.ficheiro = fopen(ficheiro, "w");
+		if (eventos.ficheiro == NULL) ok = 0;
+		else if (!eventos.ndjson) fprintf(eventos.ficheiro, "frame,tempo_ms,valor,area,perimetro,circularidade,diametro,xc,yc\n");
 	}
 
-	return 1;
+	eventos.escritos = 0;
+	eventos.lidos = 0;
+	eventos.ndescartados = 0;
+	eventos.terminar = false;
+	eventos.inicio = std::chrono::steady_clock::now();
+	eventos.ativo = true;
+	eventos.thread = std::thread(eventosThread);
+
+	return ok;
 }
+
 #pragma endregion
 
-#pragma region Função: vc_gray_lowpass_median_filter
+#pragma region Função: registarMoeda
 /**
- * Função: vc_gray_lowpass_median_filter
- * -------------------------------------
- * Aplica um filtro de mediana (median filter) a uma imagem em tons de cinza.
- * O filtro de mediana suaviza a imagem, reduzindo o ruído, preservando bordas.
+ * @brief Coloca o evento de uma moeda contada no anel de eventos (sem locks nem chamadas ao sistema).
  *
- * Parâmetros:
- *   src        - imagem de entrada (grayscale, 1 canal)
- *   dst        - imagem de saída (grayscale, 1 canal)
- *   kernelsize - tamanho do kernel (deve ser ímpar)
+ * Só pode ser chamada pela thread de processamento (anel com um único produtor). Sem registo aberto,
+ * o evento é escrito logo no terminal.
  *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ * @param evento Evento a registar (o instante é preenchido aqui).
  */
-int vc_gray_lowpass_median_filter(IVC* src, IVC* dst, int kernelsize)
+void registarMoeda(const EVENTO_MOEDA* evento)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int offset = (kernelsize - 1) / 2;
-	long int pos, kpos;
-	unsigned char* ordem;
-	int i, j;
-	unsigned char temp;
-
-	// Error verification
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels))
-		return 0;
-	if (channels != 1)
-		return 0;
-
-
-	// Allocate memory for the sorting window
-	ordem = (unsigned char*)malloc(kernelsize * kernelsize * sizeof(unsigned char));
-	if (ordem == NULL) return 0;
+	EVENTO_MOEDA e = *evento;
+	e.tempo = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - eventos.inicio).count();
 
-	// Apply median filter
-	for (y = offset; y < height - offset; y++)
+	if (!eventos.ativo.load(std::memory_order_relaxed))
 	{
-		for (x = offset; x < width - offset; x++)
-		{
-			// Collect pixels in the kernel window
-			i = 0;
-			for (ky = -offset; ky <= offset; ky++)
-			{
-				for (kx = -offset; kx <= offset; kx++)
-				{
-					kpos = (y + ky) * bytesperline + (x + kx) * channels;
-					ordem[i++] = datasrc[kpos];
-				}
-			}
-
-			// Sort the window using bubble sort (simple for small kernels)
-			for (i = 0; i < kernelsize * kernelsize - 1; i++)
-			{
-				for (j = i + 1; j < kernelsize * kernelsize; j++)
-				{
-					if (ordem[i] > ordem[j])
-					{
-						temp = ordem[i];
-						ordem[i] = ordem[j];
-						ordem[j] = temp;
-					}
-				}
-			}
+		escreverEvento(&e);
+		return;
+	}
 
-			// Get the median value (middle element)
-			pos = y * bytesperline + x * channels;
-			datadst[pos] = (unsigned char)ordem[(kernelsize * kernelsize) / 2];
-		}
+	unsigned long long escritos = eventos.escritos.load(std::memory_order_relaxed);
+	if (escritos - eventos.lidos.load(std::memory_order_acquire) >= EVENTOS_CAPACIDADE)
+	{
+		eventos.ndescartados++;
+		return;
 	}
 
-	free(ordem);
-	return 1;
+	eventos.anel[escritos & (EVENTOS_CAPACIDADE - 1)] = e;
+	eventos.escritos.store(escritos + 1, std::memory_order_release);
 }
+
 #pragma endregion
 
-#pragma region Função vc_gray_lowpass_gaussian_filter
+#pragma region Função: esvaziarEventos
 /**
- * Função: vc_gray_lowpass_gaussian_filter
- * ---------------------------------------
- * Aplica um filtro gaussiano de baixa passagem a uma imagem em tons de cinza.
- * O filtro gaussiano suaviza a imagem, reduzindo o ruído.
- *
- * Parâmetros:
- *   src - imagem de entrada (grayscale, 1 canal)
- *   dst - imagem de saída (grayscale, 1 canal)
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ * @brief Espera que a thread de eventos escreva todos os eventos já registados (antes dos resumos no terminal).
  */
-int vc_gray_lowpass_gaussian_filter(IVC* src, IVC* dst)
+void esvaziarEventos(void)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y, kx, ky;
-	int offset = (5 - 1) / 2;  // Kernel radius (for 5x5 kernel)
-	long int pos, kpos;
-	float sum;
-
-	// Gaussian kernel values (1D) - corrected from the image
-	float gaussarray[5] = { 0.054f, 0.242f, 0.399f, 0.242f, 0.054f };
-
-	// Error checking
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
-		return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels))
-		return 0;
-	if (channels != 1)
-		return 0;
+	if (!eventos.ativo.load()) return;
 
-	for (y = offset; y < height - offset; y++)
+	while (eventos.lidos.load(std::memory_order_acquire) != eventos.escritos.load(std::memory_order_relaxed))
 	{
-		for (x = offset; x < width - offset; x++)
-		{
-			sum = 0.0f;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	fflush(stdout);
+}
 
+#pragma endregion
 
-			for (ky = -offset; ky <= offset; ky++)
-			{
-				for (kx = -offset; kx <= offset; kx++)
-				{
-					kpos = (y + ky) * bytesperline + (x + kx) * channels;
-					sum += ((float)datasrc[kpos]) * gaussarray[kx + offset] * gaussarray[ky + offset];
-				}
-			}
+#pragma region Função: fecharEventos
+/**
+ * @brief Escreve os eventos que faltam, termina a thread de eventos e fecha o ficheiro de eventos.
+ */
+void fecharEventos(void)
+{
+	if (!eventos.ativo.load()) return;
 
-			// Store result (no need for normalization as kernel is pre-normalized)
-			pos = y * bytesperline + x * channels;
-			datadst[pos] = (unsigned char)sum;
-		}
+	eventos.terminar.store(true, std::memory_order_release);
+	eventos.thread.join();
+	eventos.ativo = false;
+
+	if (eventos.ficheiro != NULL)
+	{
+		fclose(eventos.ficheiro);
+		eventos.ficheiro = NULL;
 	}
 
-	return 1;
+	if (eventos.ndescartados > 0)
+	{
+		printf("\n\t\t\t\t\t\t\tEventos descartados (anel cheio): %ld\n", eventos.ndescartados);
+	}
 }
-#pragma endregion
 
-#pragma region Função vc_gray_highpass_filter
-/**
- * Função: vc_gray_highpass_filter
- * -------------------------------
- * Aplica um filtro passa-alto a uma imagem em tons de cinza.
- * O filtro passa-alto realça os contornos e detalhes da imagem.
+#pragma endregion
+
+#pragma region Função: lerCenario
+// Cenários predefinidos do vídeo sintético (ver lerCenario)
+static const CENARIO cenariosSinteticos[] = {
+	// nome			largura	altura	frames	velocidade	densidade	encostadas	ruido	distratores	semente
+	{ "base",		1280,	720,	600,	8.0f,		3.0f,		0,			0.0f,	0,			1 },
+	{ "rapido",		1280,	720,	600,	24.0f,		3.0f,		0,			0.0f,	0,			2 },
+	{ "denso",		1280,	720,	600,	8.0f,		8.0f,		0,			0.0f,	0,			3 },
+	{ "encostadas",	1280,	720,	600,	8.0f,		4.0f,		30,			0.0f,	0,			4 },
+	{ "ruido",		1280,	720,	600,	8.0f,		3.0f,		0,			6.0f,	0,			5 },
+	{ "estresse",	1280,	720,	300,	8.0f,		3.0f,		0,			4.0f,	200,		6 },
+	{ "4k",			3840,	2160,	200,	16.0f,		30.0f,		0,			4.0f,	0,			7 },
+};
+
+#define NCENARIOS_SINTETICOS	((int)(sizeof(cenariosSinteticos) / sizeof(cenariosSinteticos[0])))
+
+/**
+ * @brief Lê a descrição de um cenário do vídeo sintético.
  *
- * Parâmetros:
- *   src - imagem de entrada (grayscale, 1 canal)
- *   dst - imagem de saída (grayscale, 1 canal)
+ * A descrição é o nome de um cenário predefinido (base, rapido, denso, encostadas, ruido, estresse
+ * ou 4k), opcionalmente seguido de alterações `chave=valor` separadas por vírgulas, por exemplo
+ * `denso,ruido=8,resolucao=1920x1080`. Chaves: resolucao (LxA), frames, velocidade (píxeis por
+ * frame), densidade (moedas visíveis por frame, em média), encostadas (percentagem de moedas
+ * lançadas encostadas a outra), ruido (desvio-padrão em níveis), distratores (blobs pequenos por
+ * frame) e semente.
  *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
+ * @param texto Descrição do cenário.
+ * @param cenario Cenário a preencher.
+ *
+ * @return 1 se a descrição é válida; 0 caso contrário.
  */
-int vc_gray_highpass_filter(IVC* src, IVC* dst)
+int lerCenario(const char* texto, CENARIO* cenario)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y;
-	long int posX, posA, posB, posC, posD, posE, posF, posG, posH;
-	int sum;
+	char copia[256];
+	char* parte;
+	int i;
 
-	// Verificação de erros
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
-	if (channels != 1) return 0;
+	strncpy(copia, texto, sizeof(copia) - 1);
+	copia[sizeof(copia) - 1] = '\0';
 
-	for (y = 1; y < height - 1; y++)
+	// Cenário predefinido
+	parte = strtok(copia, ",");
+	if (parte == NULL) return 0;
+
+	for (i = 0; i < NCENARIOS_SINTETICOS; i++)
 	{
-		for (x = 1; x < width - 1; x++)
-		{
-			posX = y * bytesperline + x * channels;
+		if (strcmp(parte, cenariosSinteticos[i].nome) == 0) break;
+	}
+	if (i == NCENARIOS_SINTETICOS) return 0;
 
-			posA = (y - 1) * bytesperline + (x - 1) * channels;
-			posB = (y - 1) * bytesperline + x * channels;
-			posC = (y - 1) * bytesperline + (x + 1) * channels;
-			posD = y * bytesperline + (x - 1) * channels;
-			posE = y * bytesperline + (x + 1) * channels;
-			posF = (y + 1) * bytesperline + (x - 1) * channels;
-			posG = (y + 1) * bytesperline + x * channels;
-			posH = (y + 1) * bytesperline + (x + 1) * channels;
+	*cenario = cenariosSinteticos[i];
 
-			// Exemplo 3: kernel passa-alto 3x3 (realçado de contornos)
-			sum = datasrc[posA] * -1;
-			sum += datasrc[posB] * -1;
-			sum += datasrc[posC] * -1;
-			sum += datasrc[posD] * -1;
-			sum += datasrc[posE] * -1;
-			sum += datasrc[posF] * -1;
-			sum += datasrc[posG] * -1;
-			sum += datasrc[posH] * -1;
-			sum += datasrc[posX] * 8;
+	// Alterações chave=valor
+	while ((parte = strtok(NULL, ",")) != NULL)
+	{
+		char* valor = strchr(parte, '=');
+		if (valor == NULL) return 0;
+		*valor++ = '\0';
 
-			datadst[posX] = (unsigned char)((float)abs(sum) / (float)9 * 20); // normalização e escala
+		if (strcmp(parte, "resolucao") == 0)
+		{
+			if (sscanf(valor, "%dx%d", &cenario->width, &cenario->height) != 2) return 0;
 		}
+		else if (strcmp(parte, "frames") == 0) cenario->nframes = atoi(valor);
+		else if (strcmp(parte, "velocidade") == 0) cenario->velocidade = (float)atof(valor);
+		else if (strcmp(parte, "densidade") == 0) cenario->densidade = (float)atof(valor);
+		else if (strcmp(parte, "encostadas") == 0) cenario->encostadas = atoi(valor);
+		else if (strcmp(parte, "ruido") == 0) cenario->ruido = (float)atof(valor);
+		else if (strcmp(parte, "distratores") == 0) cenario->distratores = atoi(valor);
+		else if (strcmp(parte, "semente") == 0) cenario->semente = (unsigned int)atoi(valor);
+		else return 0;
 	}
 
+	// A linha de reconhecimento (a 1/4 da altura) tem de ficar abaixo de uma moeda de 2 euros inteira
+	if ((cenario->width < 256) || (cenario->height < 432) || (cenario->nframes <= 0)) return 0;
+	if ((cenario->velocidade <= 0.0f) || (cenario->densidade <= 0.0f) || (cenario->ruido < 0.0f)) return 0;
+	if ((cenario->encostadas < 0) || (cenario->encostadas > 100) || (cenario->distratores < 0)) return 0;
+
 	return 1;
 }
+
 #pragma endregion
 
-#pragma region Função vc_gray_highpass_filter_enhance
-/**
- * Função: vc_gray_highpass_filter_enhance
- * ---------------------------------------
- * Aplica um filtro passa-alto realçado a uma imagem em tons de cinza.
- * O filtro realça os contornos e detalhes da imagem, permitindo ajustar o ganho.
- *
- * Parâmetros:
- *   src  - imagem de entrada (grayscale, 1 canal)
- *   dst  - imagem de saída (grayscale, 1 canal)
- *   gain - fator de ganho para realçar os contornos
- *
- * Retorna:
- *   1 se a operação for bem-sucedida, 0 caso contrário.
- */
-int vc_gray_highpass_filter_enhance(IVC* src, IVC* dst, int gain)
+#pragma region Função: abrirGerador
+// Cores (B, G, R) das moedas sintéticas, com margem para o ruído dentro dos intervalos de segmentarMoedas
+// (um só píxel fora da máscara no interior da moeda chega para a abertura 9x9 com 3 iterações a cortar)
+static const unsigned char corCobre[3] = { 30, 80, 120 };		// 1, 2 e 5 cêntimos
+static const unsigned char corOuro[3] = { 35, 105, 125 };		// 10, 20 e 50 cêntimos (e anel de 1 e 2 euros)
+static const unsigned char corPrata[3] = { 70, 105, 110 };	// Centro de 1 e 2 euros
+static const unsigned char corFundo[3] = { 200, 200, 200 };	// Tapete (fora dos intervalos da segmentação)
+
+struct GERADOR {
+	CENARIO cenario;
+	int nframe;								// Próximo frame a gerar (0 = primeiro)
+	unsigned int estado;					// Gerador pseudoaleatório (xorshift32)
+	float acumulado;						// Moedas por lançar (fração acumulada)
+	float raio[MAX_MOEDAS];					// Raio calibrado de cada moeda da tabela (0 = moeda não gerada)
+	float entalhe[MAX_MOEDAS];				// Profundidade calibrada dos entalhes do bordo de cada moeda
+	int nmoedas;							// Número de moedas da tabela que podem ser geradas
+	std::vector<MOEDA_SINTETICA> moedas;	// Todas as moedas lançadas
+};
+
+// Número pseudoaleatório de 32 bits (xorshift32)
+static unsigned int aleatorio(GERADOR* g)
 {
-	unsigned char* datasrc = (unsigned char*)src->data;
-	unsigned char* datadst = (unsigned char*)dst->data;
-	int width = src->width;
-	int height = src->height;
-	int bytesperline = src->bytesperline;
-	int channels = src->channels;
-	int x, y;
-	long int posX, posA, posB, posC, posD, posE, posF, posG, posH;
-	int sum;
+	g->estado ^= g->estado << 13;
+	g->estado ^= g->estado >> 17;
+	g->estado ^= g->estado << 5;
+	return g->estado;
+}
 
-	// Verificação de erros
-	if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
-	if ((src->width != dst->width) || (src->height != dst->height) || (src->channels != dst->channels)) return 0;
-	if (channels != 1) return 0;
+// Número pseudoaleatório uniforme em [0, 1)
+static float aleatorioUniforme(GERADOR* g)
+{
+	return (float)(aleatorio(g) >> 8) / 16777216.0f;
+}
 
-	for (y = 1; y < height - 1; y++)
+// Centro da moeda no frame nframe (0 = primeiro)
+static float yMoeda(const GERADOR* g, const MOEDA_SINTETICA* m, int nframe)
+{
+	return m->y0 + g->cenario.velocidade * (float)nframe;
+}
+
+// Entalhes radiais (serrilha) no bordo das moedas sintéticas, com 2 píxeis de largura: os dentes entre
+// eles têm de ser mais largos do que o elemento estruturante de segmentarMoedas, senão a abertura corta-os
+#define DENTE_ENTALHES 36.0f
+#define ENTALHE_MAX 16.0f
+
+// Desenha um disco (ou o anel entre raioInterior e raio) com a cor dada, com entalhes de profundidade
+// entalhe no bordo, em número múltiplo de 4 e desencontrados dos eixos (não alteram a bounding box)
+static void desenharDisco(cv::Mat& frame, float cx, float cy, float raio, float raioInterior, float entalhe, const unsigned char* cor)
+{
+	int nentalhes = 4 * MAX((int)(2.0f * 3.14159265f * raio / (4.0f * DENTE_ENTALHES)), 1);
+	float passo = 2.0f * 3.14159265f / (float)nentalhes;
+	float raioEntalhe = raio - entalhe;
+
+	int y0 = MAX((int)ceilf(cy - raio), 0);
+	int y1 = MIN((int)floorf(cy + raio), frame.rows - 1);
+
+	for (int y = y0; y <= y1; y++)
 	{
-		for (x = 1; x < width - 1; x++)
+		float dy = (float)y - cy;
+		float dx = sqrtf(MAX(raio * raio - dy * dy, 0.0f));
+		float dxi = (raioInterior * raioInterior > dy * dy) ? sqrtf(raioInterior * raioInterior - dy * dy) : -1.0f;
+		int x0 = MAX((int)ceilf(cx - dx), 0);
+		int x1 = MIN((int)floorf(cx + dx), frame.cols - 1);
+		unsigned char* linha = frame.ptr<unsigned char>(y);
+
+		for (int x = x0; x <= x1; x++)
 		{
-			posX = y * bytesperline + x * channels;
+			// Dentro do raio interior (anel): píxel não desenhado
+			if ((dxi >= 0.0f) && (fabsf((float)x - cx) <= dxi)) continue;
 
-			posA = (y - 1) * bytesperline + (x - 1) * channels;
-			posB = (y - 1) * bytesperline + x * channels;
-			posC = (y - 1) * bytesperline + (x + 1) * channels;
-			posD = y * bytesperline + (x - 1) * channels;
-			posE = y * bytesperline + (x + 1) * channels;
-			posF = (y + 1) * bytesperline + (x - 1) * channels;
-			posG = (y + 1) * bytesperline + x * channels;
-			posH = (y + 1) * bytesperline + (x + 1) * channels;
+			// Dentro de um entalhe: píxel não desenhado
+			float ex = (float)x - cx;
+			if ((entalhe > 0.0f) && (ex * ex + dy * dy > raioEntalhe * raioEntalhe))
+			{
+				float angulo = atan2f(dy, ex);
+				float delta = angulo - passo * (floorf(angulo / passo) + 0.5f);
+				if (sqrtf(ex * ex + dy * dy) * fabsf(sinf(delta)) < 1.0f) continue;
+			}
 
-			// Exemplo 3: kernel passa-alto 3x3 (realçado de contornos)
-			sum = datasrc[posA] * -1;
-			sum += datasrc[posB] * -1;
-			sum += datasrc[posC] * -1;
-			sum += datasrc[posD] * -1;
-			sum += datasrc[posE] * -1;
-			sum += datasrc[posF] * -1;
-			sum += datasrc[posG] * -1;
-			sum += datasrc[posH] * -1;
-			sum += datasrc[posX] * 8;
+			linha[3 * x + 0] = cor[0];
+			linha[3 * x + 1] = cor[1];
+			linha[3 * x + 2] = cor[2];
+		}
+	}
+}
 
-			datadst[posX] = (unsigned char)MIN(MAX((float)datasrc[posX] + ((float)sum / 16.0f * (float)gain), 0), 255);
+// Desenha uma moeda da tabela: cobre até 5 cêntimos, ouro até 50 cêntimos e bimetálica acima
+static void desenharMoeda(cv::Mat& frame, int tipo, float cx, float cy, float raio, float entalhe)
+{
+	int valor = tabelaMoedas.valor[tipo];
 
-		}
+	if (valor < 10)
+	{
+		desenharDisco(frame, cx, cy, raio, 0.0f, entalhe, corCobre);
+	}
+	else if (valor < 100)
+	{
+		desenharDisco(frame, cx, cy, raio, 0.0f, entalhe, corOuro);
+	}
+	else
+	{
+		desenharDisco(frame, cx, cy, raio, 0.7f * raio, entalhe, corOuro);
+		desenharDisco(frame, cx, cy, 0.7f * raio, 0.0f, 0.0f, corPrata);
 	}
+}
 
-	return 1;
+// Preenche o frame com o tapete
+static void desenharFundo(cv::Mat& frame)
+{
+	frame.setTo(cv::Scalar(corFundo[0], corFundo[1], corFundo[2]));
 }
-#pragma endregion
 
-//**************************************//
-// 										//
-//  Trabalho Visão por Computador		//
-//  2024/2025							//
-//										//
-//  Fernando Salgueiro		nº 39		//
-//  Hugo Lopes				nº 30516	//
-//  Claudio Fernandes		nº 30517	//
-//  Nuno Cruz				nº 30518	//
-//										//
-//**************************************//
+// Classificação de uma moeda isolada com o diâmetro e os entalhes dados (centro deslocado de desvio píxeis),
+// pelo mesmo processamento dos frames (segmentação, etiquetagem e cascata de avaliação);
+// em perimetro (se não for NULL) fica o perímetro medido (0 se a moeda não chegar a ser medida)
+static int classificarSintetica(int tipo, float diametro, float entalhe, float desvio, int* perimetro)
+{
+	int lado = (int)diametro + 96;
+	cv::Mat frame(lado, lado, CV_8UC3);
+	IVC* mascara = vc_image_new(lado, lado, 1, 255);
+	int nblobs = 0, valor = -1;
 
-OVC passou[500];
-int cont = 0;
+	desenharFundo(frame);
+	desenharMoeda(frame, tipo, lado / 2 + desvio, lado / 2 + desvio, diametro / 2.0f, entalhe);
+
+	segmentarMoedas(frame, mascara, 9);
+	OVC* blobs = etiquetarMoedas(mascara, lado / 2, &nblobs);
+
+	if (perimetro != NULL) *perimetro = 0;
+	if ((nblobs == 1) && (blobs[0].estado & ETAPA_PERIMETRO))
+	{
+		if (perimetro != NULL) *perimetro = blobs[0].perimetro;
+		valor = tipoMoedas(blobs[0].perimetro, blobs[0].area, blobs[0].circularidade, blobs[0].diametro);
+	}
+
+	free(blobs);
+	vc_image_free(mascara);
+
+	return valor;
+}
 
-#pragma region Função: escolherVideo
 /**
- * @brief Permite ao utilizador escolher um vídeo a partir de uma lista de opções apresentadas no terminal.
+ * @brief Abre o gerador de um vídeo sintético com moedas de verdade conhecida.
  *
- * A função apresenta um menu com 3 opções:
- * - Opção 1: Seleciona "video1.mp4" (12 moedas);
- * - Opção 2: Seleciona "video2.mp4" (29 moedas);
- * - Opção 0: Sai do programa.
+ * As moedas da tabela (`tabelaMoedas`) são desenhadas como discos (bimetálicos a partir de 1 euro)
+ * com entalhes no bordo, que descem pelo frame a velocidade constante. Cada moeda é calibrada no arranque,
+ * com uma moeda isolada processada como os frames do vídeo (segmentação, etiquetagem e cascata):
+ * - os entalhes fazem de serrilha: a profundidade escolhida é a que, no diâmetro central da tabela,
+ *   põe o perímetro medido mais perto do centro do intervalo de perímetros, de preferência com a moeda
+ *   já classificada (um disco liso fica abaixo dos perímetros empíricos, medidos em moedas reais com
+ *   o bordo irregular);
+ * - o diâmetro é o centro do maior intervalo de diâmetros (passo de 0,5 píxeis) em que a moeda
+ *   é classificada como ela própria com vários desvios sub-píxel do centro.
  *
- * Se o utilizador escolher uma opção inválida, o menu é repetido até uma opção válida ser selecionada.
- * O nome do ficheiro escolhido é copiado para a variável `videofile`.
+ * As moedas sem nenhum diâmetro válido não são geradas.
  *
- * @param videofile Ponteiro para a string onde será armazenado o nome do vídeo escolhido.
+ * @param cenario Cenário (ver `lerCenario`).
  *
- * @return Retorna 1 se a escolha for válida; retorna 0 se o utilizador optar por sair.
+ * @return O gerador, ou NULL se nenhuma moeda da tabela puder ser gerada.
  */
-int escolherVideo(char* videofile)
+GERADOR* abrirGerador(const CENARIO* cenario)
 {
-	// Exibe cabeçalho institucional e informações sobre o trabalho
-	printf("\t_________________________________________________________________________________________________________________________________________\n\n");
-	printf("\t\t\t\t\t\t\tIPCA\n\n");
-	printf("\t\t\t\t\t\t\tEscola Superior de Tecnologia\n\n");
-	printf("\t\t\t\t\t\t\tEngenharia de Sistemas Informáticos PL\n");
-	printf("\t\t\t\t\t\t\t2024/2025\n\n");
-	printf("\t\t\t\t\t\t\tVisão por Computador\n");
-	printf("\t\t\t\t\t\t\tTrabalho Prático:\n");
-	printf("\t\t\t\t\t\t\tPermite a quantificação automática de dinheiro em vídeos.\n\n");
-	printf("\t__________________________________________________________________________________________________________________________________________\n");
+	static const float desvios[3] = { 0.0f, 0.25f, 0.5f };
+	GERADOR* g = new GERADOR();
+	CASCATA copia = cascata;
 
-	int escolha = -1;
+	g->cenario = *cenario;
+	g->estado = cenario->semente ? cenario->semente : 1;
 
-	// Ciclo até o utilizador escolher uma opção válida (1, 2 ou 0)
-	while ((escolha != 0) && (escolha != 1) && (escolha != 2))
+	for (int tipo = 0; tipo < tabelaMoedas.n; tipo++)
 	{
-		// Exibição do menu de opções
-		printf("\n\n\t\t\t\t\t\t\tEscolha um vídeo : \n\n");
-		printf("\t\t\t\t\t\t\t\tOpção 1 -> Vídeo 1 (12 Moedas)\n\n");
-		printf("\t\t\t\t\t\t\t\tOpção 2 -> Vídeo 2 (29 Moedas)\n\n");
-		printf("\t\t\t\t\t\t\t\tOpção 0 -> Sair\n\n");
-		printf("\t\t\t\t\t\t\tInsira a sua opção: ");
-
-		// Recebe a opção do utilizador
-		scanf("%d", &escolha);
+		int melhorInicio = -1, melhorN = 0, inicio = -1;
+		int n = (int)(2.0f * (tabelaMoedas.diamMax[tipo] - tabelaMoedas.diamMin[tipo] + 16.0f)) + 1;
+		float centro = 0.5f * (float)(tabelaMoedas.perimMin[tipo] + tabelaMoedas.perimMax[tipo]);
+		float melhorErro = -1.0f;
 
-		// Atribuição do nome do vídeo com base na escolha
-		if (escolha == 1)
+		// Profundidade dos entalhes (o perímetro cresce com ela, quase sem mudar a área e o diâmetro)
+		for (float entalhe = 0.0f; entalhe <= ENTALHE_MAX; entalhe += 0.5f)
 		{
-			strcpy(videofile, "video1.mp4");
+			int perimetro;
+			int valor = classificarSintetica(tipo, 0.5f * (float)(tabelaMoedas.diamMin[tipo] + tabelaMoedas.diamMax[tipo]) + 1.0f, entalhe, 0.0f, &perimetro);
+
+			// Preferidas as profundidades em que a moeda já é classificada como ela própria
+			float erro = fabsf((float)perimetro - centro) + ((valor == tabelaMoedas.valor[tipo]) ? 0.0f : 100000.0f);
+			if (perimetro > 0 && (melhorErro < 0.0f || erro < melhorErro))
+			{
+				melhorErro = erro;
+				g->entalhe[tipo] = entalhe;
+			}
 		}
-		else if (escolha == 2)
+
+		for (int i = 0; i <= n; i++)
 		{
-			strcpy(videofile, "video2.mp4");
+			float diametro = tabelaMoedas.diamMin[tipo] - 8.0f + 0.5f * (float)i;
+			int valido = (i < n);
+
+			for (int d = 0; valido && d < 3; d++)
+			{
+				valido = (classificarSintetica(tipo, diametro, g->entalhe[tipo], desvios[d], NULL) == tabelaMoedas.valor[tipo]);
+			}
+
+			if (valido && inicio < 0) inicio = i;
+			if (!valido && inicio >= 0)
+			{
+				if (i - inicio > melhorN)
+				{
+					melhorInicio = inicio;
+					melhorN = i - inicio;
+				}
+				inicio = -1;
+			}
 		}
-		else if (escolha == 0)
+
+		if (melhorN > 0)
 		{
-			// Se escolher sair, limpa o ecrã e retorna 0
-			printf("\n A fechar o programa...\n\n");
-			system("cls");
-			return 0;
+			g->raio[tipo] = (tabelaMoedas.diamMin[tipo] - 8.0f + 0.5f * (float)(2 * melhorInicio + melhorN - 1) / 2.0f) / 2.0f;
+			g->nmoedas++;
 		}
 		else
 		{
-			// Opção inválida: limpar ecrã e mostrar mensagem de erro
-			system("cls");
-			printf("\nOpção errada!\n\n");
-			printf("Tente novamente!\n\n");
+			fprintf(stderr, "Moeda de %d cêntimos sem diâmetro classificável: não é gerada.\n", tabelaMoedas.valor[tipo]);
 		}
 	}
 
-	// Retorna 1 indicando uma escolha válida
-	return 1;
+	// A calibração não conta na avaliação dos blobs
+	cascata = copia;
+
+	if (g->nmoedas == 0)
+	{
+		delete g;
+		return NULL;
+	}
+
+	return g;
 }
 
 #pragma endregion
 
-#pragma region Função: filtrarMoedas
-/**
- * @brief Filtra as moedas na imagem fornecida, utilizando segmentação em HSV e morfologia matemática.
- *
- * Esta função realiza a conversão da imagem BGR para RGB, seguida da conversão para HSV.
- * Depois realiza duas segmentações HSV em diferentes faixas de cor (para capturar diferentes tipos de moedas).
- * As duas segmentações são somadas, aplica-se uma operação morfológica de abertura para limpar ruído.
- * Após isso, realiza a etiquetagem dos blobs encontrados e analisa cada blob, contando e desenhando apenas moedas que passem na linha de reconhecimento.
- * Aplica ainda verificações adicionais de área, perímetro, circularidade e evita duplicação de contagem com base em uma lista de objetos já detetados.
- *
- * @param frame Imagem de entrada (BGR), será também utilizada para desenhar as anotações.
- * @param soma Ponteiro para a variável que armazena a soma do valor das moedas detetadas.
- * @param total Ponteiro para o array que armazena a contagem de moedas por tipo.
- */
-void filtrarMoedas(cv::Mat& frame, float* soma, int* total)
+#pragma region Função: gerarFrame
+// Verifica se um disco no frame nframe fica a menos de folga píxeis de alguma moeda já lançada
+static int moedaSobreposta(GERADOR* g, float x, float y, float raio, float folga, int nframe)
 {
-	int nlabels = 0; // Número de blobs encontrados após etiquetagem
+	for (const MOEDA_SINTETICA& m : g->moedas)
+	{
+		float dx = m.x - x;
+		float dy = yMoeda(g, &m, nframe) - y;
+		float d = m.raio + raio + folga;
 
-	// Alocação de imagens IVC intermediárias
-	IVC* imagem = vc_image_new(frame.cols, frame.rows, frame.channels(), 255);
-	IVC* hsv = vc_image_new(frame.cols, frame.rows, 3, 255);
-	IVC* binaria = vc_image_new(frame.cols, frame.rows, 1, 255);
-	IVC* binaria2 = vc_image_new(frame.cols, frame.rows, 1, 255);
-	IVC* binaria3 = vc_image_new(frame.cols, frame.rows, 1, 255);
+		if (dx * dx + dy * dy < d * d) return 1;
+	}
 
-	// Conversão de BGR (OpenCV) para RGB (IVC)
-	bgr_to_rgb(frame, imagem);
+	return 0;
+}
+
+// Escolhe uma moeda da tabela com diâmetro calibrado
+static int sortearMoeda(GERADOR* g)
+{
+	int k = (int)(aleatorio(g) % (unsigned int)g->nmoedas);
+
+	for (int tipo = 0; tipo < tabelaMoedas.n; tipo++)
+	{
+		if (g->raio[tipo] > 0.0f && k-- == 0) return tipo;
+	}
+
+	return 0;
+}
+
+// Acrescenta uma moeda com o centro (x, y) no frame nframe
+static void lancarMoeda(GERADOR* g, int tipo, float x, float y, int nframe)
+{
+	MOEDA_SINTETICA m;
+	int linha = g->cenario.height / 4;
+
+	m.id = (int)g->moedas.size() + 1;
+	m.tipo = tipo;
+	m.raio = g->raio[tipo];
+	m.x = x;
+	m.y0 = y - g->cenario.velocidade * (float)nframe;
+
+	// Primeiro frame (a contar de 1) com o centro na linha de reconhecimento ou abaixo
+	m.nframeLinha = (int)ceilf(((float)linha - m.y0) / g->cenario.velocidade) + 1;
+
+	g->moedas.push_back(m);
+}
+
+// Lança as moedas do frame nframe, acima do frame, sem sobreposição (exceto as encostadas de propósito)
+static void lancarMoedas(GERADOR* g, int nframe)
+{
+	const CENARIO* c = &g->cenario;
+	float raioMax = 0.0f;
 
-	// Conversão de RGB para HSV
-	vc_rgb_to_hsv(imagem, hsv);
+	for (int tipo = 0; tipo < tabelaMoedas.n; tipo++) raioMax = MAX(raioMax, g->raio[tipo]);
 
-	// Segmentação para moedas amarelas
-	vc_hsv_segmentation(hsv, binaria, 12, 150, 35, 255, 20, 150);
+	// Moedas por frame para manter, em média, `densidade` moedas visíveis
+	g->acumulado += c->densidade * c->velocidade / ((float)c->height + 2.0f * raioMax);
 
-	// Segmentação para moedas castanhas
-	vc_hsv_segmentation(hsv, binaria2, 12, 150, 0, 80, 20, 130);
+	// Só são lançadas as moedas que passam a linha com folga antes do último frame (verdade sem ambiguidade)
+	int ultimo = c->nframes - (int)ceilf(32.0f / c->velocidade) - 1;
 
-	// Combinação das duas máscaras numa imagem binária final
-	somarImagens(binaria, binaria2, binaria3);
+	while (g->acumulado >= 1.0f)
+	{
+		int tipo = sortearMoeda(g);
+		float raio = g->raio[tipo];
+		float y = -raio - 1.0f;
+		int lancada = 0;
 
-	// Conversão da IVC para Mat para aplicar morfologia com OpenCV
-	cv::Mat bin_mat3(binaria3->height, binaria3->width, CV_8UC1, binaria3->data);
+		if ((float)nframe + ((float)(c->height / 4) - y) / c->velocidade >= (float)ultimo) return;
 
-	// Aplicação da abertura morfológica (remove ruídos e pequenos objetos)
-	cv::Mat limpa;
-	cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(9, 9));
-	cv::morphologyEx(bin_mat3, limpa, cv::MORPH_OPEN, kernel, cv::Point(-1, -1), 3);
+		for (int tentativa = 0; tentativa < 10 && !lancada; tentativa++)
+		{
+			float x = raio + 2.0f + aleatorioUniforme(g) * ((float)c->width - 2.0f * raio - 5.0f);
 
-	// Copiar o resultado da operação morfológica de volta para a IVC
-	memcpy(binaria3->data, limpa.data, binaria3->width * binaria3->height);
+			if (moedaSobreposta(g, x, y, raio, 4.0f, nframe)) continue;
 
-	// Etiquetagem dos blobs encontrados na imagem binária
-	OVC* blobs = vc_binary_blob_labelling(binaria3, binaria3, &nlabels);
+			// Segunda moeda encostada à direita (distância entre centros igual à soma dos raios)
+			int outra = -1;
+			float x2 = 0.0f;
 
-	// Desenhar a linha de reconhecimento (auxiliar visual)
-	linhaReconhecimento(frame);
+			if ((int)(aleatorio(g) % 100) < c->encostadas)
+			{
+				outra = sortearMoeda(g);
+				x2 = x + raio + g->raio[outra];
 
-	// Calcula área, perímetro, centroide, etc. de cada blob
-	vc_binary_blob_info(binaria3, blobs, nlabels);
+				if ((x2 + g->raio[outra] + 3.0f >= (float)c->width) || moedaSobreposta(g, x2, y, g->raio[outra], 4.0f, nframe)) outra = -1;
+			}
 
-	// Ciclo para processar cada blob encontrado
-	for (int i = 0; i < nlabels; i++)
-	{
-		int cx = blobs[i].xc;
-		int cy = blobs[i].yc;
+			lancarMoeda(g, tipo, x, y, nframe);
+			if (outra >= 0) lancarMoeda(g, outra, x2, y, nframe);
+			lancada = 1;
+		}
 
-		// Verificar se o centro está dentro dos limites da imagem
-		if (cx < 0 || cx >= frame.cols || cy < 0 || cy >= frame.rows) continue;
+		// Sem espaço: tenta no frame seguinte
+		if (!lancada) return;
 
-		// Desenhar caixa ao redor do blob
-		desenhaBox(frame, blobs[i]);
+		g->acumulado -= 1.0f;
+	}
+}
 
-		// Verificar se a moeda cruza a linha de reconhecimento (com tolerância)
-		if (frame.rows / 4 >= blobs[i].yc - 12 && frame.rows / 4 <= blobs[i].yc + 9)
-		{
-			// Filtrar por área e perímetro mínimos esperados
-			if (blobs[i].area < 10000 || blobs[i].perimetro < 300) continue;
+// Desenha os distratores do frame: quadrados pequenos (que sobrevivem à abertura, mas nunca têm a
+// área de uma moeda), um por célula de 64x64 píxeis livre de moedas, para não se juntarem
+static void desenharDistratores(GERADOR* g, cv::Mat& frame, int nframe)
+{
+	const int celula = 64;
+	int ncolunas = frame.cols / celula, nlinhas = frame.rows / celula;
+	std::vector<unsigned char> ocupada(ncolunas * nlinhas, 0);
 
-			// Escrever aviso de moeda detetada no frame
-			escreveMoedaDetetada(frame);
+	for (const MOEDA_SINTETICA& m : g->moedas)
+	{
+		float y = yMoeda(g, &m, nframe);
 
-			// Verifica se a moeda já foi contada (evitar duplicação)
-			if (verificaRepeticao(passou, blobs[i], cont) == 1)
+		for (int cy = MAX((int)((y - m.raio - 8.0f) / celula), 0); cy <= MIN((int)((y + m.raio + 8.0f) / celula), nlinhas - 1); cy++)
+		{
+			for (int cx = MAX((int)((m.x - m.raio - 8.0f) / celula), 0); cx <= MIN((int)((m.x + m.raio + 8.0f) / celula), ncolunas - 1); cx++)
 			{
-				// Conta e acumula a moeda
-				contarMoeda(frame, blobs[i], soma, total);
-				// Regista o blob no histórico para evitar contar novamente
-				passou[cont++] = blobs[i];
+				if (y + m.raio + 8.0f >= 0.0f) ocupada[cy * ncolunas + cx] = 1;
 			}
 		}
 	}
 
-	// Libertação da memória
-	free(blobs);
-	vc_image_free(imagem);
-	vc_image_free(hsv);
-	vc_image_free(binaria);
-	vc_image_free(binaria2);
-	vc_image_free(binaria3);
+	for (int i = 0, tentativas = 0; i < g->cenario.distratores && tentativas < 4 * g->cenario.distratores; tentativas++)
+	{
+		int c = (int)(aleatorio(g) % (unsigned int)(ncolunas * nlinhas));
+		if (ocupada[c]) continue;
+		ocupada[c] = 1;
+
+		int lado = 28 + (int)(aleatorio(g) % 17);
+		int x0 = (c % ncolunas) * celula + 8 + (int)(aleatorio(g) % (unsigned int)(celula - 16 - lado + 1));
+		int y0 = (c / ncolunas) * celula + 8 + (int)(aleatorio(g) % (unsigned int)(celula - 16 - lado + 1));
+
+		frame(cv::Rect(x0, y0, lado, lado)).setTo((aleatorio(g) & 1) ? cv::Scalar(corOuro[0], corOuro[1], corOuro[2]) : cv::Scalar(corCobre[0], corCobre[1], corCobre[2]));
+		i++;
+	}
 }
 
+// Soma ruído gaussiano (aproximado pela soma de quatro uniformes) a todos os bytes do frame
+static void somarRuido(GERADOR* g, cv::Mat& frame)
+{
+	float escala = g->cenario.ruido * 1.7320508f / 256.0f;		// A soma de quatro bytes uniformes tem desvio-padrão 256 / sqrt(3)
 
-#pragma endregion
+	for (int y = 0; y < frame.rows; y++)
+	{
+		unsigned char* linha = frame.ptr<unsigned char>(y);
+
+		for (int x = 0; x < frame.cols * 3; x++)
+		{
+			unsigned int a = aleatorio(g), b = aleatorio(g);
+			int soma = (int)(a & 0xFF) + (int)(a >> 24) + (int)(b & 0xFF) + (int)(b >> 24) - 510;
+			int v = linha[x] + (int)lrintf((float)soma * escala);
+
+			linha[x] = (unsigned char)MIN(MAX(v, 0), 255);
+		}
+	}
+}
 
-#pragma region Função: bgr_to_rgb
 /**
- * @brief Converte uma imagem no formato BGR (padrão do OpenCV) para o formato RGB,
- * armazenando o resultado numa estrutura de imagem IVC.
+ * @brief Gera o próximo frame do vídeo sintético (BGR).
  *
- * Esta função converte uma imagem OpenCV (`cv::Mat`) que está no espaço de cor BGR
- * para RGB, e depois copia os dados linha a linha para a estrutura `IVC`.
- * Esta conversão é necessária porque a biblioteca OpenCV utiliza BGR por padrão,
- * enquanto o processamento na framework IVC utiliza RGB.
+ * Lança as moedas novas acima do frame, desenha o tapete, as moedas visíveis, os distratores e o ruído.
  *
- * @param imagemEntrada Imagem de entrada do OpenCV em BGR (tipo `cv::Mat`).
- * @param imagemSaida Apontador para a estrutura `IVC` previamente alocada onde será armazenada a imagem convertida em RGB.
+ * @param g Gerador (ver `abrirGerador`).
+ * @param frame Frame de saída (alocado com a resolução do cenário, se necessário).
  *
- * @return Retorna 1 se a conversão foi realizada com sucesso, ou 0 em caso de erro (parâmetros inválidos, dimensões incompatíveis, etc.).
+ * @return O número do frame gerado (a contar de 1), ou 0 depois do último frame do cenário.
  */
-int bgr_to_rgb(const cv::Mat& imagemEntrada, IVC* imagemSaida)
+int gerarFrame(GERADOR* g, cv::Mat& frame)
 {
-	// Verificar se a imagem de entrada está vazia ou se a imagem de saída é nula
-	if (imagemEntrada.empty() || imagemSaida == nullptr)
-		return 0;
-
-	// Verificar se ambas as imagens possuem 3 canais (BGR e RGB)
-	if (imagemEntrada.channels() != 3 || imagemSaida->channels != 3)
-		return 0;
+	int nframe = g->nframe;
 
-	// Criação de uma nova imagem RGB temporária usando OpenCV
-	cv::Mat imagemRGB;
-	cv::cvtColor(imagemEntrada, imagemRGB, cv::COLOR_BGR2RGB);
+	if (nframe >= g->cenario.nframes) return 0;
 
-	// Validar se as dimensões da imagem convertida coincidem com a estrutura de saída
-	if (imagemRGB.cols != imagemSaida->width || imagemRGB.rows != imagemSaida->height)
-		return 0;
+	frame.create(g->cenario.height, g->cenario.width, CV_8UC3);
 
-	// Obter o número de bytes por linha na estrutura IVC
-	int bytesPerLine = imagemSaida->bytesperline;
+	lancarMoedas(g, nframe);
 
-	// Percorrer todas as linhas da imagem
-	for (int y = 0; y < imagemRGB.rows; y++)
+	desenharFundo(frame);
+	for (const MOEDA_SINTETICA& m : g->moedas)
 	{
-		// Ponteiro para a linha atual na imagem OpenCV (RGB)
-		const cv::Vec3b* linha = imagemRGB.ptr<cv::Vec3b>(y);
-
-		// Ponteiro para a linha correspondente na imagem de saída IVC
-		unsigned char* linhaSaida = imagemSaida->data + y * bytesPerLine;
+		float y = yMoeda(g, &m, nframe);
 
-		// Percorrer todos os píxeis da linha
-		for (int x = 0; x < imagemRGB.cols; x++)
-		{
-			// Copiar cada componente RGB para a estrutura IVC
-			linhaSaida[x * 3] = linha[x][0]; // R
-			linhaSaida[x * 3 + 1] = linha[x][1]; // G
-			linhaSaida[x * 3 + 2] = linha[x][2]; // B
-		}
+		if ((y + m.raio >= 0.0f) && (y - m.raio < (float)frame.rows)) desenharMoeda(frame, m.tipo, m.x, y, m.raio, g->entalhe[m.tipo]);
 	}
 
-	// Retorna 1 indicando sucesso
-	return 1;
+	if (g->cenario.distratores > 0) desenharDistratores(g, frame, nframe);
+	if (g->cenario.ruido > 0.0f) somarRuido(g, frame);
+
+	g->nframe++;
+
+	return g->nframe;
 }
 
 #pragma endregion
 
-#pragma region Função: tipoMoedas
-
+#pragma region Função: verdadeGerador
 /**
- * @brief Determina o tipo de moeda (valor em centavos) com base em várias características geométricas.
- *
- * Esta função utiliza as características calculadas do blob, nomeadamente o perímetro, área, circularidade e diâmetro.
- * Utiliza limites empíricos definidos para cada moeda de euro, verificando se o blob analisado cumpre os requisitos de cada tipo.
- * Caso cumpra, retorna o valor da moeda em centavos (ex: 200 para 2€, 50 para 0.50€, etc.).
+ * @brief Contagens esperadas: moedas cujo centro chegou à linha de reconhecimento nos frames já gerados.
  *
- * Caso o blob não corresponda a nenhum dos tipos definidos, retorna -1.
- *
- * @param perimetro Valor do perímetro do blob.
- * @param area Valor da área do blob.
- * @param circ Valor da circularidade do blob.
- * @param diametro Estimativa do diâmetro da moeda calculado a partir da bounding box.
+ * @param gerador Gerador.
+ * @param total Array de 9 contagens (por índice da tabela, 0 a 7, e total geral em 8), como em `contarMoeda`.
+ * @param centimos Valor total esperado em cêntimos.
  *
- * @return Valor da moeda em centavos, ou -1 se não corresponder a nenhuma moeda válida.
+ * @return O número de moedas esperadas.
  */
-int tipoMoedas(int perimetro, int area, float circ, int diametro)
+int verdadeGerador(GERADOR* gerador, int* total, long int* centimos)
 {
-	// Filtro rápido inicial: rejeita qualquer blob com área, perímetro ou circularidade fora dos mínimos aceitáveis
-	if (area < 10000 || perimetro < 300 || circ <= 0.40)
-		return -1;
+	memset(total, 0, 9 * sizeof(int));
+	*centimos = 0;
 
-	// Moeda de 0.50€
-	if (diametro >= 177 && diametro <= 181 && area >= 24200 && area <= 25950 && perimetro >= 550 && perimetro <= 560)
-	{
-		return 50;
-	}
-	// Moeda de 0.20€
-	else if (diametro >= 158 && diametro <= 165 && area >= 19375 && area <= 21615 && perimetro >= 467 && perimetro <= 590)
-	{
-		return 20;
-	}
-	// Moeda de 2€
-	else if (diametro >= 184 && diametro <= 190 && area >= 27140 && area <= 28140 && perimetro >= 575 && perimetro <= 605)
-	{
-		return 200;
-	}
-	// Moeda de 0.10€
-	else if (diametro >= 140 && diametro <= 145 && area >= 15460 && area <= 17210 && perimetro >= 430 && perimetro <= 460)
-	{
-		return 10;
-	}
-	// Moeda de 0.05€
-	else if (diametro >= 150 && diametro <= 157 && area >= 19060 && area <= 19844 && perimetro >= 450 && perimetro <= 493)
+	for (const MOEDA_SINTETICA& m : gerador->moedas)
 	{
-		return 5;
-	}
-	// Moeda de 1€
-	else if (diametro >= 169 && diametro <= 172 && area >= 22145 && area <= 23000 && perimetro >= 545 && perimetro <= 745)
-	{
-		return 100;
-	}
-	// Moeda de 0.02€
-	else if (diametro >= 135 && diametro <= 140 && area >= 14920 && area <= 15470 && perimetro >= 400 && perimetro <= 430)
-	{
-		return 2;
-	}
-	// Moeda de 0.01€
-	else if (diametro >= 116 && diametro <= 122 && area >= 10740 && area <= 11930 && perimetro >= 340 && perimetro <= 420)
-	{
-		return 1;
+		if (m.nframeLinha > gerador->nframe) continue;
+
+		if (tabelaMoedas.indice[m.tipo] >= 0) total[tabelaMoedas.indice[m.tipo]]++;
+		total[8]++;
+		*centimos += tabelaMoedas.valor[m.tipo];
 	}
 
-	// Se nenhum critério corresponder, retorna -1 (não reconhecida)
-	return -1;
+	return total[8];
 }
 
-
-#pragma endregion
-
-#pragma region Função: contarMoeda
 /**
- * @brief Conta o valor da moeda detetada, atualiza a soma total e incrementa a contagem por tipo.
+ * @brief Escreve a verdade do vídeo sintético em CSV: uma linha por moeda lançada, com o frame
+ * (a contar de 1) em que o centro chega à linha de reconhecimento. A posição no frame n é
+ * (x, y0 + velocidade * (n - 1)); as moedas com `frame_linha` posterior ao último frame não são contadas.
  *
- * Esta função calcula o diâmetro estimado da moeda, calcula a circularidade e chama a função `tipoMoedas`
- * para obter o valor monetário correspondente.
- * Se a moeda for reconhecida, atualiza o array de contagem de moedas (`total`), acumula o valor na variável `soma`
- * e anota visualmente a moeda no frame (desenha as informações na imagem e imprime no terminal).
+ * @param gerador Gerador.
+ * @param ficheiro Nome do ficheiro.
  *
- * @param frame Imagem do vídeo onde a moeda foi detetada (a função desenha as anotações nesta imagem).
- * @param blob Estrutura OVC contendo as informações geométricas do blob detetado.
- * @param soma Ponteiro para a variável que acumula a soma total em euros.
- * @param total Ponteiro para o array que armazena a contagem de moedas por tipo (índices 0 a 7 por tipo, índice 8 para total geral).
+ * @return 1 se o ficheiro foi escrito; 0 caso contrário.
  */
-void contarMoeda(cv::Mat& frame, OVC& blob, float* soma, int* total)
+int escreverVerdade(GERADOR* gerador, const char* ficheiro)
 {
-	// Estimar o diâmetro médio da moeda com base na bounding box
-	int diametro = (blob.width + blob.height) / 2;
+	FILE* f = fopen(ficheiro, "w");
+	const CENARIO* c = &gerador->cenario;
+	int total[9];
+	long int centimos;
 
-	// Calcular a circularidade do blob (4*PI*Area / Perímetro²)
-	float circ = calcular_circularidade(&blob);
+	if (f == NULL) return 0;
 
-	// Classificar o tipo de moeda com base nas características calculadas
-	int valor = tipoMoedas(blob.perimetro, blob.area, circ, diametro);
+	// Números sem printf de vírgula flutuante: o locale do programa usa vírgula decimal
+	fprintf(f, "# cenario %s %dx%d, %d frames, velocidade %d/100 px por frame, linha y = %d\n",
+		c->nome, c->width, c->height, gerador->nframe, (int)lrintf(c->velocidade * 100.0f), c->height / 4);
+	fprintf(f, "id,valor,indice,diametro_centesimos,x_centesimos,y0_centesimos,frame_linha\n");
 
-	// Atualizar as contagens e soma com base no valor retornado
-	switch (valor)
+	for (const MOEDA_SINTETICA& m : gerador->moedas)
 	{
-	case 200: total[7]++; *soma += 2.0f; break;      // 2€
-	case 100: total[6]++; *soma += 1.0f; break;      // 1€
-	case 50:  total[5]++; *soma += 0.5f; break;      // 0.50€
-	case 20:  total[4]++; *soma += 0.2f; break;      // 0.20€
-	case 10:  total[3]++; *soma += 0.1f; break;      // 0.10€
-	case 5:   total[2]++; *soma += 0.05f; break;     // 0.05€
-	case 2:   total[1]++; *soma += 0.02f; break;     // 0.02€
-	case 1:   total[0]++; *soma += 0.01f; break;     // 0.01€
-	default:  valor = -1; break;                     // Não reconhecida
+		fprintf(f, "%d,%d,%d,%ld,%ld,%ld,%d\n", m.id, tabelaMoedas.valor[m.tipo], tabelaMoedas.indice[m.tipo],
+			lrintf(m.raio * 200.0f), lrintf(m.x * 100.0f), lrintf(m.y0 * 100.0f), m.nframeLinha);
 	}
 
-	// Se a moeda foi reconhecida (valor diferente de -1)
-	if (valor != -1)
-	{
-		// Atualiza o total geral de moedas detetadas (índice 8)
-		total[8]++;
-
-		// Converte valor para float para exibir em euros
-		float valor2 = valor;
+	verdadeGerador(gerador, total, &centimos);
+	fprintf(f, "# moedas contadas %d, valor %ld centimos, por indice %d %d %d %d %d %d %d %d\n",
+		total[8], centimos, total[0], total[1], total[2], total[3], total[4], total[5], total[6], total[7]);
 
-		// Imprime no terminal as características da moeda detetada
-		printf("\n\t\t\t\t\tMoeda de %.2f Eur -> A: %d, P: %d, C: %.2f, Ø: %d, (x,y): (%d,%d)\n",
-			(valor2 / 100), blob.area, blob.perimetro, circ, diametro, blob.xc, blob.yc);
+	fclose(f);
 
-		// Escreve informações da moeda diretamente no frame (overlay gráfico)
-		escreverInfoMoeda(frame, blob, valor, circ);
-	}
+	return 1;
 }
 
 #pragma endregion
 
-#pragma region Função: verificaRepeticao
+#pragma region Função: fecharGerador
 /**
- * @brief Verifica se a moeda atual já foi contada, com base na posição do centro de massa em X.
+ * @brief Liberta o gerador do vídeo sintético.
  *
- * Esta função verifica apenas a última moeda registada no array `passou`, comparando a posição X do centro de massa.
- * Considera-se que a moeda é nova (não repetida) se a posição X estiver fora de uma tolerância de 8 píxeis em relação à última moeda registada.
- * Este método simples previne contagens duplicadas de moedas próximas no eixo X.
- *
- * @note Esta função usa apenas a posição X para evitar contagem dupla, não analisando o eixo Y nem outras características.
- *
- * @param passou Array de moedas já contadas (estrutura OVC).
- * @param atual Estrutura OVC da moeda atual a verificar.
- * @param cont Número atual de moedas registadas em `passou`.
- *
- * @return Retorna 1 se a moeda é considerada nova (não repetida), ou 0 se já foi contada.
+ * @param gerador Gerador (pode ser NULL).
  */
-int verificaRepeticao(OVC* passou, OVC atual, int cont)
+void fecharGerador(GERADOR* gerador)
 {
-	// Se não há moedas registadas, considera como nova
-	if (cont == 0)
-		return 1;
-
-	// Verifica se a posição X da moeda atual está fora da zona de tolerância (±8 píxeis)
-	if (atual.xc < passou[cont - 1].xc - 8 || atual.xc > passou[cont - 1].xc + 8)
-	{
-		// Fora da zona de tolerância → considera nova moeda
-		return 1;
-	}
-	else
-	{
-		// Dentro da zona de tolerância → considera repetida
-		return 0;
-	}
+	delete gerador;
 }
 
 #pragma endregion
 
-#pragma region Função: calcular_circularidade
+#pragma region Função: gerarSintetico
 /**
- * @brief Calcula a circularidade de um blob com base na fórmula padrão.
- *
- * A circularidade é uma medida adimensional que indica o quão próximo de um círculo perfeito é um objeto.
- * A fórmula utilizada é: \f$ Circularidade = \frac{4 \times \pi \times Área}{Perímetro^2} \f$
- * - Um círculo perfeito tem circularidade = 1.
- * - Objetos mais alongados ou com contornos irregulares terão circularidade inferior a 1.
- *
- * @note Caso o blob seja nulo ou o perímetro seja 0 (evitando divisão por zero), a função retorna 0.
+ * @brief Escreve os frames de um cenário sintético em bruto (BGR) no stdout, para
+ * `--entrada-stdin LxA`, e a verdade no ficheiro dado.
  *
- * @param blob Ponteiro para a estrutura `OVC` contendo as informações do blob (área e perímetro).
+ * @param texto Descrição do cenário (ver `lerCenario`).
+ * @param verdade Ficheiro da verdade (CSV, ver `escreverVerdade`).
  *
- * @return A circularidade calculada como float. Retorna 0.0f em caso de erro.
+ * @return 1 se a geração terminou; 0 em caso de erro.
  */
-float calcular_circularidade(OVC* blob)
+int gerarSintetico(const char* texto, const char* verdade)
 {
-	// Verificação de segurança: blob nulo ou perímetro zero retorna circularidade 0 (evita divisão por zero)
-	if (blob == NULL || blob->perimetro == 0)
-		return 0.0f;
-
-	// Definição de PI com precisão de float
-	const float PI = 3.14159265358979323846f;
+	CENARIO cenario;
+	cv::Mat frame;
 
-	// Cálculo da circularidade: (4 * PI * área) / (perímetro²)
-	return (4.0f * PI * (float)blob->area) / ((float)blob->perimetro * (float)blob->perimetro);
-}
+	if (!lerCenario(texto, &cenario))
+	{
+		fprintf(stderr, "Cenário inválido: %s\n", texto);
+		return 0;
+	}
 
-#pragma endregion
+	GERADOR* g = abrirGerador(&cenario);
+	if (g == NULL) return 0;
 
-#pragma region Função: escreverInfoMoeda
-/**
- * @brief Escreve informações detalhadas sobre a moeda diretamente na imagem.
- *
- * Esta função desenha sobre a imagem (`cv::Mat`) as informações:
- * - Valor da moeda (em euros ou cêntimos);
- * - Área do blob (número de píxeis);
- * - Circularidade calculada.
- *
- * As informações são escritas à direita da bounding box da moeda, usando a fonte simples do OpenCV.
- *
- * @param image Imagem do frame onde será desenhada a informação.
- * @param blob Estrutura `OVC` com as informações geométricas da moeda.
- * @param valor Valor da moeda detetada (em centavos).
- * @param circ Circularidade calculada da moeda.
- */
-void escreverInfoMoeda(cv::Mat& image, OVC blob, int valor, float circ)
-{
-	char texto[100];                                // Buffer para as mensagens de texto
-	cv::Scalar corTexto(255, 0, 0);                 // Cor do texto (Azul em BGR)
-	int fontFace = cv::FONT_HERSHEY_SIMPLEX;        // Tipo de fonte OpenCV
-	double fontScale = 0.4;                         // Escala da fonte
-	int thickness = 1;                              // Espessura da fonte
+#ifdef _WIN32
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
 
-	// Posição inicial do texto (à direita da bounding box da moeda)
-	int xText = blob.x + blob.width + 5;
-	int yText = blob.y;
+	while (gerarFrame(g, frame) > 0)
+	{
+		if (fwrite(frame.data, (size_t)frame.cols * 3, frame.rows, stdout) != (size_t)frame.rows) break;
+	}
+	fflush(stdout);
 
-	// Primeira linha: Valor da moeda
-	if (valor >= 100)
-		sprintf(texto, "%d euro", valor / 100);     // Exibe em euros (ex.: 2 euro)
-	else if (valor > 0)
-		sprintf(texto, "%d cent", valor);           // Exibe em cêntimos (ex.: 50 cent)
-	else
-		sprintf(texto, "valor: 0");                 // Valor não reconhecido
+	fprintf(stderr, "Cenário %s: %d frames de %dx%d (--entrada-stdin %dx%d)\n", cenario.nome, g->nframe, cenario.width, cenario.height, cenario.width, cenario.height);
 
-	cv::putText(image, texto, cv::Point(xText, yText), fontFace, fontScale, corTexto, thickness);
+	int escrita = escreverVerdade(g, verdade);
+	if (!escrita) fprintf(stderr, "Erro ao escrever a verdade em %s!\n", verdade);
 
-	// Segunda linha: Área do blob (em píxeis)
-	sprintf(texto, "Area: %d", blob.area);
-	cv::putText(image, texto, cv::Point(xText, yText + 15), fontFace, fontScale, corTexto, thickness);
+	fecharGerador(g);
 
-	// Terceira linha: Circularidade calculada
-	sprintf(texto, "Circ: %.2f", circ);
-	cv::putText(image, texto, cv::Point(xText, yText + 30), fontFace, fontScale, corTexto, thickness);
+	return escrita;
 }
 
-
 #pragma endregion
 
-#pragma region Função: somarImagens
+#pragma region Função: benchmarkSintetico
 /**
- * @brief Realiza a operação lógica OR entre duas imagens binárias e armazena o resultado numa terceira imagem.
+ * @brief Processa cenários sintéticos e mostra, para cada um, a exatidão da contagem (moedas
+ * contadas por valor face à verdade) e a velocidade do processamento.
  *
- * Esta função percorre duas imagens binárias (`src1` e `src2`) de mesmo tamanho e combina-as
- * aplicando uma operação de soma lógica (OR pixel a pixel). Se qualquer um dos píxeis for 255 (branco),
- * o resultado será 255; caso contrário, será 0.
- *
- * @note Todas as imagens devem ter 1 canal (binárias) e as mesmas dimensões.
+ * Cada frame gerado passa pelo mesmo processamento do vídeo (segmentação, ou pirâmide com
+ * `--piramide`, etiquetagem e análise), sem janela nem gravação. O tempo medido é só o do
+ * processamento (a geração dos frames não conta).
  *
- * @param src1 Ponteiro para a primeira imagem binária de entrada.
- * @param src2 Ponteiro para a segunda imagem binária de entrada.
- * @param dst Ponteiro para a imagem de saída onde será armazenado o resultado da soma.
+ * @param cenarios Descrições separadas por ';' (ver `lerCenario`), ou "todos" para os cenários predefinidos.
  *
- * @return Retorna 1 se a operação for bem-sucedida; caso contrário, retorna 0 (erro de parâmetros ou incompatibilidade).
+ * @return 1 se todas as contagens coincidem com a verdade; 0 caso contrário (ou em caso de erro).
  */
-int somarImagens(IVC* src1, IVC* src2, IVC* dst)
+int benchmarkSintetico(const char* cenarios)
 {
-	// Verificação de ponteiros válidos
-	if (!src1 || !src2 || !dst)
-		return 0;
+	std::vector<std::string> lista;
+	std::string resto = cenarios;
+	int certos = 1;
 
-	// Verificação se as dimensões das imagens de entrada coincidem
-	if (src1->width != src2->width || src1->height != src2->height)
-		return 0;
+	if (strcmp(cenarios, "todos") == 0)
+	{
+		for (int i = 0; i < NCENARIOS_SINTETICOS; i++) lista.push_back(cenariosSinteticos[i].nome);
+	}
+	else
+	{
+		size_t p;
+		while ((p = resto.find(';')) != std::string::npos)
+		{
+			lista.push_back(resto.substr(0, p));
+			resto = resto.substr(p + 1);
+		}
+		lista.push_back(resto);
+	}
 
-	// Verificação se todas as imagens têm apenas 1 canal (binário)
-	if (src1->channels != 1 || src2->channels != 1 || dst->channels != 1)
-		return 0;
+	std::vector<std::string> linhas;
 
-	// Percorrer todas as linhas da imagem
-	for (int y = 0; y < src1->height; y++)
+	for (const std::string& texto : lista)
 	{
-		// Percorrer todos os píxeis da linha
-		for (int x = 0; x < src1->width; x++)
+		CENARIO cenario;
+		cv::Mat frame;
+		int total[9] = { 0 }, esperado[9];
+		long int centimos;
+		float soma = 0.0f;
+		double segundos = 0.0, maximo = 0.0;
+		long int nblobsTotal = 0;
+		int nblobsMax = 0;
+
+		if (!lerCenario(texto.c_str(), &cenario))
+		{
+			fprintf(stderr, "Cenário inválido: %s\n", texto.c_str());
+			return 0;
+		}
+
+		GERADOR* g = abrirGerador(&cenario);
+		if (g == NULL) return 0;
+
+		iniciarRastreador(&rastreador);
+		IVC* mascara = vc_image_new(cenario.width, cenario.height, 1, 255);
+		int nframe;
+
+		while ((nframe = gerarFrame(g, frame)) > 0)
+		{
+			std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+			OVC* blobs;
+			int nblobs = 0;
+
+			if (opcoes.piramide > 1)
+			{
+				blobs = detetarMoedasPiramide(frame, opcoes.piramide, mascara, &nblobs);
+			}
+			else
+			{
+				segmentarMoedas(frame, mascara, 9);
+				blobs = etiquetarMoedas(mascara, cenario.height / 4, &nblobs);
+			}
+			processarBlobs(frame, blobs, nblobs, nframe, &soma, total);
+			free(blobs);
+
+			double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+			segundos += t;
+			maximo = MAX(maximo, t);
+			nblobsTotal += nblobs;
+			nblobsMax = MAX(nblobsMax, nblobs);
+		}
+
+		esvaziarEventos();
+
+		verdadeGerador(g, esperado, &centimos);
+
+		// Moedas certas: por índice, o mínimo entre as contadas e as esperadas
+		int corretas = 0, aMais = 0;
+		for (int i = 0; i < 8; i++)
 		{
-			// Calcular a posição linear no buffer da imagem
-			int pos = y * src1->bytesperline + x;
+			corretas += MIN(total[i], esperado[i]);
+			aMais += MAX(total[i] - esperado[i], 0);
+		}
+		long int contados = lrintf(soma * 100.0f);
+		int igual = (memcmp(total, esperado, sizeof(total)) == 0) && (contados == centimos);
+		double fps = (segundos > 0.0) ? (double)g->nframe / segundos : 0.0;
 
-			// Soma lógica: se qualquer um dos píxeis for 255, o resultado será 255; caso contrário, 0
-			dst->data[pos] = (src1->data[pos] == 255 || src2->data[pos] == 255) ? 255 : 0;
+		printf("\n\t\t\t\t\t\t\tCenário %s (%dx%d, %d frames):\n", cenario.nome, cenario.width, cenario.height, g->nframe);
+		printf("\t\t\t\t\t\t\t\tMoedas (contadas/esperadas): %d/%d\n", total[8], esperado[8]);
+		for (int i = 0; i < tabelaMoedas.n; i++)
+		{
+			int k = tabelaMoedas.indice[i];
+			if (k >= 0 && (total[k] || esperado[k])) printf("\t\t\t\t\t\t\t\t%d cêntimos: %d/%d\n", tabelaMoedas.valor[i], total[k], esperado[k]);
 		}
+		printf("\t\t\t\t\t\t\t\tValor (contado/esperado): %ld.%02ld/%ld.%02ld euros\n", contados / 100, contados % 100, centimos / 100, centimos % 100);
+		printf("\t\t\t\t\t\t\t\tExatidão: %.1f%% (%d certas, %d a mais)%s\n",
+			esperado[8] ? 100.0 * corretas / esperado[8] : 100.0, corretas, aMais, igual ? "" : " [DIFERENTE]");
+		printf("\t\t\t\t\t\t\t\tVelocidade: %.1f frames/s (%.2f ms por frame, máximo %.2f ms)\n",
+			fps, 1000.0 * segundos / MAX(g->nframe, 1), 1000.0 * maximo);
+		printf("\t\t\t\t\t\t\t\tBlobs por frame: %.1f (máximo %d)\n", (double)nblobsTotal / MAX(g->nframe, 1), nblobsMax);
+
+		char linha[256];
+		snprintf(linha, sizeof(linha), "%-12s %5d/%-5d %7.1f%% %9.1f fps  %s", cenario.nome, total[8], esperado[8],
+			esperado[8] ? 100.0 * corretas / esperado[8] : 100.0, fps, igual ? "ok" : "DIFERENTE");
+		linhas.push_back(linha);
+
+		certos &= igual;
+
+		vc_image_free(mascara);
+		fecharGerador(g);
 	}
 
-	// Retorna 1 indicando sucesso
-	return 1;
+	printf("\n\t\t\t\t\t\t\tResumo dos cenários (moedas contadas/esperadas, exatidão, velocidade):\n");
+	for (const std::string& linha : linhas) printf("\t\t\t\t\t\t\t\t%s\n", linha.c_str());
+
+	return certos;
 }
+
 #pragma endregion
 
-#pragma region Função: desenhaBox
-/**
- * @brief Desenha uma caixa delimitadora (bounding box) em torno da moeda e uma cruz no seu centro de massa.
- *
- * Esta função desenha, sobre a imagem colorida (`cv::Mat`), a bounding box (em verde) ao redor do blob (moeda)
- * e uma cruz no centro de massa (em vermelho).
- * Antes de desenhar, verifica se a moeda cumpre os critérios mínimos de área, perímetro, circularidade e diâmetro.
- *
- * @note A função altera diretamente a imagem fornecida como parâmetro.
- *
- * @param image Imagem onde será desenhada a caixa e a cruz.
- * @param blob Estrutura `OVC` contendo as informações geométricas da moeda (bounding box, centro, etc.).
- *
- * @return Retorna 1 se a caixa e cruz foram desenhadas com sucesso; 0 caso contrário (blob não cumpre critérios mínimos).
- */
-int desenhaBox(cv::Mat& image, OVC& blob)
+#pragma region Função: microbenchmark
+// Resoluções com nome do microbenchmark (ver microbenchmark)
+static const struct {
+	const char* nome;
+	int width, height;
+} resolucoesMicrobenchmark[] = {
+	{ "vga", 640, 480 },
+	{ "hd", 1280, 720 },
+	{ "fhd", 1920, 1080 },
+	{ "4k", 3840, 2160 },
+};
+
+#define NRESOLUCOES_MICROBENCHMARK	((int)(sizeof(resolucoesMicrobenchmark) / sizeof(resolucoesMicrobenchmark[0])))
+
+// Tempo de um kernel (ver medirKernel)
+typedef struct {
+	double ms;			// Milissegundos da execução mais rápida
+	double ciclos;		// Ciclos do contador de tempo do processador na mesma execução (0 se não existir)
+} MEDICAO_KERNEL;
+
+// Comparação do resultado de um kernel do IVC com o do OpenCV
+typedef struct {
+	double iguais;		// Percentagem de píxeis (ou de áreas de blobs) iguais
+	int diferenca;		// Maior diferença absoluta entre píxeis (ou diferença no número de blobs)
+} PARIDADE;
+
+// Resultado das funções sem outra saída, para que o compilador não elimine a chamada
+static volatile long long sumidouroMicrobenchmark;
+
+// Contador de tempo do processador (TSC): conta à frequência nominal, não à frequência real do núcleo
+static unsigned long long ciclosTSC(void)
 {
-	// Calcular a circularidade do blob
-	float circ = calcular_circularidade(&blob);
+#ifdef VC_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
 
-	// Estimar o diâmetro médio a partir da bounding box
-	int diametro = (blob.width + blob.height) / 2;
+// Mede um kernel: a primeira execução aquece as caches (e fica como medição se demorar mais de 0,25 s);
+// depois repete-o até somar 0,25 s (no máximo 100 vezes) e fica com a execução mais rápida
+template <typename F> static MEDICAO_KERNEL medirKernel(F kernel)
+{
+	MEDICAO_KERNEL melhor = { 0.0, 0.0 };
+	double total = 0.0;
 
-	// Verificação rápida para rejeitar blobs que não cumprem os requisitos mínimos de moeda
-	if (blob.area <= 10000 || blob.perimetro < 300 || circ <= 0.50 || diametro < 115)
-		return 0;
+	for (int i = 0; i <= 100; i++)
+	{
+		std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+		unsigned long long c0 = ciclosTSC();
+		kernel();
+		unsigned long long c1 = ciclosTSC();
+		double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
 
-	// Obter propriedades da imagem
-	int width = image.cols;
-	int height = image.rows;
-	int channels = image.channels();
-	int step = image.step; // Número de bytes por linha
-	unsigned char* data = image.data;
+		if ((i <= 1) || (s * 1000.0 < melhor.ms))
+		{
+			melhor.ms = s * 1000.0;
+			melhor.ciclos = (double)(c1 - c0);
+		}
+
+		if ((i == 0) && (s >= 0.25)) break;
+		if (i > 0) total += s;
+		if (total >= 0.25) break;
+	}
+
+	return melhor;
+}
+
+// Imagens de teste: fundo escuro (gradiente com ruído, abaixo de 128) e 48 discos claros (acima de 128),
+// um por célula de uma grelha 8x6, para que a máscara (limiar 128) tenha sempre 48 blobs afastados dos limites
+static void imagensMicrobenchmark(IVC* rgb, IVC* gray, IVC* binaria)
+{
+	unsigned int estado = 12345;
+	int width = gray->width, height = gray->height;
+	int raio = MAX(MIN(width / 8, height / 6) / 8, 2);
 
-	// === Desenhar bounding box verde ===
-	for (int y = blob.y; y <= blob.y + blob.height; y++)
+	for (int y = 0; y < height; y++)
 	{
-		for (int x = blob.x; x <= blob.x + blob.width; x++)
+		unsigned char* linha = gray->data + y * gray->bytesperline;
+
+		for (int x = 0; x < width; x++)
 		{
-			// Verificar se dentro dos limites da imagem
-			if (x < 0 || x >= width || y < 0 || y >= height)
-				continue;
+			estado ^= estado << 13; estado ^= estado >> 17; estado ^= estado << 5;
+			linha[x] = (unsigned char)(36 + 64 * x / width + (int)(estado % 33) - 16);
+		}
+	}
 
-			int pos = y * step + x * channels;
+	for (int c = 0; c < 48; c++)
+	{
+		int cx = (c % 8) * width / 8 + width / 16;
+		int cy = (c / 8) * height / 6 + height / 12;
+		int r = raio + c % (raio + 1);
+
+		for (int y = cy - r; y <= cy + r; y++)
+		{
+			unsigned char* linha = gray->data + y * gray->bytesperline;
 
-			// Desenhar apenas as bordas da caixa
-			if (y == blob.y || y == blob.y + blob.height || x == blob.x || x == blob.x + blob.width)
+			for (int x = cx - r; x <= cx + r; x++)
 			{
-				data[pos + 0] = 0;     // B (Azul)
-				data[pos + 1] = 255;   // G (Verde)
-				data[pos + 2] = 0;     // R (Vermelho)
+				if ((x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r) continue;
+
+				estado ^= estado << 13; estado ^= estado >> 17; estado ^= estado << 5;
+				linha[x] = (unsigned char)(184 + (int)(estado % 33) - 16);
 			}
 		}
 	}
 
-	// === Desenhar cruz vermelha no centro de massa ===
-	// Linha vertical da cruz
-	for (int y = blob.yc - 10; y <= blob.yc + 10; y++)
+	for (int y = 0; y < height; y++)
 	{
-		int x = blob.xc;
-		if (x < 0 || x >= width || y < 0 || y >= height)
-			continue;
+		unsigned char* g = gray->data + y * gray->bytesperline;
+		unsigned char* c = rgb->data + y * rgb->bytesperline;
 
-		int pos = y * step + x * channels;
-		data[pos + 0] = 0;     // Azul
-		data[pos + 1] = 0;     // Verde
-		data[pos + 2] = 255;   // Vermelho
+		for (int x = 0; x < width; x++)
+		{
+			c[3 * x + 0] = g[x];
+			c[3 * x + 1] = (unsigned char)(g[x] * 3 / 4);
+			c[3 * x + 2] = (unsigned char)(255 - g[x]);
+		}
 	}
 
-	// Linha horizontal da cruz
-	for (int x = blob.xc - 10; x <= blob.xc + 10; x++)
+	vc_gray_to_binary(gray, binaria, 128);
+}
+
+// Compara uma imagem IVC de 1 canal com uma Mat de 8 bits, sem as `margem` linhas e colunas junto
+// a cada limite (onde os kernels do IVC e do OpenCV tratam a vizinhança de forma diferente);
+// com binaria, só compara se os píxeis são 0 ou não (a morfologia do IVC escreve 1 e não 255)
+static PARIDADE compararImagens(IVC* a, const cv::Mat& b, int margem, int binaria)
+{
+	PARIDADE p = { 100.0, 0 };
+	long int iguais = 0, n = 0;
+
+	for (int y = margem; y < a->height - margem; y++)
 	{
-		int y = blob.yc;
-		if (x < 0 || x >= width || y < 0 || y >= height)
-			continue;
+		const unsigned char* la = a->data + y * a->bytesperline;
+		const unsigned char* lb = b.ptr<unsigned char>(y);
 
-		int pos = y * step + x * channels;
-		data[pos + 0] = 0;     // Azul
-		data[pos + 1] = 8;     // Verde claro (quase nulo)
-		data[pos + 2] = 255;   // Vermelho
+		for (int x = margem; x < a->width - margem; x++)
+		{
+			int d = binaria ? 255 * ((la[x] != 0) != (lb[x] != 0)) : abs((int)la[x] - (int)lb[x]);
+
+			iguais += (d == 0);
+			p.diferenca = MAX(p.diferenca, d);
+			n++;
+		}
 	}
 
-	// Retorna 1 indicando que foi desenhado com sucesso
-	return 1;
-}
+	if (n > 0) p.iguais = 100.0 * (double)iguais / (double)n;
 
-#pragma endregion
+	return p;
+}
 
-#pragma region Função: escreveMoedaDetetada
-/**
- * @brief Escreve uma mensagem visual na imagem indicando que uma moeda foi detetada.
- *
- * Esta função desenha no frame três elementos:
- * - Duas linhas de texto informativas (em vermelho) com a mensagem "MOEDA DETETADA !!".
- * - Uma linha horizontal de separação em vermelho (linha de reconhecimento visual).
- *
- * A mensagem é desenhada numa área fixa horizontal, em torno de 1/4 da altura do frame.
- *
- * @param frame Imagem (`cv::Mat`) onde será desenhada a mensagem.
- */
-void escreveMoedaDetetada(cv::Mat& frame)
+// Compara as áreas dos blobs do IVC com as de connectedComponentsWithStats (ordenadas; etiqueta 0 = fundo)
+static PARIDADE compararAreas(const OVC* blobs, int nblobs, const cv::Mat& stats, int ncv)
 {
-	// Primeira mensagem de aviso
-	std::string texto = "    !!MOEDA DETETADA !!                                                                                                              !! MOEDA DETETADA !!     ";
-	cv::Point posicao(20, frame.rows / 4 - 10);  // Posição da primeira linha de texto (um pouco acima da linha de reconhecimento)
-	int fontFace = cv::FONT_HERSHEY_SIMPLEX;     // Fonte padrão do OpenCV
-	double fontScale = 0.5;                      // Escala da fonte
-	cv::Scalar cor(0, 0, 255);                   // Cor vermelha (BGR)
+	PARIDADE p = { 100.0, 0 };
+	std::vector<int> a, b;
 
-	// Segunda mensagem de aviso (duplicada, abaixo da linha)
-	std::string texto2 = "    !!MOEDA DETETADA !!                                                                                                              !! MOEDA DETETADA !!     ";
-	cv::Point posicao2(20, frame.rows / 4 + 15);
-	int fontFace2 = cv::FONT_HERSHEY_SIMPLEX;
-	double fontScale2 = 0.5;
-	cv::Scalar cor2(0, 0, 255);
+	for (int i = 0; i < nblobs; i++) a.push_back(blobs[i].area);
+	for (int i = 1; i < ncv; i++) b.push_back(stats.at<int>(i, cv::CC_STAT_AREA));
 
-	// Desenhar ambas as mensagens no frame
-	cv::putText(frame, texto, posicao, fontFace, fontScale, cor);
-	cv::putText(frame, texto2, posicao2, fontFace2, fontScale2, cor2);
+	std::sort(a.begin(), a.end());
+	std::sort(b.begin(), b.end());
 
-	// Linha horizontal (linha de reconhecimento visual) centrada a 1/4 da altura
-	std::string texto3 = "_____________________________________________________________________________________________________________________________________________________________";
-	cv::Point posicao3(0, frame.rows / 4);
-	int fontFace3 = cv::FONT_HERSHEY_SIMPLEX;
-	double fontScale3 = 0.5;
-	cv::Scalar cor3(0, 0, 255);
+	size_t n = MIN(a.size(), b.size()), maior = MAX(a.size(), b.size()), iguais = 0;
+	for (size_t i = 0; i < n; i++) iguais += (a[i] == b[i]);
 
-	// Desenhar a linha horizontal no frame
-	cv::putText(frame, texto3, posicao3, fontFace3, fontScale3, cor3);
-}
+	if (maior > 0) p.iguais = 100.0 * (double)iguais / (double)maior;
+	p.diferenca = (int)(maior - n);
 
-#pragma endregion
+	return p;
+}
 
-#pragma region Função: linhaReconhecimento
-/**
- * @brief Desenha uma linha horizontal de reconhecimento na imagem.
- *
- * Esta linha serve como referência visual no vídeo, permitindo ao utilizador identificar
- * a zona onde as moedas devem cruzar para serem consideradas válidas (por exemplo, para evitar contagens duplicadas).
- * A linha é desenhada utilizando caracteres "_" ao longo de toda a largura do frame, centrada aproximadamente a 1/4 da altura da imagem.
- *
- * @param frame Imagem (`cv::Mat`) onde a linha será desenhada.
- */
-void linhaReconhecimento(cv::Mat& frame)
+// Binariza a magnitude dos gradientes do Sobel do OpenCV como vc_gray_edge_sobel (gradientes divididos por 3)
+static void binarizarSobel(const cv::Mat& gx, const cv::Mat& gy, cv::Mat& dst, float th)
 {
-	// Texto composto por sublinhados para simular uma linha horizontal
-	std::string texto = "_____________________________________________________________________________________________________________________________________________________________";
-
-	// Posição da linha: altura = 1/4 da altura da imagem, início no canto esquerdo (0, altura/4)
-	cv::Point posicao(0, frame.rows / 4);
+	dst.create(gx.rows, gx.cols, CV_8UC1);
 
-	// Configuração da fonte
-	int fontFace = cv::FONT_HERSHEY_SIMPLEX;
-	double fontScale = 0.5;
-	cv::Scalar cor(0, 0, 0); // Cor preta (BGR)
+	for (int y = 0; y < gx.rows; y++)
+	{
+		for (int x = 0; x < gx.cols; x++)
+		{
+			double mx = gx.ptr<short>(y)[x] / 3;
+			double my = gy.ptr<short>(y)[x] / 3;
 
-	// Desenhar o texto (linha) na imagem
-	cv::putText(frame, texto, posicao, fontFace, fontScale, cor);
+			dst.ptr<unsigned char>(y)[x] = (sqrt(mx * mx + my * my) > th) ? 255 : 0;
+		}
+	}
 }
 
-#pragma endregion
-
-#pragma region Função: vc_timer
-/**
- * @brief Função de temporização simples que mede e exibe o tempo decorrido entre duas chamadas consecutivas.
- *
- * Esta função utiliza `std::chrono` para calcular o tempo decorrido em segundos desde a primeira chamada.
- * Na primeira execução, apenas ativa o modo de contagem (inicializa o `previousTime`).
- * Na segunda chamada (ou seguintes), calcula o tempo decorrido e exibe no terminal.
- *
- * @note Após mostrar o tempo decorrido, aguarda uma tecla do utilizador (`std::cin.get()`) antes de prosseguir.
- *
- * @warning Esta função utiliza variáveis estáticas locais, o que significa que o temporizador mantém o estado entre chamadas.
- */
-void vc_timer(void)
+// Escreve a linha de um kernel: tempo e píxeis por ciclo do IVC e, se existirem, os do OpenCV e a paridade
+static void mostrarKernel(const char* nome, long int pixeis, MEDICAO_KERNEL ivc, const MEDICAO_KERNEL* opencv, const PARIDADE* paridade)
 {
-	// Variável estática que controla se a função já foi chamada anteriormente
-	static bool running = false;
-
-	// Variável estática que armazena o momento da primeira chamada
-	static std::chrono::steady_clock::time_point previousTime = std::chrono::steady_clock::now();
+	printf("\t\t\t\t\t\t\t\t%-52s %10.3f ms", nome, ivc.ms);
+	if (ivc.ciclos > 0.0) printf(" %8.4f px/ciclo", (double)pixeis / ivc.ciclos);
 
-	// Primeira chamada: apenas ativa o modo de contagem e não faz mais nada
-	if (!running)
+	if (opencv != NULL)
 	{
-		running = true;
+		printf("  | OpenCV %10.3f ms", opencv->ms);
+		if (opencv->ciclos > 0.0) printf(" %8.4f px/ciclo", (double)pixeis / opencv->ciclos);
+		printf("  IVC/OpenCV %7.2fx", ivc.ms / MAX(opencv->ms, 1e-6));
 	}
-	// Segunda chamada (ou seguintes): calcula e exibe o tempo decorrido
-	else
-	{
-		// Captura o tempo atual
-		std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
 
-		// Calcula a duração entre o tempo atual e o tempo anterior
-		std::chrono::steady_clock::duration elapsedTime = currentTime - previousTime;
-
-		// Converte a duração para segundos em formato double
-		std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>>(elapsedTime);
-		double nseconds = time_span.count();
-
-		// Exibe o tempo decorrido no terminal
-		std::cout << "Tempo decorrido: " << nseconds << " segundos" << std::endl;
+	if (paridade != NULL) printf("  iguais %6.2f%% (diferença máx. %d)", paridade->iguais, paridade->diferenca);
 
-		// Aguarda o utilizador pressionar Enter
-		std::cin.get();
-	}
+	printf("\n");
 }
 
-#pragma endregion
-
-#pragma region Função: resumoFrame
 /**
- * @brief Desenha no frame um resumo visual do processamento de moedas.
+ * @brief Microbenchmark das funções vc_* (conversões de cor, limiarizações, morfologia, etiquetagem,
+ * histogramas, contornos e filtros), com comparação com as funções equivalentes do OpenCV.
  *
- * Exibe no vídeo as estatísticas do processamento atual:
- * - Resolução do vídeo;
- * - Total de frames e taxa de frames por segundo (FPS);
- * - Número do frame atual;
- * - Total de moedas detetadas (geral e por tipo);
- * - Soma total das moedas;
- * - Identificação da instituição, curso, disciplina, professor e alunos;
- * - Mensagem de instrução ("Prima ESC para sair").
+ * Para cada resolução, as imagens de teste (ver `imagensMicrobenchmark`) são processadas por cada
+ * kernel (os de vizinhança com janelas de 3, 5, 7 e 9) e são mostrados o tempo da execução mais
+ * rápida (ver `medirKernel`) e o débito em píxeis por ciclo do contador de tempo do processador
+ * (TSC, à frequência nominal; só em x86).
  *
- * @param frame Imagem (`cv::Mat`) onde será desenhado o resumo.
- * @param total Ponteiro para o array com as contagens por tipo de moeda (total[8] contém o total geral).
- * @param soma Soma total calculada das moedas em euros.
- * @param width Largura do frame.
- * @param height Altura do frame.
- * @param totalFrames Número total de frames do vídeo.
- * @param fps Taxa de frames por segundo.
- * @param nframe Número do frame atual.
+ * Onde existe um equivalente no OpenCV (cvtColor, threshold, erode, dilate, connectedComponentsWithStats,
+ * medianBlur e Sobel) são mostrados também o seu tempo, a razão entre os tempos (acima de 1, o kernel
+ * do IVC é mais lento) e a percentagem de píxeis iguais, sem os limites da imagem (onde a vizinhança
+ * é tratada de forma diferente). Na etiquetagem comparam-se as áreas dos blobs, com a etiquetagem do IVC
+ * seguida do cálculo das áreas; no Sobel, o tempo do OpenCV é o dos dois gradientes e a binarização da
+ * magnitude é feita à parte, só para a comparação.
+ *
+ * As operações ponto a ponto são medidas em cada nível SIMD até ao nível em uso (ver `vc_simd_definir`),
+ * depois de cada variante ser comparada com a escalar (ver `vc_simd_verificar`).
+ *
+ * @param resolucoes Resoluções separadas por ';': vga, hd, fhd, 4k ou LxA (`todas` = as quatro com nome).
+ *
+ * @return 1 se o microbenchmark terminou; 0 se alguma resolução é inválida ou alguma variante SIMD
+ * difere da escalar.
  */
-void resumoFrame(cv::Mat& frame, int* total, float soma, int width, int height, int totalFrames, int fps, int nframe)
+int microbenchmark(const char* resolucoes)
 {
-	char buffer[200];
-	int yStart = 230;   // Posição vertical inicial para o resumo das moedas
-	int yStep = 20;     // Espaçamento vertical entre linhas
-
-	// Cores para textos
-	cv::Scalar corFonte(0, 0, 0);       // Preto
-	cv::Scalar corFonte2(100, 0, 0);    // Vermelho escuro
-
-	// Configurações da fonte
-	int fontFace = cv::FONT_HERSHEY_SIMPLEX;
-	double fontScale = 0.5;
-	double fontScale2 = 0.7;
+	static const int janelas[4] = { 3, 5, 7, 9 };
+	std::vector<std::pair<int, int>> lista;
+	std::string resto = resolucoes;
+	size_t p;
 
-	// Exibir informações do vídeo
-	std::string str;
-	str = "RESOLUCAO: " + std::to_string(width) + "x" + std::to_string(height);
-	cv::putText(frame, str, cv::Point(yStep, 25), fontFace, fontScale2, corFonte);
-
-	str = "TOTAL DE FRAMES: " + std::to_string(totalFrames);
-	cv::putText(frame, str, cv::Point(yStep, 50), fontFace, fontScale2, corFonte);
-
-	str = "FRAME RATE: " + std::to_string(fps);
-	cv::putText(frame, str, cv::Point(yStep, 75), fontFace, fontScale2, corFonte);
-
-	str = "N. FRAME: " + std::to_string(nframe);
-	cv::putText(frame, str, cv::Point(yStep, 100), fontFace, fontScale2, corFonte);
-
-	// Exibir total geral de moedas
-	sprintf(buffer, "Total de moedas:");
-	cv::putText(frame, buffer, cv::Point(20, yStart), fontFace, fontScale, cv::Scalar(255, 0, 0));
-	sprintf(buffer, "%d", total[8]);
-	cv::putText(frame, buffer, cv::Point(165, yStart), fontFace, fontScale, cv::Scalar(0, 0, 255));
-
-	// Exibir contagem por tipo de moeda (em ordem de valor decrescente)
-	const char* nomes[] = {
-		"Moedas 2 Eur", "Moedas 1 Eur", "Moedas 0,50 Eur", "Moedas 0,20 Eur",
-		"Moedas 0,10 Eur", "Moedas 0,05 Eur", "Moedas 0,02 Eur", "Moedas 0,01 Eur"
-	};
-
-	for (int i = 0; i < 8; i++)
+	do
 	{
-		int idx = 7 - i; // Ordem inversa (do maior valor para o menor)
-		sprintf(buffer, "%s: %d", nomes[i], total[idx]);
-		cv::putText(frame, buffer, cv::Point(20, yStart + (i + 1) * yStep), fontFace, fontScale, corFonte2);
-	}
+		p = resto.find(';');
+		std::string texto = resto.substr(0, p);
+		int width = 0, height = 0, i;
 
-	// Exibir a soma total em euros
-	sprintf(buffer, "Soma:");
-	cv::putText(frame, buffer, cv::Point(20, yStart + 9 * yStep), fontFace, fontScale, cv::Scalar(255, 0, 0));
-	sprintf(buffer, "%.2f Euros", soma);
-	cv::putText(frame, buffer, cv::Point(70, yStart + 9 * yStep), fontFace, fontScale, cv::Scalar(0, 0, 255));
+		if (p != std::string::npos) resto = resto.substr(p + 1);
 
-	// Identificação institucional
-	sprintf(buffer, "IPCA");
-	cv::putText(frame, buffer, cv::Point(yStep, yStart + 13 * yStep), fontFace, 0.6, cv::Scalar(0, 120, 0));
-	sprintf(buffer, "Escola Superior de Tecnologia");
-	cv::putText(frame, buffer, cv::Point(yStep, yStart + 14 * yStep), fontFace, 0.4, cv::Scalar(150, 0, 0));
-	sprintf(buffer, "Engenharia de Sistemas Informaticos PL");
-	cv::putText(frame, buffer, cv::Point(yStep, yStart + 15 * yStep), fontFace, 0.4, corFonte2);
-	sprintf(buffer, "2024/2025");
-	cv::putText(frame, buffer, cv::Point(yStep, yStart + 16 * yStep), fontFace, 0.4, corFonte2);
-	sprintf(buffer, "Visao por Computador");
-	cv::putText(frame, buffer, cv::Point(yStep, yStart + 17 * yStep), fontFace, 0.4, corFonte2);
-	sprintf(buffer, "Professor: Simao Valente");
-	cv::putText(frame, buffer, cv::Point(yStep, yStart + 18 * yStep), fontFace, 0.4, corFonte2);
+		if (texto == "todas")
+		{
+			for (i = 0; i < NRESOLUCOES_MICROBENCHMARK; i++) lista.push_back(std::make_pair(resolucoesMicrobenchmark[i].width, resolucoesMicrobenchmark[i].height));
+			continue;
+		}
 
-	// Lista dos alunos
-	cv::putText(frame, "Alunos:", cv::Point(yStep, yStart + 19 * yStep), fontFace, 0.4, corFonte2);
-	cv::putText(frame, "    Fernando Salgueiro n. 39", cv::Point(yStep, yStart + 20 * yStep), fontFace, 0.4, corFonte2);
-	cv::putText(frame, "    Hugo Lopes n. 30516", cv::Point(yStep, yStart + 21 * yStep), fontFace, 0.4, corFonte2);
-	cv::putText(frame, "    Claudio Fernandes n. 30517", cv::Point(yStep, yStart + 22 * yStep), fontFace, 0.4, corFonte2);
-	cv::putText(frame, "    Nuno Cruz n. 30518", cv::Point(yStep, yStart + 23 * yStep), fontFace, 0.4, corFonte2);
+		for (i = 0; i < NRESOLUCOES_MICROBENCHMARK; i++)
+		{
+			if (texto == resolucoesMicrobenchmark[i].nome)
+			{
+				width = resolucoesMicrobenchmark[i].width;
+				height = resolucoesMicrobenchmark[i].height;
+			}
+		}
+		if (width == 0) sscanf(texto.c_str(), "%dx%d", &width, &height);
 
-	// Mensagem de instrução
-	sprintf(buffer, "Prima ESC para sair");
-	cv::putText(frame, buffer, cv::Point(1100, yStart + 23 * yStep), fontFace, 0.4, corFonte);
+		// Grelha de 8x6 discos de raio pelo menos 2
+		if ((width < 128) || (height < 96))
+		{
+			fprintf(stderr, "Resolução inválida: %s\n", texto.c_str());
+			return 0;
+		}
 
-	// Atualizar a janela com o frame anotado
-	cv::imshow("Trabalho de Visao por Computador", frame);
-}
+		lista.push_back(std::make_pair(width, height));
+	} while (p != std::string::npos);
 
-#pragma endregion
+	// Variantes SIMD das operações ponto a ponto, comparadas com as escalares
+	int nivelSimd = vc_simd_nivel(), diferentes = 0;
 
-#pragma region Função: resumoTerminal
-/**
- * @brief Exibe no terminal um resumo final da contagem de moedas e do valor total.
- *
- * Esta função apresenta no terminal:
- * - Total geral de moedas detetadas;
- * - Contagem por tipo de moeda (de 1 cêntimo até 2 euros);
- * - Valor total em euros;
- * - Informação adicional sobre como consultar características de cada moeda;
- * - Identificação da instituição, disciplina, professor e alunos.
- *
- * @param total Ponteiro para o array com as contagens por tipo de moeda (total[8] contém o total geral).
- * @param soma Valor total acumulado em euros.
- */
-void resumoTerminal(int* total, float soma)
-{
-	// Cabeçalho do resumo
-	printf("\n\t\t\t\t\t\t\t*********** Resumo final ***************\n");
-	printf("\t\t\t\t\t\t\t---------------------------------------\n\n");
+	printf("\n\t\t\t\t\t\t\tDespacho SIMD: %s (suportado: %s)\n", vc_simd_nome(nivelSimd), vc_simd_nome(vc_simd_suportado()));
+	for (int nivel = VC_SIMD_SSE41; nivel <= nivelSimd; nivel++)
+	{
+		int d = vc_simd_verificar(nivel);
 
-	// Total geral de moedas
-	printf("\t\t\t\t\t\t\t\tTotal de moedas: %d \n\n", total[8]);
+		printf("\t\t\t\t\t\t\t\t%-8s %s\n", vc_simd_nome(nivel), (d == 0) ? "iguais à escalar" : "DIFERENTE da escalar");
+		diferentes += d;
+	}
 
-	// Cabeçalho da tabela
-	printf("\t\t\t\t\t\t\t\tvalor\t\t\tQuant.\n");
+	for (const std::pair<int, int>& resolucao : lista)
+	{
+		int width = resolucao.first, height = resolucao.second;
+		long int pixeis = (long int)width * height;
+		IVC* rgb = vc_image_new(width, height, 3, 255);
+		IVC* rgb2 = vc_image_new(width, height, 3, 255);
+		IVC* hsv = vc_image_new(width, height, 3, 255);
+		IVC* gray = vc_image_new(width, height, 1, 255);
+		IVC* gray2 = vc_image_new(width, height, 1, 255);
+		IVC* binaria = vc_image_new(width, height, 1, 255);
+		IVC* saida = vc_image_new(width, height, 1, 255);
+		IVC* etiquetas = vc_image_new(width, height, 1, 255);
+		IVC* histograma = vc_image_new(256, 256, 1, 255);
+		IVC* borda = vc_image_new_border(width, height, 1, 255, 4, VC_BORDER_REPLICATE, 0);
+		cv::Mat matRgb(height, width, CV_8UC3, rgb->data, rgb->bytesperline);
+		cv::Mat matGray(height, width, CV_8UC1, gray->data, gray->bytesperline);
+		cv::Mat matBinaria(height, width, CV_8UC1, binaria->data, binaria->bytesperline);
+		cv::Mat cvSaida, cvGx, cvGy, cvEtiquetas, cvStats, cvCentroides;
+		MEDICAO_KERNEL m, mcv;
+		PARIDADE par;
+		unsigned int hist[256];
+		unsigned char lut[256];
+		char nome[64];
+		int n = 0, ncv = 0;
+		OVC* blobs;
+
+		imagensMicrobenchmark(rgb, gray, binaria);
+		memcpy(rgb2->data, rgb->data, (size_t)rgb->bytesperline * height);
+		memcpy(gray2->data, gray->data, (size_t)gray->bytesperline * height);
+
+		printf("\n\t\t\t\t\t\t\tMicrobenchmark %dx%d (%ld píxeis):\n", width, height, pixeis);
+
+		// Conversões de cor e operações ponto a ponto, em cada nível SIMD (threshold do OpenCV: acima do
+		// limiar; vc_gray_to_binary: a partir do limiar)
+		for (int nivel = VC_SIMD_ESCALAR; nivel <= nivelSimd; nivel++)
+		{
+			const char* simd = vc_simd_nome(vc_simd_definir(nivel));
+
+			snprintf(nome, sizeof(nome), "vc_gray_negative [%s]", simd);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_gray_negative(gray2); }), NULL, NULL);
+			snprintf(nome, sizeof(nome), "vc_rgb_negative [%s]", simd);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_rgb_negative(rgb2); }), NULL, NULL);
+			snprintf(nome, sizeof(nome), "vc_rgb_get_red_gray [%s]", simd);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_rgb_get_red_gray(rgb2); }), NULL, NULL);
+			snprintf(nome, sizeof(nome), "vc_rgb_get_green_gray [%s]", simd);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_rgb_get_green_gray(rgb2); }), NULL, NULL);
+			snprintf(nome, sizeof(nome), "vc_rgb_get_blue_gray [%s]", simd);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_rgb_get_blue_gray(rgb2); }), NULL, NULL);
+
+			m = medirKernel([&] { vc_rgb_to_gray(rgb, saida); });
+			mcv = medirKernel([&] { cv::cvtColor(matRgb, cvSaida, cv::COLOR_RGB2GRAY); });
+			par = compararImagens(saida, cvSaida, 0, 0);
+			snprintf(nome, sizeof(nome), "vc_rgb_to_gray / cvtColor [%s]", simd);
+			mostrarKernel(nome, pixeis, m, &mcv, &par);
+
+			m = medirKernel([&] { vc_gray_to_binary(gray, saida, 128); });
+			mcv = medirKernel([&] { cv::threshold(matGray, cvSaida, 127, 255, cv::THRESH_BINARY); });
+			par = compararImagens(saida, cvSaida, 0, 0);
+			snprintf(nome, sizeof(nome), "vc_gray_to_binary / threshold [%s]", simd);
+			mostrarKernel(nome, pixeis, m, &mcv, &par);
+
+			snprintf(nome, sizeof(nome), "somarImagens [%s]", simd);
+			mostrarKernel(nome, pixeis, medirKernel([&] { somarImagens(binaria, gray, saida); }), NULL, NULL);
+		}
+		vc_simd_definir(nivelSimd);
 
-	// Contagem por tipo de moeda (em ordem crescente de valor)
-	printf("\t\t\t\t\t\t\t\tt1\tcêntimo:\t%d \n", total[0]);
-	printf("\t\t\t\t\t\t\t\t2\tcêntimos:\t%d \n", total[1]);
-	printf("\t\t\t\t\t\t\t\t5\tcêntimos:\t%d \n", total[2]);
-	printf("\t\t\t\t\t\t\t\t10\tcêntimos:\t%d \n", total[3]);
-	printf("\t\t\t\t\t\t\t\t20\tcêntimos:\t%d \n", total[4]);
-	printf("\t\t\t\t\t\t\t\t50\tcêntimos:\t%d \n", total[5]);
-	printf("\t\t\t\t\t\t\t\t1\teuro:\t\t%d \n", total[6]);
-	printf("\t\t\t\t\t\t\t\t2\teuros:\t\t%d \n", total[7]);
+		mostrarKernel("vc_rgb_to_hsv", pixeis, medirKernel([&] { vc_rgb_to_hsv(rgb, hsv); }), NULL, NULL);
+		mostrarKernel("vc_hsv_segmentation", pixeis, medirKernel([&] { vc_hsv_segmentation(hsv, saida, 12, 150, 35, 255, 20, 150); }), NULL, NULL);
 
-	printf("\t\t\t\t\t\t\t---------------------------------------\n");
+		// Limiarizações
+		mostrarKernel("vc_gray_to_binary_global_mean", pixeis, medirKernel([&] { vc_gray_to_binary_global_mean(gray, saida); }), NULL, NULL);
 
-	// Valor total calculado em euros
-	printf("\t\t\t\t\t\t\t\tValor total: %.2f euros \n", soma);
+		for (int k : janelas)
+		{
+			snprintf(nome, sizeof(nome), "vc_gray_to_binary_midpoint %dx%d", k, k);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_gray_to_binary_midpoint(gray, saida, k); }), NULL, NULL);
+			snprintf(nome, sizeof(nome), "vc_gray_to_binary_bernsen %dx%d", k, k);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_gray_to_binary_bernsen(gray, saida, k, 15); }), NULL, NULL);
+			snprintf(nome, sizeof(nome), "vc_gray_to_binary_niblack %dx%d", k, k);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_gray_to_binary_niblack(gray, saida, k, -0.2f); }), NULL, NULL);
+		}
 
-	printf("\n\t\t\t\t\t\t\t***************************************\n\n");
+		// Morfologia
+		for (int k : janelas)
+		{
+			cv::Mat elemento = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(k, k));
+
+			m = medirKernel([&] { vc_binary_dilate(binaria, saida, k); });
+			mcv = medirKernel([&] { cv::dilate(matBinaria, cvSaida, elemento); });
+			par = compararImagens(saida, cvSaida, k / 2, 1);
+			snprintf(nome, sizeof(nome), "vc_binary_dilate %dx%d / dilate", k, k);
+			mostrarKernel(nome, pixeis, m, &mcv, &par);
+
+			m = medirKernel([&] { vc_binary_erode(binaria, saida, k); });
+			mcv = medirKernel([&] { cv::erode(matBinaria, cvSaida, elemento); });
+			par = compararImagens(saida, cvSaida, k / 2, 1);
+			snprintf(nome, sizeof(nome), "vc_binary_erode %dx%d / erode", k, k);
+			mostrarKernel(nome, pixeis, m, &mcv, &par);
+
+			snprintf(nome, sizeof(nome), "vc_binary_open %dx%d", k, k);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_binary_open(binaria, saida, k, k); }), NULL, NULL);
+			snprintf(nome, sizeof(nome), "vc_binary_close %dx%d", k, k);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_binary_close(binaria, saida, k, k); }), NULL, NULL);
+		}
 
-	// Nota adicional explicativa
-	printf("\t\tNota: pode consultar acima as informações sobre cada moeda (Área(A), Perímetro(P), Circularidade(C), Diâmetro(Ø), Centro(x,y))\n");
-	printf("\t_________________________________________________________________________________________________________________________________________\n\n");
+		// Etiquetagem: connectedComponentsWithStats devolve as etiquetas e as áreas, por isso é comparado
+		// com a etiquetagem seguida das áreas (e, nos runs, também da conversão da máscara em runs)
+		VC_RUNS* runs = vc_runs_new(1024);
+
+		mcv = medirKernel([&] { ncv = cv::connectedComponentsWithStats(matBinaria, cvEtiquetas, cvStats, cvCentroides, 8, CV_32S); });
+
+		mostrarKernel("vc_binary_blob_labelling", pixeis, medirKernel([&] { free(vc_binary_blob_labelling(binaria, etiquetas, &n)); }), NULL, NULL);
+		blobs = vc_binary_blob_labelling(binaria, etiquetas, &n);
+		mostrarKernel("vc_binary_blob_info", pixeis, medirKernel([&] { vc_binary_blob_info(etiquetas, blobs, n); }), NULL, NULL);
+		mostrarKernel("vc_binary_blob_area", pixeis, medirKernel([&] { vc_binary_blob_area(etiquetas, blobs, n); }), NULL, NULL);
+		mostrarKernel("vc_binary_blob_perimeter (todos os blobs)", pixeis, medirKernel([&] { for (int i = 0; i < n; i++) vc_binary_blob_perimeter(etiquetas, &blobs[i]); }), NULL, NULL);
+		free(blobs);
+
+		m = medirKernel([&] { blobs = vc_binary_blob_labelling(binaria, etiquetas, &n); vc_binary_blob_area(etiquetas, blobs, n); free(blobs); });
+		blobs = vc_binary_blob_labelling(binaria, etiquetas, &n);
+		vc_binary_blob_area(etiquetas, blobs, n);
+		par = compararAreas(blobs, n, cvStats, ncv);
+		mostrarKernel("labelling + blob_area / connectedComponentsWithStats", pixeis, m, &mcv, &par);
+		free(blobs);
+
+		mostrarKernel("vc_binary_to_runs", pixeis, medirKernel([&] { vc_binary_to_runs(binaria, runs); }), NULL, NULL);
+		mostrarKernel("vc_runs_labelling", pixeis, medirKernel([&] { free(vc_runs_labelling(runs, &n)); }), NULL, NULL);
+		blobs = vc_runs_labelling(runs, &n);
+		mostrarKernel("vc_runs_blob_info", pixeis, medirKernel([&] { vc_runs_blob_info(runs, blobs, n); }), NULL, NULL);
+		mostrarKernel("vc_runs_paint", pixeis, medirKernel([&] { vc_runs_paint(runs, etiquetas); }), NULL, NULL);
+		free(blobs);
+
+		m = medirKernel([&] { vc_binary_to_runs(binaria, runs); blobs = vc_runs_labelling(runs, &n); vc_runs_blob_info(runs, blobs, n); free(blobs); });
+		vc_binary_to_runs(binaria, runs);
+		blobs = vc_runs_labelling(runs, &n);
+		vc_runs_blob_info(runs, blobs, n);
+		par = compararAreas(blobs, n, cvStats, ncv);
+		mostrarKernel("runs + labelling + blob_info / connectedComp.", pixeis, m, &mcv, &par);
+		free(blobs);
+
+		m = medirKernel([&] { free(vc_runs_labelling_parallel(binaria, runs, &n, 0)); });
+		blobs = vc_runs_labelling_parallel(binaria, runs, &n, 0);
+		par = compararAreas(blobs, n, cvStats, ncv);
+		mostrarKernel("vc_runs_labelling_parallel / connectedComp.", pixeis, m, &mcv, &par);
+		free(blobs);
+		vc_runs_free(runs);
+
+		// Histogramas
+		mostrarKernel("vc_gray_histogram", pixeis, medirKernel([&] { vc_gray_histogram(gray, hist); }), NULL, NULL);
+		mostrarKernel("vc_histogram_equalization_lut", 256, medirKernel([&] { vc_histogram_equalization_lut(hist, lut); }), NULL, NULL);
+		mostrarKernel("vc_gray_lut", pixeis, medirKernel([&] { vc_gray_lut(gray, saida, lut); }), NULL, NULL);
+		mostrarKernel("vc_gray_histogram_equalization", pixeis, medirKernel([&] { vc_gray_histogram_equalization(gray, saida); }), NULL, NULL);
+		mostrarKernel("vc_gray_histogram_show", pixeis, medirKernel([&] { vc_gray_histogram_show(gray, histograma); }), NULL, NULL);
+
+		// Contornos (vc_gray_edge_sobel não calcula a primeira e a última linha e coluna)
+		mostrarKernel("vc_gray_edge_prewitt", pixeis, medirKernel([&] { vc_gray_edge_prewitt(gray, saida, 30.0f); }), NULL, NULL);
+		m = medirKernel([&] { vc_gray_edge_sobel(gray, saida, 30.0f); });
+		mcv = medirKernel([&] { cv::Sobel(matGray, cvGx, CV_16S, 1, 0, 3); cv::Sobel(matGray, cvGy, CV_16S, 0, 1, 3); });
+		binarizarSobel(cvGx, cvGy, cvSaida, 30.0f);
+		par = compararImagens(saida, cvSaida, 1, 0);
+		mostrarKernel("vc_gray_edge_sobel / Sobel", pixeis, m, &mcv, &par);
+
+		// Filtros
+		for (int k : janelas)
+		{
+			snprintf(nome, sizeof(nome), "vc_gray_lowpass_mean_filter %dx%d", k, k);
+			mostrarKernel(nome, pixeis, medirKernel([&] { vc_gray_lowpass_mean_filter(gray, saida, k); }), NULL, NULL);
+
+			m = medirKernel([&] { vc_gray_lowpass_median_filter(gray, saida, k); });
+			mcv = medirKernel([&] { cv::medianBlur(matGray, cvSaida, k); });
+			par = compararImagens(saida, cvSaida, k / 2, 0);
+			snprintf(nome, sizeof(nome), "vc_gray_lowpass_median_filter %dx%d / medianBlur", k, k);
+			mostrarKernel(nome, pixeis, m, &mcv, &par);
+		}
 
-	// Informações institucionais e de identificação
-	printf("\t\t\t\t\t\t\tIPCA\n");
-	printf("\t\t\t\t\t\t\tEscola Superior de Tecnologia\n");
-	printf("\t\t\t\t\t\t\tEngenharia de Sistemas Informáticos PL\n");
-	printf("\t\t\t\t\t\t\t2024/2025\n\n");
-	printf("\t\t\t\t\t\t\tVisão por Computador\n");
-	printf("\t\t\t\t\t\t\tProfessor: Simão Valente\n\n");
-	printf("\t\t\t\t\t\t\tAlunos:\n");
-	printf("\t\t\t\t\t\t\t\tFernando Salgueiro n. 39\n");
-	printf("\t\t\t\t\t\t\t\tHugo Lopes n. 30516\n");
-	printf("\t\t\t\t\t\t\t\tCláudio Fernandes n. 30517\n");
-	printf("\t\t\t\t\t\t\t\tNuno Cruz n. 30518\n\n");
+		mostrarKernel("vc_gray_lowpass_gaussian_filter", pixeis, medirKernel([&] { vc_gray_lowpass_gaussian_filter(gray, saida); }), NULL, NULL);
+		mostrarKernel("vc_gray_highpass_filter", pixeis, medirKernel([&] { vc_gray_highpass_filter(gray, saida); }), NULL, NULL);
+		mostrarKernel("vc_gray_highpass_filter_enhance", pixeis, medirKernel([&] { vc_gray_highpass_filter_enhance(gray, saida, 2); }), NULL, NULL);
+
+		// Outras
+		mostrarKernel("vc_image_sad", pixeis, medirKernel([&] { sumidouroMicrobenchmark = vc_image_sad(gray, gray2, 1); }), NULL, NULL);
+		mostrarKernel("vc_image_fill_border (borda de 4)", pixeis, medirKernel([&] { vc_image_fill_border(borda); }), NULL, NULL);
+
+		vc_image_free(rgb);
+		vc_image_free(rgb2);
+		vc_image_free(hsv);
+		vc_image_free(gray);
+		vc_image_free(gray2);
+		vc_image_free(binaria);
+		vc_image_free(saida);
+		vc_image_free(etiquetas);
+		vc_image_free(histograma);
+		vc_image_free(borda);
+	}
 
-	// Mensagem de encerramento
-	printf("\t\t\t\t\t\t\t\tObrigado                      ");
-	printf("\n\t_________________________________________________________________________________________________________________________________________\n\n");
+	return (diferentes == 0) ? 1 : 0;
 }
 
 #pragma endregion
@@ -14,6 +14,11 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <string>
 
 #define VC_DEBUG
 #define _CRT_SECURE_NO_WARNINGS
@@ -30,17 +35,77 @@ typedef struct {
 	int width, height;
 	int channels;			// Binrio/Cinzentos=1; RGB=3
 	int levels;				// Binrio=2; Cinzentos [1,256]; RGB [1,256]
-	int bytesperline;		// width * channels
+	int bytesperline;		// width * channels (+ 2 * border * channels com borda)
+	int border;				// Largura da borda de guarda em pxeis (0 = sem borda; ver vc_image_new_border)
+	int bordertype;			// VC_BORDER_REPLICATE, VC_BORDER_CONSTANT ou VC_BORDER_REFLECT
+	int bordervalue;		// Valor da borda constante
 } IVC;
 
+// Bordas de guarda: pxeis fora da imagem, preenchidos por vc_image_fill_border, que permitem
+// aos operadores de vizinhana ler a janela completa em toda a imagem sem verificar limites
+#define VC_BORDER_REPLICATE	0		// aaa|abcd|ddd
+#define VC_BORDER_CONSTANT	1		// vvv|abcd|vvv
+#define VC_BORDER_REFLECT	2		// dcb|abcd|cba (sem repetir o pxel do limite)
+
 typedef struct {
 	int x, y, width, height;	// Caixa Delimitadora (Bounding Box)
 	int area;					// rea
 	int xc, yc;					// Centro-de-massa
-	int perimetro;				// Permetro
+	int perimetro;				// Permetro (pxeis de contorno)
 	int label;					// Etiqueta
+	float perimetroCorrigido;	// Permetro com correo de cantos (cdigo de cadeia do contorno)
+	int diametro;				// Dimetro estimado ((largura + altura) / 2)
+	float circularidade;		// Circularidade (4*PI*rea / Permetro)
+	int estado;					// Caractersticas j avaliadas (uso da aplicao)
 } OVC;
 
+// Tabela de blobs em estrutura de arrays: um array contguo por caracterstica
+enum {
+	VC_BLOB_X, VC_BLOB_Y, VC_BLOB_WIDTH, VC_BLOB_HEIGHT,	// Caixa Delimitadora
+	VC_BLOB_AREA,											// rea
+	VC_BLOB_XC, VC_BLOB_YC,									// Centro-de-massa
+	VC_BLOB_PERIMETRO,										// Permetro
+	VC_BLOB_LABEL,											// Etiqueta
+	VC_BLOB_DIAMETRO,										// Dimetro estimado
+	VC_BLOB_ESTADO,											// Caractersticas j avaliadas
+	VC_BLOB_NCAMPOS_BASE									// Primeiro campo extra (vc_blobs_add_field)
+};
+
+// Campos em vrgula flutuante
+enum {
+	VC_BLOBF_CIRCULARIDADE,									// Circularidade
+	VC_BLOBF_PERIMETRO_CORRIGIDO,							// Permetro com correo de cantos
+	VC_BLOBF_NCAMPOS_BASE									// Primeiro campo extra (vc_blobs_add_field_f)
+};
+
+#define VC_BLOB_MAXCAMPOS	16
+
+typedef struct {
+	int n;							// Nmero de blobs
+	int capacidade;					// Nmero mximo de blobs
+	int ncampos;					// Nmero de campos (base + extra)
+	int* campo[VC_BLOB_MAXCAMPOS];	// campo[c][i]: caracterstica c do blob i
+	int ncamposf;					// Nmero de campos em vrgula flutuante
+	float* campof[VC_BLOB_MAXCAMPOS];// campof[c][i]: caracterstica c (vrgula flutuante) do blob i
+} VC_BLOBS;
+
+// Mscara binria em RLE: runs (segmentos horizontais de primeiro plano) por ordem de varrimento
+typedef struct {
+	int n;							// Nmero de runs
+	int capacidade;					// Nmero de runs alocados
+	int width, height;				// Dimenses da mscara
+	int* y;							// y[r]: linha do run r
+	int* x0;						// x0[r]: primeira coluna do run r
+	int* x1;						// x1[r]: ltima coluna do run r
+	int* label;						// label[r]: etiqueta do blob do run r (vc_runs_labelling)
+	int* seguinte;					// seguinte[r]: run seguinte do mesmo blob (-1 no ltimo)
+	int* linha;						// linha[y]: primeiro run da linha y (height + 1 entradas)
+	int capacidadeLinhas;			// Nmero de entradas alocadas em linha
+	int nblobs;						// Nmero de blobs (vc_runs_labelling)
+	int* primeiro;					// primeiro[label - 1]: primeiro run do blob
+	int capacidadeBlobs;			// Nmero de entradas alocadas em primeiro
+} VC_RUNS;
+
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //                    PROTTIPOS DE FUNES
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -48,11 +113,67 @@ typedef struct {
 // FUNES: ALOCAR E LIBERTAR UMA IMAGEM
 IVC* vc_image_new(int width, int height, int channels, int levels);
 IVC* vc_image_free(IVC* image);
+IVC* vc_image_new_border(int width, int height, int channels, int levels, int border, int bordertype, int bordervalue);
+int vc_image_fill_border(IVC* image);
 
 // FUNES: LEITURA E ESCRITA DE IMAGENS (PBM, PGM E PPM)
 IVC* vc_read_image(char* filename);
 int vc_write_image(char* filename, IVC* image);
 
+// FUNES: GRAVAO DE SEQUNCIAS DE IMAGENS (VCR)
+#define VC_REC_MASCARA		0		// Mscara binria (0/255)
+#define VC_REC_ETIQUETAS	1		// Imagem de etiquetas (sada da etiquetagem)
+#define VC_REC_FRAME		2		// Frame original (BGR)
+
+#define VC_REC_RAW			0		// Dados sem compresso
+#define VC_REC_RLE			1		// Imagens de 1 canal comprimidas em RLE
+
+typedef struct VC_GRAVADOR VC_GRAVADOR;
+typedef struct VC_LEITOR VC_LEITOR;
+
+VC_GRAVADOR* vc_gravador_abrir(const char* filename, int compressao); //cria um ficheiro .vcr e inicia a thread de escrita
+int vc_gravador_escrever(VC_GRAVADOR* gravador, IVC* image, int nframe, int tipo); //acrescenta uma cpia da imagem  fila de escrita
+int vc_gravador_fechar(VC_GRAVADOR* gravador); //esvazia a fila, escreve o ndice e fecha o ficheiro
+VC_LEITOR* vc_leitor_abrir(const char* filename); //abre um ficheiro .vcr para leitura
+int vc_leitor_nregistos(VC_LEITOR* leitor); //nmero de imagens gravadas
+int vc_leitor_info(VC_LEITOR* leitor, int indice, int* nframe, int* tipo); //nmero do frame e tipo de um registo
+IVC* vc_leitor_ler(VC_LEITOR* leitor, int indice, int* nframe, int* tipo); //l a imagem com o ndice dado
+void vc_leitor_fechar(VC_LEITOR* leitor);
+
+// FUNES: TABELA DE BLOBS (ESTRUTURA DE ARRAYS)
+VC_BLOBS* vc_blobs_new(int capacidade);
+VC_BLOBS* vc_blobs_free(VC_BLOBS* blobs);
+int vc_blobs_add_field(VC_BLOBS* blobs); //acrescenta um campo (ex.: momentos, cor mdia); retorna o seu ndice
+int vc_blobs_add_field_f(VC_BLOBS* blobs); //acrescenta um campo em vrgula flutuante; retorna o seu ndice
+int vc_blobs_from_ovc(VC_BLOBS* blobs, OVC* src, int n);
+int vc_blobs_to_ovc(VC_BLOBS* blobs, OVC* dst);
+int vc_blobs_range_mask(VC_BLOBS* blobs, int campo, int min, int max, unsigned char* manter); //marca os blobs com o campo em [min, max]
+int vc_blobs_compact(VC_BLOBS* blobs, const unsigned char* manter); //mantm s os blobs marcados (pela mesma ordem)
+int vc_blobs_filter_range(VC_BLOBS* blobs, int campo, int min, int max); //mantm os blobs com o campo em [min, max]
+
+// FUNES: RUNS (MSCARAS EM RLE)
+VC_RUNS* vc_runs_new(int capacidade);
+VC_RUNS* vc_runs_free(VC_RUNS* runs);
+int vc_binary_to_runs(IVC* src, VC_RUNS* runs); //converte uma mscara binria nos seus runs; retorna o nmero de runs
+OVC* vc_runs_labelling(VC_RUNS* runs, int* nlabels); //etiquetagem dos runs (e lista de runs de cada blob)
+int vc_runs_blob_info(VC_RUNS* runs, OVC* blobs, int nblobs); //rea, caixa, centro de massa e permetro calculados sobre os runs
+OVC* vc_runs_labelling_parallel(IVC* src, VC_RUNS* runs, int* nlabels, int nthreads); //runs, etiquetagem e caractersticas em faixas paralelas (0 = automtico)
+int vc_runs_filter_area(VC_RUNS* runs, OVC* blobs, int nblobs, int areamin); //mantm s os blobs com a rea mnima e renumera as etiquetas
+int vc_runs_paint(VC_RUNS* runs, IVC* dst); //imagem de etiquetas dos runs
+
+// FUNES: DESPACHO SIMD (OPERAES PONTO A PONTO)
+#define VC_SIMD_ESCALAR		0		// Ciclos em C (referncia)
+#define VC_SIMD_SSE41		1		// SSE4.1 (16 bytes por instruo)
+#define VC_SIMD_AVX2		2		// AVX2 (32 bytes)
+#define VC_SIMD_AVX512		3		// AVX-512 F e BW (64 bytes)
+
+int vc_simd_suportado(void); //nvel SIMD mais alto suportado (lido uma vez do CPUID)
+int vc_simd_nivel(void); //nvel SIMD em uso pelas operaes ponto a ponto
+int vc_simd_definir(int nivel); //limita o nvel SIMD (negativo = o suportado); retorna o nvel em uso
+const char* vc_simd_nome(int nivel); //"escalar", "sse4.1", "avx2" ou "avx512"
+int vc_simd_procurar(const char* nome); //nvel com o nome dado (-1 se no existe)
+int vc_simd_verificar(int nivel); //compara os kernels de um nvel com os escalares; retorna o nmero de kernels diferentes
+
 // FUNES: ESPAOS DE CORES
 int vc_gray_negative(IVC* srcdst); //calcula o negativo de uma imagem Gray
 
@@ -74,7 +195,16 @@ int vc_binary_erode(IVC* src, IVC* dst, int kernel);//eros
 int vc_binary_open(IVC* src, IVC* dst, int kernelsizeErode, int kernelsizeDilate);//abertura de uma imagem Binria
 int vc_binary_close(IVC* src, IVC* dst, int kernelsizeDilate, int kernelsizeErode);//fecho de uma imagem Binria
 OVC* vc_binary_blob_labelling(IVC* src, IVC* dst, int* nlabels);//etiquetagem de blobs numa imagem Binria
+extern long int vc_etiquetas_excedidas;//etiquetagens em que as 254 etiquetas provisrias no chegaram (refeitas sobre os runs)
 int vc_binary_blob_info(IVC* src, OVC* blobs, int nblobs);//informao de blobs numa imagem Binria
+int vc_binary_blob_area(IVC* src, OVC* blobs, int nblobs);//rea, caixa e centro de massa de todos os blobs numa s passagem
+int vc_binary_blob_perimeter(IVC* src, OVC* blob);//permetro de um blob (seguimento do contorno)
+int vc_binary_blob_contour(IVC* src, OVC* blob, unsigned char* cadeia, int max);//cdigo de cadeia do contorno exterior de um blob
+float vc_chain_perimeter(const unsigned char* cadeia, int n);//permetro com correo de cantos de um cdigo de cadeia
+#define VC_HISTOGRAMA_PIXEIS_THREAD	(1 << 19)	// Pxeis por thread no histograma e nas LUT (imagens menores: uma thread)
+int vc_gray_histogram(IVC* src, unsigned int* hist); //histograma (256 nveis) de uma imagem Gray
+int vc_histogram_equalization_lut(const unsigned int* hist, unsigned char* lut); //LUT de equalizao (CDF inteira) de um histograma
+int vc_gray_lut(IVC* src, IVC* dst, const unsigned char* lut); //aplica uma LUT de 256 entradas a cada byte de uma imagem
 IVC* vc_gray_histogram_show(IVC* src, IVC* dst);//histograma de uma imagem Gray
 int vc_gray_histogram_equalization(IVC* src, IVC* dst); //equalizao de histograma de uma imagem Gray
 int vc_gray_edge_prewitt(IVC* src, IVC* dst, float th); //deteco de bordas numa imagem Gray com filtro de Prewitt
@@ -84,6 +214,8 @@ int vc_gray_lowpass_median_filter(IVC* src, IVC* dst, int kernel); //filtro pass
 int vc_gray_lowpass_gaussian_filter(IVC* src, IVC* dst); //filtro passa-baixa gaussiano de uma imagem Gray
 int vc_gray_highpass_filter(IVC* src, IVC* dst); //filtro passa-alta de uma imagem Gray
 int vc_gray_highpass_filter_enhance(IVC* src, IVC* dst, int gain); //filtro passa-alta de uma imagem Gray com ganho
+long long vc_image_sad(IVC* src1, IVC* src2, int passo); //soma das diferenas absolutas entre duas imagens (uma linha em cada passo)
+float vc_image_sad_blocos(IVC* src1, IVC* src2, int passo, int bloco); //maior diferena mdia por byte entre clulas de bloco x bloco pxeis
 
 //**************************************//
 // 										//
@@ -97,21 +229,357 @@ int vc_gray_highpass_filter_enhance(IVC* src, IVC* dst, int gain); //filtro pass
 //										//
 //**************************************//
 
+// Fonte dos frames (ver abrirEntrada)
+#define FONTE_VIDEO			0		// Vdeo escolhido no menu (cv::VideoCapture)
+#define FONTE_STDIN			1		// Frames em bruto lidos do stdin (ex.: ffmpeg ... -f rawvideo -)
+#define FONTE_SHM			2		// Anel de memria partilhada POSIX preenchido por um processo de captura
+
+#define FORMATO_BGR			0		// 3 bytes por pxel (B, G, R)
+#define FORMATO_YUV420		1		// YUV 4:2:0 planar (I420): Y, U e V, width * height * 3 / 2 bytes
+
+typedef struct {
+	int tipo;				// FONTE_*
+	int width, height;		// Dimenses dos frames (memria partilhada: lidas do cabealho)
+	int formato;			// FORMATO_* (memria partilhada: lido do cabealho)
+	float fps;				// Frames por segundo declarados (0 = 30)
+	char nome[256];			// Nome da memria partilhada (ex.: /moedas)
+} FONTE;
+
+// Cabealho do anel de memria partilhada (no incio do objeto, seguido dos frames a partir de SHM_DADOS).
+// O processo de captura escreve o frame i no lugar i % nlugares e s depois incrementa `escritos`.
+#define SHM_DADOS			64
+
+typedef struct {
+	char magic[4];					// "VCSH"
+	uint32_t width, height;
+	uint32_t formato;				// FORMATO_*
+	uint32_t nlugares;				// Nmero de lugares do anel
+	uint32_t tamanho;				// Bytes por lugar (>= bytes de um frame)
+	std::atomic<uint64_t> escritos;	// Frames completos escritos desde o incio
+	std::atomic<uint32_t> fim;		// 1 quando o processo de captura termina
+} SHM_CABECALHO;
+
+// Opes da linha de comandos
+typedef struct {
+	char gravar[256];		// Ficheiro .vcr onde gravar as mscaras (vazio = no grava)
+	int gravarEtiquetas;	// Grava tambm a imagem de etiquetas de cada frame
+	int gravarFrames;		// Grava tambm o frame original de cada frame
+	char reproduzir[256];	// Ficheiro .vcr a reproduzir em vez de um vdeo
+	float movimento;		// Limiar do detetor de movimento (diferena mdia por byte numa clula; 0 = desativado)
+	char moedas[256];		// Ficheiro com a tabela de moedas (vazio = moedas.txt)
+	int piramide;			// Fator de reduo da segmentao (2 ou 4; 0 = resoluo original)
+	int decimar;			// Processa s um frame em cada k
+	float decimarAlvo;		// Throughput alvo da decimao (frames de vdeo por segundo; 0 = sem alvo)
+	float previsualizar;	// Escala da janela (0 = tamanho original)
+	int antecipar;			// Frames descodificados antecipadamente (0 = ANTECIPAR_FRAMES)
+	char saida[256];		// Vdeo anotado a gravar (vazio = no grava)
+	int saidaEventos;		// S grava os n frames antes e depois de cada moeda contada (0 = todos)
+	int saidaEsperar;		// Com a fila de escrita cheia, espera (em vez de descartar o frame)
+	FONTE entrada;			// Fonte dos frames (FONTE_VIDEO = menu)
+	char metricas[256];		// Ficheiro ou "unix:<caminho>" onde exportar as mtricas (vazio = desativadas)
+	int metricasPeriodo;	// Perodo de exportao das mtricas (ms; 0 = METRICAS_PERIODO)
+	char eventos[256];		// Ficheiro .csv ou .ndjson com as moedas contadas (vazio = s o terminal)
+	char gerar[256];		// Cenrio do vdeo sinttico a escrever no stdout (vazio = no gera)
+	char verdade[256];		// Ficheiro da verdade do vdeo sinttico (vazio = verdade.csv)
+	char benchmark[256];	// Cenrios sintticos a medir, separados por ';' (vazio = sem benchmark)
+	char microbenchmark[256];	// Resolues do microbenchmark das funes vc_*, separadas por ';' (vazio = sem microbenchmark)
+	int simd;				// Nvel SIMD mximo das operaes ponto a ponto (VC_SIMD_*; -1 = o suportado)
+} OPCOES;
+
+// Requisitos mnimos de uma moeda
+#define AREA_MINIMA				10000
+#define PERIMETRO_MINIMO		300
+#define CIRCULARIDADE_MINIMA	0.40f
+#define CIRCULARIDADE_CAIXA		0.50f	// Circularidade mnima para desenhar a caixa da moeda (desenhaBox)
+#define DIAMETRO_MINIMO			115		// Dimetro mnimo para desenhar a caixa da moeda (desenhaBox)
+
+// Etapas da cascata de avaliao dos blobs (bits de OVC::estado)
+#define ETAPA_AREA				1		// rea mnima
+#define ETAPA_LINHA				2		// Centro na linha de reconhecimento
+#define ETAPA_PERIMETRO			4		// Permetro mnimo (permetro calculado)
+#define ETAPA_CIRCULARIDADE		8		// Circularidade mnima (circularidade calculada)
+
+// Estatsticas da cascata de avaliao
+typedef struct {
+	long int nblobs;			// Blobs avaliados
+	long int narea;				// Com a rea mnima (permetro calculado)
+	long int nlinha;			// Com a rea mnima e na linha de reconhecimento
+	long int nperimetro;		// Com o permetro mnimo (circularidade calculada)
+	long int ncircularidade;	// Com a circularidade mnima
+} CASCATA;
+
+extern CASCATA cascata;
+
+// Detetor de movimento (salta o processamento de frames sem alteraes)
+typedef struct {
+	float limiar;			// Diferena mdia por byte, numa clula, a partir da qual h movimento
+	int passo;				// Distncia entre as linhas comparadas
+	int bloco;				// Lado das clulas comparadas (pxeis)
+	IVC* referencia;		// Cpia do ltimo frame processado
+	long int nframes;		// Frames avaliados
+	long int nsaltados;		// Frames cujo processamento foi saltado
+	int nframeReferencia;	// Frame em que a referncia foi copiada
+} MOVIMENTO;
+
+// Rastreador de moedas (identificadores persistentes, previso com velocidade constante)
+#define MAX_RASTOS 64
+
+typedef struct {
+	int id;					// Identificador persistente
+	float x, y;				// ltima posio medida (centro de massa)
+	float yanterior;		// Posio Y na observao anterior (para detetar a passagem na linha)
+	float vx, vy;			// Velocidade estimada (pxeis por frame)
+	float raio;				// Raio da moeda (janela de associao)
+	int nframe;				// Frame da ltima associao
+	int nassociacoes;		// Nmero de frames em que a moeda foi observada
+	int contada;			// 1 se a moeda j foi contada
+} RASTO;
+
+typedef struct {
+	RASTO rastos[MAX_RASTOS];
+	int nrastos;
+	int proximoId;			// Identificador do prximo rasto
+	int maxPerdido;			// Frames sem associao at o rasto ser removido
+} RASTREADOR;
+
+extern RASTREADOR rastreador;
+
+// Tabela de moedas (estrutura de arrays: um intervalo por caracterstica e por moeda)
+#define MAX_MOEDAS 32
+
+typedef struct {
+	int n;						// Nmero de moedas
+	int valor[MAX_MOEDAS];		// Valor em cntimos
+	int indice[MAX_MOEDAS];		// Posio no array de contagens (-1 = s no total)
+	float diamMin[MAX_MOEDAS], diamMax[MAX_MOEDAS];
+	float areaMin[MAX_MOEDAS], areaMax[MAX_MOEDAS];
+	float perimMin[MAX_MOEDAS], perimMax[MAX_MOEDAS];
+	float circMin[MAX_MOEDAS];	// Circularidade mnima (exclusiva)
+} TABELA_MOEDAS;
+
+extern TABELA_MOEDAS tabelaMoedas;
+
+// Decimao adaptativa (processa um frame em cada k)
+typedef struct {
+	float alvo;				// Throughput alvo (frames de vdeo por segundo; 0 = sem alvo)
+	int k;					// Frames a avanar at ao prximo frame processado
+	int kalvo;				// k pedido pelo controlo de throughput
+	int kmax;				// Limite de k
+	float vmax;				// Velocidade mxima observada das moedas (pxeis por frame)
+	int velocidadeConhecida;// 1 depois da primeira velocidade observada
+	double throughput;		// Frames de vdeo consumidos por segundo (mdia exponencial)
+	std::chrono::steady_clock::time_point anterior; // Instante do ltimo frame processado
+	long int nlidos;		// Frames lidos do vdeo
+	long int nprocessados;	// Frames processados
+} DECIMACAO;
+
+// Sobreposio do frame (primitivas acumuladas durante a anlise e desenhadas de uma s vez)
+#define MAX_PRIMITIVAS 256
+
+#define PRIMITIVA_CAIXA		0		// Contorno de uma caixa (x, y, width, height, inclusivo)
+#define PRIMITIVA_CRUZ		1		// Cruz centrada em (x, y) com braos de comprimento width (horizontal em corHorizontal)
+#define PRIMITIVA_LINHA		2		// Linha horizontal de (x, y) com comprimento width
+#define PRIMITIVA_TEXTO		3		// Texto com origem em (x, y)
+#define PRIMITIVA_AVISO		4		// Aviso "MOEDA DETETADA" da camada do HUD, em torno da linha y
+
+typedef struct {
+	int tipo;				// PRIMITIVA_*
+	int x, y;				// Posio (ver PRIMITIVA_*)
+	int width, height;		// Dimenses (ver PRIMITIVA_*)
+	unsigned char cor[3];	// Cor (B, G, R)
+	unsigned char corHorizontal[3];	// Cor do brao horizontal (cruz; por omisso igual a cor)
+	float escala;			// Escala da fonte (texto)
+	char texto[160];		// Texto (texto)
+} PRIMITIVA;
+
+typedef struct {
+	PRIMITIVA primitivas[MAX_PRIMITIVAS];
+	int n;						// Nmero de primitivas do frame
+	long int ndescartadas;		// Primitivas descartadas por falta de espao
+} SOBREPOSICAO;
+
+extern SOBREPOSICAO sobreposicao;
+
+// HUD: camadas estticas desenhadas uma vez por resoluo e copiadas para cada frame
+typedef struct {
+	int y, x0, x1;			// Linha e colunas (inclusivo) de um segmento de pxeis com contedo
+} SEGMENTO_HUD;
+
+typedef struct {
+	int width, height, type;	// Frame para o qual a camada foi desenhada (width = 0: por desenhar)
+	int chave[3];				// Outros parmetros do contedo (resoluo do vdeo, total de frames, ...)
+	cv::Mat sprite;				// Contedo esttico da camada
+	std::vector<SEGMENTO_HUD> segmentos;	// Mscara do sprite (pxeis com contedo, por segmentos)
+} CAMADA_HUD;
+
+typedef struct {
+	CAMADA_HUD resumo;		// Textos fixos de resumoFrame
+	CAMADA_HUD aviso;		// Aviso "MOEDA DETETADA" e linha de reconhecimento vermelha
+	long int ndesenhadas;	// Nmero de vezes que uma camada foi (re)desenhada
+} HUD;
+
+extern HUD hud;
+
+// Janela de visualizao com thread prpria (ver abrirEcra)
+typedef struct ECRA ECRA;
+
+// Descodificao antecipada do vdeo numa thread prpria (ver abrirDescodificador)
+#define ANTECIPAR_FRAMES	4		// Frames no anel por omisso
+#define ANTECIPAR_MAX		64
+
+typedef struct DESCODIFICADOR DESCODIFICADOR;
+
+// Gravao do vdeo anotado numa thread prpria (ver abrirEscritor)
+#define ESCRITOR_FILA_MAX	16		// Nmero mximo de frames  espera de codificao
+#define ESCRITOR_EVENTOS_MAX	120	// Mximo de frames antes e depois de cada evento
+
+typedef struct ESCRITOR ESCRITOR;
+
+// Mtricas: contadores por thread (sem sincronizao no processamento), agregados e exportados
+// em formato de texto Prometheus por uma thread prpria (ver abrirMetricas)
+#define METRICAS_PERIODO	1000	// Perodo de exportao por omisso (ms)
+#define METRICA_NBALDES		12		// Baldes dos histogramas (mais o +Inf)
+
+enum {
+	METRICA_FRAMES,					// Frames processados
+	METRICA_FRAMES_SEM_MOVIMENTO,	// Frames com a segmentao saltada (detetor de movimento)
+	METRICA_CANDIDATAS,				// Moedas candidatas (rea e permetro mnimos)
+	METRICA_ETIQUETAS_EXCEDIDAS,	// Etiquetagens com mais blobs do que etiquetas
+	METRICA_ECRA_DESCARTADOS,		// Frames substitudos antes de serem mostrados
+	METRICA_ESCRITOR_DESCARTADOS,	// Frames no gravados (fila de escrita cheia)
+	METRICA_NCONTADORES
+};
+
+enum {
+	TEMPO_SEGMENTACAO,				// segmentarMoedas
+	TEMPO_ETIQUETAGEM,				// etiquetarMoedas (etiquetagem e cascata de avaliao)
+	TEMPO_PIRAMIDE,					// detetarMoedasPiramide (segmentao e etiquetagem reduzidas)
+	TEMPO_ANALISE,					// processarBlobs (seguimento, classificao, contagem e anotaes)
+	TEMPO_APRESENTACAO,				// resumoFrame e envio para a janela e para o vdeo de sada
+	TEMPO_FRAME,					// Frame completo (desde que  obtido do descodificador)
+	METRICA_NTEMPOS
+};
+
+enum {
+	FILA_DESCODIFICADOR,			// Frames descodificados  espera de processamento
+	FILA_ESCRITOR,					// Frames  espera de codificao
+	METRICA_NFILAS
+};
+
+// Registo de eventos: cada moeda contada  colocada num anel sem locks (um produtor, um consumidor)
+// e escrita no terminal e no ficheiro de eventos por uma thread prpria (ver abrirEventos)
+#define EVENTOS_CAPACIDADE	1024	// Eventos no anel (potncia de 2)
+
+typedef struct {
+	int nframe;					// Frame em que a moeda foi medida
+	long long tempo;			// Instante do evento (us desde abrirEventos)
+	int valor;					// Valor em cntimos
+	int area, perimetro, diametro;
+	float circularidade;
+	int xc, yc;					// Centro de massa
+} EVENTO_MOEDA;
+
+// Vdeo sinttico: moedas de verdade conhecida a descer pelo frame (ver abrirGerador)
+typedef struct {
+	char nome[32];			// Cenrio predefinido de origem (ver lerCenario)
+	int width, height;		// Resoluo
+	int nframes;			// Frames a gerar
+	float velocidade;		// Velocidade das moedas (pxeis por frame, de cima para baixo)
+	float densidade;		// Nmero mdio de moedas visveis em cada frame
+	int encostadas;			// Percentagem de moedas lanadas encostadas a outra
+	float ruido;			// Desvio-padro do rudo gaussiano (nveis)
+	int distratores;		// Blobs pequenos (que nunca so moedas) por frame
+	unsigned int semente;	// Semente do gerador pseudoaleatrio
+} CENARIO;
+
+typedef struct {
+	int id;					// Identificador (ordem de lanamento, a partir de 1)
+	int tipo;				// ndice na tabela de moedas
+	float x, y0;			// Centro no primeiro frame (y0 < 0: acima do frame)
+	float raio;				// Raio calibrado (ver abrirGerador)
+	int nframeLinha;		// Primeiro frame (a contar de 1) com o centro na linha de reconhecimento ou abaixo
+} MOEDA_SINTETICA;
+
+typedef struct GERADOR GERADOR;
+
+extern OPCOES opcoes;
+
+int lerOpcoes(int argc, char** argv, OPCOES* opcoes);
 int escolherVideo(char* videofile);
-void filtrarMoedas(cv::Mat& frame, float* soma, int* total);
+void filtrarMoedas(cv::Mat& frame, int nframe, float* soma, int* total);
+void segmentarMoedas(cv::Mat& frame, IVC* mascara, int kernelSize);
+OVC* detetarMoedasPiramide(cv::Mat& frame, int escala, IVC* mascara, int* nblobs);
+void analisarMoedas(cv::Mat& frame, IVC* mascara, int nframe, float* soma, int* total);
+OVC* etiquetarMoedas(IVC* mascara, int linha, int* nlabels);
+void avaliarBlobs(IVC* etiquetas, OVC* blobs, int nblobs, int linha);
+void resumoCascata(CASCATA* cascata);
+void processarBlobs(cv::Mat& frame, OVC* blobs, int nlabels, int nframe, float* soma, int* total);
+int blobNaLinha(OVC& blob, int linha);
+int verificarMovimento(MOVIMENTO* movimento, cv::Mat& frame, OVC* blobs, int nblobs, int linha, int nframe, RASTREADOR* rastreador);
+void resumoMovimento(MOVIMENTO* movimento);
+void iniciarDecimacao(DECIMACAO* decimacao, float alvo);
+int calcularDecimacao(DECIMACAO* decimacao, RASTREADOR* rastreador, int nframe);
+void resumoDecimacao(DECIMACAO* decimacao);
+int reproduzirGravacao(const char* ficheiro, float* soma, int* total);
 int bgr_to_rgb(const cv::Mat& imagemEntrada, IVC* imagemSaida);
 int tipoMoedas(int perimetro, int area, float circ, int diametro);
-void contarMoeda(cv::Mat& limpa, OVC& blob, float* soma, int* total);
-int verificaRepeticao(OVC* passou, OVC atual, int cont);
+int carregarMoedas(TABELA_MOEDAS* tabela, const char* ficheiro);
+void classificarMoedas(TABELA_MOEDAS* tabela, VC_BLOBS* blobs, int* tipo);
+void contarMoeda(SOBREPOSICAO* sobreposicao, OVC& blob, int tipo, int nframe, float* soma, int* total);
+void iniciarRastreador(RASTREADOR* rastreador);
+void atualizarRastreador(RASTREADOR* rastreador, OVC* blobs, int nblobs, int nframe, int* rasto);
 float calcular_circularidade(OVC* blobs);
-void escreverInfoMoeda(cv::Mat& image, OVC blob, int valor, float circ);
+void escreverInfoMoeda(SOBREPOSICAO* sobreposicao, OVC& blob, int valor, float circ);
 int somarImagens(IVC* src1, IVC* src2, IVC* dst);
-int desenhaBox(cv::Mat& image, OVC& blob);
-void escreveMoedaDetetada(cv::Mat& frame);
-void linhaReconhecimento(cv::Mat& frame);
+void iniciarSobreposicao(SOBREPOSICAO* sobreposicao);
+PRIMITIVA* adicionarPrimitiva(SOBREPOSICAO* sobreposicao, int tipo, int x, int y, int width, int height, cv::Scalar cor);
+void adicionarTexto(SOBREPOSICAO* sobreposicao, const char* texto, int x, int y, float escala, cv::Scalar cor);
+int aplicarSobreposicao(cv::Mat& frame, SOBREPOSICAO* sobreposicao);
+int desenhaBox(SOBREPOSICAO* sobreposicao, OVC& blob);
+void escreveMoedaDetetada(SOBREPOSICAO* sobreposicao, int linha, int largura);
+void linhaReconhecimento(SOBREPOSICAO* sobreposicao, int linha, int largura);
 void vc_timer(void);
+int construirResumoHud(CAMADA_HUD* camada, cv::Mat& frame, int width, int height, int totalFrames, int fps);
+int construirAvisoHud(CAMADA_HUD* camada, cv::Mat& frame, int linha);
+void desenharCamadaHud(cv::Mat& frame, CAMADA_HUD* camada);
 void resumoFrame(cv::Mat& frame, int* total, float soma, int width, int height, int totalFrames, int fps, int nframe);
 void resumoTerminal(int* total, float soma);
+ECRA* abrirEcra(const char* janela, float escala);
+void mostrarEcra(ECRA* ecra, cv::Mat& frame);
+int teclaEcra(ECRA* ecra);
+void fecharEcra(ECRA* ecra);
+int abrirVideo(cv::VideoCapture& capture, const char* videofile);
+DESCODIFICADOR* abrirDescodificador(cv::VideoCapture* capture, int profundidade, int width, int height);
+DESCODIFICADOR* abrirEntrada(FONTE* fonte, int profundidade);
+cv::Mat* obterFrame(DESCODIFICADOR* descodificador, int* nframe, double* tempo);
+void libertarFrame(DESCODIFICADOR* descodificador);
+void saltarFrames(DESCODIFICADOR* descodificador, int k);
+void fecharDescodificador(DESCODIFICADOR* descodificador);
+ESCRITOR* abrirEscritor(const char* ficheiro, double fps, int width, int height, int eventos, int esperar);
+void escreverEscritor(ESCRITOR* escritor, cv::Mat& frame, int evento);
+void fecharEscritor(ESCRITOR* escritor);
+int abrirMetricas(const char* destino, int periodo);
+void fecharMetricas(void);
+void metricaContar(int contador, long int n);
+void metricaMoeda(int tipo);
+void metricaBlobs(int nblobs);
+double metricaRelogio(void);
+void metricaTempo(int etapa, double inicio);
+void metricaFila(int fila, int profundidade);
+void textoMetricas(std::string& texto);
+int abrirEventos(const char* ficheiro);
+void registarMoeda(const EVENTO_MOEDA* evento);
+void esvaziarEventos(void);
+void fecharEventos(void);
+int lerCenario(const char* texto, CENARIO* cenario);
+GERADOR* abrirGerador(const CENARIO* cenario);
+int gerarFrame(GERADOR* g, cv::Mat& frame);
+int verdadeGerador(GERADOR* gerador, int* total, long int* centimos);
+int escreverVerdade(GERADOR* gerador, const char* ficheiro);
+void fecharGerador(GERADOR* gerador);
+int gerarSintetico(const char* texto, const char* verdade);
+int benchmarkSintetico(const char* cenarios);
+int microbenchmark(const char* resolucoes);
 
 
 